@@ -137,6 +137,16 @@ DefineExternalTarget(FreeImage
 	${Extern_DIR}/FreeImage/Source
 )
 
+# ZLib is built as part of FreeImage
+set(ZLib_INCLUDE ${Extern_DIR}/FreeImage/Source/ZLib)
+set(ZLib_LIBRARY ZLib)
+
+# FileTools reads compressed .blend files with the zlib that FreeImage builds.
+set(FileTools_USE_ZLIB         TRUE)
+set(FileTools_ZLIB_INCLUDE     ${ZLib_INCLUDE})
+set(FileTools_ZLIB_LIBRARY     ${ZLib_LIBRARY})
+set(FileTools_ZLIB_DEFINITIONS "-DFT_USE_ZLIB=1")
+
 
 DefineExternalTargetEx(FileTools
 	Extern 
@@ -0,0 +1,93 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "ftCastPlan.h"
+#include "ftHashTypes.h"
+#include "ftMember.h"
+#include "ftStruct.h"
+#include "ftTable.h"
+
+using namespace ftFlags;
+
+int ftCastPlan::findMethod(ftStruct* file, ftStruct* memory, const int headerFlags)
+{
+    if ((headerFlags & (FH_ENDIAN_SWAP | FH_VAR_BITS)) != 0 ||
+        file->getSizeInBytes() != memory->getSizeInBytes() ||
+        file->getMemberCount() != memory->getMemberCount() ||
+        file->hasFlag(ftStruct::MISALIGNED) ||
+        memory->hasFlag(ftStruct::MISALIGNED))
+        return CM_CAST;
+
+    bool hasPointers = false;
+
+    ftStruct::Members::Iterator it = memory->getMemberIterator();
+    while (it.hasMoreElements())
+    {
+        ftMember* dst = it.getNext();
+        ftMember* src = file->find(dst);
+
+        if (!src ||
+            src->getOffset() != dst->getOffset() ||
+            src->getSizeInBytes() != dst->getSizeInBytes() ||
+            src->getHashedType() != dst->getHashedType() ||
+            src->getArraySize() != dst->getArraySize() ||
+            src->getPointerCount() != dst->getPointerCount())
+            return CM_CAST;
+
+        if (dst->isPointer())
+            hasPointers = true;
+    }
+    return hasPointers ? CM_COPY : CM_IN_PLACE;
+}
+
+void ftCastPlan::build(ftTable* file, ftTable* memory, const int headerFlags, const bool castAll)
+{
+    m_structs.clear();
+    m_members.clear();
+
+    const ftTable::StructureArray& structures = file->getStructureArray();
+    m_structs.reserve(structures.size());
+
+    for (ftTable::StructureArray::SizeType i = 0; i < structures.size(); ++i)
+    {
+        Struct plan = {structures.at(i), nullptr, CM_CAST, 0, 0};
+
+        const char* name = file->getTypeNameAt(plan.file->getTypeIndex());
+        if (name != nullptr)
+            plan.memory = memory->findStructByName(ftCharHashKey(name));
+
+        if (plan.memory)
+        {
+            plan.method = castAll ? (int)CM_CAST : findMethod(plan.file, plan.memory, headerFlags);
+            plan.first  = (SKuint32)m_members.size();
+
+            ftStruct::Members::Iterator it = plan.memory->getMemberIterator();
+            while (it.hasMoreElements())
+            {
+                ftMember* dst = it.getNext();
+                if (plan.method == CM_CAST || dst->isPointer())
+                    m_members.push_back({dst, plan.file->find(dst)});
+            }
+            plan.count = (SKuint32)m_members.size() - plan.first;
+        }
+        m_structs.push_back(plan);
+    }
+}
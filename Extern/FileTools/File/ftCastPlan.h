@@ -0,0 +1,134 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _ftCastPlan_h_
+#define _ftCastPlan_h_
+
+#include "Utils/skArray.h"
+#include "ftTypes.h"
+
+class ftTable;
+class ftStruct;
+class ftMember;
+
+/// <summary>
+/// ftCastPlan holds the result of matching every structure in a
+/// file table against the memory table. It is computed once per
+/// pair of tables, so that loading a chunk does not need to search
+/// for the corresponding structure or members again.
+/// </summary>
+class ftCastPlan
+{
+public:
+    enum Method
+    {
+        /// <summary>
+        /// Each member in the memory structure is cast from
+        /// the corresponding member in the file structure.
+        /// </summary>
+        CM_CAST = 0,
+
+        /// <summary>
+        /// The file and memory structures have the same layout.
+        /// The whole chunk is copied, then only the pointer members
+        /// are cast.
+        /// </summary>
+        CM_COPY,
+
+        /// <summary>
+        /// The file and memory structures have the same layout and
+        /// there are no pointers to relocate, so the file block can
+        /// be used as the memory block.
+        /// </summary>
+        CM_IN_PLACE,
+    };
+
+    /// <summary>
+    /// Pairs a memory member with the file member that it reads from.
+    /// The source is null if the member is not in the file structure.
+    /// </summary>
+    struct Member
+    {
+        ftMember* dst;
+        ftMember* src;
+    };
+
+    /// <summary>
+    /// The plan for a single file structure.
+    /// </summary>
+    struct Struct
+    {
+        ftStruct* file;
+        ftStruct* memory;
+        int       method;
+
+        /// <summary>
+        /// The range of members in the plan's member array that need to be
+        /// cast. For CM_COPY this only holds the pointer members.
+        /// </summary>
+        SKuint32 first;
+        SKuint32 count;
+    };
+
+    typedef skArray<Struct> Structs;
+    typedef skArray<Member> Members;
+
+private:
+    Structs m_structs;
+    Members m_members;
+
+    static int findMethod(ftStruct* file, ftStruct* memory, int headerFlags);
+
+public:
+    ftCastPlan() = default;
+    ~ftCastPlan() = default;
+
+    /// <summary>
+    /// Matches each structure in the file table with the memory table.
+    /// </summary>
+    /// <param name="file">The table that was read from the file.</param>
+    /// <param name="memory">The table that was compiled into the program.</param>
+    /// <param name="headerFlags">The ftFlags::FileHeader flags of the file.</param>
+    /// <param name="castAll">Plans every structure as CM_CAST so that each member can be logged.</param>
+    void build(ftTable* file, ftTable* memory, int headerFlags, bool castAll = false);
+
+    /// <summary>
+    /// Returns the plan for the structure at the supplied index of the file table,
+    /// or null if the index is out of range. The memory structure in the returned
+    /// plan is null if the structure is not in the memory table.
+    /// </summary>
+    const Struct* find(SKint32 structId) const
+    {
+        if (structId > 0 && structId < (SKint32)m_structs.size())
+            return &m_structs.at((Structs::SizeType)structId);
+        return nullptr;
+    }
+
+    /// <summary>
+    /// Returns the first of the plan's members.
+    /// </summary>
+    const Member* getMembers(const Struct& plan) const
+    {
+        return m_members.ptr() + plan.first;
+    }
+};
+
+#endif  //_ftCastPlan_h_
@@ -106,6 +106,24 @@ struct ftMemoryChunk
         /// Flag to indicate that this chunk has been reconstructed.
         /// </summary>
         BLK_LINKED = 0x02,
+
+        /// <summary>
+        /// Flag to indicate that fileBlock points into a mapped file
+        /// and is not owned by this chunk.
+        /// </summary>
+        BLK_MAPPED = 0x04,
+
+        /// <summary>
+        /// Flag to indicate that memoryBlock is the same block as fileBlock,
+        /// because the data did not need to be converted.
+        /// </summary>
+        BLK_IN_PLACE = 0x08,
+
+        /// <summary>
+        /// Flag to indicate that the chunk itself was allocated
+        /// from the file's chunk pool.
+        /// </summary>
+        BLK_POOLED = 0x10,
     };
 
     /// <summary>
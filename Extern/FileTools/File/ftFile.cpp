@@ -22,6 +22,7 @@
 #include "ftFile.h"
 #include "Utils/skPlatformHeaders.h"
 #include "ftAtomic.h"
+#include "ftCastPlan.h"
 #include "ftEndianUtils.h"
 #include "ftHashTypes.h"
 #include "ftLogger.h"
@@ -29,6 +30,7 @@
 #include "ftScanDNA.h"
 #include "ftStreams.h"
 #include "ftTable.h"
+#include "ftTableCache.h"
 
 using namespace ftEndianUtils;
 using namespace ftFlags;
@@ -45,6 +47,13 @@ ftFile::ftFile(const char* header) :
     m_castFilter(nullptr),
     m_castFilterLen(0),
     m_inclusive(false),
+    m_mapping(nullptr),
+    m_chunkPool(nullptr),
+    m_chunkPoolSize(0),
+    m_chunkPoolUsed(0),
+    m_plan(nullptr),
+    m_sharedMemory(false),
+    m_sharedFile(false),
     m_memoryVersion(-1),
     m_fileVersion(0),
     m_memory(nullptr),
@@ -89,28 +98,74 @@ int ftFile::load(const char* path, int mode)
         }
     }
 
-    skStream* stream = openStream(path, mode);
+    ftMappedStream* mapping = nullptr;
+
+    skStream* stream = openStream(path, mode, mapping);
     if (!stream->isOpen())
     {
         if (m_fileFlags != LF_NONE)
             ftLogger::logF("File '%s' loading failed.", path);
+        delete stream;
         return FS_FAILED;
     }
 
     m_curFile = path;
 
-    const int result = parseStreamImpl(stream);
-    delete stream;
+    const int result = parseStreamImpl(stream, mapping);
+    if (mapping)
+    {
+        // Chunks reference the mapping in place, so it
+        // has to stay open until the storage is cleared.
+        m_mapping = mapping;
+    }
+    else
+        delete stream;
     return result;
 }
 
-skStream* ftFile::openStream(const char* path, int mode)
+skStream* ftFile::openStream(const char* path, int mode, ftMappedStream*& mapping)
 {
     skStream* stream;
+    mapping = nullptr;
+
+    if (mode == RM_UNCOMPRESSED)
+    {
+        mapping = new ftMappedStream();
+        mapping->open(path, skStream::READ);
+        if (mapping->isOpen())
+        {
+            m_fileSizeInBytes = mapping->size();
+            return mapping;
+        }
+
+        // Fall back to reading the file.
+        delete mapping;
+        mapping = nullptr;
+    }
+    else if (mode == RM_COMPRESSED)
+    {
+        // The pre-scan reads the whole file and then seeks back to the
+        // header, which would inflate it a second time. So it is inflated
+        // once into memory, and the chunks are used in place from there.
+        ftGzReadAheadStream source;
+        source.open(path, skStream::READ);
+
+        mapping = new ftMappedStream();
+        mapping->load(source);
+        if (mapping->isOpen())
+        {
+            m_fileSizeInBytes = mapping->size();
+            return mapping;
+        }
+
+        delete mapping;
+        mapping = nullptr;
+    }
+
     if (mode == RM_UNCOMPRESSED || mode == RM_COMPRESSED)
     {
         if (mode == RM_COMPRESSED)
-            stream = new ftGzStream();
+            stream = new ftGzReadAheadStream();
         else
             stream = new skFileStream();
     }
@@ -194,29 +249,93 @@ int ftFile::preScan(skStream* stream)
     int status = scanner.scan(stream);
     if (status == FS_OK)
     {
-        m_fileTableData = scanner.getDNA();
-        if (m_fileTableData && scanner.getLength() > 0)
+        // Reserve the bookkeeping for every chunk up front, rather
+        // than allocating it one chunk at a time in handleChunk.
+        m_chunkPoolSize = scanner.getChunkCount();
+        if (m_chunkPoolSize > 0)
         {
-            m_file = new ftTable((m_headerFlags & FH_CHUNK_64) != 0 ? 8 : 4);
-            status = m_file->read(m_fileTableData, scanner.getLength(), m_headerFlags, m_fileFlags);
-            if (status == FS_OK)
-            {
-                if (m_fileFlags & LF_DO_CHECKS)
-                    status = runTableChecks(m_file);
-            }
-            else
-            {
-                if (m_fileFlags != LF_NONE)
-                    ftLogger::logF("File table initialization failed.");
-            }
+            m_chunkPool = (ftMemoryChunk*)malloc(sizeof(ftMemoryChunk) * m_chunkPoolSize);
+            if (!m_chunkPool)
+                m_chunkPoolSize = 0;
         }
+
+        void* data = scanner.getDNA();
+        if (data && scanner.getLength() > 0)
+            status = readFileTables(data, scanner.getLength());
         else
+        {
+            free(data);
             status = FS_TABLE_INIT_FAILED;
+        }
     }
 
     return status;
 }
 
+int ftFile::readFileTables(void* data, const SKsize length)
+{
+    // Files that were saved with the same DNA have identical tables,
+    // so they only need to be read and matched against the memory
+    // table the first time that one of them is loaded.
+    const bool useCache = m_sharedMemory && useTableCache();
+    if (useCache)
+    {
+        const ftTableCache::FileTables* cached = ftTableCache::findFileTables(data, length, m_headerFlags, m_memory);
+        if (cached)
+        {
+            free(data);
+            m_fileTableData = cached->data;
+            m_file          = cached->file;
+            m_plan          = cached->plan;
+            m_sharedFile    = true;
+            return FS_OK;
+        }
+    }
+
+    m_fileTableData = data;
+    m_file          = new ftTable((m_headerFlags & FH_CHUNK_64) != 0 ? 8 : 4);
+
+    int status = m_file->read(m_fileTableData, length, m_headerFlags, m_fileFlags);
+    if (status == FS_OK)
+    {
+        if (m_fileFlags & LF_DO_CHECKS)
+            status = runTableChecks(m_file);
+    }
+    else
+    {
+        if (m_fileFlags != LF_NONE)
+            ftLogger::logF("File table initialization failed.");
+    }
+
+    if (status == FS_OK)
+    {
+        // Casting every member keeps the per member diagnostics.
+        const bool castAll = (m_fileFlags & LF_DIAGNOSTICS) != 0 && (m_fileFlags & LF_DUMP_CAST) != 0;
+
+        m_plan = new ftCastPlan();
+        m_plan->build(m_file, m_memory, m_headerFlags, castAll);
+
+        if (useCache)
+        {
+            const ftTableCache::FileTables* cached = ftTableCache::insertFileTables({
+                ftTableCache::hash(data, length),
+                length,
+                m_headerFlags,
+                m_memory,
+                m_fileTableData,
+                m_file,
+                m_plan,
+            });
+
+            m_fileTableData = cached->data;
+            m_file          = cached->file;
+            m_plan          = cached->plan;
+            m_sharedFile    = true;
+        }
+    }
+    return status;
+}
+
 int ftFile::runTableChecks(ftTable* check) const
 {
     if (check)
@@ -232,7 +351,7 @@ int ftFile::runTableChecks(ftTable* check) const
     return FS_OK;
 }
 
-int ftFile::parseStreamImpl(skStream* stream)
+int ftFile::parseStreamImpl(skStream* stream, ftMappedStream* mapping)
 {
     ftChunk chunk = ftChunkUtils::BlankChunk;
 
@@ -270,7 +389,7 @@ int ftFile::parseStreamImpl(skStream* stream)
         ftLogger::log(status, "Failed to seek back to the header.");
     }
 
-    m_map.reserve(skClamp(FileTools_DefaultAllocationSize, 0, 4096));
+    m_map.reserve(skMax<SKsize>(skClamp(FileTools_DefaultAllocationSize, 0, 4096), m_chunkPoolSize));
 
     while (chunk.code != ftIdNames::ENDB &&
            chunk.code != ftIdNames::DNA1 &&
@@ -291,15 +410,27 @@ int ftFile::parseStreamImpl(skStream* stream)
         {
             if ((int)chunk.length > 0 && chunk.length < m_fileSizeInBytes)
             {
-                void* curPtr = malloc(chunk.length);
-                if (!curPtr)
-                    status = FS_BAD_ALLOC;
-                else
+                if (mapping)
                 {
-                    if (stream->read(curPtr, chunk.length) <= 0)
+                    // Use the chunk's data directly out of the mapped file.
+                    void* curPtr = mapping->addressAtPosition();
+                    if (!curPtr || !mapping->seek(chunk.length, SEEK_CUR))
                         status = FS_INV_READ;
                     else
-                        handleChunk(curPtr, chunk.length, chunk, status);
+                        handleChunk(curPtr, chunk.length, chunk, true, status);
+                }
+                else
+                {
+                    void* curPtr = malloc(chunk.length);
+                    if (!curPtr)
+                        status = FS_BAD_ALLOC;
+                    else
+                    {
+                        if (stream->read(curPtr, chunk.length) <= 0)
+                            status = FS_INV_READ;
+                        else
+                            handleChunk(curPtr, chunk.length, chunk, false, status);
+                    }
                 }
             }
             else
@@ -326,15 +457,33 @@ int ftFile::parseStreamImpl(skStream* stream)
     return status;
 }
 
+ftMemoryChunk* ftFile::allocateChunk()
+{
+    ftMemoryChunk* bin;
+    if (m_chunkPoolUsed < m_chunkPoolSize)
+    {
+        bin = &m_chunkPool[m_chunkPoolUsed++];
+        memset(bin, 0, sizeof(ftMemoryChunk));
+        bin->flag = ftMemoryChunk::BLK_POOLED;
+    }
+    else
+    {
+        bin = (ftMemoryChunk*)malloc(sizeof(ftMemoryChunk));
+        if (bin)
+            memset(bin, 0, sizeof(ftMemoryChunk));
+    }
+    return bin;
+}
+
 void ftFile::handleChunk(void*          block,
                          SKsize         allocLen,
                          const ftChunk& chunk,
+                         bool           mapped,
                          int&           status)
 {
-    ftMemoryChunk* bin = (ftMemoryChunk*)malloc(sizeof(ftMemoryChunk));
+    ftMemoryChunk* bin = allocateChunk();
     if (bin)
     {
-        memset(bin, 0, sizeof(ftMemoryChunk));
         memcpy(&bin->chunk, &chunk, sizeof(ftChunk));
 
         // This is saved here to recalculate the total
@@ -344,7 +493,8 @@ void ftFile::handleChunk(void*          block,
         const ftPointerHashKey phk(chunk.address);
         if (m_map.find(phk) != m_map.npos)
         {
-            free(block);
+            if (!mapped)
+                free(block);
             freeChunk(bin);
 
             // This should be an error if it's properly linked,
@@ -355,6 +505,8 @@ void ftFile::handleChunk(void*          block,
         {
             bin->fileBlock    = block;
             bin->fileBlockLen = (SKuint32)allocLen;
+            if (mapped)
+                bin->flag |= ftMemoryChunk::BLK_MAPPED;
 
             ftStruct* memoryStruct = nullptr;
 
@@ -365,14 +517,15 @@ void ftFile::handleChunk(void*          block,
                 status = allocateMBlock(phk,
                                         bin,
                                         (SKsize)chunk.length * (SKsize)chunk.count,
-                                        false);
+                                        ftCastPlan::CM_IN_PLACE);
             }
             else
             {
-                ftStruct* fileStruct = m_file->findStructByType(bin->chunk.structId);
+                const ftCastPlan::Struct* plan       = m_plan->find(bin->chunk.structId);
+                ftStruct*                 fileStruct = plan ? plan->file : nullptr;
                 if (fileStruct)
                 {
-                    memoryStruct = findInMemoryTable(fileStruct);
+                    memoryStruct = plan->memory;
 
                     if (memoryStruct)
                     {
@@ -400,7 +553,7 @@ void ftFile::handleChunk(void*          block,
                         status = allocateMBlock(phk,
                                                 bin,
                                                 totalAlloc,
-                                                true);
+                                                plan->method);
                     }
                     else
                     {
@@ -419,10 +572,14 @@ void ftFile::handleChunk(void*          block,
         }
     }
     else
+    {
+        if (!mapped)
+            free(block);
         status = FS_BAD_ALLOC;
+    }
 }
 
-int ftFile::allocateMBlock(const ftPointerHashKey& phk, ftMemoryChunk* bin, const SKsize& len, bool zero)
+int ftFile::allocateMBlock(const ftPointerHashKey& phk, ftMemoryChunk* bin, const SKsize& len, const int method)
 {
     int status = FS_OK;
 
@@ -431,32 +588,44 @@ int ftFile::allocateMBlock(const ftPointerHashKey& phk, ftMemoryChunk* bin, cons
     const SKuint32 totSize = (SKuint32)len;
     if (totSize > 0 && totSize < m_fileSizeInBytes)
     {
-        bin->memoryBlockLen = totSize;
-        bin->memoryBlock    = malloc(totSize);
-        if (!bin->memoryBlock)
-            status = FS_BAD_ALLOC;
+        // This is for the case when the chunk.code is saved
+        // as DATA, and the structure ID is less than the first
+        // user-defined type. I.E. it's an atomic pointer type so
+        // the file block can be used as is. The same goes for
+        // structures that have an identical layout in the file and
+        // in memory. Mapped blocks are only used in place if they
+        // are aligned to hold a pointer.
+        if (method == ftCastPlan::CM_IN_PLACE && ((SKsize)bin->fileBlock & (sizeof(SKsize) - 1)) == 0)
+        {
+            bin->memoryBlockLen = bin->fileBlockLen;
+            bin->memoryBlock    = bin->fileBlock;
+            bin->flag |= ftMemoryChunk::BLK_IN_PLACE;
+        }
         else
         {
-            if (zero)
-                memset(bin->memoryBlock, 0, totSize);
+            bin->memoryBlockLen = totSize;
+            bin->memoryBlock    = malloc(totSize);
+            if (!bin->memoryBlock)
+                status = FS_BAD_ALLOC;
             else
             {
-                // This is for the case when the chunk.code is saved
-                // as DATA, and the structure ID is less than the first
-                // user-defined type. I.E. it's an atomic pointer type so it's
-                // safe to just copy this block
-
-                SKsize cpSize = bin->memoryBlockLen;
-                if (cpSize > bin->fileBlockLen)
-                    cpSize = bin->fileBlockLen;
+                if (method == ftCastPlan::CM_CAST)
+                    memset(bin->memoryBlock, 0, totSize);
+                else
+                {
+                    SKsize cpSize = bin->memoryBlockLen;
+                    if (cpSize > bin->fileBlockLen)
+                        cpSize = bin->fileBlockLen;
 
-                memcpy(bin->memoryBlock, bin->fileBlock, cpSize);
+                    memcpy(bin->memoryBlock, bin->fileBlock, cpSize);
+                }
             }
         }
 
         if (status == FS_OK)
         {
-            insertChunk(phk, bin, zero, status);
+            // Only structures need to be rebuilt.
+            insertChunk(phk, bin, bin->memoryStruct != nullptr, status);
 
             if (m_fileFlags & LF_READ_CHUNKS)
                 ftLogger::logReadChunk(bin->chunk, bin->fileBlock, bin->chunk.length);
@@ -488,11 +657,12 @@ void ftFile::freeChunk(ftMemoryChunk*& chunk)
     {
         if (chunk->pointerBlock)
             free(chunk->pointerBlock);
-        if (chunk->fileBlock)
+        if (chunk->fileBlock && (chunk->flag & ftMemoryChunk::BLK_MAPPED) == 0)
             free(chunk->fileBlock);
-        if (chunk->memoryBlock)
+        if (chunk->memoryBlock && (chunk->flag & ftMemoryChunk::BLK_IN_PLACE) == 0)
             free(chunk->memoryBlock);
-        free(chunk);
+        if ((chunk->flag & ftMemoryChunk::BLK_POOLED) == 0)
+            free(chunk);
         chunk = nullptr;
     }
 }
@@ -519,20 +689,24 @@ int ftFile::rebuildStructures()
                 ftLogger::logDiagnosticsCastHeader(chunk, fileStruct, memoryStruct);
         }
 
+        // Structures that were copied or used in place when the chunk
+        // was allocated only have their pointers left in the plan.
+        const ftCastPlan::Struct* plan    = fileStruct && memoryStruct ? m_plan->find(chunk.structId) : nullptr;
+        const ftCastPlan::Member* members = plan ? m_plan->getMembers(*plan) : nullptr;
+
         for (SKuint32 n = 0;
              n < chunk.count && status == FS_OK &&
-             fileStruct && memoryStruct &&
+             plan && plan->count > 0 &&
              (node->flag & ftMemoryChunk::BLK_LINKED) == 0;
              ++n)
         {
             SKbyte* dst = memoryStruct->getChunk(node->memoryBlock, n, node->memoryBlockLen);
             SKbyte* src = fileStruct->getChunk(node->fileBlock, n, node->fileBlockLen);
 
-            ftStruct::Members::Iterator it = memoryStruct->getMemberIterator();
-            while (it.hasMoreElements())
+            for (SKuint32 i = 0; i < plan->count; ++i)
             {
-                ftMember* dstMember = it.getNext();
-                ftMember* srcMember = fileStruct->find(dstMember);
+                ftMember* dstMember = members[i].dst;
+                ftMember* srcMember = members[i].src;
 
                 if (srcMember)
                 {
@@ -673,10 +847,16 @@ void ftFile::castMemberPointer(ftMember* dst,
 template <typename BaseType>
 void ftFile::castPointer(SKsize*& dstPtr, SKsize* srcPtr, SKsize arrayLen)
 {
-    BaseType* ptr = (BaseType*)srcPtr;
+    // Mapped file blocks are not guaranteed to be aligned
+    // for the file's pointer size, so read them bytewise.
+    const SKbyte* ptr = (const SKbyte*)srcPtr;
     for (SKsize i = 0; i < arrayLen; ++i)
     {
-        void* vp  = (void*)(SKsize)*ptr++;
+        BaseType value;
+        memcpy(&value, ptr, sizeof(BaseType));
+        ptr += sizeof(BaseType);
+
+        void* vp  = (void*)(SKsize)value;
         dstPtr[i] = (SKsize)findPointer(ftPointerHashKey(vp));
     }
 }
@@ -687,7 +867,10 @@ void ftFile::castPointerToPointer(ftMember* dst,
                                   SKsize*&  srcPtr,
                                   int&      status)
 {
-    ftMemoryChunk* bin = findBlock((SKsize)*srcPtr);
+    SKsize address;
+    memcpy(&address, srcPtr, sizeof(SKsize));
+
+    ftMemoryChunk* bin = findBlock(address);
     if (bin)
     {
         if (bin->flag & ftMemoryChunk::BLK_MODIFIED && bin->pointerBlock)
@@ -732,10 +915,10 @@ void ftFile::castPointerToPointer(ftMember* dst,
     }
     else if (m_fileFlags & LF_MISSING_PTR_PTR)
     {
-        if ((SKsize)*srcPtr != 0)
+        if (address != 0)
         {
             ftLogger::logF("Failed to find corresponding chunk for address (0x%08X)",
-                           (SKsize)*srcPtr);
+                           address);
             ftLogger::logF("Source");
             ftLogger::log(src);
             ftLogger::logF("Destination");
@@ -924,11 +1107,13 @@ void ftFile::setFilter(SKhash*& dest, SKint32& destLen, SKhash* filter, const SK
     while (i < length && dest[i] != 0)
         i++;
 
+    // Sort the whole list, so that searchFilter
+    // can find every entry with a binary search.
     destLen = i;
-    for (i = 0; i < destLen - 2; i++)
+    for (i = 0; i < destLen - 1; i++)
     {
         int k = i;
-        for (int j = i + 1; j < destLen - 1; ++j)
+        for (int j = i + 1; j < destLen; ++j)
             if (dest[j] < dest[k])
                 k = j;
         if (k != i)
@@ -1036,6 +1221,17 @@ int ftFile::initializeMemory(void)
     int status = m_memory == nullptr ? (int)FS_FAILED : (int)FS_OK;
     if (!m_memory)
     {
+        const bool useCache = useTableCache();
+        if (useCache)
+        {
+            m_memory = ftTableCache::findMemoryTable(getTables());
+            if (m_memory)
+            {
+                m_sharedMemory = true;
+                return FS_OK;
+            }
+        }
+
         m_memory = new ftTable(sizeof(void*));
 
         status = initializeTables(m_memory);
@@ -1044,6 +1240,12 @@ int ftFile::initializeMemory(void)
             if (m_fileFlags & LF_DO_CHECKS)
                 status = runTableChecks(m_memory);
         }
+
+        if (status == FS_OK && useCache)
+        {
+            m_memory       = ftTableCache::insertMemoryTable(getTables(), m_memory);
+            m_sharedMemory = true;
+        }
     }
     return status;
 }
@@ -1074,23 +1276,44 @@ void ftFile::clearStorage(void)
     m_map.clear();
     m_chunks.clear();
 
-    if (m_fileTableData)
+    if (m_chunkPool)
     {
-        free(m_fileTableData);
-        m_fileTableData = nullptr;
+        free(m_chunkPool);
+        m_chunkPool = nullptr;
     }
+    m_chunkPoolSize = 0;
+    m_chunkPoolUsed = 0;
 
-    if (m_file)
+    delete m_mapping;
+    m_mapping = nullptr;
+
+    // Tables that came from ftTableCache are owned by the cache.
+    if (!m_sharedFile)
     {
+        free(m_fileTableData);
         delete m_file;
-        m_file = nullptr;
+        delete m_plan;
     }
+    m_fileTableData = nullptr;
+    m_file          = nullptr;
+    m_plan          = nullptr;
+    m_sharedFile    = false;
 
-    if (m_memory)
-    {
+    if (!m_sharedMemory)
         delete m_memory;
-        m_memory = nullptr;
-    }
+    m_memory       = nullptr;
+    m_sharedMemory = false;
+}
+
+bool ftFile::useTableCache() const
+{
+    // Cached tables are not read or checked again, so files that ask
+    // for the tables to be dumped or checked always build their own.
+    if (m_fileFlags & (LF_DO_CHECKS | LF_DUMP_MEMBER_HASH))
+        return false;
+
+    const int dumpFlags = LF_DUMP_NAME_TABLE | LF_DUMP_TYPE_TABLE | LF_DUMP_SIZE_TABLE | LF_DUMP_CAST;
+    return (m_fileFlags & LF_DIAGNOSTICS) == 0 || (m_fileFlags & dumpFlags) == 0;
 }
 
 int ftFile::save(const char* path, const int mode)
@@ -27,6 +27,9 @@
 #include "ftHashTypes.h"
 #include "ftTypes.h"
 
+class ftMappedStream;
+class ftCastPlan;
+
 /// <summary>
 /// ftFile is the base class for a file in this system.
 /// Derived classes should override the table methods and supply them to this class.
@@ -52,6 +55,14 @@ private:
     SKint32     m_castFilterLen;
     bool        m_inclusive;
 
+    ftMappedStream* m_mapping;
+    ftMemoryChunk*  m_chunkPool;
+    SKuint32        m_chunkPoolSize;
+    SKuint32        m_chunkPoolUsed;
+    ftCastPlan*     m_plan;
+    bool            m_sharedMemory;
+    bool            m_sharedFile;
+
 protected:
     int          m_memoryVersion;
     int          m_fileVersion;
@@ -77,6 +88,8 @@ public:
     /// <param name="mode">
     /// Mode to determine how the file should be read.
     /// It should be one of the ftFlags::ReadMode values.
+    /// Uncompressed files are memory mapped, and chunks that do not need to
+    /// be converted are used in place for as long as the file is loaded.
     /// </param>
     /// <returns>
     /// A status code indicating the result.
@@ -277,10 +290,12 @@ private:
 
     ftMemoryChunk* findBlock(const SKsize& iPtr);
 
-    skStream* openStream(const char* path, int mode);
+    skStream* openStream(const char* path, int mode, ftMappedStream*& mapping);
 
     bool skip(const SKhash& id) const;
 
+    bool useTableCache() const;
+
     void serializeChunk(skStream* stream,
                         SKuint32  code,
                         SKuint32  nr,
@@ -292,8 +307,11 @@ private:
         void*          block,
         SKsize         allocLen,
         const ftChunk& chunk,
+        bool           mapped,
         int&           status);
 
+    ftMemoryChunk* allocateChunk();
+
     void insertChunk(const ftPointerHashKey& phk,
                      ftMemoryChunk*&         chunk,
                      bool                    addToRebuildList,
@@ -307,16 +325,18 @@ private:
 
     int parseHeader(skStream* stream);
 
-    int parseStreamImpl(skStream* stream);
+    int parseStreamImpl(skStream* stream, ftMappedStream* mapping = nullptr);
 
     int preScan(skStream* stream);
 
+    int readFileTables(void* data, SKsize length);
+
     int rebuildStructures();
 
     int allocateMBlock(const ftPointerHashKey& phk, 
         ftMemoryChunk* bin, 
         const SKsize& len, 
-        bool zero);
+        int method);
 
     void castMember(
         ftMember* dst,
@@ -33,6 +33,7 @@ ftScanDna::ftScanDna() :
     m_foundBlock(nullptr),
     m_foundLen(0),
     m_totalLen(0),
+    m_chunkCount(0),
     m_headerFlags(0)
 {
 }
@@ -137,6 +138,7 @@ int ftScanDna::scan(skStream* stream)
             {
                 if (scan.length > 0 && scan.length != SK_NPOS32)
                 {
+                    ++m_chunkCount;
                     if (!stream->seek(scan.length, SEEK_CUR))
                         status = FS_INV_READ;
                 }
@@ -39,9 +39,10 @@
 class ftScanDna
 {
 private:
-    void*  m_foundBlock;
-    SKsize m_foundLen, m_totalLen;
-    int    m_headerFlags;
+    void*    m_foundBlock;
+    SKsize   m_foundLen, m_totalLen;
+    SKuint32 m_chunkCount;
+    int      m_headerFlags;
 
 public:
     ftScanDna();
@@ -105,6 +106,14 @@ public:
     }
 
 
+    /// <summary>
+    /// Returns the number of chunks that were found before the DNA1 block.
+    /// </summary>
+    SKuint32 getChunkCount() const
+    {
+        return m_chunkCount;
+    }
+
     /// <summary>
     /// A test to see if the file is a 64-bit file. 
     /// </summary>
@@ -20,13 +20,210 @@
 -------------------------------------------------------------------------------
 */
 #include "ftStreams.h"
+#include "Utils/skMinMax.h"
 #include "Utils/skPlatformHeaders.h"
 
+#if SK_PLATFORM != SK_PLATFORM_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #if FT_USE_ZLIB == 1
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include "zconf.h"
 #include "zlib.h"
 #endif
 
+ftMappedStream::ftMappedStream() :
+    m_data(nullptr),
+    m_size(0),
+    m_pos(0),
+    m_allocated(false)
+{
+}
+
+ftMappedStream::~ftMappedStream()
+{
+    ftMappedStream::close();
+}
+
+void ftMappedStream::open(const char* path, int mode)
+{
+    if (!path)
+    {
+        printf("Invalid path name.\n");
+        return;
+    }
+
+    close();
+    if (mode != READ)
+        return;
+    m_mode = mode;
+
+#if SK_PLATFORM == SK_PLATFORM_WIN32
+    HANDLE file = CreateFileA(path,
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return;
+
+    LARGE_INTEGER len;
+    if (GetFileSizeEx(file, &len) && len.QuadPart > 0)
+    {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        if (mapping)
+        {
+            // The view keeps its own reference to the mapping,
+            // so both handles can be released here.
+            m_data = (SKbyte*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+
+    if (m_data)
+        m_size = (SKsize)len.QuadPart;
+#else
+    const int fd = ::open(path, O_RDONLY);
+    if (fd == -1)
+        return;
+
+    struct stat st = {};
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void* map = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED)
+        {
+            m_data = (SKbyte*)map;
+            m_size = (SKsize)st.st_size;
+        }
+    }
+    ::close(fd);
+#endif
+}
+
+void ftMappedStream::load(const skStream& source)
+{
+    close();
+    if (!source.isOpen())
+        return;
+
+    // The size of a gzip stream comes from its trailer, which only holds
+    // it modulo 2^32, so the buffer still grows if there is more to read.
+    SKsize  capacity = skMax<SKsize>(source.size(), 0x10000);
+    SKsize  length   = 0;
+    SKbyte* data     = (SKbyte*)malloc(capacity);
+
+    while (data)
+    {
+        const SKsize got = source.read(data + length, capacity - length);
+        if (got == SK_NPOS)
+        {
+            free(data);
+            data = nullptr;
+            break;
+        }
+
+        length += got;
+        if (got == 0 || source.eof())
+            break;
+        if (length < capacity)
+            continue;
+
+        SKbyte* grown = (SKbyte*)realloc(data, capacity * 2);
+        if (!grown)
+        {
+            free(data);
+            data = nullptr;
+            break;
+        }
+        data = grown;
+        capacity *= 2;
+    }
+
+    if (data && length > 0)
+    {
+        m_data      = data;
+        m_size      = length;
+        m_allocated = true;
+        m_mode      = READ;
+    }
+    else
+        free(data);
+}
+
+void ftMappedStream::close(void)
+{
+    if (m_data)
+    {
+        if (m_allocated)
+            free(m_data);
+        else
+        {
+#if SK_PLATFORM == SK_PLATFORM_WIN32
+            UnmapViewOfFile(m_data);
+#else
+            munmap(m_data, m_size);
+#endif
+        }
+        m_data = nullptr;
+    }
+    m_size      = 0;
+    m_pos       = 0;
+    m_allocated = false;
+    m_mode      = SK_NPOS32;
+}
+
+SKsize ftMappedStream::read(void* dest, SKsize nr) const
+{
+    if (!dest || !canRead() || !isOpen())
+        return SK_NPOS;
+
+    if (m_pos >= m_size)
+        return 0;
+
+    if (nr > m_size - m_pos)
+        nr = m_size - m_pos;
+
+    memcpy(dest, m_data + m_pos, nr);
+    m_pos += nr;
+    return nr;
+}
+
+SKsize ftMappedStream::write(const void* src, SKsize nr)
+{
+    return SK_NPOS;
+}
+
+bool ftMappedStream::seek(SKint64 offset, SKsize dir)
+{
+    if (!isOpen())
+        return false;
+
+    SKint64 base;
+    if (dir == SEEK_END)
+        base = (SKint64)m_size;
+    else if (dir == SEEK_CUR)
+        base = (SKint64)m_pos;
+    else
+        base = 0;
+
+    const SKint64 pos = base + offset;
+    if (pos < 0 || pos > (SKint64)m_size)
+        return false;
+
+    m_pos = (SKsize)pos;
+    return true;
+}
+
 #if FT_USE_ZLIB == 1
 
 ftGzStream::ftGzStream() :
@@ -118,4 +315,292 @@ bool ftGzStream::seek(SKint64 offset, SKsize dir)
     return false;
 }
 
+struct ftGzReadAhead
+{
+    gzFile                  file;
+    std::thread             thread;
+    std::mutex              mutex;
+    std::condition_variable produced;
+    std::condition_variable consumed;
+
+    SKbyte* buffers[ftGzReadAheadStream::BufferCount];
+    SKsize  lengths[ftGzReadAheadStream::BufferCount];
+
+    // Buffers are filled at head and read at tail. Both only ever
+    // grow, so head - tail is the number of buffers ready to read.
+    SKsize head;
+    SKsize tail;
+    bool   done;
+    bool   stop;
+
+    // Reader side. The reader holds the buffer at tail while
+    // offset is inside of it.
+    SKsize pos;
+    SKsize offset;
+    bool   holding;
+
+    void produce()
+    {
+        for (;;)
+        {
+            SKsize slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                consumed.wait(lock,
+                              [this]
+                              {
+                                  return stop || head - tail < ftGzReadAheadStream::BufferCount;
+                              });
+                if (stop)
+                    return;
+                slot = head % ftGzReadAheadStream::BufferCount;
+            }
+
+            // gzread only returns less than what was asked
+            // for at the end of the file or on an error.
+            const int  len = gzread(file, buffers[slot], (unsigned int)ftGzReadAheadStream::BufferSize);
+            const bool end = len < (int)ftGzReadAheadStream::BufferSize;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (len > 0)
+                {
+                    lengths[slot] = (SKsize)len;
+                    ++head;
+                }
+                done = end;
+            }
+            produced.notify_one();
+
+            if (end)
+                return;
+        }
+    }
+
+    void start()
+    {
+        head    = 0;
+        tail    = 0;
+        done    = false;
+        stop    = false;
+        pos     = 0;
+        offset  = 0;
+        holding = false;
+        thread  = std::thread(&ftGzReadAhead::produce, this);
+    }
+
+    void halt()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        consumed.notify_one();
+        if (thread.joinable())
+            thread.join();
+    }
+
+    bool acquire()
+    {
+        if (!holding)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            produced.wait(lock,
+                          [this]
+                          {
+                              return head != tail || done;
+                          });
+            if (head == tail)
+                return false;
+
+            holding = true;
+            offset  = 0;
+        }
+        return true;
+    }
+
+    void release()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++tail;
+            holding = false;
+        }
+        consumed.notify_one();
+    }
+
+    SKsize consume(void* dest, SKsize nr)
+    {
+        SKbyte* dst   = (SKbyte*)dest;
+        SKsize  total = 0;
+        while (total < nr && acquire())
+        {
+            const SKsize slot = tail % ftGzReadAheadStream::BufferCount;
+            const SKsize len  = skMin(nr - total, lengths[slot] - offset);
+            if (dst)
+                memcpy(dst + total, buffers[slot] + offset, len);
+
+            offset += len;
+            pos += len;
+            total += len;
+            if (offset >= lengths[slot])
+                release();
+        }
+        return total;
+    }
+};
+
+ftGzReadAheadStream::ftGzReadAheadStream() :
+    m_state(nullptr),
+    m_size(0)
+{
+}
+
+ftGzReadAheadStream::~ftGzReadAheadStream()
+{
+    ftGzReadAheadStream::close();
+}
+
+void ftGzReadAheadStream::open(const char* path, int mode)
+{
+    if (!path)
+    {
+        printf("Invalid path name.\n");
+        return;
+    }
+
+    close();
+    if (mode != READ)
+        return;
+
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+        return;
+
+    // The last four bytes of a gzip file hold the uncompressed
+    // size, modulo 2^32. Files that are not compressed are read
+    // as is by zlib, so then it is the size of the file.
+    SKubyte magic[2] = {};
+    SKubyte isize[4] = {};
+    const bool compressed = fread(magic, 1, 2, fp) == 2 && magic[0] == 0x1F && magic[1] == 0x8B;
+
+    if (compressed)
+    {
+        if (fseek(fp, -4, SEEK_END) == 0 && fread(isize, 1, 4, fp) == 4)
+            m_size = (SKsize)isize[0] | (SKsize)isize[1] << 8 | (SKsize)isize[2] << 16 | (SKsize)isize[3] << 24;
+    }
+    else if (fseek(fp, 0, SEEK_END) == 0)
+        m_size = (SKsize)ftell(fp);
+    fclose(fp);
+
+    gzFile file = gzopen(path, "rb");
+    if (!file)
+    {
+        m_size = 0;
+        return;
+    }
+
+    // Reads are at least a megabyte, so zlib inflates straight into
+    // the ring and only needs a larger buffer for the compressed input.
+    gzbuffer(file, 0x20000);
+
+    m_state       = new ftGzReadAhead();
+    m_state->file = file;
+    for (SKsize i = 0; i < BufferCount; ++i)
+        m_state->buffers[i] = (SKbyte*)malloc(BufferSize);
+
+    for (SKsize i = 0; i < BufferCount; ++i)
+    {
+        if (!m_state->buffers[i])
+        {
+            close();
+            return;
+        }
+    }
+
+    m_mode = mode;
+    m_state->start();
+}
+
+void ftGzReadAheadStream::close(void)
+{
+    if (m_state)
+    {
+        m_state->halt();
+        gzclose(m_state->file);
+
+        for (SKsize i = 0; i < BufferCount; ++i)
+            free(m_state->buffers[i]);
+
+        delete m_state;
+        m_state = nullptr;
+    }
+    m_size = 0;
+    m_mode = SK_NPOS32;
+}
+
+SKsize ftGzReadAheadStream::read(void* dest, SKsize nr) const
+{
+    if (!dest || !canRead() || !isOpen())
+        return SK_NPOS;
+    return m_state->consume(dest, nr);
+}
+
+SKsize ftGzReadAheadStream::write(const void* src, SKsize nr)
+{
+    return SK_NPOS;
+}
+
+SKsize ftGzReadAheadStream::position(void) const
+{
+    return m_state ? m_state->pos : SK_NPOS;
+}
+
+bool ftGzReadAheadStream::eof(void) const
+{
+    if (!m_state)
+        return true;
+    return !m_state->acquire();
+}
+
+bool ftGzReadAheadStream::seek(SKint64 offset, SKsize dir)
+{
+    if (!isOpen())
+        return false;
+
+    SKint64 target;
+    if (dir == SEEK_END)
+        target = (SKint64)m_size + offset;
+    else if (dir == SEEK_CUR)
+        target = (SKint64)m_state->pos + offset;
+    else
+        target = offset;
+
+    if (target < 0)
+        return false;
+
+    const SKsize to = (SKsize)target;
+    if (to >= m_state->pos)
+    {
+        const SKsize skip = to - m_state->pos;
+        return m_state->consume(nullptr, skip) == skip;
+    }
+
+    if (m_state->holding && m_state->pos - to <= m_state->offset)
+    {
+        // Still inside of the current buffer.
+        m_state->offset -= m_state->pos - to;
+        m_state->pos = to;
+        return true;
+    }
+
+    m_state->halt();
+    if (gzrewind(m_state->file) != 0)
+    {
+        close();
+        return false;
+    }
+    m_state->start();
+    return m_state->consume(nullptr, to) == to;
+}
+
 #endif
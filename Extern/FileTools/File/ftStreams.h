@@ -27,6 +27,76 @@
 #include "Utils/skStreams.h"
 #include "ftTypes.h"
 
+/// <summary>
+/// ftMappedStream is a read only stream that maps an entire file into memory.
+/// </summary>
+/// <remarks>
+/// The mapping is private, so pages that are written to through addressAtPosition
+/// are copied on write and never reach the file on disk. The stream can also hold
+/// a copy of another stream in memory, through load, and is then read the same way.
+/// </remarks>
+class ftMappedStream final : public skStream
+{
+private:
+    SKbyte*        m_data;
+    SKsize         m_size;
+    mutable SKsize m_pos;
+    bool           m_allocated;
+
+public:
+    ftMappedStream();
+    ~ftMappedStream() override;
+
+    void open(const char* path, int mode) override;
+
+    /// <summary>
+    /// Reads the rest of a stream into memory that this stream owns. It is used
+    /// for compressed files, so that they are inflated once and then read in
+    /// place, rather than inflated again every time the reader seeks back.
+    /// </summary>
+    /// <param name="source">The stream to copy. Its size is only used as a hint.</param>
+    void load(const skStream& source);
+
+    SKsize read(void* dest, SKsize nr) const override;
+
+    SKsize write(const void* src, SKsize nr) override;
+
+    SKsize position(void) const override
+    {
+        return m_pos;
+    }
+
+    SKsize size(void) const override
+    {
+        return m_size;
+    }
+
+    void close(void) override;
+
+    bool eof(void) const override
+    {
+        return m_pos >= m_size;
+    }
+
+    bool seek(SKint64 offset, SKsize dir) override;
+
+    bool isOpen(void) const override
+    {
+        return m_data != nullptr;
+    }
+
+    /// <summary>
+    /// Returns the address of the current read position in the mapping,
+    /// or null if the position is at the end of the file.
+    /// </summary>
+    SKbyte* addressAtPosition() const
+    {
+        if (m_data && m_pos < m_size)
+            return m_data + m_pos;
+        return nullptr;
+    }
+};
+
 #if FT_USE_ZLIB == 1
 
 class ftGzStream final : public skStream
@@ -60,11 +130,65 @@ public:
     }
 };
 
+struct ftGzReadAhead;
+
+/// <summary>
+/// ftGzReadAheadStream is a read only gzip stream that inflates the file on a
+/// background thread, into a small ring of buffers ahead of the reader.
+/// </summary>
+/// <remarks>
+/// Parsing and decompression run at the same time, instead of every read
+/// waiting on gzread. Seeking forward consumes the inflated data. Seeking back
+/// past the start of the current buffer restarts the inflation from the beginning.
+/// </remarks>
+class ftGzReadAheadStream final : public skStream
+{
+public:
+    static const SKsize BufferSize  = 0x100000;
+    static const SKsize BufferCount = 4;
+
+private:
+    ftGzReadAhead* m_state;
+    SKsize         m_size;
+
+public:
+    ftGzReadAheadStream();
+    ~ftGzReadAheadStream() override;
+
+    void open(const char* path, int mode) override;
+
+    SKsize read(void* dest, SKsize nr) const override;
+
+    SKsize write(const void* src, SKsize nr) override;
+
+    SKsize position(void) const override;
+
+    /// <summary>
+    /// Returns the uncompressed size that is recorded in the gzip trailer.
+    /// </summary>
+    SKsize size(void) const override
+    {
+        return m_size;
+    }
+
+    void close(void) override;
+
+    bool eof(void) const override;
+
+    bool seek(SKint64 offset, SKsize dir) override;
+
+    bool isOpen(void) const override
+    {
+        return m_state != nullptr;
+    }
+};
+
 typedef skMemoryStream ftMemoryStream;
 
 #else
 
 typedef skFileStream   ftGzStream;
+typedef skFileStream   ftGzReadAheadStream;
 typedef skMemoryStream ftMemoryStream;
 
 #endif
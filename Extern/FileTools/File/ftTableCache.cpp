@@ -0,0 +1,179 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "ftTableCache.h"
+#include <mutex>
+#include "Utils/skArray.h"
+#include "Utils/skPlatformHeaders.h"
+#include "ftCastPlan.h"
+#include "ftTable.h"
+
+namespace
+{
+    struct ftMemoryTables
+    {
+        const void* data;
+        ftTable*    table;
+    };
+
+    struct ftTableCacheState
+    {
+        std::mutex                         mutex;
+        skArray<ftMemoryTables>            memory;
+        skArray<ftTableCache::FileTables*> files;
+    };
+
+    ftTableCacheState& getState()
+    {
+        // This is never deleted, so that the tables
+        // are not torn down by at exit deconstruction.
+        static ftTableCacheState* state = new ftTableCacheState();
+        return *state;
+    }
+
+    void freeFileTables(const ftTableCache::FileTables& tables)
+    {
+        delete tables.plan;
+        delete tables.file;
+        free(tables.data);
+    }
+
+    const ftTableCache::FileTables* findFileTablesImpl(ftTableCacheState& state,
+                                                       SKuint64           hash,
+                                                       const void*        data,
+                                                       SKsize             length,
+                                                       int                headerFlags,
+                                                       ftTable*           memory)
+    {
+        for (SKsize i = 0; i < state.files.size(); ++i)
+        {
+            const ftTableCache::FileTables* tables = state.files.at(i);
+
+            // The hash only rules out blocks quickly,
+            // an equal block still has to be compared.
+            if (tables->hash == hash &&
+                tables->length == length &&
+                tables->headerFlags == headerFlags &&
+                tables->memory == memory &&
+                memcmp(tables->data, data, length) == 0)
+                return tables;
+        }
+        return nullptr;
+    }
+}  // namespace
+
+SKuint64 ftTableCache::hash(const void* data, const SKsize length)
+{
+    // 64-bit FNV-1a
+    const SKubyte* bytes = (const SKubyte*)data;
+
+    SKuint64 result = 0xCBF29CE484222325ULL;
+    for (SKsize i = 0; i < length; ++i)
+    {
+        result ^= bytes[i];
+        result *= 0x100000001B3ULL;
+    }
+    return result;
+}
+
+ftTable* ftTableCache::findMemoryTable(const void* tableData)
+{
+    ftTableCacheState& state = getState();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    for (SKsize i = 0; i < state.memory.size(); ++i)
+    {
+        if (state.memory.at(i).data == tableData)
+            return state.memory.at(i).table;
+    }
+    return nullptr;
+}
+
+ftTable* ftTableCache::insertMemoryTable(const void* tableData, ftTable* table)
+{
+    ftTableCacheState& state = getState();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    for (SKsize i = 0; i < state.memory.size(); ++i)
+    {
+        if (state.memory.at(i).data == tableData)
+        {
+            delete table;
+            return state.memory.at(i).table;
+        }
+    }
+
+    state.memory.push_back({tableData, table});
+    return table;
+}
+
+const ftTableCache::FileTables* ftTableCache::findFileTables(const void* data,
+                                                             const SKsize length,
+                                                             const int    headerFlags,
+                                                             ftTable*     memory)
+{
+    ftTableCacheState& state = getState();
+
+    const SKuint64 key = hash(data, length);
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return findFileTablesImpl(state, key, data, length, headerFlags, memory);
+}
+
+const ftTableCache::FileTables* ftTableCache::insertFileTables(const FileTables& tables)
+{
+    ftTableCacheState& state = getState();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    const FileTables* found = findFileTablesImpl(state,
+                                                 tables.hash,
+                                                 tables.data,
+                                                 tables.length,
+                                                 tables.headerFlags,
+                                                 tables.memory);
+    if (found)
+    {
+        freeFileTables(tables);
+        return found;
+    }
+
+    FileTables* copy = new FileTables(tables);
+    state.files.push_back(copy);
+    return copy;
+}
+
+void ftTableCache::clear()
+{
+    ftTableCacheState& state = getState();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    for (SKsize i = 0; i < state.files.size(); ++i)
+    {
+        freeFileTables(*state.files.at(i));
+        delete state.files.at(i);
+    }
+    state.files.clear();
+
+    for (SKsize i = 0; i < state.memory.size(); ++i)
+        delete state.memory.at(i).table;
+    state.memory.clear();
+}
@@ -0,0 +1,108 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _ftTableCache_h_
+#define _ftTableCache_h_
+
+#include "ftTypes.h"
+
+class ftTable;
+class ftCastPlan;
+
+/// <summary>
+/// ftTableCache keeps the tables that were built while loading a file,
+/// so that loading another file that was saved with the same DNA can
+/// reuse them instead of reading the tables and matching them again.
+/// </summary>
+/// <remarks>
+/// Memory tables are keyed by the address of the compiled table data.
+/// File tables are keyed by a hash of the DNA1 block, the file's header
+/// flags and the memory table they were matched against. Cached tables
+/// are shared by every file that uses them, and they are not modified
+/// after they are inserted. It is safe to use from multiple threads.
+/// </remarks>
+class ftTableCache
+{
+public:
+    /// <summary>
+    /// Holds a file table and the cast plan from it to a memory table.
+    /// </summary>
+    struct FileTables
+    {
+        SKuint64    hash;
+        SKsize      length;
+        int         headerFlags;
+        ftTable*    memory;
+        void*       data;
+        ftTable*    file;
+        ftCastPlan* plan;
+    };
+
+    /// <summary>
+    /// Computes the key that file tables are stored under.
+    /// </summary>
+    /// <param name="data">The DNA1 block of the file.</param>
+    /// <param name="length">The length of the DNA1 block.</param>
+    static SKuint64 hash(const void* data, SKsize length);
+
+    /// <summary>
+    /// Searches for a memory table that was built from the supplied table data.
+    /// </summary>
+    /// <returns>The cached table or null if it has not been built.</returns>
+    static ftTable* findMemoryTable(const void* tableData);
+
+    /// <summary>
+    /// Stores a memory table for the supplied table data. The cache takes
+    /// ownership of the table. If another thread stored a table for the
+    /// same data first, the supplied table is deleted.
+    /// </summary>
+    /// <returns>The table that should be used.</returns>
+    static ftTable* insertMemoryTable(const void* tableData, ftTable* table);
+
+    /// <summary>
+    /// Searches for a file table that was built from an identical DNA1 block.
+    /// </summary>
+    /// <param name="data">The DNA1 block of the file.</param>
+    /// <param name="length">The length of the DNA1 block.</param>
+    /// <param name="headerFlags">The ftFlags::FileHeader flags of the file.</param>
+    /// <param name="memory">The memory table that the file will be cast to.</param>
+    /// <returns>The cached tables or null if they have not been built.</returns>
+    static const FileTables* findFileTables(const void* data,
+                                            SKsize      length,
+                                            int         headerFlags,
+                                            ftTable*    memory);
+
+    /// <summary>
+    /// Stores the tables that were built from a DNA1 block. The cache takes
+    /// ownership of the block, the table and the plan. If another thread
+    /// stored tables for the same block first, the supplied ones are freed.
+    /// </summary>
+    /// <returns>The tables that should be used.</returns>
+    static const FileTables* insertFileTables(const FileTables& tables);
+
+    /// <summary>
+    /// Frees every cached table. This must not be called while any
+    /// loaded file is still using the cached tables.
+    /// </summary>
+    static void clear();
+};
+
+#endif  //_ftTableCache_h_
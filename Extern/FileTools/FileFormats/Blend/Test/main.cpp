@@ -24,6 +24,7 @@
 #include "ftBlend.h"
 #include "ftLogger.h"
 #include "ftTable.h"
+#include "ftTableCache.h"
 #include "gtest/gtest.h"
 
 using namespace Blender;
@@ -312,3 +313,32 @@ GTEST_TEST(BlendFile, AssertTypes)
         }
     }
 }
+
+GTEST_TEST(BlendFile, CachedTables)
+{
+    ftTableCache::clear();
+    {
+        ftBlend a, b;
+        EXPECT_EQ(FS_OK, a.load("Test.blend"));
+        EXPECT_EQ(FS_OK, b.load("Test.blend"));
+
+        // The second load should reuse the tables of the first.
+        EXPECT_NE(a.getFileTable(), nullptr);
+        EXPECT_EQ(a.getFileTable(), b.getFileTable());
+        EXPECT_EQ(a.getMemoryTable(), b.getMemoryTable());
+
+        BlendFile_TestCommonScene(a.m_fg->curscene);
+        BlendFile_TestCommonScene(b.m_fg->curscene);
+
+        // A file with a different DNA gets its own table.
+        ftBlend c;
+        EXPECT_EQ(FS_OK, c.load("Test1.blend"));
+        EXPECT_NE(a.getFileTable(), c.getFileTable());
+        EXPECT_EQ(a.getMemoryTable(), c.getMemoryTable());
+    }
+    ftTableCache::clear();
+
+    ftBlend fp;
+    EXPECT_EQ(FS_OK, fp.load("Test.blend"));
+    BlendFile_TestCommonScene(fp.m_fg->curscene);
+}
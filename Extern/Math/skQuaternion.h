@@ -227,7 +227,7 @@ public:
 
     SK_INLINE bool operator!=(const skQuaternion& v) const
     {
-        return skNeq(x, v.x) && skNeq(y, v.y) && skNeq(z, v.z) && skNeq(w, v.w);
+        return !(*this == v);
     }
 
     SK_INLINE skScalar length2() const
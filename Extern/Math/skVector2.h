@@ -64,7 +64,7 @@ public:
 
     SK_INLINE bool operator!=(const skVector2& v) const
     {
-        return !skEq(x, v.x) && !skEq(y, v.y);
+        return !(*this == v);
     }
 
     SK_INLINE bool operator<(const skVector2& v) const
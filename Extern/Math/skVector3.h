@@ -84,7 +84,7 @@ public:
 
     SK_INLINE bool operator!=(const skVector3& v) const
     {
-        return !skEq(x, v.x) && !skEq(y, v.y) && !skEq(z, v.z);
+        return !(*this == v);
     }
 
     SK_INLINE skVector3 operator+(skScalar v) const
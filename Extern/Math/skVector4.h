@@ -70,7 +70,7 @@ public:
 
     SK_INLINE bool operator!=(const skVector4& v) const
     {
-        return !skEq(x, v.x) && !skEq(y, v.y) && !skEq(z, v.z) && !skEq(w, v.w);
+        return !(*this == v);
     }
 
     void print() const;
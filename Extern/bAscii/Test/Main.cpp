@@ -22,9 +22,16 @@
 -------------------------------------------------------------------------------
 */
 #include <gtest/gtest.h>
+#include <cstdlib>
+#include <cstring>
+#include <random>
 #include "TestDirectory.h"
 #include "bAscii/bAscii.h"
+#include "bAscii/bAsciiArena.h"
 #include "bAscii/bAsciiBlock.h"
+#include "bAscii/bAsciiKeywords.h"
+#include "bAscii/bAsciiMain.h"
+#include "bAscii/bAsciiNumbers.h"
 #include "bAscii/bAsciiOpCodes.h"
 
 #define VERBOSE false
@@ -38,9 +45,9 @@ GTEST_TEST(Global, T1)
     bAsciiBlock* blk = file.findBlock(LIB_GLOBAL);
     EXPECT_NE(nullptr, blk);
 
-    const bString creator = blk->getString(OP_GLOBAL_CREATOR);
+    const bStringView creator = blk->getString(OP_GLOBAL_CREATOR);
     EXPECT_TRUE(creator.empty());
-    const bString scene = blk->getString(OP_GLOBAL_SCENE);
+    const bStringView scene = blk->getString(OP_GLOBAL_SCENE);
     EXPECT_TRUE(scene.empty());
 }
 
@@ -53,9 +60,9 @@ GTEST_TEST(Global, T2)
     bAsciiBlock* blk = file.findBlock(LIB_GLOBAL);
     EXPECT_NE(nullptr, blk);
 
-    const bString creator = blk->getString(OP_GLOBAL_CREATOR);
+    const bStringView creator = blk->getString(OP_GLOBAL_CREATOR);
     EXPECT_TRUE(creator.equals("Some Valid String"));
-    const bString scene = blk->getString(OP_GLOBAL_SCENE);
+    const bStringView scene = blk->getString(OP_GLOBAL_SCENE);
     EXPECT_TRUE(scene.equals("Active Scene In the scene library"));
     const SKuint32 version = blk->getInt32(OP_GLOBAL_VERSION);
     EXPECT_EQ(123, version);
@@ -139,6 +146,238 @@ GTEST_TEST(SceneLibrary, T1)
 
 }
 
+GTEST_TEST(MeshLibrary, T1)
+{
+    bAscii    file;
+    const int status = file.load(GetTestFilePath("MeshLibrary/T1.bascii"), VERBOSE);
+    EXPECT_EQ(0, status);
+
+    bAsciiBlock* me = file.findBlock("Quad");
+    TestBlockProperties(me,
+                        "Mesh",
+                        LIB_BLOCK_MESH,
+                        "Quad",
+                        file.findBlock(LIB_MESH),
+                        OP_UNDEFINED);
+
+    // Names are copied out of the scanner's buffer and terminated.
+    EXPECT_EQ(0, me->getName().data()[me->getName().size()]);
+
+    bAsciiBlockArray& buffers = me->getChildren();
+    ASSERT_EQ(2, buffers.size());
+
+    const bNumberVector& vertices = buffers[0]->getNumberVector(OP_MESH_VERTEX_VERTICES);
+    ASSERT_EQ(15, vertices.size());
+    EXPECT_EQ(-1.f, vertices[0]);
+    EXPECT_EQ(std::strtof("0.096133", nullptr), vertices[12]);
+    EXPECT_EQ(std::strtof("-0.995185", nullptr), vertices[13]);
+    EXPECT_EQ(std::strtof("12345.678", nullptr), vertices[14]);
+
+    const bIntegerVector& indices = buffers[1]->getIntegerVector(OP_MESH_INDEX_INDICES);
+    ASSERT_EQ(8, indices.size());
+    EXPECT_EQ(3, indices[3]);
+    EXPECT_EQ(4, indices[5]);
+
+    // Integer arrays are not stored as floats, so
+    // this does not round to 16777216.
+    EXPECT_EQ(16777217, buffers[1]->getInt32(OP_MESH_INDEX_FLAGS, 0));
+    EXPECT_EQ(-3, buffers[1]->getInt32(OP_MESH_INDEX_FLAGS, 1));
+}
+
+GTEST_TEST(MeshLibrary, Api)
+{
+    bAscii      file;
+    bAsciiMain* main = file.loadApi(GetTestFilePath("MeshLibrary/T1.bascii"), VERBOSE);
+    ASSERT_NE(nullptr, main);
+
+    bMesh* me = main->getMeshLibrary().find("Quad");
+    ASSERT_NE(nullptr, me);
+    EXPECT_EQ(LIB_BLOCK_MESH, me->type);
+    EXPECT_EQ(main->getMaterialLibrary().find("Red"), me->material);
+    EXPECT_EQ(15, me->vertices.size());
+    EXPECT_EQ(8, me->faces.size());
+
+    bObject* ob = main->getObjectLibrary().find("A");
+    ASSERT_NE(nullptr, ob);
+    EXPECT_EQ(LIB_BLOCK_MESH, ob->type);
+    EXPECT_EQ(me, ob->data);
+    EXPECT_EQ(me->material, ob->material);
+
+    // The object's own material overrides the mesh's.
+    ob = main->getObjectLibrary().find("B");
+    ASSERT_NE(nullptr, ob);
+    EXPECT_EQ(me, ob->data);
+    EXPECT_EQ(main->getMaterialLibrary().find("Blue"), ob->material);
+}
+
+GTEST_TEST(MeshLibrary, InvalidNumber)
+{
+    bAscii    file;
+    const int status = file.load(GetTestFilePath("MeshLibrary/InvalidNumber.bascii"), VERBOSE);
+    EXPECT_EQ(-1, status);
+}
+
+GTEST_TEST(MeshLibrary, InvalidCount)
+{
+    bAscii    file;
+    const int status = file.load(GetTestFilePath("MeshLibrary/InvalidCount.bascii"), VERBOSE);
+    EXPECT_EQ(-1, status);
+}
+
+GTEST_TEST(Keywords, Find)
+{
+    const char* keywords[] = {"Global", "MeshLibrary", "VertexBuffer", "material", "materials", "zenith"};
+    for (const char* keyword : keywords)
+    {
+        const SKint32 id = bAsciiFindKeyword(keyword);
+        EXPECT_NE(-1, id) << keyword;
+
+        // Ids are unique to each keyword.
+        for (const char* other : keywords)
+        {
+            if (strcmp(keyword, other) != 0)
+                EXPECT_NE(id, bAsciiFindKeyword(other)) << keyword << " " << other;
+        }
+    }
+
+    // Only a whole token matches.
+    EXPECT_EQ(-1, bAsciiFindKeyword(""));
+    EXPECT_EQ(-1, bAsciiFindKeyword("global"));
+    EXPECT_EQ(-1, bAsciiFindKeyword("Globals"));
+    EXPECT_EQ(-1, bAsciiFindKeyword(bStringView("Global", 5)));
+}
+
+GTEST_TEST(Arena, Allocate)
+{
+    bAsciiArena arena;
+
+    // Every allocation is aligned for any type, and
+    // small ones follow each other in the same chunk.
+    char*  last     = nullptr;
+    SKsize lastSize = 0;
+    for (SKsize size = 1; size < 200; size += 7)
+    {
+        char* mem = (char*)arena.allocate(size);
+        ASSERT_NE(nullptr, mem);
+        EXPECT_EQ(0, (SKsize)mem % 16) << size;
+        memset(mem, 0xAB, size);
+
+        if (last)
+            EXPECT_TRUE(mem >= last + lastSize) << size;
+        last     = mem;
+        lastSize = size;
+    }
+
+    // A request larger than a chunk gets one of its own, and
+    // the space left in the current chunk is still used.
+    char* big = (char*)arena.allocate(0x40000);
+    ASSERT_NE(nullptr, big);
+    memset(big, 0xCD, 0x40000);
+
+    char* next = (char*)arena.allocate(16);
+    EXPECT_TRUE(next > last);
+    EXPECT_TRUE(next < big || next >= big + 0x40000);
+
+    arena.clear();
+    EXPECT_NE(nullptr, arena.allocate(8));
+}
+
+GTEST_TEST(Arena, Copy)
+{
+    bAsciiArena arena;
+
+    const char* text = "Material: \"Red\"";
+    bStringView view = arena.copy(bStringView(text + 11, 3));
+    ASSERT_EQ(3, view.size());
+    EXPECT_NE(text + 11, view.data());
+    EXPECT_EQ(0, memcmp("Red", view.data(), 3));
+
+    // Copies are terminated, so they can be passed on as C strings.
+    EXPECT_EQ(0, view.data()[3]);
+
+    bStringView empty = arena.copy(bStringView("", 0));
+    EXPECT_EQ(0, empty.size());
+    EXPECT_EQ(0, empty.data()[0]);
+}
+
+void TestParseNumber(const char* str)
+{
+    const SKsize len = strlen(str);
+
+    // The parser expects the terminator to be in the buffer.
+    bString buf(str);
+    buf.append(',');
+
+    bNumber     value;
+    const char* end = bAsciiParseNumber(buf.c_str(), buf.c_str() + buf.size(), value);
+    EXPECT_EQ(buf.c_str() + len, end) << str;
+
+    // Compared bit for bit, so that the sign of zero is checked.
+    const float expected = std::strtof(str, nullptr);
+    EXPECT_EQ(0, memcmp(&expected, &value, sizeof(float))) << str;
+}
+
+GTEST_TEST(Numbers, Parse)
+{
+    const char* tests[] = {
+        "0",
+        "-0",
+        ".",
+        "-.",
+        "1.",
+        ".5",
+        "-.5",
+        "1.2.3",
+        "0.096133",
+        "-0.995185",
+        "16777217",
+        "16777216.5",
+        "123456789012345678901234567890",
+        "0.000000000000000000000000000000000000000001",
+        "340282356779733661637539395458142568448",
+        // exactly halfway between 1 and the next float
+        "1.000000059604644775390625",
+        "1.00000005960464477539062500000000001",
+    };
+
+    for (const char* str : tests)
+        TestParseNumber(str);
+}
+
+GTEST_TEST(Numbers, Random)
+{
+    std::mt19937 rng(1234);
+    for (int i = 0; i < 100000; ++i)
+    {
+        char     str[64];
+        SKuint32 bits = rng();
+
+        float f;
+        memcpy(&f, &bits, sizeof(float));
+        if (f != f || f - f != 0)
+            continue;
+
+        snprintf(str, sizeof str, "%.*f", (int)(rng() % 12), f);
+        TestParseNumber(str);
+    }
+}
+
+GTEST_TEST(Numbers, ParseInteger)
+{
+    const char* tests[] = {"0", "-0", "16777217", "-2147483648", "2147483647", "2.9", "-2.9"};
+    const int   expected[] = {0, 0, 16777217, -2147483647 - 1, 2147483647, 2, -2};
+
+    for (int i = 0; i < 7; ++i)
+    {
+        bString buf(tests[i]);
+        buf.append(';');
+
+        bInteger value;
+        bAsciiParseInteger(buf.c_str(), buf.c_str() + buf.size(), value);
+        EXPECT_EQ(expected[i], value) << tests[i];
+    }
+}
+
 #if 1
 GTEST_TEST(bAscii, BigEndian)
 {
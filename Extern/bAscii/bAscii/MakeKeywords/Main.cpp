@@ -4,43 +4,95 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <unordered_map>
 #include <unordered_set>
-#include "Utils/skHash.h"
+#include "bAsciiKeywords.h"
 
 using namespace std;
-using Pair = pair<string, SKhash>;
 
-int Alpha(const Pair& a, const Pair& b)
+int Alpha(const string& a, const string& b)
 {
-    return a.first < b.first;
+    return a < b;
 }
 
-void writeToStream(vector<Pair> vec, size_t ms, std::ostream& os)
+// Searches for a seed that places every keyword in a different slot.
+bool findSeed(const vector<string>& vec, SKuint32 mask, SKuint32& seed)
+{
+    vector<bool> used;
+    for (seed = 0; seed < 0x100000; ++seed)
+    {
+        used.assign((size_t)mask + 1, false);
+
+        bool collision = false;
+        for (const string& str : vec)
+        {
+            const SKuint32 slot = bAsciiKeywordHash(str.c_str(), str.size(), seed) & mask;
+            if (used[slot])
+            {
+                collision = true;
+                break;
+            }
+            used[slot] = true;
+        }
+
+        if (!collision)
+            return true;
+    }
+    return false;
+}
+
+void writeToStream(const vector<string>& vec, size_t ms, SKuint32 mask, SKuint32 seed, std::ostream& os)
 {
     os << "#pragma once" << endl
        << endl;
     os << "#include \"Utils/skHash.h\"" << endl;
     os << "struct bKey" << endl;
     os << "{" << endl;
-    os << "    const char*  name;" << endl;
-    os << "    const SKhash hash;" << endl;
+    os << "    const char*    name;" << endl;
+    os << "    const SKuint32 length;" << endl;
+    os << "    const SKint32  id;" << endl;
     os << "};" << endl
        << endl;
 
     os << setfill(' ');
-    for (const Pair& pair : vec)
+    for (size_t i = 0; i < vec.size(); ++i)
     {
         os
             << "constexpr bKey KW_"
-            << pair.first << setw(ms - pair.first.size()) << ' '
+            << vec[i] << setw(ms - vec[i].size()) << ' '
             << "= { \""
-            << pair.first
-            << "\", 0x"
-            << uppercase
-            << hex << pair.second
+            << vec[i]
+            << "\", "
+            << dec << vec[i].size()
+            << ", "
+            << i
             << "};" << endl;
     }
+
+    os << endl;
+    os << "constexpr SKuint32 KW_Seed = 0x" << uppercase << hex << seed << ";" << endl;
+    os << "constexpr SKuint32 KW_Mask = 0x" << uppercase << hex << mask << ";" << endl
+       << endl;
+
+    os << "constexpr bKey KW_Keys[] = {" << endl;
+    for (const string& str : vec)
+        os << "    KW_" << str << "," << endl;
+    os << "};" << endl
+       << endl;
+
+    vector<int> slots((size_t)mask + 1, -1);
+    for (size_t i = 0; i < vec.size(); ++i)
+        slots[bAsciiKeywordHash(vec[i].c_str(), vec[i].size(), seed) & mask] = (int)i;
+
+    os << "constexpr SKint16 KW_Slots[] = {" << endl;
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+        if (i % 16 == 0)
+            os << "   ";
+        os << " " << dec << slots[i] << ",";
+        if (i % 16 == 15 || i + 1 == slots.size())
+            os << endl;
+    }
+    os << "};" << endl;
 }
 
 
@@ -60,10 +112,9 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    ifstream                      fs;
-    unordered_map<string, SKhash> sMap;
-    unordered_set<SKhash>         hSet;
-    vector<Pair>                  vec;
+    ifstream               fs;
+    unordered_set<string>  sSet;
+    vector<string>         vec;
 
     fs.open(argv[1]);
 
@@ -81,32 +132,37 @@ int main(int argc, char** argv)
 
             if (!str.empty())
             {
-                if (sMap.find(str) == sMap.end())
+                if (sSet.find(str) == sSet.end())
                 {
-                    const SKhash hash = skHash(str.c_str());
-
-                    if (hSet.find(hash) != hSet.end())
-                        cout << "duplicate hash: " << str << hash << endl;
-                    else
-                    {
-                        sMap.insert(make_pair(str, hash));
-                        hSet.insert(hash);
-                        ms = max(str.size() + 1, ms);
-
-                        vec.emplace_back(str, hash);
-                    }
+                    sSet.insert(str);
+                    ms = max(str.size() + 1, ms);
+                    vec.push_back(str);
                 }
             }
         }
         sort(vec.begin(), vec.end(), Alpha);
 
+        // Keeping the table at least four times larger than the
+        // number of keywords makes a seed quick to find.
+        SKuint32 mask = 1;
+        while (mask < vec.size() * 4)
+            mask <<= 1;
+        mask -= 1;
+
+        SKuint32 seed;
+        if (!findSeed(vec, mask, seed))
+        {
+            cout << "failed to find a seed for the keyword table" << endl;
+            return 1;
+        }
+
         ofstream out;
         out.open("bAsciiKeywords.inl");
 
         if (out.is_open())
-            writeToStream(vec, ms, out);
+            writeToStream(vec, ms, mask, seed, out);
         else
-            writeToStream(vec, ms, cout);
+            writeToStream(vec, ms, mask, seed, cout);
         return 0;
     }
     cout << "failed To open input file" << endl;
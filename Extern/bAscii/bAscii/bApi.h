@@ -116,6 +116,21 @@ struct bPlane : bShape
     bFloat3 normal;
 };
 
+struct bMesh : bShape
+{
+    bMesh() :
+        bShape(LIB_BLOCK_MESH)
+    {
+    }
+
+    // Three numbers per vertex.
+    bNumberVector vertices;
+
+    // Four indices per face. A face is a triangle if its
+    // fourth index is zero, otherwise it is a quad.
+    bIntegerVector faces;
+};
+
 struct bObject
 {
     bObject() :
@@ -41,7 +41,7 @@ bAscii::~bAscii()
     delete m_main;
 }
 
-bAsciiBlock* bAscii::findBlock(const bString& name)
+bAsciiBlock* bAscii::findBlock(const bStringView& name)
 {
     SKsize pos;
     if ((pos = m_findBlocks.find(name)) != SK_NPOS)
@@ -53,10 +53,14 @@ void bAscii::clearParseTree(void)
 {
     // frees the text based memory
 
+    // The blocks live in the arena, but their
+    // children and arguments still need to be freed.
     for (bAsciiBlock* block : m_blocks)
-        delete block;
+        block->~bAsciiBlock();
     m_blocks.clear();
     m_findBlocks.clear();
+    m_codeMapBlocks.clear();
+    m_arena.clear();
 }
 
 void bAscii::addBlock(bAsciiBlock* block)
@@ -65,12 +69,19 @@ void bAscii::addBlock(bAsciiBlock* block)
         m_blocks.push_back(block);
 }
 
-void bAscii::addBlock(const bString& name, bAsciiBlock* block)
+void bAscii::addBlock(const bStringView& name, bAsciiBlock* block)
 {
     if (block)
     {
-        if (m_findBlocks.find(name) == SK_NPOS)
-            m_findBlocks.insert(name, block);
+        const SKsize pos = m_findBlocks.find(name);
+        if (pos != SK_NPOS)
+            block->setName(m_findBlocks.at(pos)->getName());
+        else
+        {
+            const bStringView copy = m_arena.copy(name);
+            block->setName(copy);
+            m_findBlocks.insert(copy, block);
+        }
     }
 }
 
@@ -24,6 +24,7 @@
 #ifndef _bAscii_h_
 #define _bAscii_h_
 
+#include "bAsciiArena.h"
 #include "bAsciiCommon.h"
 
 /// <summary>
@@ -43,6 +44,7 @@ protected:
     bAsciiBlockArray m_blocks;
     bAsciiBlockMap   m_findBlocks;
     bAsciiBlockMapI  m_codeMapBlocks;
+    bAsciiArena      m_arena;
     bool             m_compiled;
 
     friend class bAsciiCompiler;
@@ -52,7 +54,11 @@ protected:
     void clearParseTree();
 
     void addBlock(bAsciiBlock* block);
-    void addBlock(const bString& name, bAsciiBlock* block);
+    /// <summary>
+    /// Names the block and makes it searchable by name. Names are interned
+    /// in the arena, blocks that share a name also share its memory.
+    /// </summary>
+    void addBlock(const bStringView& name, bAsciiBlock* block);
     void addBlock(bCode code, bAsciiBlock* block);
 
 public:
@@ -91,7 +97,7 @@ public:
     ///
     /// bAsciiBlock *block = findBlock("name");
     /// </example>
-    bAsciiBlock* findBlock(const bString& name);
+    bAsciiBlock* findBlock(const bStringView& name);
 
     /// <summary>
     /// Searches for the library block by its predefined code.
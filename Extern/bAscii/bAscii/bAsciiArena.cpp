@@ -0,0 +1,108 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley
+    
+   This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "bAsciiArena.h"
+#include <cstdlib>
+
+namespace
+{
+    const SKsize ChunkSize = 0x10000;
+    const SKsize Alignment = 16;
+
+    SKsize align(const SKsize size)
+    {
+        return (size + (Alignment - 1)) & ~(Alignment - 1);
+    }
+}  // namespace
+
+bAsciiArena::bAsciiArena() :
+    m_chunks(nullptr),
+    m_cur(nullptr),
+    m_end(nullptr)
+{
+}
+
+bAsciiArena::~bAsciiArena()
+{
+    clear();
+}
+
+void* bAsciiArena::allocateChunk(const SKsize size)
+{
+    const SKsize header = align(sizeof(Chunk));
+
+    // Requests that are larger than a chunk get a chunk of their own,
+    // which is linked behind the current one so that the remaining
+    // space in the current chunk is still used.
+    const SKsize capacity = size > ChunkSize / 4 ? size : ChunkSize;
+
+    Chunk* chunk = (Chunk*)malloc(header + capacity);
+    if (!chunk)
+        throw std::bad_alloc();
+
+    chunk->size = capacity;
+    char* base  = (char*)chunk + header;
+
+    if (capacity != ChunkSize && m_chunks)
+    {
+        chunk->next    = m_chunks->next;
+        m_chunks->next = chunk;
+        return base;
+    }
+
+    chunk->next = m_chunks;
+    m_chunks    = chunk;
+    m_cur       = base + size;
+    m_end       = base + capacity;
+    return base;
+}
+
+void* bAsciiArena::allocate(SKsize size)
+{
+    size = align(size > 0 ? size : 1);
+    if ((SKsize)(m_end - m_cur) < size)
+        return allocateChunk(size);
+
+    void* mem = m_cur;
+    m_cur += size;
+    return mem;
+}
+
+bStringView bAsciiArena::copy(const bStringView& str)
+{
+    char* mem = (char*)allocate(str.size() + 1);
+    if (str.size() > 0)
+        memcpy(mem, str.data(), str.size());
+    mem[str.size()] = 0;
+    return {mem, str.size()};
+}
+
+void bAsciiArena::clear()
+{
+    while (m_chunks)
+    {
+        Chunk* next = m_chunks->next;
+        free(m_chunks);
+        m_chunks = next;
+    }
+    m_cur = nullptr;
+    m_end = nullptr;
+}
@@ -0,0 +1,82 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley
+    
+   This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _bAsciiArena_h_
+#define _bAsciiArena_h_
+
+#include <new>
+#include "bAsciiCommon.h"
+
+/// <summary>
+/// A bump allocator for the parse tree. Memory is taken from large chunks
+/// and is only released all at once, so building the tree does not need
+/// an allocation for every block, argument or name.
+/// </summary>
+/// <remarks>
+/// The arena does not call destructors. Objects that own memory outside of
+/// the arena need to be destroyed explicitly before the arena is cleared.
+/// </remarks>
+class bAsciiArena
+{
+private:
+    struct Chunk
+    {
+        Chunk* next;
+        SKsize size;
+    };
+
+    Chunk* m_chunks;
+    char*  m_cur;
+    char*  m_end;
+
+    void* allocateChunk(SKsize size);
+
+public:
+    bAsciiArena();
+    ~bAsciiArena();
+
+    /// <summary>
+    /// Returns uninitialized memory that is aligned for any type.
+    /// </summary>
+    void* allocate(SKsize size);
+
+    /// <summary>
+    /// Copies the characters of str into the arena and terminates them.
+    /// </summary>
+    /// <returns>A view of the copy.</returns>
+    bStringView copy(const bStringView& str);
+
+    /// <summary>
+    /// Constructs a T in memory taken from the arena.
+    /// </summary>
+    template <typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+        return new (allocate(sizeof(T))) T(static_cast<Args&&>(args)...);
+    }
+
+    /// <summary>
+    /// Releases every chunk.
+    /// </summary>
+    void clear();
+};
+
+#endif  //_bAsciiArena_h_
@@ -32,7 +32,8 @@ public:
     bAsciiArgument(const bCode& name, const bCode& type, const int nrArg) :
         name(name),
         type(type),
-        nrArg(nrArg)
+        nrArg(nrArg),
+        next(nullptr)
     {
     }
 
@@ -42,8 +43,14 @@ public:
     const bCode  type;
     const int    nrArg;
     bNumberVector  numbers;
+    bIntegerVector integers;
     bBooleanVector booleans;
     bStringVector strings;
+
+    /// <summary>
+    /// The next argument in the owning block.
+    /// </summary>
+    bAsciiArgument* next;
 };
 
 #endif  //_bAsciiScanner_h_
@@ -24,33 +24,58 @@
 #include "bAsciiBlock.h"
 #include "bAsciiArgument.h"
 
-bAsciiBlock::bAsciiBlock(const bString& type, const bInteger code) :
+bAsciiBlock::bAsciiBlock(const bStringView& type, const bInteger code) :
     m_type(type),
     m_code(code),
     m_len(OP_UNDEFINED),
-    m_parent(nullptr)
+    m_parent(nullptr),
+    m_arguments(nullptr)
 {
 }
 
 bAsciiBlock::~bAsciiBlock()
 {
-    for (SKsize i = 0; i < m_arguments.size(); ++i)
-        delete m_arguments[i];
+    // The arguments are in the arena, only
+    // the memory that they own is freed here.
+    bAsciiArgument* arg = m_arguments;
+    while (arg)
+    {
+        bAsciiArgument* next = arg->next;
+        arg->~bAsciiArgument();
+        arg = next;
+    }
+    m_arguments = nullptr;
 }
 
 bAsciiArgument* bAsciiBlock::getArgument(const bCode& arg)
 {
-    SKsize pos;
-    if ((pos = m_arguments.find(arg)) != SK_NPOS)
-        return m_arguments.at(pos);
-
+    // A block only has a handful of arguments,
+    // so a list is quicker than a table.
+    for (bAsciiArgument* obj = m_arguments; obj; obj = obj->next)
+    {
+        if (obj->name == arg)
+            return obj;
+    }
     return nullptr;
 }
 
+bool bAsciiBlock::hasArgument(const bCode& arg) const
+{
+    for (const bAsciiArgument* obj = m_arguments; obj; obj = obj->next)
+    {
+        if (obj->name == arg)
+            return true;
+    }
+    return false;
+}
+
 void bAsciiBlock::addArgument(bAsciiArgument* argument)
 {
-    if (m_arguments.find(argument->name) == SK_NPOS)
-        m_arguments.insert(argument->name, argument);
+    if (argument && !getArgument(argument->name))
+    {
+        argument->next = m_arguments;
+        m_arguments    = argument;
+    }
 }
 
 bool bAsciiBlock::getBool(const bCode& arg, const SKuint32& idx, bool def)
@@ -64,6 +89,8 @@ bool bAsciiBlock::getBool(const bCode& arg, const SKuint32& idx, bool def)
 SKint16 bAsciiBlock::getInt16(const bCode& arg, const SKuint32& idx, SKint16 def)
 {
     bAsciiArgument* obj = getArgument(arg);
+    if (obj && idx < obj->integers.size())
+        return (SKint16)obj->integers[idx];
     if (obj && idx < obj->numbers.size())
         return (SKint16)obj->numbers[idx];
     return def;
@@ -72,6 +99,8 @@ SKint16 bAsciiBlock::getInt16(const bCode& arg, const SKuint32& idx, SKint16 def
 SKint32 bAsciiBlock::getInt32(const bCode& arg, const SKuint32& idx, SKint32 def)
 {
     bAsciiArgument* obj = getArgument(arg);
+    if (obj && idx < obj->integers.size())
+        return (SKint32)obj->integers[idx];
     if (obj && idx < obj->numbers.size())
         return (SKint32)obj->numbers[idx];
     return def;
@@ -80,6 +109,8 @@ SKint32 bAsciiBlock::getInt32(const bCode& arg, const SKuint32& idx, SKint32 def
 SKuint16 bAsciiBlock::getUint16(const bCode& arg, const SKuint32& idx, SKuint16 def)
 {
     bAsciiArgument* obj = getArgument(arg);
+    if (obj && idx < obj->integers.size())
+        return (SKuint16)obj->integers[idx];
     if (obj && idx < obj->numbers.size())
         return (SKuint16)obj->numbers[idx];
     return def;
@@ -88,6 +119,8 @@ SKuint16 bAsciiBlock::getUint16(const bCode& arg, const SKuint32& idx, SKuint16
 SKuint32 bAsciiBlock::getUint32(const bCode& arg, const SKuint32& idx, SKuint32 def)
 {
     bAsciiArgument* obj = getArgument(arg);
+    if (obj && idx < obj->integers.size())
+        return (SKuint32)obj->integers[idx];
     if (obj && idx < obj->numbers.size())
         return (SKuint32)obj->numbers[idx];
     return def;
@@ -96,6 +129,8 @@ SKuint32 bAsciiBlock::getUint32(const bCode& arg, const SKuint32& idx, SKuint32
 float bAsciiBlock::getFloat(const bCode& arg, const SKuint32& idx, float def)
 {
     bAsciiArgument* obj = getArgument(arg);
+    if (obj && idx < obj->integers.size())
+        return (float)obj->integers[idx];
     if (obj && idx < obj->numbers.size())
         return obj->numbers[idx];
     return def;
@@ -127,8 +162,16 @@ const bNumberVector& bAsciiBlock::getNumberVector(const bCode& arg, const bNumbe
     return def;
 }
 
+const bIntegerVector& bAsciiBlock::getIntegerVector(const bCode& arg, const bIntegerVector& def)
+{
+    bAsciiArgument* obj = getArgument(arg);
+    if (obj)
+        return obj->integers;
+    return def;
+}
+
 
-const bString& bAsciiBlock::getString(const bCode& arg, const SKuint32& idx, const bString& def)
+const bStringView& bAsciiBlock::getString(const bCode& arg, const SKuint32& idx, const bStringView& def)
 {
     bAsciiArgument* obj = getArgument(arg);
     if (obj && idx < obj->strings.size())
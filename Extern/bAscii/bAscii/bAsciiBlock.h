@@ -27,19 +27,24 @@
 #include "bAsciiCommon.h"
 #include "bAsciiOpCodes.h"
 
+/// <summary>
+/// A block in the parse tree. Blocks and their arguments are allocated in the
+/// arena of the bAscii instance that compiled them, and the names they hold
+/// refer to memory in the same arena.
+/// </summary>
 class bAsciiBlock
 {
 protected:
-    const bString     m_type;
+    const bStringView m_type;
     const int         m_code;
-    bString           m_name;
+    bStringView       m_name;
     bInteger          m_len;
     bAsciiBlock*      m_parent;
     bAsciiBlockArray  m_children;
-    bAsciiArgumentMap m_arguments;
+    bAsciiArgument*   m_arguments;
 
 public:
-    bAsciiBlock(const bString& type, bInteger code);
+    bAsciiBlock(const bStringView& type, bInteger code);
     ~bAsciiBlock();
 
     void addArgument(bAsciiArgument* argument);
@@ -62,14 +67,13 @@ public:
 
     const bNumberVector&  getNumberVector(const bCode& arg, const bNumberVector& def = bNumberVector());
 
-    const bString& getString(const bCode& arg, const SKuint32& idx = 0, const bString& def = bString());
+    const bIntegerVector& getIntegerVector(const bCode& arg, const bIntegerVector& def = bIntegerVector());
+
+    const bStringView& getString(const bCode& arg, const SKuint32& idx = 0, const bStringView& def = bStringView());
 
     bAsciiArgument* getArgument(const bCode& arg);
 
-    SK_INLINE bool hasArgument(const bCode& arg) const
-    {
-        return m_arguments.find(arg) != m_arguments.npos;
-    }
+    bool hasArgument(const bCode& arg) const;
 
     void setParent(bAsciiBlock* par);
 
@@ -88,12 +92,12 @@ public:
         return m_children;
     }
 
-    SK_INLINE void setName(const bString& v)
+    SK_INLINE void setName(const bStringView& v)
     {
         m_name = v;
     }
 
-    SK_INLINE const bString& getName() const
+    SK_INLINE const bStringView& getName() const
     {
         return m_name;
     }
@@ -103,7 +107,7 @@ public:
         return m_code;
     }
 
-    SK_INLINE const bString& getTypeName() const
+    SK_INLINE const bStringView& getTypeName() const
     {
         return m_type;
     }
@@ -24,6 +24,7 @@
 #ifndef _bAsciiCommon_h_
 #define _bAsciiCommon_h_
 
+#include <cstring>
 #include "Utils/skMap.h"
 #include "Utils/skString.h"
 
@@ -43,18 +44,98 @@ class bAsciiArgument;
 
 typedef SKuint32 bCode;
 
+// ---------------------------------------------------------------------------
+/// <summary>
+/// A read only reference to a range of characters that is owned elsewhere.
+/// The range is not required to be null terminated.
+/// </summary>
+class bStringView
+{
+private:
+    const char* m_data;
+    SKsize      m_size;
+
+public:
+    bStringView() :
+        m_data(""),
+        m_size(0)
+    {
+    }
+
+    bStringView(const char* str, const SKsize len) :
+        m_data(str),
+        m_size(len)
+    {
+    }
+
+    bStringView(const char* str) :
+        m_data(str ? str : ""),
+        m_size(str ? strlen(str) : 0)
+    {
+    }
+
+    bStringView(const skString& str) :
+        m_data(str.c_str() ? str.c_str() : ""),
+        m_size(str.size())
+    {
+    }
+
+    SK_INLINE const char* data() const
+    {
+        return m_data;
+    }
+
+    SK_INLINE SKsize size() const
+    {
+        return m_size;
+    }
+
+    SK_INLINE bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    SK_INLINE bool equals(const bStringView& rhs) const
+    {
+        return m_size == rhs.m_size && memcmp(m_data, rhs.m_data, m_size) == 0;
+    }
+
+    SK_INLINE bool operator==(const bStringView& rhs) const
+    {
+        return equals(rhs);
+    }
+
+    SK_INLINE bool operator!=(const bStringView& rhs) const
+    {
+        return !equals(rhs);
+    }
+
+    /// <summary>
+    /// Copies the range into a new string.
+    /// </summary>
+    skString toString() const
+    {
+        return m_size > 0 ? skString(m_data, m_size) : skString();
+    }
+};
+
+inline SKhash skHash(const bStringView& key)
+{
+    return skHash(key.data(), key.size());
+}
+
 // ---------------------------------------------------------------------------
 using bString        = skString;
 using bNumber        = float;
 using bInteger       = int;
 using bNumberVector  = skArray<bNumber>;
-using bStringVector  = skArray<bString>;
+using bIntegerVector = skArray<bInteger>;
+using bStringVector  = skArray<bStringView>;
 using bBooleanVector = skArray<bool>;
 
 // ---------------------------------------------------------------------------
 typedef skArray<bAsciiBlock*>                  bAsciiBlockArray;
-typedef skHashTable<SKuint32, bAsciiArgument*> bAsciiArgumentMap;
-typedef skHashTable<skString, bAsciiBlock*>    bAsciiBlockMap;
+typedef skHashTable<bStringView, bAsciiBlock*> bAsciiBlockMap;
 typedef skHashTable<SKuint32, bAsciiBlock*>    bAsciiBlockMapI;
 
 #endif  //_bAsciiCommon_h_
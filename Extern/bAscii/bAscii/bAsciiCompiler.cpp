@@ -24,17 +24,23 @@
 #include "bAsciiCompiler.h"
 #include <cstdio>
 #include <cstdlib>
+#include "Utils/skMinMax.h"
 #include "bAscii.h"
 #include "bAsciiArgument.h"
 #include "bAsciiBlock.h"
 #include "bAsciiKeywords.h"
+#include "bAsciiNumbers.h"
 #include "bAsciiScanner.h"
 
+// Token strings are views into the scanner's buffer,
+// so they are printed with an explicit length.
+#define VIEW_ARGS(str) (int)(str).size(), (str).data()
+
 #define LOG_SCAN(op, tok)                  \
     {                                      \
-        printf("\t==> 0x%02X %s\n", \
+        printf("\t==> 0x%02X %.*s\n",      \
                (unsigned char)(op),        \
-               (tok).string.c_str());      \
+               VIEW_ARGS((tok).string));   \
     }
 
 bAsciiCompiler::bAsciiCompiler(bAscii* parent, bool verbose) :
@@ -57,10 +63,10 @@ bool bAsciiCompiler::compileBlock(bAsciiScanner&     scanner,
 
     if (op != OP_SECTION)
     {
-        printf("%s(%i): expecting sub section ':', found '%s' \n",
+        printf("%s(%i): expecting sub section ':', found '%.*s' \n",
                scanner.getSource(),
                tok.line,
-               tok.string.c_str());
+               VIEW_ARGS(tok.string));
         return false;
     }
 
@@ -76,18 +82,17 @@ bool bAsciiCompiler::compileBlock(bAsciiScanner&     scanner,
         {
             const char* dbg = locals->ctor == OP_STRING ? "string" : "number";
 
-            printf("%s(%i): missing block constructor expected '%s', found '%s' \n",
+            printf("%s(%i): missing block constructor expected '%s', found '%.*s' \n",
                    scanner.getSource(),
                    tok.line,
                    dbg,
-                   tok.string.c_str());
+                   VIEW_ARGS(tok.string));
             return false;
         }
     }
 
     if (op == OP_STRING)
     {
-        parent->setName(tok.string);
         m_parent->addBlock(tok.string, parent);
         op = scanner.scan(tok, m_verbose);
 
@@ -96,7 +101,9 @@ bool bAsciiCompiler::compileBlock(bAsciiScanner&     scanner,
     }
     else if (op == OP_NUMBER)
     {
-        parent->setLength(skChar::toInt32(tok.string));
+        bInteger length;
+        bAsciiParseInteger(tok.string.data(), tok.string.data() + tok.string.size(), length);
+        parent->setLength(length);
         op = scanner.scan(tok, m_verbose);
         if (m_verbose)
             LOG_SCAN(op, tok)
@@ -105,10 +112,10 @@ bool bAsciiCompiler::compileBlock(bAsciiScanner&     scanner,
     // assert
     if (op != OP_BRACKET_OPEN)
     {
-        printf("%s(%i): expecting open bracket '{', found '%s' (%d) \n",
+        printf("%s(%i): expecting open bracket '{', found '%.*s' (%d) \n",
                scanner.getSource(),
                tok.line,
-               tok.string.c_str(),
+               VIEW_ARGS(tok.string),
                op);
         return false;
     }
@@ -125,32 +132,35 @@ bool bAsciiCompiler::compileBlock(bAsciiScanner&     scanner,
 
         if (op != OP_ALPHA)
         {
-            printf("%s(%i): expecting a block or statement, found '%s' \n",
+            printf("%s(%i): expecting a block or statement, found '%.*s' \n",
                    scanner.getSource(),
                    tok.line,
-                   tok.string.c_str());
+                   VIEW_ARGS(tok.string));
             return false;
         }
 
+        const SKint32      id = bAsciiFindKeyword(tok.string);
         const bAsciiLocal* local;
         if (locals)
-            local = bAsciiFindLocal(locals, skHash(tok.string));
+            local = bAsciiFindLocal(locals, id);
         else
-            local = bAsciiFindLocal(globals, skHash(tok.string));
+            local = bAsciiFindLocal(globals, id);
 
         if (!local)
         {
-            printf("%s(%i): invalid keyword '%s' \n",
+            printf("%s(%i): invalid keyword '%.*s' \n",
                    scanner.getSource(),
                    tok.line,
-                   tok.string.c_str());
+                   VIEW_ARGS(tok.string));
             return false;
         }
 
         if (local->types)
         {
             // it's a sub block
-            bAsciiBlock* block = new bAsciiBlock(tok.string, local->op);
+            bAsciiBlock* block = m_parent->m_arena.create<bAsciiBlock>(
+                bStringView(local->name, local->length),
+                local->op);
             block->setParent(parent);
             m_parent->addBlock(block);
 
@@ -159,7 +169,7 @@ bool bAsciiCompiler::compileBlock(bAsciiScanner&     scanner,
         }
         else
         {
-            const bString cTok = tok.string;
+            const bStringView cTok = tok.string;
 
             op = scanner.scan(tok, m_verbose);
             if (m_verbose)
@@ -169,14 +179,23 @@ bool bAsciiCompiler::compileBlock(bAsciiScanner&     scanner,
 
             if (tok.tok != OP_ASSIGNMENT)
             {
-                printf("%s(%i): expecting assignment statement, found '%s' (%d)\n",
+                printf("%s(%i): expecting assignment statement, found '%.*s' (%d)\n",
                        scanner.getSource(),
                        tok.line,
-                       tok.string.c_str(),
+                       VIEW_ARGS(tok.string),
                        tok.tok);
                 return false;
             }
 
+            if (local->type == OP_TYPE_FLOAT_ARRAY || local->type == OP_TYPE_INT_ARRAY)
+            {
+                // Mesh buffers can hold millions of numbers,
+                // so they are not scanned a token at a time.
+                if (!compileNumberArray(scanner, local, parent, cTok))
+                    return false;
+                continue;
+            }
+
             op = scanner.scan(tok, m_verbose);
             if (m_verbose)
                 LOG_SCAN(op, tok)
@@ -197,7 +216,7 @@ bool bAsciiCompiler::compileBlock(bAsciiScanner&     scanner,
                 return false;
             }
 
-            bAsciiArgument* arg = new bAsciiArgument(local->op, local->type, local->argCount);
+            bAsciiArgument* arg = m_parent->m_arena.create<bAsciiArgument>(local->op, local->type, local->argCount);
             parent->addArgument(arg);
 
             int argNr       = 0;
@@ -213,6 +232,14 @@ bool bAsciiCompiler::compileBlock(bAsciiScanner&     scanner,
                     argsToCheck = -1;
             }
 
+            if (argsToCheck > 0 && local->type < OP_TYPE_ARRAY_BEGIN)
+            {
+                if (local->arg == OP_STRING)
+                    arg->strings.reserve((SKsize)argsToCheck);
+                else
+                    arg->numbers.reserve((SKsize)argsToCheck);
+            }
+
             // scan till term
             do
             {
@@ -222,10 +249,10 @@ bool bAsciiCompiler::compileBlock(bAsciiScanner&     scanner,
                     {
                         const char* dbg = local->arg == OP_STRING ? "string(s)" : "number(s)";
 
-                        printf("%s(%i): incorrect number of arguments to '%s', expected '%i' %s.\n",
+                        printf("%s(%i): incorrect number of arguments to '%.*s', expected '%i' %s.\n",
                                scanner.getSource(),
                                tok.line,
-                               cTok.c_str(),
+                               VIEW_ARGS(cTok),
                                argsToCheck,
                                dbg);
                         return false;
@@ -236,10 +263,10 @@ bool bAsciiCompiler::compileBlock(bAsciiScanner&     scanner,
                 {
                     if (local->arg != OP_STRING && local->type != OP_TYPE_MIXED)
                     {
-                        printf("%s(%i): invalid string argument to '%s', expected %i number(s).\n",
+                        printf("%s(%i): invalid string argument to '%.*s', expected %i number(s).\n",
                                scanner.getSource(),
                                tok.line,
-                               cTok.c_str(),
+                               VIEW_ARGS(cTok),
                                argsToCheck);
                         return false;
                     }
@@ -249,10 +276,10 @@ bool bAsciiCompiler::compileBlock(bAsciiScanner&     scanner,
                 {
                     if (local->arg != OP_NUMBER && local->type != OP_TYPE_MIXED)
                     {
-                        printf("%s(%i): invalid string argument to '%s', expected %i string(s).\n",
+                        printf("%s(%i): invalid string argument to '%.*s', expected %i string(s).\n",
                                scanner.getSource(),
                                tok.line,
-                               cTok.c_str(),
+                               VIEW_ARGS(cTok),
                                argsToCheck);
                         return false;
                     }
@@ -260,22 +287,24 @@ bool bAsciiCompiler::compileBlock(bAsciiScanner&     scanner,
 
                 if (op == OP_STRING || op == OP_ALPHA)
                 {
-                    arg->strings.push_back(tok.string);
+                    arg->strings.push_back(m_parent->m_arena.copy(tok.string));
                     argNr++;
                 }
                 else if (op == OP_NUMBER)
                 {
-                    arg->numbers.push_back(skChar::toFloat(tok.string));
+                    bNumber value;
+                    bAsciiParseNumber(tok.string.data(), tok.string.data() + tok.string.size(), value);
+                    arg->numbers.push_back(value);
                     argNr++;
                 }
                 else
                 {
                     if (op != OP_TERM && op != OP_SEPARATOR)
                     {
-                        printf("%s(%i): expecting ',' or ';', found '%s' \n",
+                        printf("%s(%i): expecting ',' or ';', found '%.*s' \n",
                                scanner.getSource(),
                                tok.line,
-                               tok.string.c_str());
+                               VIEW_ARGS(tok.string));
                         return false;
                     }
 
@@ -304,10 +333,10 @@ bool bAsciiCompiler::compileBlock(bAsciiScanner&     scanner,
 
             if (local->maxArgCount != -1 && argNr > local->maxArgCount)
             {
-                printf("%s(%i): maximum arguments exceeded for %s, max is %i, found %i.\n",
+                printf("%s(%i): maximum arguments exceeded for %.*s, max is %i, found %i.\n",
                        scanner.getSource(),
                        tok.line,
-                       cTok.c_str(),
+                       VIEW_ARGS(cTok),
                        local->maxArgCount,
                        argNr);
                 return false;
@@ -316,11 +345,11 @@ bool bAsciiCompiler::compileBlock(bAsciiScanner&     scanner,
             if (argsToCheck != -1 && argNr != argsToCheck)
             {
                 printf(
-                    "%s(%i): the required number of arguments for '%s' is %i."
+                    "%s(%i): the required number of arguments for '%.*s' is %i."
                     " found %i argument(s).\n",
                     scanner.getSource(),
                     tok.line,
-                    cTok.c_str(),
+                    VIEW_ARGS(cTok),
                     argsToCheck,
                     argNr);
                 return false;
@@ -330,6 +359,118 @@ bool bAsciiCompiler::compileBlock(bAsciiScanner&     scanner,
     return true;
 }
 
+bool bAsciiCompiler::compileNumberArray(bAsciiScanner&     scanner,
+                                        const bAsciiLocal* local,
+                                        bAsciiBlock*       parent,
+                                        const bStringView& name) const
+{
+    bAsciiArgument* arg = m_parent->m_arena.create<bAsciiArgument>(local->op, local->type, local->argCount);
+    parent->addArgument(arg);
+
+    int argsToCheck = local->argCount;
+    if (argsToCheck != -1)
+    {
+        // nrArg then becomes the stride
+        const int pLen = (int)parent->getLength();
+        if (pLen != -1)
+            argsToCheck *= pLen;
+        else
+            argsToCheck = -1;
+    }
+
+    // Each number takes at least two characters, which
+    // limits how much a bad length can reserve.
+    SKuint32 reserve = 0;
+    if (argsToCheck > 0)
+        reserve = skMin<SKuint32>((SKuint32)argsToCheck, scanner.getRemaining() / 2 + 1);
+
+    bAsciiToken tok;
+    bCode       op;
+    int         argNr;
+    if (local->type == OP_TYPE_INT_ARRAY)
+    {
+        if (reserve > 0)
+            arg->integers.reserve(reserve);
+
+        op    = scanner.scanIntegers(arg->integers, tok, m_verbose);
+        argNr = (int)arg->integers.size();
+    }
+    else
+    {
+        if (reserve > 0)
+            arg->numbers.reserve(reserve);
+
+        op    = scanner.scanNumbers(arg->numbers, tok, m_verbose);
+        argNr = (int)arg->numbers.size();
+    }
+
+    if (m_verbose)
+    {
+        printf("\t==> %i number(s)\n", argNr);
+        LOG_SCAN(op, tok)
+    }
+
+    if (op == OP_END)
+    {
+        printf("%s(%i): end of file found while scanning assignment statement.\n",
+               scanner.getSource(),
+               tok.line);
+        return false;
+    }
+
+    if (op == OP_STRING || op == OP_ALPHA)
+    {
+        printf("%s(%i): invalid string argument to '%.*s', expected %i number(s).\n",
+               scanner.getSource(),
+               tok.line,
+               VIEW_ARGS(name),
+               argsToCheck);
+        return false;
+    }
+
+    if (op != OP_TERM)
+    {
+        printf("%s(%i): expecting ',' or ';', found '%.*s' \n",
+               scanner.getSource(),
+               tok.line,
+               VIEW_ARGS(tok.string));
+        return false;
+    }
+
+    if (argNr == 0)
+    {
+        printf("%s(%i): empty assignment statement.\n",
+               scanner.getSource(),
+               tok.line);
+        return false;
+    }
+
+    if (local->maxArgCount != -1 && argNr > local->maxArgCount)
+    {
+        printf("%s(%i): maximum arguments exceeded for %.*s, max is %i, found %i.\n",
+               scanner.getSource(),
+               tok.line,
+               VIEW_ARGS(name),
+               local->maxArgCount,
+               argNr);
+        return false;
+    }
+
+    if (argsToCheck != -1 && argNr != argsToCheck)
+    {
+        printf(
+            "%s(%i): the required number of arguments for '%.*s' is %i."
+            " found %i argument(s).\n",
+            scanner.getSource(),
+            tok.line,
+            VIEW_ARGS(name),
+            argsToCheck,
+            argNr);
+        return false;
+    }
+    return true;
+}
+
 bool bAsciiCompiler::compile(bAsciiScanner& scanner) const
 {
     bAsciiToken tok;
@@ -346,34 +487,36 @@ bool bAsciiCompiler::compile(bAsciiScanner& scanner) const
 
         if (op == OP_UNKNOWN)
         {
-            printf("%s(%i): unknown error, '%s' \n",
+            printf("%s(%i): unknown error, '%.*s' \n",
                    scanner.getSource(),
                    tok.line,
-                   tok.string.c_str());
+                   VIEW_ARGS(tok.string));
             return false;
         }
 
         // looking for top level start block OP_ALPHA
         if (op != OP_ALPHA)
         {
-            printf("%s(%i): expecting start block, found '%s' \n",
+            printf("%s(%i): expecting start block, found '%.*s' \n",
                    scanner.getSource(),
                    tok.line,
-                   tok.string.c_str());
+                   VIEW_ARGS(tok.string));
             return false;
         }
 
-        const bAsciiLocal* global = bAsciiFindGlobal(skHash(tok.string));
+        const bAsciiLocal* global = bAsciiFindGlobal(bAsciiFindKeyword(tok.string));
         if (!global || global->op == OP_UNKNOWN)
         {
-            printf("%s(%i): unknown block '%s' \n",
+            printf("%s(%i): unknown block '%.*s' \n",
                    scanner.getSource(),
                    tok.line,
-                   tok.string.c_str());
+                   VIEW_ARGS(tok.string));
             return false;
         }
 
-        bAsciiBlock* block = new bAsciiBlock(tok.string, global->op);
+        bAsciiBlock* block = m_parent->m_arena.create<bAsciiBlock>(
+            bStringView(global->name, global->length),
+            global->op);
         m_parent->addBlock(block);
         m_parent->addBlock(global->op, block);
 
@@ -39,6 +39,11 @@ protected:
                       const bAsciiLocal* locals,
                       bAsciiBlock*       parent) const;
 
+    bool compileNumberArray(bAsciiScanner&     scanner,
+                            const bAsciiLocal* local,
+                            bAsciiBlock*       parent,
+                            const bStringView& name) const;
+
 public:
     bAsciiCompiler(bAscii* parent, bool verbose);
     ~bAsciiCompiler() = default;
@@ -22,12 +22,14 @@
 -------------------------------------------------------------------------------
 */
 #include "bAsciiKeywords.h"
+#include <cstring>
 #include "bAsciiKeywords.inl"
 #include "bAsciiOpCodes.h"
 
 constexpr bAsciiLocal NullRecord = {
     nullptr,
-    SK_NPOS,
+    0,
+    -1,
     OP_UNKNOWN,
     OP_UNKNOWN,
     OP_UNKNOWN,
@@ -43,7 +45,8 @@ constexpr bAsciiLocal MakeStruct(const bKey         key,
 {
     return {
         key.name,
-        key.hash,
+        key.length,
+        key.id,
         op,
         OP_STRING,
         OP_UNKNOWN,
@@ -59,63 +62,63 @@ constexpr bAsciiLocal MakeStruct(const bKey         key,
                                  bCode              constructor,
                                  const bAsciiLocal* libs)
 {
-    return {key.name, key.hash, op, constructor, OP_UNKNOWN, OP_TYPE_STRUCT, -1, -1, libs};
+    return {key.name, key.length, key.id, op, constructor, OP_UNKNOWN, OP_TYPE_STRUCT, -1, -1, libs};
 }
 constexpr bAsciiLocal MakeStringArray(const bKey key,
                                       bCode      op,
                                       int        args    = -1,
                                       int        maxArgs = -1)
 {
-    return {key.name, key.hash, op, OP_UNKNOWN, OP_STRING, OP_TYPE_STRING_ARRAY, args, maxArgs, nullptr};
+    return {key.name, key.length, key.id, op, OP_UNKNOWN, OP_STRING, OP_TYPE_STRING_ARRAY, args, maxArgs, nullptr};
 }
 
 constexpr bAsciiLocal MakeBool(const bKey key, bCode op)
 {
-    return {key.name, key.hash, op, OP_UNKNOWN, OP_NUMBER, OP_TYPE_BOOL, 1, 1, nullptr};
+    return {key.name, key.length, key.id, op, OP_UNKNOWN, OP_NUMBER, OP_TYPE_BOOL, 1, 1, nullptr};
 }
 
 constexpr bAsciiLocal MakeFloat(const bKey key, bCode op)
 {
-    return {key.name, key.hash, op, OP_UNKNOWN, OP_NUMBER, OP_TYPE_FLOAT, 1, 1, nullptr};
+    return {key.name, key.length, key.id, op, OP_UNKNOWN, OP_NUMBER, OP_TYPE_FLOAT, 1, 1, nullptr};
 }
 
 constexpr bAsciiLocal MakeFloat2(const bKey key, bCode op)
 {
-    return {key.name, key.hash, op, OP_UNKNOWN, OP_NUMBER, OP_TYPE_FLOAT2, 2, 2, nullptr};
+    return {key.name, key.length, key.id, op, OP_UNKNOWN, OP_NUMBER, OP_TYPE_FLOAT2, 2, 2, nullptr};
 }
 
 constexpr bAsciiLocal MakeFloat3(const bKey key, bCode op)
 {
-    return {key.name, key.hash, op, OP_UNKNOWN, OP_NUMBER, OP_TYPE_FLOAT3, 3, 3, nullptr};
+    return {key.name, key.length, key.id, op, OP_UNKNOWN, OP_NUMBER, OP_TYPE_FLOAT3, 3, 3, nullptr};
 }
 
 constexpr bAsciiLocal MakeFloat16(const bKey key, bCode op)
 {
-    return {key.name, key.hash, op, OP_UNKNOWN, OP_NUMBER, OP_TYPE_FLOAT16, 16, 16, nullptr};
+    return {key.name, key.length, key.id, op, OP_UNKNOWN, OP_NUMBER, OP_TYPE_FLOAT16, 16, 16, nullptr};
 }
 
 constexpr bAsciiLocal MakeFloatArray(const bKey key,
                                      bCode      op,
                                      SKint32    stride = -1)
 {
-    return {key.name, key.hash, op, OP_UNKNOWN, OP_NUMBER, OP_TYPE_FLOAT_ARRAY, stride, -1, nullptr};
+    return {key.name, key.length, key.id, op, OP_UNKNOWN, OP_NUMBER, OP_TYPE_FLOAT_ARRAY, stride, -1, nullptr};
 }
 
 constexpr bAsciiLocal MakeInt(const bKey key, bCode op)
 {
-    return {key.name, key.hash, op, OP_UNKNOWN, OP_NUMBER, OP_TYPE_INT, 1, 1, nullptr};
+    return {key.name, key.length, key.id, op, OP_UNKNOWN, OP_NUMBER, OP_TYPE_INT, 1, 1, nullptr};
 }
 
 constexpr bAsciiLocal MakeIntArray(const bKey key,
                                    bCode      op,
                                    SKint32    stride = -1)
 {
-    return {key.name, key.hash, op, OP_UNKNOWN, OP_NUMBER, OP_TYPE_INT_ARRAY, stride, -1, nullptr};
+    return {key.name, key.length, key.id, op, OP_UNKNOWN, OP_NUMBER, OP_TYPE_INT_ARRAY, stride, -1, nullptr};
 }
 
 constexpr bAsciiLocal MakeString(const bKey key, bCode op)
 {
-    return {key.name, key.hash, op, OP_UNKNOWN, OP_STRING, OP_TYPE_STRING, 1, 1, nullptr};
+    return {key.name, key.length, key.id, op, OP_UNKNOWN, OP_STRING, OP_TYPE_STRING, 1, 1, nullptr};
 }
 
 // Global Tables
@@ -286,27 +289,41 @@ constexpr bAsciiLocal bAsciiGlobals[] = {
     NullRecord,
 };
 
-const bAsciiLocal* bAsciiFindGlobal(SKhash code)
+SKint32 bAsciiFindKeyword(const bStringView& str)
+{
+    const SKuint32 slot = bAsciiKeywordHash(str.data(), str.size(), KW_Seed) & KW_Mask;
+
+    const SKint32 id = KW_Slots[slot];
+    if (id != -1)
+    {
+        const bKey& key = KW_Keys[id];
+        if (key.length == str.size() && memcmp(key.name, str.data(), str.size()) == 0)
+            return id;
+    }
+    return -1;
+}
+
+const bAsciiLocal* bAsciiFindGlobal(SKint32 id)
 {
     const bAsciiLocal* type = bAsciiGlobals;
 
     while (type && type->name)
     {
-        if (type->hash == code)
+        if (type->id == id)
             return type;
         ++type;
     }
     return nullptr;
 }
 
-const bAsciiLocal* bAsciiFindLocal(const bAsciiLocal* st, SKhash code)
+const bAsciiLocal* bAsciiFindLocal(const bAsciiLocal* st, SKint32 id)
 {
     if (st && st->types)
     {
         const bAsciiLocal* l = st->types;
         while (l && l->name)
         {
-            if (l->hash == code)
+            if (l->id == id)
                 return l;
             ++l;
         }
@@ -27,10 +27,28 @@
 #include "bAsciiCommon.h"
 #define BASCII_VERSION 1
 
+/// <summary>
+/// The hash that the keyword table is built with. MakeKeywords searches for
+/// a seed that gives every keyword a different slot in the table, so a
+/// lookup only needs to hash the token and compare it with one keyword.
+/// </summary>
+inline SKuint32 bAsciiKeywordHash(const char* str, const SKsize len, const SKuint32 seed)
+{
+    // 32-bit FNV-1a
+    SKuint32 hash = 0x811C9DC5 ^ seed;
+    for (SKsize i = 0; i < len; ++i)
+    {
+        hash ^= (SKubyte)str[i];
+        hash *= 0x01000193;
+    }
+    return hash ^ (hash >> 16);
+}
+
 struct bAsciiLocal
 {
     const char*        name;
-    SKhash             hash;
+    SKuint32           length;
+    SKint32            id;
     bCode              op;
     bCode              ctor;
     bCode              arg;
@@ -40,8 +58,14 @@ struct bAsciiLocal
     const bAsciiLocal* types;
 };
 
-extern const bAsciiLocal* bAsciiFindGlobal(SKhash code);
-extern const bAsciiLocal* bAsciiFindLocal(const bAsciiLocal* st, SKhash code);
+/// <summary>
+/// Looks up the keyword that matches the supplied token.
+/// </summary>
+/// <returns>The id of the keyword or -1 if the token is not a keyword.</returns>
+extern SKint32 bAsciiFindKeyword(const bStringView& str);
+
+extern const bAsciiLocal* bAsciiFindGlobal(SKint32 id);
+extern const bAsciiLocal* bAsciiFindLocal(const bAsciiLocal* st, SKint32 id);
 
 
 #endif  //_bAsciiKeywords_h_
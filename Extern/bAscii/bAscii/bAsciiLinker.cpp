@@ -103,9 +103,9 @@ int bAsciiLinker::link(bAscii* parent, bAsciiMain* main, bool verbose)
     lib = m_parent->findBlock(LIB_GLOBAL);
     if (lib)
     {
-        m_main->m_creator = lib->getString(OP_GLOBAL_CREATOR, 0);
+        m_main->m_creator = lib->getString(OP_GLOBAL_CREATOR, 0).toString();
         m_main->m_version = lib->getInt32(OP_GLOBAL_VERSION, 0);
-        m_main->m_scene   = m_main->getSceneLibrary().find(lib->getString(OP_GLOBAL_SCENE, 0));
+        m_main->m_scene   = m_main->getSceneLibrary().find(lib->getString(OP_GLOBAL_SCENE, 0).toString());
     }
 
     return 0;
@@ -127,7 +127,7 @@ void bAsciiLinker::linkCamera(bAsciiBlock* lib) const
         ob->limits[1]   = obj->getFloat(OP_CAMERA_CLIP, 1, 1000);
         ob->fov         = obj->getFloat(OP_CAMERA_FOV, 0, 45);
         ob->interactive = obj->hasArgument(OP_CAMERA_INTERACTIVE);
-        m_main->getCameraLibrary().insert(obj->getName(), ob);
+        m_main->getCameraLibrary().insert(obj->getName().toString(), ob);
     }
 }
 
@@ -153,7 +153,7 @@ void bAsciiLinker::linkLight(bAsciiBlock* lib) const
 
         obj->getFloatVector(ob->color, OP_LIGHT_COLOR, 0, 3);
 
-        m_main->getLightLibrary().insert(obj->getName(), ob);
+        m_main->getLightLibrary().insert(obj->getName().toString(), ob);
     }
 }
 
@@ -200,19 +200,47 @@ void bAsciiLinker::linkShape(bAsciiBlock* lib) const
         if (ob != nullptr)
         {
             ob->material = m_main->getMaterialLibrary().find(
-                obj->getString(OP_OBJECT_MATERIAL));
-            m_main->getShapeLibrary().insert(obj->getName(), ob);
+                obj->getString(OP_OBJECT_MATERIAL).toString());
+            m_main->getShapeLibrary().insert(obj->getName().toString(), ob);
         }
     }
 }
 
 void bAsciiLinker::linkMesh(bAsciiBlock* lib) const
 {
+    bAsciiBlockArray& children = lib->getChildren();
+    for (bAsciiBlock* obj : children)
+    {
+        if (obj->getType() != LIB_BLOCK_MESH)
+        {
+            printf("Mesh block mis-match\n");
+            continue;
+        }
+
+        bMesh* me = new bMesh();
+
+        // Only the first material is used, the
+        // per face material indices are ignored.
+        me->material = m_main->getMaterialLibrary().find(
+            obj->getString(OP_MESH_MATERIALS).toString());
+
+        bAsciiBlockArray& buffers = obj->getChildren();
+        for (bAsciiBlock* buf : buffers)
+        {
+            if (buf->getType() == OP_MESH_VERTEX_BUFFER)
+                me->vertices = buf->getNumberVector(OP_MESH_VERTEX_VERTICES);
+            else if (buf->getType() == OP_MESH_INDEX_BUFFER)
+                me->faces = buf->getIntegerVector(OP_MESH_INDEX_INDICES);
+        }
+
+        m_main->getMeshLibrary().insert(obj->getName().toString(), me);
+    }
 }
 
 void bAsciiLinker::resolveData(const bString& string, bObject* ob) const
 {
     bShape*  sh;
+    bMesh*   me;
     bLight*  li;
     bCamera* ca;
     if ((ca = m_main->getCameraLibrary().find(string)) != nullptr)
@@ -227,9 +255,19 @@ void bAsciiLinker::resolveData(const bString& string, bObject* ob) const
     }
     else if ((sh = m_main->getShapeLibrary().find(string)) != nullptr)
     {
-        ob->type     = sh->type;
-        ob->data     = sh;
-        ob->material = sh->material;
+        // A material given on the object overrides the data's,
+        // so objects that share a shape can still differ.
+        ob->type = sh->type;
+        ob->data = sh;
+        if (!ob->material)
+            ob->material = sh->material;
+    }
+    else if ((me = m_main->getMeshLibrary().find(string)) != nullptr)
+    {
+        ob->type = me->type;
+        ob->data = me;
+        if (!ob->material)
+            ob->material = me->material;
     }
     else
     {
@@ -252,17 +290,17 @@ void bAsciiLinker::linkObject(bAsciiBlock* lib) const
 
         bObject* ob = new bObject();
 
-        ob->type               = type;
-        ob->material           = m_main->getMaterialLibrary().find(obj->getString(OP_OBJECT_MATERIAL));
-        const bString& libData = obj->getString(OP_OBJECT_LIB);
+        ob->type                   = type;
+        ob->material               = m_main->getMaterialLibrary().find(obj->getString(OP_OBJECT_MATERIAL).toString());
+        const bStringView& libData = obj->getString(OP_OBJECT_LIB);
         if (!libData.empty())
-            resolveData(libData, ob);
+            resolveData(libData.toString(), ob);
 
         obj->getFloatVector(ob->location, OP_OBJECT_LOCATION, 0, 3);
         obj->getFloatVector(ob->rotation, OP_OBJECT_ROTATION, 0, 3);
         obj->getFloatVector(ob->scale, OP_OBJECT_SCALE, 0, 3);
 
-        m_main->getObjectLibrary().insert(obj->getName(), ob);
+        m_main->getObjectLibrary().insert(obj->getName().toString(), ob);
     }
 }
 
@@ -285,7 +323,7 @@ void bAsciiLinker::linkMaterial(bAsciiBlock* lib) const
         ob->flags     = obj->getInt32(OP_MATERIAL_FLAGS, 0, bMaterial::LIGHTING);
         obj->getFloatVector(ob->color, OP_MATERIAL_COLOR, 0, 3);
 
-        m_main->getMaterialLibrary().insert(obj->getName(), ob);
+        m_main->getMaterialLibrary().insert(obj->getName().toString(), ob);
     }
 }
 
@@ -315,16 +353,16 @@ void bAsciiLinker::linkScene(bAsciiBlock* lib) const
             ob->objects     = new bObjectPtr[(SKsize)scObj->strings.size() + 1];
             ob->objectCount = 0;
 
-            for (const bString& objName : scObj->strings)
+            for (const bStringView& objName : scObj->strings)
             {
-                bObject* lob = m_main->getObjectLibrary().find(objName);
+                bObject* lob = m_main->getObjectLibrary().find(objName.toString());
                 if (lob != nullptr)
                     ob->objects[ob->objectCount++] = lob;
                 else
-                    printf("Failed to find object '%s'\n", objName.c_str());
+                    printf("Failed to find object '%.*s'\n", (int)objName.size(), objName.data());
             }
         }
 
-        m_main->getSceneLibrary().insert(obj->getName(), ob);
+        m_main->getSceneLibrary().insert(obj->getName().toString(), ob);
     }
 }
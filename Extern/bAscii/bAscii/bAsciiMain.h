@@ -99,6 +99,7 @@ public:
     typedef bAsciiApiStorage<bScene>    SceneLibrary;
     typedef bAsciiApiStorage<bMaterial> MaterialLibrary;
     typedef bAsciiApiStorage<bShape>    ShapeLibrary;
+    typedef bAsciiApiStorage<bMesh>     MeshLibrary;
 
 private:
     bScene* m_scene;
@@ -113,6 +114,7 @@ private:
     SceneLibrary    m_scenes;
     MaterialLibrary m_materials;
     ShapeLibrary    m_shapes;
+    MeshLibrary     m_meshes;
 
 public:
     explicit bAsciiMain() :
@@ -153,6 +155,11 @@ public:
         return m_shapes;
     }
 
+    SK_INLINE MeshLibrary& getMeshLibrary()
+    {
+        return m_meshes;
+    }
+
     SK_INLINE bScene* getActiveScene() const
     {
         return m_scene;
@@ -0,0 +1,255 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley
+    
+   This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "bAsciiNumbers.h"
+#include <cfloat>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    // Powers of ten that are exact in a double.
+    const double Powers[] = {
+        1e0,
+        1e1,
+        1e2,
+        1e3,
+        1e4,
+        1e5,
+        1e6,
+        1e7,
+        1e8,
+        1e9,
+        1e10,
+        1e11,
+        1e12,
+        1e13,
+        1e14,
+        1e15,
+        1e16,
+        1e17,
+        1e18,
+        1e19,
+        1e20,
+        1e21,
+        1e22,
+    };
+
+    const int      MaxExactPower    = 22;
+    const SKuint64 MaxExactMantissa = 1ULL << 53;
+
+    struct bAsciiDecimal
+    {
+        SKuint64 mantissa;
+        int      exponent;
+        bool     negative;
+        bool     truncated;
+        bool     empty;
+    };
+
+    SK_INLINE bool isDigit(const char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+#if SK_ENDIAN == SK_ENDIAN_LITTLE
+    const SKuint64 DigitPowers[] = {
+        1,
+        10,
+        100,
+        1000,
+        10000,
+        100000,
+        1000000,
+        10000000,
+        100000000,
+    };
+
+    // Counts the digits at the start of eight characters. A byte is a digit if its
+    // high nibble is 3 and adding 6 to it does not carry out of the low nibble.
+    // A carry out of a byte only comes from a byte that is not a digit, so it
+    // cannot change the bytes before the first one that is not a digit.
+    SK_INLINE int countDigits(const SKuint64 v)
+    {
+        const SKuint64 nonDigits = ((v & 0xF0F0F0F0F0F0F0F0ULL) |
+                                    ((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4) ^
+                                   0x3333333333333333ULL;
+
+        // Sets every bit below the first character that is not a digit,
+        // then counts the bytes that are completely set.
+        const SKuint64 below = (nonDigits & (~nonDigits + 1)) - 1;
+        return (int)((((below >> 7) & 0x0101010101010101ULL) * 0x0101010101010101ULL) >> 56);
+    }
+
+    // Converts the first n digits of eight characters at once. The digits are
+    // moved to the end and padded with leading zeros, then pairs of digits are
+    // combined, then pairs of pairs, with the first character in the lowest byte.
+    SK_INLINE SKuint64 parseDigits(SKuint64 v, const int n)
+    {
+        if (n < 8)
+            v = v << (8 * (8 - n)) | 0x3030303030303030ULL >> (8 * n);
+
+        v -= 0x3030303030303030ULL;
+        v = v * 10 + (v >> 8);
+        v = ((v & 0x000000FF000000FFULL) * 0x000F424000000064ULL +
+             ((v >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL) >>
+            32;
+        return v & 0xFFFFFFFF;
+    }
+#endif
+
+    // Reads the digits of a number into a 64-bit mantissa and a power of ten.
+    // Digits that no longer fit in the mantissa mark the decimal as truncated.
+    // As with strtof, anything after a second decimal point is ignored.
+    const char* scanDecimal(const char* src, const char* end, bAsciiDecimal& dest)
+    {
+        dest.mantissa  = 0;
+        dest.exponent  = 0;
+        dest.negative  = false;
+        dest.truncated = false;
+        dest.empty     = true;
+
+        const char* p = src;
+        if (p < end && *p == '-')
+        {
+            dest.negative = true;
+            ++p;
+        }
+
+        bool fraction = false, ignore = false;
+        while (p < end)
+        {
+#if SK_ENDIAN == SK_ENDIAN_LITTLE
+            if (!ignore && end - p >= 8 && dest.mantissa < 100000000000ULL)
+            {
+                SKuint64 v;
+                memcpy(&v, p, 8);
+
+                const int n = countDigits(v);
+                if (n > 0)
+                {
+                    dest.mantissa = dest.mantissa * DigitPowers[n] + parseDigits(v, n);
+                    if (fraction)
+                        dest.exponent -= n;
+                    dest.empty = false;
+
+                    p += n;
+                    if (n == 8)
+                        continue;
+                }
+            }
+#endif
+            const char c = *p;
+            if (isDigit(c))
+            {
+                if (!ignore && dest.mantissa < 1000000000000000000ULL)
+                {
+                    dest.mantissa = dest.mantissa * 10 + (SKuint64)(c - '0');
+                    if (fraction)
+                        --dest.exponent;
+                }
+                else if (!ignore)
+                {
+                    dest.truncated = true;
+                    if (!fraction)
+                        ++dest.exponent;
+                }
+                dest.empty = false;
+            }
+            else if (c == '.')
+            {
+                if (fraction)
+                    ignore = true;
+                fraction = true;
+            }
+            else
+                break;
+            ++p;
+        }
+        return p;
+    }
+
+    float toFloat(const bAsciiDecimal& dec, const char* src)
+    {
+        // strtof does not convert a sign or a point
+        // without any digits, so neither is negative.
+        if (dec.empty)
+            return 0.f;
+        if (dec.mantissa == 0 && !dec.truncated)
+            return dec.negative ? -0.f : 0.f;
+
+        if (!dec.truncated &&
+            dec.mantissa <= MaxExactMantissa &&
+            dec.exponent >= -MaxExactPower &&
+            dec.exponent <= MaxExactPower)
+        {
+            // The mantissa and the power are both exact, so the
+            // division or multiplication is rounded only once.
+            double v = (double)dec.mantissa;
+            if (dec.exponent < 0)
+                v /= Powers[-dec.exponent];
+            else
+                v *= Powers[dec.exponent];
+
+            // Rounding the double to a float is only correct if the double
+            // does not land exactly halfway between two floats, where the
+            // first rounding may have hidden which way it should go.
+            SKuint64 bits;
+            memcpy(&bits, &v, sizeof(double));
+            if (v >= FLT_MIN && (bits & 0x1FFFFFFF) != 0x10000000)
+            {
+                const float f = (float)v;
+                return dec.negative ? -f : f;
+            }
+        }
+        return std::strtof(src, nullptr);
+    }
+}  // namespace
+
+const char* bAsciiParseNumber(const char* src, const char* end, bNumber& dest)
+{
+    bAsciiDecimal dec;
+
+    const char* p = scanDecimal(src, end, dec);
+    dest          = toFloat(dec, src);
+    return p;
+}
+
+const char* bAsciiParseInteger(const char* src, const char* end, bInteger& dest)
+{
+    bAsciiDecimal dec;
+
+    const char* p = scanDecimal(src, end, dec);
+    if (!dec.truncated && dec.exponent == 0 && dec.mantissa <= (SKuint64)INT_MAX)
+        dest = dec.negative ? -(bInteger)dec.mantissa : (bInteger)dec.mantissa;
+    else
+    {
+        const float f = toFloat(dec, src);
+        if (f >= (float)INT_MAX)
+            dest = INT_MAX;
+        else if (f <= (float)INT_MIN)
+            dest = INT_MIN;
+        else
+            dest = (bInteger)f;
+    }
+    return p;
+}
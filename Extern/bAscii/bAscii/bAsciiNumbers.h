@@ -0,0 +1,55 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley
+    
+   This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _bAsciiNumbers_h_
+#define _bAsciiNumbers_h_
+
+#include "bAsciiCommon.h"
+
+/// <summary>
+/// Converts the number that starts at src to a float. The number has the
+/// scanner's grammar, an optional minus sign followed by digits and decimal
+/// points. The result is identical to calling strtof on the number's token.
+/// </summary>
+/// <param name="src">The first character of the number.</param>
+/// <param name="end">
+/// One past the last character in the buffer. The buffer must be terminated
+/// by a character that is not part of a number.
+/// </param>
+/// <param name="dest">Receives the converted value.</param>
+/// <returns>A pointer to the first character that is not part of the number.</returns>
+extern const char* bAsciiParseNumber(const char* src, const char* end, bNumber& dest);
+
+/// <summary>
+/// Converts the number that starts at src to an integer. Whole numbers are
+/// converted exactly. Numbers with a fractional part are truncated the same
+/// way that casting the value from bAsciiParseNumber would truncate them.
+/// </summary>
+/// <param name="src">The first character of the number.</param>
+/// <param name="end">
+/// One past the last character in the buffer. The buffer must be terminated
+/// by a character that is not part of a number.
+/// </param>
+/// <param name="dest">Receives the converted value.</param>
+/// <returns>A pointer to the first character that is not part of the number.</returns>
+extern const char* bAsciiParseInteger(const char* src, const char* end, bInteger& dest);
+
+#endif  //_bAsciiNumbers_h_
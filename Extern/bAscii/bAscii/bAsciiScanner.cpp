@@ -26,6 +26,7 @@
 #include <cstring>
 #include "Utils/skFileStream.h"
 #include "Utils/skMemoryStream.h"
+#include "bAsciiNumbers.h"
 #include "bAsciiOpCodes.h"
 
 #define CurrentToken ((m_curTok < m_bufSize && m_curTok >= 0) ? m_buffer[m_curTok] : OP_END)
@@ -97,23 +98,11 @@ void bAsciiScanner::loadStream(skStream& stream)
     }
 }
 
-int bAsciiScanner::scan(bAsciiToken& tok, bool verbose)
+void bAsciiScanner::skipWhiteSpace()
 {
-    tok.string.clear();
-    tok.tok  = OP_UNKNOWN;
-    tok.line = -1;
-
     for (;;)
     {
         const char c = CurrentToken;
-        if (c == OP_END)
-        {
-            tok.tok    = OP_END;
-            tok.line   = m_line;
-            tok.string = "EOF";
-            return OP_END;
-        }
-
         if (c == '\n' || c == '\r')
         {
             if (NextToken == '\r')
@@ -138,112 +127,150 @@ int bAsciiScanner::scan(bAsciiToken& tok, bool verbose)
                 Advance;
             }
         }
-        else if (c == ':')
-        {
-            Advance;
-            tok.string.append(':');
-            tok.tok  = OP_SECTION;
-            tok.line = m_line;
+        else
+            break;
+    }
+}
 
-            return OP_SECTION;
-        }
+int bAsciiScanner::scan(bAsciiToken& tok, bool verbose)
+{
+    tok.string = bStringView();
+    tok.tok    = OP_UNKNOWN;
+    tok.line   = -1;
+
+    skipWhiteSpace();
+
+    const SKuint32 start = m_curTok;
+
+    const char c = CurrentToken;
+    if (c == OP_END)
+    {
+        tok.tok    = OP_END;
+        tok.line   = m_line;
+        tok.string = "EOF";
+        return OP_END;
+    }
+
+    if (c == ':' || c == ',' || c == '=' || c == ';' || c == '{' || c == '}')
+    {
+        Advance;
+        tok.string = bStringView(m_buffer + start, 1);
+        tok.line   = m_line;
+
+        if (c == ':')
+            tok.tok = OP_SECTION;
         else if (c == ',')
-        {
-            Advance;
-            tok.string.append(',');
-            tok.tok  = OP_SEPARATOR;
-            tok.line = m_line;
-            return OP_SEPARATOR;
-        }
+            tok.tok = OP_SEPARATOR;
         else if (c == '=')
-        {
-            Advance;
-            tok.string.append('=');
-            tok.tok  = OP_ASSIGNMENT;
-            tok.line = m_line;
-            return OP_ASSIGNMENT;
-        }
+            tok.tok = OP_ASSIGNMENT;
         else if (c == ';')
-        {
-            Advance;
-            tok.string.append(';');
-            tok.tok  = OP_TERM;
-            tok.line = m_line;
-            return OP_TERM;
-        }
+            tok.tok = OP_TERM;
         else if (c == '{')
+            tok.tok = OP_BRACKET_OPEN;
+        else
+            tok.tok = OP_BRACKET_CLOSE;
+        return tok.tok;
+    }
+    else if (c == StartString)
+    {
+        Advance;
+        do
         {
             Advance;
-            tok.string.append('{');
-            tok.tok  = OP_BRACKET_OPEN;
-            tok.line = m_line;
-            return OP_BRACKET_OPEN;
-        }
-        else if (c == '}')
+        } while (CurrentToken != StartString && CurrentToken != OP_END);
+
+        if (CurrentToken == OP_END)
         {
-            Advance;
-            tok.string.append('}');
-            tok.tok  = OP_BRACKET_CLOSE;
-            tok.line = m_line;
-            return OP_BRACKET_CLOSE;
+            // eof scan
+            tok.string = "end of file";
+            tok.tok    = OP_UNKNOWN;
+            tok.line   = m_line;
+            return OP_UNKNOWN;
         }
-        else if (c == StartString)
+
+        tok.string = bStringView(m_buffer + start + 1, (SKsize)(m_curTok - start - 1));
+        Advance;
+        tok.tok  = OP_STRING;
+        tok.line = m_line;
+        return OP_STRING;
+    }
+    else if (IsLetter(c))
+    {
+        do
         {
             Advance;
-            do
-            {
-                tok.string.append(CurrentToken);
-                Advance;
-            } while (CurrentToken != StartString && CurrentToken != OP_END);
+        } while (IsLetter(CurrentToken) && CurrentToken != OP_END);
 
-            if (CurrentToken == OP_END)
-            {
-                // eof scan
-                tok.string = "end of file";
-                tok.tok    = OP_UNKNOWN;
-                tok.line   = m_line;
-                return OP_UNKNOWN;
-            }
-            Advance;
-            tok.tok  = OP_STRING;
-            tok.line = m_line;
-            return OP_STRING;
-        }
-        else if (IsLetter(c))
+        tok.string = bStringView(m_buffer + start, (SKsize)(m_curTok - start));
+        tok.tok    = OP_ALPHA;
+        tok.line   = m_line;
+        return OP_ALPHA;
+    }
+    else if (c == '-' || IsDigit(c))
+    {
+        if (c == '-' && !IsDigit(NextToken))
         {
-            do
-            {
-                tok.string.append(CurrentToken);
-                Advance;
-            } while (IsLetter(CurrentToken) && CurrentToken != OP_END);
-
-            tok.tok  = OP_ALPHA;
+            tok.tok  = OP_UNKNOWN;
             tok.line = m_line;
-            return OP_ALPHA;
+            return OP_UNKNOWN;
         }
-        else if (c == '-' || IsDigit(c))
+        do
         {
-            if (c == '-' && !IsDigit(NextToken))
-            {
-                tok.tok  = OP_UNKNOWN;
-                tok.line = m_line;
-                return OP_UNKNOWN;
-            }
-            do
-            {
-                tok.string.append(CurrentToken);
-                Advance;
-            } while (IsDigit(CurrentToken) && CurrentToken != OP_END);
+            Advance;
+        } while (IsDigit(CurrentToken) && CurrentToken != OP_END);
 
-            tok.tok  = OP_NUMBER;
-            tok.line = m_line;
-            return OP_NUMBER;
+        tok.string = bStringView(m_buffer + start, (SKsize)(m_curTok - start));
+        tok.tok    = OP_NUMBER;
+        tok.line   = m_line;
+        return OP_NUMBER;
+    }
+    else
+    {
+        tok.tok  = OP_UNKNOWN;
+        tok.line = m_line;
+        return OP_UNKNOWN;
+    }
+}
+
+template <typename T>
+int bAsciiScanner::scanArray(skArray<T>&  dest,
+                             bAsciiToken& tok,
+                             bool         verbose,
+                             const char* (*parse)(const char*, const char*, T&))
+{
+    // The buffer is terminated, so the character at
+    // end and the one after a minus sign can be read.
+    const char* end = m_buffer + m_bufSize;
+    const char* p   = m_buffer + m_curTok;
+    for (;;)
+    {
+        const char c = *p;
+        if (c == ' ' || c == ',' || c == '\t')
+            ++p;
+        else if (IsDigit(c) || (c == '-' && IsDigit(p[1])))
+        {
+            T value;
+            p = parse(p, end, value);
+            dest.push_back(value);
         }
         else
         {
-            tok.tok  = OP_UNKNOWN;
-            tok.line = m_line;
-            return OP_UNKNOWN;
+            m_curTok = (SKuint32)(p - m_buffer);
+            if (c != '\n' && c != '\r' && c != StartComment)
+                return scan(tok, verbose);
+
+            skipWhiteSpace();
+            p = m_buffer + m_curTok;
         }
     }
 }
+
+int bAsciiScanner::scanNumbers(bNumberVector& dest, bAsciiToken& tok, bool verbose)
+{
+    return scanArray(dest, tok, verbose, bAsciiParseNumber);
+}
+
+int bAsciiScanner::scanIntegers(bIntegerVector& dest, bAsciiToken& tok, bool verbose)
+{
+    return scanArray(dest, tok, verbose, bAsciiParseInteger);
+}
@@ -28,6 +28,10 @@
 
 class skStream;
 
+/// <summary>
+/// A token that was scanned from the buffer. The string is a view into the
+/// scanner's buffer, so it is only valid while the scanner exists.
+/// </summary>
 class bAsciiToken
 {
 public:
@@ -37,7 +41,7 @@ public:
     {
     }
 
-    bAsciiToken(const bString& b, int op, int line) :
+    bAsciiToken(const bStringView& b, int op, int line) :
         string(b),
         tok(op),
         line(line)
@@ -46,9 +50,9 @@ public:
 
     bAsciiToken& operator=(const bAsciiToken& o) = default;
 
-    bString string;
-    int     tok;
-    int     line;
+    bStringView string;
+    int         tok;
+    int         line;
 };
 
 class bAsciiScanner
@@ -63,6 +67,14 @@ protected:
 
     void loadStream(skStream& stream);
 
+    void skipWhiteSpace();
+
+    template <typename T>
+    int scanArray(skArray<T>&  dest,
+                  bAsciiToken& tok,
+                  bool         verbose,
+                  const char* (*parse)(const char*, const char*, T&));
+
 public:
     bAsciiScanner(const char* file);
 
@@ -80,7 +92,31 @@ public:
         return m_source;
     }
 
+    /// <summary>
+    /// Returns the number of characters that have not been scanned.
+    /// </summary>
+    SKuint32 getRemaining() const
+    {
+        return m_bufSize - m_curTok;
+    }
+
     int scan(bAsciiToken& tok, bool verbose);
+
+    /// <summary>
+    /// Scans a list of numbers directly from the buffer, without building a
+    /// token for each number. The list ends at the first token that is not a
+    /// number or a separator, and that token is returned in tok.
+    /// </summary>
+    /// <param name="dest">Receives the numbers.</param>
+    /// <param name="tok">Receives the token that ended the list.</param>
+    /// <param name="verbose">Passed on to scan.</param>
+    /// <returns>The op code of the token that ended the list.</returns>
+    int scanNumbers(bNumberVector& dest, bAsciiToken& tok, bool verbose);
+
+    /// <summary>
+    /// The same as scanNumbers, except the numbers are converted to integers.
+    /// </summary>
+    int scanIntegers(bIntegerVector& dest, bAsciiToken& tok, bool verbose);
 };
 
 #endif  //_bAsciiScanner_h_
@@ -27,87 +27,282 @@
 #include "RenderSystem/Math/rtColor.h"
 #include "RenderSystem/rtCamera.h"
 #include "RenderSystem/rtLight.h"
+#include "RenderSystem/rtMeshBvh.h"
+
+/// <summary>
+/// Moves a ray into the space of a mesh instance. The transform is
+/// affine, so distances along the ray are the same in both spaces.
+/// </summary>
+static void rtCpuInstanceRay(const rtPackedInstance& in,
+                             const rtCpuRay&         ray,
+                             skVector3&              origin,
+                             skVector3&              direction)
+{
+    const rtScalar o[3] = {
+        ray.origin.x - in.location[0],
+        ray.origin.y - in.location[1],
+        ray.origin.z - in.location[2],
+    };
+    const rtScalar* d = &ray.direction.x;
+
+    rtScalar* ro = &origin.x;
+    rtScalar* rd = &direction.x;
+    for (int r = 0; r < 3; ++r)
+    {
+        const rtScalar* m = in.rotation[r];
+
+        ro[r] = (m[0] * o[0] + m[1] * o[1] + m[2] * o[2]) / in.scale[r];
+        rd[r] = (m[0] * d[0] + m[1] * d[1] + m[2] * d[2]) / in.scale[r];
+    }
+}
 
-bool rtCpuRayIntersectsObject(rtObjectType* obj, rtCpuRay* ray, const rtVector2& lim)
+static bool rtCpuMeshTest(const rtPackedSceneType& ps,
+                          const SKuint32&          i,
+                          const rtCpuRay&          ray,
+                          const rtVector2&         lim)
 {
-    switch (obj->type)
+    const rtPackedInstance& in = ps.instances.data[i];
+    if (in.geometry == SK_NPOS32)
+        return false;
+
+    const rtPackedGeometry& geo = ps.geometries.data[in.geometry];
+
+    skVector3 origin, direction;
+    rtCpuInstanceRay(in, ray, origin, direction);
+    return geo.bvh->occluded(geo.view, origin, direction, lim.x, lim.y);
+}
+
+static bool rtCpuMeshTest(rtCpuHitResult*          nearest,
+                          const rtPackedSceneType& ps,
+                          const SKuint32&          i,
+                          const rtCpuRay&          ray,
+                          const rtVector2&         lim)
+{
+    const rtPackedInstance& in = ps.instances.data[i];
+    if (in.geometry == SK_NPOS32)
+        return false;
+
+    const rtPackedGeometry& geo = ps.geometries.data[in.geometry];
+
+    skVector3 origin, direction;
+    rtCpuInstanceRay(in, ray, origin, direction);
+
+    skScalar t = lim.y;
+    SKuint32 tri;
+    if (!geo.bvh->intersect(geo.view, origin, direction, lim.x, t, tri))
+        return false;
+
+    if (nearest)
+    {
+        const rtMeshView& v = geo.view;
+
+        const rtScalar* p[3];
+        for (SKuint32 k = 0; k < 3; ++k)
+        {
+            const SKuint32 index = *(const SKuint32*)(v.indices + (SKsize)(tri * 3 + k) * v.indexStride);
+            p[k]                 = (const rtScalar*)(v.vertices + (SKsize)index * v.vertexStride);
+        }
+
+        const skVector3 e1(p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2]);
+        const skVector3 e2(p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2]);
+        const skVector3 n = e1.cross(e2);
+
+        // Normals move by the inverse transpose of the
+        // instance transform, the rotation by the inverse scale.
+        const rtScalar m[3] = {
+            n.x / in.scale[0],
+            n.y / in.scale[1],
+            n.z / in.scale[2],
+        };
+
+        rtVector3 normal = {
+            in.rotation[0][0] * m[0] + in.rotation[1][0] * m[1] + in.rotation[2][0] * m[2],
+            in.rotation[0][1] * m[0] + in.rotation[1][1] * m[1] + in.rotation[2][1] * m[2],
+            in.rotation[0][2] * m[0] + in.rotation[1][2] * m[1] + in.rotation[2][2] * m[2],
+        };
+
+        // Triangles are two sided, so the normal faces the ray.
+        if (rtCpuVec3Dot(normal, ray.direction) > 0)
+            normal = {-normal.x, -normal.y, -normal.z};
+
+        nearest->distance = t;
+        nearest->point    = {
+            ray.origin.x + ray.direction.x * t,
+            ray.origin.y + ray.direction.y * t,
+            ray.origin.z + ray.direction.z * t,
+        };
+        nearest->normal = rtCpuVec3Norm(normal);
+    }
+    return true;
+}
+
+/// <summary>
+/// The slab test used to traverse the top level hierarchy, with the
+/// inverse direction computed once per ray. As in rtCpuBoxTest, a ray
+/// that is parallel to a slab passes it when the origin lies between
+/// its planes, so no subtree is skipped by mistake.
+/// </summary>
+static bool rtCpuNodeTest(const rtPackedNode& node,
+                          const rtScalar      o[3],
+                          const rtScalar      inv[3],
+                          const bool          parallel[3],
+                          const rtVector2&    lim)
+{
+    rtScalar t0 = lim.x, t1 = lim.y;
+    for (int a = 0; a < 3; ++a)
+    {
+        if (parallel[a])
+        {
+            if (o[a] < node.bMin[a] || o[a] > node.bMax[a])
+                return false;
+            continue;
+        }
+
+        rtScalar n = (node.bMin[a] - o[a]) * inv[a];
+        rtScalar f = (node.bMax[a] - o[a]) * inv[a];
+        if (n > f)
+            skSwap(n, f);
+        t0 = n > t0 ? n : t0;
+        t1 = f < t1 ? f : t1;
+    }
+    return t0 <= t1;
+}
+
+bool rtCpuRayIntersectsObject(const rtPackedSceneType& ps,
+                              const SKuint32&          i,
+                              const rtCpuRay*          ray,
+                              const rtVector2&         lim)
+{
+    switch (ps.types.data[i])
     {
     case RT_AO_SHAPE_MESH:
+        return rtCpuMeshTest(ps, i, *ray, lim);
     case RT_AO_SHAPE_CUBE:
     case RT_AO_BVO:
-        return rtCpuBoxTest(obj->bounds.bMin, obj->bounds.bMax, *ray, lim);
+        return rtCpuBoxTest(ps.bounds.data[i].bMin, ps.bounds.data[i].bMax, *ray, lim);
     case RT_AO_SHAPE_SPHERE:
     {
-        rtSphereVolume* sphere = (rtSphereVolume*)obj->bounds.data;
-        if (sphere)
-            return rtCpuSphereTest(sphere->center, sphere->radius, *ray, lim);
-        return false;
+        const rtVector4& sphere = ps.params.data[i];
+        return rtCpuSphereTest({sphere.x, sphere.y, sphere.z}, sphere.w, *ray, lim);
     }
     default:
         return false;
     }
 }
 
-bool rtCpuRayIntersectsObject(rtCpuHitResult* nearest, rtObjectType* obj, rtCpuRay* ray, const rtVector2& lim)
+bool rtCpuRayIntersectsObject(rtCpuHitResult*          nearest,
+                              const rtPackedSceneType& ps,
+                              const SKuint32&          i,
+                              const rtCpuRay*          ray,
+                              const rtVector2&         lim)
 {
-    switch (obj->type)
+    switch (ps.types.data[i])
     {
     case RT_AO_SHAPE_MESH:
+        return rtCpuMeshTest(nearest, ps, i, *ray, lim);
     case RT_AO_SHAPE_CUBE:
     case RT_AO_BVO:
-        return rtCpuBoxTest(nearest, obj->bounds.bMin, obj->bounds.bMax, *ray, lim);
+        return rtCpuBoxTest(nearest, ps.bounds.data[i].bMin, ps.bounds.data[i].bMax, *ray, lim);
     case RT_AO_SHAPE_SPHERE:
     {
-        rtSphereVolume* sphere = (rtSphereVolume*)obj->bounds.data;
-        if (sphere)
-            return rtCpuSphereTest(nearest, sphere->center, sphere->radius, *ray, lim);
-        return false;
+        const rtVector4& sphere = ps.params.data[i];
+        return rtCpuSphereTest(nearest, {sphere.x, sphere.y, sphere.z}, sphere.w, *ray, lim);
     }
     default:
         return false;
     }
 }
 
-bool rtCpuTestScene(const rtSceneType* sc, rtCpuHitResult* nearest, rtCpuRay* ray, bool first = false)
+/// <summary>
+/// The top level traversal that both scene tests share. Visit is called
+/// with the index of each object whose leaf the ray passes through, and
+/// it returns true to stop the traversal.
+/// </summary>
+template <typename Visit>
+static void rtCpuTraverseScene(const rtPackedSceneType& ps,
+                               const rtCpuRay&          ray,
+                               const rtVector2&         lim,
+                               Visit                    visit)
 {
-    SK_ASSERT(sc && sc->camera);
+    if (ps.nodes.size == 0)
+        return;
 
-    // copy the limits..
-    rtVector2 lim = sc->camera->limits;
+    const rtScalar* o = &ray.origin.x;
+    const rtScalar* d = &ray.direction.x;
+
+    rtScalar inv[3];
+    bool     parallel[3];
+    for (int a = 0; a < 3; ++a)
+    {
+        parallel[a] = d[a] == 0;
+        inv[a]      = parallel[a] ? 0 : 1.f / d[a];
+    }
+
+    SKuint32 stack[rtMeshBvh::MaxDepth + 1];
+    SKuint32 top = 0;
+    stack[top++] = 0;
 
-    for (uint32_t i = 0; i < sc->objects.size; ++i)
+    while (top > 0)
     {
-        rtObjectType* obj = (rtObjectType*)sc->objects.data[i];
-        if (rtCpuRayIntersectsObject(nearest, obj, ray, lim))
+        const rtPackedNode& node = ps.nodes.data[stack[--top]];
+
+        // lim is a reference, so the nearest hit so far culls nodes.
+        if (!rtCpuNodeTest(node, o, inv, parallel, lim))
+            continue;
+
+        if (node.count == 0)
+        {
+            stack[top++] = node.first + 1;
+            stack[top++] = node.first;
+            continue;
+        }
+
+        for (SKuint32 k = node.first; k < node.first + node.count; ++k)
+        {
+            if (visit(ps.order.data[k]))
+                return;
+        }
+    }
+}
+
+bool rtCpuTestScene(const rtSceneType* sc, const rtVector2& limits, rtCpuHitResult* nearest, rtCpuRay* ray, bool first)
+{
+    SK_ASSERT(sc);
+
+    // copy the limits..
+    rtVector2 lim = limits;
+
+    const rtPackedSceneType& ps = sc->packed;
+    rtCpuTraverseScene(ps, *ray, lim, [&](const SKuint32 i) {
+        if (rtCpuRayIntersectsObject(nearest, ps, i, ray, lim))
         {
             if (first)
             {
-                nearest->object = obj;
+                nearest->index = i;
                 return true;
             }
 
             if (nearest->distance < lim.y)
             {
-                nearest->object = obj;
-                lim.y           = nearest->distance;
+                nearest->index = i;
+                lim.y          = nearest->distance;
             }
         }
-    }
-    return nearest->object != nullptr;
+        return false;
+    });
+    return nearest->index != SK_NPOS32;
 }
 
-bool rtCpuTestScene(const rtSceneType* sc, rtCpuRay* ray)
+bool rtCpuTestScene(const rtSceneType* sc, const rtVector2& lim, rtCpuRay* ray)
 {
-    const rtVector2& lim = sc->camera->limits;
-
-    for (uint32_t i = 0; i < sc->objects.size; ++i)
-    {
-        rtObjectType* obj = (rtObjectType*)sc->objects.data[i];
-
-        if (rtCpuRayIntersectsObject(obj, ray, lim))
-            return true;
-    }
-    return false;
+    const rtPackedSceneType& ps = sc->packed;
+
+    bool hit = false;
+    rtCpuTraverseScene(ps, *ray, lim, [&](const SKuint32 i) {
+        hit = rtCpuRayIntersectsObject(ps, i, ray, lim);
+        return hit;
+    });
+    return hit;
 }
 
 static void rtSetPixel(rtFrameBufferInfo& fb,
@@ -115,11 +310,19 @@ static void rtSetPixel(rtFrameBufferInfo& fb,
                        const SKuint32&    y,
                        const rtColor&     c)
 {
-    const SKuint32 loc = x * 4 + y * fb.pitch;
+    // y is an image row, so it is made relative
+    // to the band that is resident in pixels.
+    if (y < fb.offsetY)
+        return;
+
+    const SKuint32 row = fb.bottomUp ? fb.height - 1 - y : y - fb.offsetY;
+
+    const SKsize loc = (SKsize)x * 4 + (SKsize)row * fb.pitch;
     if (loc < fb.maxSize)
     {
         rtPixelRGBA* col = (rtPixelRGBA*)&fb.pixels[loc];
         c.toBytes(col->r, col->g, col->b);
+        col->a = 255;
     }
 }
 
@@ -140,6 +343,7 @@ static skScalar rtCpuGetIntensity(const rtLightType* light,
 }
 
 static void rtCpuTraceSilhouette(rtColor&              pixel,
+                                 const rtSceneType*    sc,
                                  const rtVector4&      ori,
                                  const rtCpuHitResult& nearest,
                                  const rtCpuRay&       rayCenter,
@@ -151,7 +355,7 @@ static void rtCpuTraceSilhouette(rtColor&              pixel,
     pixel.set(1);
 
     const skScalar h = 2 + 10e-3f;
-    SK_ASSERT(nearest.object);
+    SK_ASSERT(nearest.index != SK_NPOS32);
 
     rtCpuRay r[4];
     r[0].origin = rayCenter.origin;
@@ -164,25 +368,29 @@ static void rtCpuTraceSilhouette(rtColor&              pixel,
     rtCpuComputeRayDirection(r[2].direction, ori, kx, ky, h, -h, offset);
     rtCpuComputeRayDirection(r[3].direction, ori, kx, ky, -h, -h, offset);
 
+    const rtPackedSceneType& ps = sc->packed;
+
     bool sum =
-        rtCpuRayIntersectsObject(nearest.object, &r[0], limit);
+        rtCpuRayIntersectsObject(ps, nearest.index, &r[0], limit);
 
-    sum = sum && rtCpuRayIntersectsObject(nearest.object, &r[1], limit);
-    sum = sum && rtCpuRayIntersectsObject(nearest.object, &r[2], limit);
-    sum = sum && rtCpuRayIntersectsObject(nearest.object, &r[3], limit);
+    sum = sum && rtCpuRayIntersectsObject(ps, nearest.index, &r[1], limit);
+    sum = sum && rtCpuRayIntersectsObject(ps, nearest.index, &r[2], limit);
+    sum = sum && rtCpuRayIntersectsObject(ps, nearest.index, &r[3], limit);
     if (!sum)
         pixel.zero();
 }
 
 static void rtCpuTraceColorAndLight(rtColor&              pixel,
                                     const rtSceneType*    sc,
+                                    const rtCameraType*   ca,
                                     const rtCpuHitResult& nearest,
                                     const rtCpuRay&       ray,
                                     const skScalar&       v)
 {
-    if (nearest.object)
+    if (nearest.index != SK_NPOS32)
     {
-        rtMaterialType& ma = *nearest.object->material;
+        const rtPackedSceneType& ps = sc->packed;
+        const rtMaterialType&    ma = ps.materialTable.data[ps.materials.data[nearest.index]];
 
         if (ma.flags != RT_MA_SHADELESS)
         {
@@ -234,7 +442,7 @@ static void rtCpuTraceColorAndLight(rtColor&              pixel,
                     if (ma.flags & RT_MA_SHADOW)
                     {
                         rtCpuRay r{nearest.point, lv};
-                        if (rtCpuTestScene(sc, &r))
+                        if (rtCpuTestScene(sc, ca->limits, &r))
                         {
                             const rtScalar fac = .5f * (1.f + i);
                             if (fac < 1.f)
@@ -288,12 +496,12 @@ static void rtCpuRenderSample(rtColor&            curPixel,
                              ca->offset);
 
     // cache the first ray cast...
-    nearest.object = nullptr;
-    if (rtCpuTestScene(sc, &nearest, &ray))
+    nearest.index = SK_NPOS32;
+    if (rtCpuTestScene(sc, ca->limits, &nearest, &ray))
     {
         // process modes when hit
         if (sc->flags & RM_COLOR_AND_LIGHT)
-            rtCpuTraceColorAndLight(curPixel, sc, nearest, ray, 0);
+            rtCpuTraceColorAndLight(curPixel, sc, ca, nearest, ray, 0);
 
         if (sc->flags & RM_COMPUTED_NORMAL)
         {
@@ -331,11 +539,11 @@ static void rtCpuRenderSample(rtColor&            curPixel,
         if (sc->flags & RM_OUTLINE)
         {
             if (sc->flags == RM_OUTLINE)
-                rtCpuTraceSilhouette(curPixel, ca->rotation, nearest, ray, kX, kY, ca->offset, {10e-4f, 1000});
+                rtCpuTraceSilhouette(curPixel, sc, ca->rotation, nearest, ray, kX, kY, ca->offset, {10e-4f, 1000});
             else
             {
                 rtColor pixel;
-                rtCpuTraceSilhouette(pixel, ca->rotation, nearest, ray, kX, kY, ca->offset, {10e-4f, 1000});
+                rtCpuTraceSilhouette(pixel, sc, ca->rotation, nearest, ray, kX, kY, ca->offset, {10e-4f, 1000});
                 curPixel.mul(pixel);
             }
         }
@@ -344,7 +552,7 @@ static void rtCpuRenderSample(rtColor&            curPixel,
     {
         // process modes when not hit
         if (sc->flags & RM_COLOR_AND_LIGHT)
-            rtCpuTraceColorAndLight(curPixel, sc, nearest, ray, skScalar(y) * ca->offset.y);
+            rtCpuTraceColorAndLight(curPixel, sc, ca, nearest, ray, skScalar(y) * ca->offset.y);
         else if (sc->flags == RM_OUTLINE)
             curPixel.set(1);
     }
@@ -356,10 +564,12 @@ static void rtCpuRenderSample(rtColor&            curPixel,
 
 void rtCpuKernelMain(rtFrameBufferInfo&  fb,
                      const rtSceneType*  sc,
+                     const rtCameraType* ca,
                      const rtTileParams* tile)
 {
-    const rtCameraType* ca      = sc->camera;
-    rtCpuHitResult      nearest = {};
+    rtCpuHitResult nearest = {};
+    const SKint32  width   = (SKint32)fb.width;
+    const SKint32  height  = (SKint32)fb.height;
 
     for (SKint32 y = tile->y; y < tile->h; ++y)
     {
@@ -367,18 +577,18 @@ void rtCpuKernelMain(rtFrameBufferInfo&  fb,
         {
             if (!(sc->flags & RM_AA))
             {
-                const skScalar kX = skScalar(fb.width - 2 * x);
-                const skScalar kY = skScalar(fb.height - 2 * y);
+                const skScalar kX = skScalar(width - 2 * x);
+                const skScalar kY = skScalar(height - 2 * y);
 
                 rtColor curPixel;
 
                 rtCpuRenderSample(curPixel, nearest, ca, sc, kX, kY, y);
-                rtSetPixel(fb, x, fb.height - 1 - y, curPixel);
+                rtSetPixel(fb, x, height - 1 - y, curPixel);
             }
             else
             {
-                const skScalar kX = skScalar(fb.width - 2 * x);
-                const skScalar kY = skScalar(fb.height - 2 * y);
+                const skScalar kX = skScalar(width - 2 * x);
+                const skScalar kY = skScalar(height - 2 * y);
 
                 rtColor        P[5];
                 const skScalar h = 1.1625f;
@@ -397,7 +607,7 @@ void rtCpuKernelMain(rtFrameBufferInfo&  fb,
                 curPixel.add(P[4]);
                 curPixel.mul(0.2f);
 
-                rtSetPixel(fb, x, fb.height - 1 - y, curPixel);
+                rtSetPixel(fb, x, height - 1 - y, curPixel);
             }
         }
     }
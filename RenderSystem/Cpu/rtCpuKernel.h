@@ -25,6 +25,7 @@
 
 #ifndef _rtCpuKernel_h_
 #define _rtCpuKernel_h_
+#include "RenderSystem/Cpu/rtCpuMath.h"
 #include "RenderSystem/rtScene.h"
 
 struct rtFrameBufferInfo;
@@ -49,10 +50,10 @@ struct rtFrameBufferInfo;
 /// </summary>
 struct rtTileParams
 {
-    const SKint32 x;
-    const SKint32 y;
-    const SKint32 w;
-    const SKint32 h;
+    SKint32 x;
+    SKint32 y;
+    SKint32 w;
+    SKint32 h;
 };
 
 /// <summary>
@@ -60,10 +61,43 @@ struct rtTileParams
 /// </summary>
 /// <param name="fb">Writable reference to the rtFrameBufferInfo structure.</param>
 /// <param name="sc">The scene to render.</param>
+/// <param name="ca">The camera that the scene is seen from.</param>
 /// <param name="tile">The current tile to render.</param>
 extern void rtCpuKernelMain(rtFrameBufferInfo&  fb,
                             const rtSceneType*  sc,
+                            const rtCameraType* ca,
                             const rtTileParams* tile);
+
+/// <summary>
+/// Tests whether a ray hits object i of the packed scene.
+/// </summary>
+extern bool rtCpuRayIntersectsObject(const rtPackedSceneType& ps,
+                                     const SKuint32&          i,
+                                     const rtCpuRay*          ray,
+                                     const rtVector2&         lim);
+
+/// <summary>
+/// Tests a ray against object i of the packed scene, filling in the hit.
+/// </summary>
+extern bool rtCpuRayIntersectsObject(rtCpuHitResult*          nearest,
+                                     const rtPackedSceneType& ps,
+                                     const SKuint32&          i,
+                                     const rtCpuRay*          ray,
+                                     const rtVector2&         lim);
+
+/// <summary>
+/// Finds the nearest object along a ray, or the first one when first is set.
+/// </summary>
+extern bool rtCpuTestScene(const rtSceneType* sc,
+                           const rtVector2&   limits,
+                           rtCpuHitResult*    nearest,
+                           rtCpuRay*          ray,
+                           bool               first = false);
+
+/// <summary>
+/// Tests whether any object is hit along a ray.
+/// </summary>
+extern bool rtCpuTestScene(const rtSceneType* sc, const rtVector2& lim, rtCpuRay* ray);
 /*!
  * @}
  */
@@ -267,6 +267,18 @@ RT_CPU_API void rtCpuMulQuaternion(rtVector3&       r,
     }
 }
 
+RT_CPU_API void rtCpuSphereHit(rtCpuHitResult*  dest,
+                               const rtVector3& center,
+                               const rtCpuRay&  ray,
+                               const rtScalar&  distance)
+{
+    dest->distance = distance;
+    dest->point.x  = ray.origin.x + ray.direction.x * distance;
+    dest->point.y  = ray.origin.y + ray.direction.y * distance;
+    dest->point.z  = ray.origin.z + ray.direction.z * distance;
+    dest->normal   = rtCpuVec3Norm(dest->point, center);
+}
+
 RT_CPU_API bool rtCpuSphereTest(rtCpuHitResult*  dest,
                                 const rtVector3& center,
                                 const rtScalar&  radius,
@@ -291,9 +303,9 @@ RT_CPU_API bool rtCpuSphereTest(rtCpuHitResult*  dest,
     const rtScalar r = radius * radius;
 
     const rtScalar c =
-        vec.x * vec.x - r +
-        (vec.y * vec.y - r) +
-        (vec.z * vec.z - r);
+        vec.x * vec.x +
+        vec.y * vec.y +
+        vec.z * vec.z - r;
 
     rtScalar d = b * b - a * c;
 
@@ -304,22 +316,14 @@ RT_CPU_API bool rtCpuSphereTest(rtCpuHitResult*  dest,
         rtScalar x = (-b - d) / a;
         if (x >= limit.x && x <= limit.y)
         {
-            dest->distance = x;
-            dest->point.x  = ray.origin.x + ray.direction.x * x;
-            dest->point.y  = ray.origin.y + ray.direction.y * x;
-            dest->point.z  = ray.origin.z + ray.direction.z * x;
-            dest->normal   = rtCpuVec3Norm(dest->point, center);
+            rtCpuSphereHit(dest, center, ray, x);
             return true;
         }
 
         x = (-b + d) / a;
         if (x >= limit.x && x <= limit.y)
         {
-            dest->distance = x;
-            dest->point.x  = ray.origin.x + ray.direction.x * x;
-            dest->point.y  = ray.origin.y + ray.direction.y * x;
-            dest->point.z  = ray.origin.z + ray.direction.z * x;
-            dest->normal   = rtCpuVec3Norm(dest->point, center);
+            rtCpuSphereHit(dest, center, ray, x);
             return true;
         }
     }
@@ -349,9 +353,9 @@ RT_CPU_API bool rtCpuSphereTest(const rtVector3& center,
     const rtScalar r = radius * radius;
 
     const rtScalar c =
-        vec.x * vec.x - r +
-        (vec.y * vec.y - r) +
-        (vec.z * vec.z - r);
+        vec.x * vec.x +
+        vec.y * vec.y +
+        vec.z * vec.z - r;
 
     rtScalar d = b * b - a * c;
 
@@ -390,22 +394,26 @@ RT_CPU_API bool rtCpuBoxTest(const rtScalar   bbMin[3],
 
     for (int i = 0; i < 3; ++i)
     {
-        rtScalar t0 = 0, t1 = 0;
-
-        if (rtCpuAbsF(d[i]) > SK_EPSILON)
+        // A ray that is parallel to a slab never crosses its
+        // planes, so it is inside the slab or misses the box.
+        if (rtCpuAbsF(d[i]) <= SK_EPSILON)
         {
-            const rtScalar t2 = 1.f / d[i];
+            if (o[i] < bbMin[i] || o[i] > bbMax[i])
+                return false;
+            continue;
+        }
+
+        const rtScalar t2 = 1.f / d[i];
 
-            t0 = (bbMin[i] - o[i]) * t2;
-            t1 = (bbMax[i] - o[i]) * t2;
+        rtScalar t0 = (bbMin[i] - o[i]) * t2;
+        rtScalar t1 = (bbMax[i] - o[i]) * t2;
 
-            if (t2 < 10e-4f)
-            {
-                const rtScalar t = t0;
+        if (t2 < 10e-4f)
+        {
+            const rtScalar t = t0;
 
-                t0 = t1;
-                t1 = t;
-            }
+            t0 = t1;
+            t1 = t;
         }
 
         tMin = t0 > tMin ? t0 : tMin;
@@ -431,22 +439,26 @@ RT_CPU_API bool rtCpuBoxTest(rtCpuHitResult*  dest,
 
     for (int i = 0; i < 3; ++i)
     {
-        rtScalar t0 = 0, t1 = 0;
-
-        if (rtCpuAbsF(d[i]) > SK_EPSILON)
+        // A ray that is parallel to a slab never crosses its
+        // planes, so it is inside the slab or misses the box.
+        if (rtCpuAbsF(d[i]) <= SK_EPSILON)
         {
-            const rtScalar t2 = 1.f / d[i];
+            if (o[i] < bbMin[i] || o[i] > bbMax[i])
+                return false;
+            continue;
+        }
 
-            t0 = (bbMin[i] - o[i]) * t2;
-            t1 = (bbMax[i] - o[i]) * t2;
+        const rtScalar t2 = 1.f / d[i];
 
-            if (t2 < 10e-4f)
-            {
-                const rtScalar t = t0;
+        rtScalar t0 = (bbMin[i] - o[i]) * t2;
+        rtScalar t1 = (bbMax[i] - o[i]) * t2;
 
-                t0 = t1;
-                t1 = t;
-            }
+        if (t2 < 10e-4f)
+        {
+            const rtScalar t = t0;
+
+            t0 = t1;
+            t1 = t;
         }
 
         tMin = t0 > tMin ? t0 : tMin;
@@ -457,47 +469,54 @@ RT_CPU_API bool rtCpuBoxTest(rtCpuHitResult*  dest,
     }
 
     if (dest)
-    {
-        dest->distance = tMin;
-        dest->point.x  = ray.origin.x + ray.direction.x * tMin;
-        dest->point.y  = ray.origin.y + ray.direction.y * tMin;
-        dest->point.z  = ray.origin.z + ray.direction.z * tMin;
-
-        const rtVector3 p1 = {
-            dest->point.x - (bbMax[0] + bbMin[0]) * 0.5f,
-            dest->point.y - (bbMax[1] + bbMin[1]) * 0.5f,
-            dest->point.z - (bbMax[2] + bbMin[2]) * 0.5f,
-        };
-        const rtVector3 p2 = {
-            ((bbMax[0] - bbMin[0]) * 0.5f),
-            ((bbMax[1] - bbMin[1]) * 0.5f),
-            ((bbMax[2] - bbMin[2]) * 0.5f),
-        };
-
-        const rtVector3 p3 = {
-            (p1.x / p2.x),
-            (p1.y / p2.y),
-            (p1.z / p2.z),
-        };
-
-        const rtVector3 p4 = {
-            p3.x < SK_EPSILON ? -p3.x : p3.x,
-            p3.y < SK_EPSILON ? -p3.y : p3.y,
-            p3.z < SK_EPSILON ? -p3.z : p3.z,
-        };
-
-        const rtScalar m = rtCpuMax3(p4);
-        dest->normal     = {0, 0, 0};
-        if (fabs(p4.x - m) <= SK_EPSILON)
-            dest->normal.x = rtCpuSign(p3.x);
-        else if (fabs(p4.y - m) <= SK_EPSILON)
-            dest->normal.y = rtCpuSign(p3.y);
-        else
-            dest->normal.z = rtCpuSign(p3.z);
-    }
+        rtCpuBoxHit(dest, bbMin, bbMax, ray, tMin);
     return true;
 }
 
+RT_CPU_API void rtCpuBoxHit(rtCpuHitResult*  dest,
+                            const rtScalar   bbMin[3],
+                            const rtScalar   bbMax[3],
+                            const rtCpuRay&  ray,
+                            const rtScalar&  distance)
+{
+    dest->distance = distance;
+    dest->point.x  = ray.origin.x + ray.direction.x * distance;
+    dest->point.y  = ray.origin.y + ray.direction.y * distance;
+    dest->point.z  = ray.origin.z + ray.direction.z * distance;
+
+    const rtVector3 p1 = {
+        dest->point.x - (bbMax[0] + bbMin[0]) * 0.5f,
+        dest->point.y - (bbMax[1] + bbMin[1]) * 0.5f,
+        dest->point.z - (bbMax[2] + bbMin[2]) * 0.5f,
+    };
+    const rtVector3 p2 = {
+        ((bbMax[0] - bbMin[0]) * 0.5f),
+        ((bbMax[1] - bbMin[1]) * 0.5f),
+        ((bbMax[2] - bbMin[2]) * 0.5f),
+    };
+
+    const rtVector3 p3 = {
+        (p1.x / p2.x),
+        (p1.y / p2.y),
+        (p1.z / p2.z),
+    };
+
+    const rtVector3 p4 = {
+        p3.x < SK_EPSILON ? -p3.x : p3.x,
+        p3.y < SK_EPSILON ? -p3.y : p3.y,
+        p3.z < SK_EPSILON ? -p3.z : p3.z,
+    };
+
+    const rtScalar m = rtCpuMax3(p4);
+    dest->normal     = {0, 0, 0};
+    if (fabs(p4.x - m) <= SK_EPSILON)
+        dest->normal.x = rtCpuSign(p3.x);
+    else if (fabs(p4.y - m) <= SK_EPSILON)
+        dest->normal.y = rtCpuSign(p3.y);
+    else
+        dest->normal.z = rtCpuSign(p3.z);
+}
+
 RT_CPU_API void rtCpuComputeRayDirection(rtVector3&       dir,
                                          const rtVector4& ori,
                                          const rtScalar&  x,
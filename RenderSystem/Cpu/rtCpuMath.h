@@ -31,8 +31,6 @@
 
 #define RT_CPU_API extern
 
-struct rtObjectType;
-
 
 /// <summary>
 /// 
@@ -55,10 +53,15 @@ struct rtCpuRay
 /// </summary>
 struct rtCpuHitResult
 {
-    rtVector3     point;
-    rtVector3     normal;
-    rtScalar      distance;
-    rtObjectType* object;
+    rtVector3 point;
+    rtVector3 normal;
+    rtScalar  distance;
+
+    /// <summary>
+    /// The index of the hit object in rtPackedSceneType,
+    /// or SK_NPOS32 if nothing was hit.
+    /// </summary>
+    SKuint32 index;
 };
 
 /// <summary>
@@ -286,6 +289,23 @@ RT_CPU_API bool rtCpuBoxTest(const rtScalar   bbMin[3],
                              const rtCpuRay&  ray,
                              const rtVector2& limit);
 
+/// <summary>
+/// Fills in the hit of a ray that meets a sphere at distance.
+/// </summary>
+RT_CPU_API void rtCpuSphereHit(rtCpuHitResult*  dest,
+                               const rtVector3& center,
+                               const rtCpuRay&  ray,
+                               const rtScalar&  distance);
+
+/// <summary>
+/// Fills in the hit of a ray that meets a box at distance.
+/// </summary>
+RT_CPU_API void rtCpuBoxHit(rtCpuHitResult*  dest,
+                            const rtScalar   bbMin[3],
+                            const rtScalar   bbMax[3],
+                            const rtCpuRay&  ray,
+                            const rtScalar&  distance);
+
 /// <summary>
 ///
 /// </summary>
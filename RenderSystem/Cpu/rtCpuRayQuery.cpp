@@ -0,0 +1,508 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "RenderSystem/Cpu/rtCpuRayQuery.h"
+#include "RenderSystem/Cpu/rtCpuKernel.h"
+#include "RenderSystem/rtMeshBvh.h"
+
+namespace
+{
+    constexpr SKuint32 PacketSize = 4;
+
+    /// <summary>
+    /// Four rays laid out by component, so that the
+    /// per object tests below run lane by lane.
+    /// </summary>
+    struct rtCpuRayPacket
+    {
+        rtScalar origin[3][PacketSize];
+        rtScalar direction[3][PacketSize];
+        rtScalar inverse[3][PacketSize];
+        rtScalar dot[PacketSize];
+        rtScalar tMin[PacketSize];
+        rtScalar tMax[PacketSize];
+
+        /// <summary>
+        /// Per axis, whether the rays are parallel to the slabs
+        /// and whether their near and far planes are swapped.
+        /// These are the same for every lane of a coherent packet.
+        /// </summary>
+        bool parallel[3];
+        bool swap[3];
+    };
+
+    rtScalar rtCpuQueryAbs(const rtScalar x)
+    {
+        return x < 0 ? -x : x;
+    }
+
+    /// <summary>
+    /// Loads four rays into a packet. Returns false when their
+    /// directions do not share signs, in which case they are
+    /// tested one by one.
+    /// </summary>
+    bool rtCpuLoadPacket(rtCpuRayPacket& packet, const rtCpuRayQuery* queries)
+    {
+        // Reject mixed signs before doing any other work.
+        for (SKuint32 a = 0; a < 3; ++a)
+        {
+            const bool negative = (&queries[0].ray.direction.x)[a] < 0;
+            for (SKuint32 l = 1; l < PacketSize; ++l)
+            {
+                if (((&queries[l].ray.direction.x)[a] < 0) != negative)
+                    return false;
+            }
+        }
+
+        for (SKuint32 a = 0; a < 3; ++a)
+        {
+            for (SKuint32 l = 0; l < PacketSize; ++l)
+            {
+                const rtScalar d = (&queries[l].ray.direction.x)[a];
+
+                const bool parallel = rtCpuQueryAbs(d) <= SK_EPSILON;
+                const bool swap     = !parallel && 1.f / d < 10e-4f;
+                if (l == 0)
+                {
+                    packet.parallel[a] = parallel;
+                    packet.swap[a]     = swap;
+                }
+                else if (packet.parallel[a] != parallel || packet.swap[a] != swap)
+                    return false;
+
+                packet.origin[a][l]    = (&queries[l].ray.origin.x)[a];
+                packet.direction[a][l] = d;
+                packet.inverse[a][l]   = parallel ? 0 : 1.f / d;
+            }
+        }
+
+        for (SKuint32 l = 0; l < PacketSize; ++l)
+        {
+            const rtVector3& d = queries[l].ray.direction;
+
+            packet.dot[l]  = d.x * d.x + d.y * d.y + d.z * d.z;
+            packet.tMin[l] = queries[l].limits.x;
+            packet.tMax[l] = queries[l].limits.y;
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// The slab test of rtCpuBoxTest for each lane. Returns a mask of
+    /// the lanes that hit, with their distances in t.
+    /// </summary>
+    SKuint32 rtCpuPacketBoxTest(const rtCpuRayPacket& packet,
+                                const rtScalar        bbMin[3],
+                                const rtScalar        bbMax[3],
+                                rtScalar              t[PacketSize])
+    {
+        rtScalar tMin[PacketSize];
+        rtScalar tMax[PacketSize];
+        SKuint32 mask = (1u << PacketSize) - 1;
+
+        for (SKuint32 l = 0; l < PacketSize; ++l)
+        {
+            tMin[l] = packet.tMin[l];
+            tMax[l] = packet.tMax[l];
+        }
+
+        for (SKuint32 a = 0; a < 3; ++a)
+        {
+            const rtScalar* o   = packet.origin[a];
+            const rtScalar* inv = packet.inverse[a];
+
+            if (packet.parallel[a])
+            {
+                for (SKuint32 l = 0; l < PacketSize; ++l)
+                {
+                    if (o[l] < bbMin[a] || o[l] > bbMax[a])
+                        mask &= ~(1u << l);
+                }
+            }
+            else
+            {
+                const rtScalar* nearPlane = packet.swap[a] ? bbMax : bbMin;
+                const rtScalar* farPlane  = packet.swap[a] ? bbMin : bbMax;
+
+                for (SKuint32 l = 0; l < PacketSize; ++l)
+                {
+                    const rtScalar t0 = (nearPlane[a] - o[l]) * inv[l];
+                    const rtScalar t1 = (farPlane[a] - o[l]) * inv[l];
+
+                    tMin[l] = t0 > tMin[l] ? t0 : tMin[l];
+                    tMax[l] = t1 < tMax[l] ? t1 : tMax[l];
+                }
+            }
+        }
+
+        for (SKuint32 l = 0; l < PacketSize; ++l)
+        {
+            t[l] = tMin[l];
+            if (tMax[l] < tMin[l])
+                mask &= ~(1u << l);
+        }
+        return mask;
+    }
+
+    /// <summary>
+    /// Tests the lanes in mask against a node of the top level hierarchy.
+    /// As in the single ray traversal, a lane that is parallel to a slab
+    /// passes it when its origin lies between the planes.
+    /// </summary>
+    SKuint32 rtCpuPacketNodeTest(const rtCpuRayPacket& packet,
+                                 const rtPackedNode&   node,
+                                 SKuint32              mask)
+    {
+        rtScalar tMin[PacketSize];
+        rtScalar tMax[PacketSize];
+
+        for (SKuint32 l = 0; l < PacketSize; ++l)
+        {
+            tMin[l] = packet.tMin[l];
+            tMax[l] = packet.tMax[l];
+        }
+
+        for (SKuint32 a = 0; a < 3; ++a)
+        {
+            const rtScalar* o   = packet.origin[a];
+            const rtScalar* inv = packet.inverse[a];
+
+            if (packet.parallel[a])
+            {
+                for (SKuint32 l = 0; l < PacketSize; ++l)
+                {
+                    if (o[l] < node.bMin[a] || o[l] > node.bMax[a])
+                        mask &= ~(1u << l);
+                }
+            }
+            else
+            {
+                const rtScalar nearPlane = packet.swap[a] ? node.bMax[a] : node.bMin[a];
+                const rtScalar farPlane  = packet.swap[a] ? node.bMin[a] : node.bMax[a];
+
+                for (SKuint32 l = 0; l < PacketSize; ++l)
+                {
+                    const rtScalar t0 = (nearPlane - o[l]) * inv[l];
+                    const rtScalar t1 = (farPlane - o[l]) * inv[l];
+
+                    tMin[l] = t0 > tMin[l] ? t0 : tMin[l];
+                    tMax[l] = t1 < tMax[l] ? t1 : tMax[l];
+                }
+            }
+        }
+
+        for (SKuint32 l = 0; l < PacketSize; ++l)
+        {
+            if (tMax[l] < tMin[l])
+                mask &= ~(1u << l);
+        }
+        return mask;
+    }
+
+    /// <summary>
+    /// Traverses the top level hierarchy with the lanes in mask. Visit is
+    /// called with each object whose leaf any active lane reaches, and the
+    /// mask of those lanes. It returns the lanes that should stop.
+    /// </summary>
+    template <typename Visit>
+    void rtCpuTraversePacket(const rtPackedSceneType& ps,
+                             const rtCpuRayPacket&    packet,
+                             SKuint32                 mask,
+                             Visit                    visit)
+    {
+        if (ps.nodes.size == 0 || !mask)
+            return;
+
+        struct Entry
+        {
+            SKuint32 node;
+            SKuint32 mask;
+        };
+
+        Entry    stack[rtMeshBvh::MaxDepth + 1];
+        SKuint32 top = 0;
+        stack[top++] = {0, mask};
+
+        while (top > 0)
+        {
+            const Entry entry = stack[--top];
+
+            // Lanes that stopped since the entry was pushed are dropped.
+            const SKuint32 active = rtCpuPacketNodeTest(packet, ps.nodes.data[entry.node], entry.mask & mask);
+            if (!active)
+                continue;
+
+            const rtPackedNode& node = ps.nodes.data[entry.node];
+            if (node.count == 0)
+            {
+                stack[top++] = {node.first + 1, active};
+                stack[top++] = {node.first, active};
+                continue;
+            }
+
+            for (SKuint32 k = node.first; k < node.first + node.count; ++k)
+            {
+                mask &= ~visit(ps.order.data[k], active & mask);
+                if (!mask)
+                    return;
+            }
+        }
+    }
+
+    /// <summary>
+    /// The hit test of rtCpuSphereTest for each lane. Returns a mask of
+    /// the lanes that hit, with their distances in t.
+    /// </summary>
+    SKuint32 rtCpuPacketSphereTest(const rtCpuRayPacket& packet,
+                                   const rtVector4&      sphere,
+                                   rtScalar              t[PacketSize])
+    {
+        const rtScalar r = sphere.w * sphere.w;
+
+        SKuint32 mask = 0;
+        for (SKuint32 l = 0; l < PacketSize; ++l)
+        {
+            const rtScalar vx = packet.origin[0][l] - sphere.x;
+            const rtScalar vy = packet.origin[1][l] - sphere.y;
+            const rtScalar vz = packet.origin[2][l] - sphere.z;
+
+            const rtScalar a = packet.dot[l];
+            const rtScalar b =
+                vx * packet.direction[0][l] +
+                vy * packet.direction[1][l] +
+                vz * packet.direction[2][l];
+
+            const rtScalar c = vx * vx + vy * vy + vz * vz - r;
+
+            const rtScalar d = b * b - a * c;
+            if (d > 10e-4f)
+            {
+                const rtScalar s  = skSqrt(d);
+                const rtScalar x0 = (-b - s) / a;
+                const rtScalar x1 = (-b + s) / a;
+
+                if (x0 >= packet.tMin[l] && x0 <= packet.tMax[l])
+                {
+                    t[l] = x0;
+                    mask |= 1u << l;
+                }
+                else if (x1 >= packet.tMin[l] && x1 <= packet.tMax[l])
+                {
+                    t[l] = x1;
+                    mask |= 1u << l;
+                }
+            }
+        }
+        return mask;
+    }
+
+    SKuint32 rtCpuPacketObjectTest(const rtCpuRayPacket&    packet,
+                                   const rtPackedSceneType& ps,
+                                   const SKuint32           i,
+                                   rtScalar                 t[PacketSize])
+    {
+        switch (ps.types.data[i])
+        {
+        case RT_AO_SHAPE_CUBE:
+        case RT_AO_BVO:
+            return rtCpuPacketBoxTest(packet, ps.bounds.data[i].bMin, ps.bounds.data[i].bMax, t);
+        case RT_AO_SHAPE_SPHERE:
+            return rtCpuPacketSphereTest(packet, ps.params.data[i], t);
+        default:
+            return 0;
+        }
+    }
+
+    /// <summary>
+    /// Fills in the hit of a lane that the packet test accepted.
+    /// </summary>
+    void rtCpuPacketHit(rtCpuHitResult&          hit,
+                        const rtPackedSceneType& ps,
+                        const SKuint32           i,
+                        const rtCpuRay&          ray,
+                        const rtScalar           t)
+    {
+        if (ps.types.data[i] == RT_AO_SHAPE_SPHERE)
+        {
+            const rtVector4& sphere = ps.params.data[i];
+            rtCpuSphereHit(&hit, {sphere.x, sphere.y, sphere.z}, ray, t);
+        }
+        else
+            rtCpuBoxHit(&hit, ps.bounds.data[i].bMin, ps.bounds.data[i].bMax, ray, t);
+    }
+
+    void rtCpuIntersectPacket(const rtSceneType*   sc,
+                              rtCpuRayPacket&      packet,
+                              const rtCpuRayQuery* queries,
+                              rtCpuHitResult*      hits)
+    {
+        const rtPackedSceneType& ps = sc->packed;
+
+        for (SKuint32 l = 0; l < PacketSize; ++l)
+        {
+            hits[l]       = {};
+            hits[l].index = SK_NPOS32;
+        }
+
+        const SKuint32 all = (1u << PacketSize) - 1;
+
+        rtScalar t[PacketSize];
+        rtCpuTraversePacket(ps, packet, all, [&](const SKuint32 i, const SKuint32 lanes) {
+            if (ps.types.data[i] == RT_AO_SHAPE_MESH)
+            {
+                // The lanes' rays are moved into the instance
+                // one at a time, and traced through its triangles.
+                for (SKuint32 l = 0; l < PacketSize; ++l)
+                {
+                    if (!(lanes & (1u << l)))
+                        continue;
+
+                    rtCpuRay       ray = queries[l].ray;
+                    rtCpuHitResult hit;
+                    if (rtCpuRayIntersectsObject(&hit, ps, i, &ray, {packet.tMin[l], packet.tMax[l]}))
+                    {
+                        hits[l]        = hit;
+                        hits[l].index  = i;
+                        packet.tMax[l] = hit.distance;
+                    }
+                }
+                return 0u;
+            }
+
+            SKuint32 mask = rtCpuPacketObjectTest(packet, ps, i, t) & lanes;
+
+            // As in rtCpuTestScene, an accepted hit shortens the ray.
+            for (SKuint32 l = 0; mask; ++l, mask >>= 1)
+            {
+                if (!(mask & 1))
+                    continue;
+
+                rtCpuPacketHit(hits[l], ps, i, queries[l].ray, t[l]);
+                if (hits[l].distance < packet.tMax[l])
+                {
+                    hits[l].index  = i;
+                    packet.tMax[l] = hits[l].distance;
+                }
+            }
+            return 0u;
+        });
+    }
+
+    SKuint32 rtCpuOccludedPacket(const rtSceneType*    sc,
+                                 const rtCpuRayPacket& packet,
+                                 const rtCpuRayQuery*  queries)
+    {
+        const rtPackedSceneType& ps = sc->packed;
+
+        const SKuint32 all = (1u << PacketSize) - 1;
+
+        rtScalar t[PacketSize];
+        SKuint32 occluded = 0;
+        rtCpuTraversePacket(ps, packet, all, [&](const SKuint32 i, const SKuint32 lanes) {
+            SKuint32 mask = 0;
+            if (ps.types.data[i] == RT_AO_SHAPE_MESH)
+            {
+                for (SKuint32 l = 0; l < PacketSize; ++l)
+                {
+                    rtCpuRay ray = queries[l].ray;
+                    if (lanes & (1u << l) &&
+                        rtCpuRayIntersectsObject(ps, i, &ray, {packet.tMin[l], packet.tMax[l]}))
+                        mask |= 1u << l;
+                }
+            }
+            else
+                mask = rtCpuPacketObjectTest(packet, ps, i, t) & lanes;
+
+            // An occluded lane is finished.
+            occluded |= mask;
+            return mask;
+        });
+        return occluded;
+    }
+}  // namespace
+
+bool rtCpuIntersectRay(const rtSceneType*   sc,
+                       const rtCpuRayQuery& query,
+                       rtCpuHitResult&      hit)
+{
+    rtCpuRay ray = query.ray;
+
+    hit       = {};
+    hit.index = SK_NPOS32;
+    return rtCpuTestScene(sc, query.limits, &hit, &ray);
+}
+
+bool rtCpuOccludedRay(const rtSceneType*   sc,
+                      const rtCpuRayQuery& query)
+{
+    rtCpuRay ray = query.ray;
+    return rtCpuTestScene(sc, query.limits, &ray);
+}
+
+void rtCpuIntersectRays(const rtSceneType*   sc,
+                        const rtCpuRayQuery* queries,
+                        rtCpuHitResult*      hits,
+                        const SKuint32       count)
+{
+    rtCpuRayPacket packet;
+
+    SKuint32 i = 0;
+    for (; i + PacketSize <= count; i += PacketSize)
+    {
+        if (rtCpuLoadPacket(packet, queries + i))
+            rtCpuIntersectPacket(sc, packet, queries + i, hits + i);
+        else
+        {
+            for (SKuint32 l = 0; l < PacketSize; ++l)
+                rtCpuIntersectRay(sc, queries[i + l], hits[i + l]);
+        }
+    }
+
+    for (; i < count; ++i)
+        rtCpuIntersectRay(sc, queries[i], hits[i]);
+}
+
+void rtCpuOccludedRays(const rtSceneType*   sc,
+                       const rtCpuRayQuery* queries,
+                       SKubyte*             occluded,
+                       const SKuint32       count)
+{
+    rtCpuRayPacket packet;
+
+    SKuint32 i = 0;
+    for (; i + PacketSize <= count; i += PacketSize)
+    {
+        if (rtCpuLoadPacket(packet, queries + i))
+        {
+            const SKuint32 mask = rtCpuOccludedPacket(sc, packet, queries + i);
+            for (SKuint32 l = 0; l < PacketSize; ++l)
+                occluded[i + l] = (SKubyte)((mask >> l) & 1);
+        }
+        else
+        {
+            for (SKuint32 l = 0; l < PacketSize; ++l)
+                occluded[i + l] = rtCpuOccludedRay(sc, queries[i + l]) ? 1 : 0;
+        }
+    }
+
+    for (; i < count; ++i)
+        occluded[i] = rtCpuOccludedRay(sc, queries[i]) ? 1 : 0;
+}
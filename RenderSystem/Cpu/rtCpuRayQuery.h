@@ -0,0 +1,105 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+/*! \addtogroup CpuKernel
+ * @{
+ */
+
+#ifndef _rtCpuRayQuery_h_
+#define _rtCpuRayQuery_h_
+
+#include "RenderSystem/Cpu/rtCpuMath.h"
+#include "RenderSystem/Data/rtSceneType.h"
+
+/// <summary>
+/// A ray and the range of distances along it that a query accepts.
+/// </summary>
+struct rtCpuRayQuery
+{
+    rtCpuRay ray;
+
+    /// <summary>
+    /// The minimum and maximum distance along the ray.
+    ///
+    /// \f$ \begin{bmatrix}
+    /// t_{min},
+    /// t_{max}
+    /// \end{bmatrix}
+    /// \f$
+    /// </summary>
+    rtVector2 limits;
+};
+
+/// <summary>
+/// Finds the nearest hit of a single ray.
+/// </summary>
+/// <param name="sc">The compiled scene.</param>
+/// <param name="query">The ray and its limits.</param>
+/// <param name="hit">Receives the hit, index is SK_NPOS32 when nothing was hit.</param>
+/// <returns>True if the ray hit an object.</returns>
+extern bool rtCpuIntersectRay(const rtSceneType*   sc,
+                              const rtCpuRayQuery& query,
+                              rtCpuHitResult&      hit);
+
+/// <summary>
+/// Tests whether anything blocks a single ray.
+/// </summary>
+/// <param name="sc">The compiled scene.</param>
+/// <param name="query">The ray and its limits.</param>
+/// <returns>True if any object is hit within the limits.</returns>
+extern bool rtCpuOccludedRay(const rtSceneType*   sc,
+                             const rtCpuRayQuery& query);
+
+/// <summary>
+/// Finds the nearest hit of each ray.
+/// </summary>
+/// <remarks>
+/// Groups of four rays whose directions share their signs are tested
+/// as a packet, so each object is fetched once for the four rays and the
+/// slab tests are computed lane by lane. The other rays are tested one by
+/// one. The results are the same as rtCpuIntersectRay's.
+/// </remarks>
+/// <param name="sc">The compiled scene.</param>
+/// <param name="queries">The rays.</param>
+/// <param name="hits">Receives one result per ray.</param>
+/// <param name="count">The number of rays.</param>
+extern void rtCpuIntersectRays(const rtSceneType*   sc,
+                               const rtCpuRayQuery* queries,
+                               rtCpuHitResult*      hits,
+                               SKuint32             count);
+
+/// <summary>
+/// Tests whether anything blocks each ray, with the same
+/// packet scheme as rtCpuIntersectRays.
+/// </summary>
+/// <param name="sc">The compiled scene.</param>
+/// <param name="queries">The rays.</param>
+/// <param name="occluded">Receives 1 for each blocked ray and 0 otherwise.</param>
+/// <param name="count">The number of rays.</param>
+extern void rtCpuOccludedRays(const rtSceneType*   sc,
+                              const rtCpuRayQuery* queries,
+                              SKubyte*             occluded,
+                              SKuint32             count);
+
+/*!
+ * @}
+ */
+#endif  //_rtCpuRayQuery_h_
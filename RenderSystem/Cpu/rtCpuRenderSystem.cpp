@@ -22,11 +22,62 @@
 #include "rtCpuRenderSystem.h"
 #include <cstdio>
 #include <thread>
+#include "Math/skRectangle.h"
 #include "RenderSystem/rtCamera.h"
 #include "RenderSystem/rtScene.h"
 #include "RenderSystem/rtTarget.h"
 #include "rtTileManager.h"
 
+namespace
+{
+    /// <summary>
+    /// Batches with fewer rays than this are not worth waking the threads for.
+    /// </summary>
+    constexpr SKuint32 QueryBatch = 64;
+
+    class rtIntersectTask final : public rtTileTask
+    {
+    private:
+        const rtSceneType*   m_scene;
+        const rtCpuRayQuery* m_queries;
+        rtCpuHitResult*      m_hits;
+
+    public:
+        rtIntersectTask(const rtSceneType* sc, const rtCpuRayQuery* queries, rtCpuHitResult* hits) :
+            m_scene(sc),
+            m_queries(queries),
+            m_hits(hits)
+        {
+        }
+
+        void execute(const SKuint32 first, const SKuint32 last) override
+        {
+            rtCpuIntersectRays(m_scene, m_queries + first, m_hits + first, last - first);
+        }
+    };
+
+    class rtOccludedTask final : public rtTileTask
+    {
+    private:
+        const rtSceneType*   m_scene;
+        const rtCpuRayQuery* m_queries;
+        SKubyte*             m_occluded;
+
+    public:
+        rtOccludedTask(const rtSceneType* sc, const rtCpuRayQuery* queries, SKubyte* occluded) :
+            m_scene(sc),
+            m_queries(queries),
+            m_occluded(occluded)
+        {
+        }
+
+        void execute(const SKuint32 first, const SKuint32 last) override
+        {
+            rtCpuOccludedRays(m_scene, m_queries + first, m_occluded + first, last - first);
+        }
+    };
+}  // namespace
+
 rtCpuRenderSystem::rtCpuRenderSystem() :
     m_tiles(nullptr)
 {
@@ -60,19 +111,9 @@ void rtCpuRenderSystem::initialize(rtScene* scene)
     }
     // Cache any persistent per frame variables before spiting into tiles.
     // Any render method / sub method must be immutable.
-    m_camera = cameras.at(0);
-
-    rtSceneType*  sc = m_scene->getPtr();
-    rtCameraType* ca = m_camera->getPtr();
-    updatePixelOffset();
-
-    ca->offset = {
-        m_iPixelOffset.x,
-        m_iPixelOffset.y,
-        m_iPixelOffset.z,
-        m_iPixelOffset.w,
-    };
-    sc->camera = ca;
+    if (!m_camera || cameras.find(m_camera) == cameras.npos)
+        m_camera = cameras.at(0);
+    bindCamera();
 
     delete m_tiles;
 
@@ -84,10 +125,196 @@ void rtCpuRenderSystem::initialize(rtScene* scene)
 
 void rtCpuRenderSystem::render(rtScene* scene)
 {
+    if (!m_target)
+    {
+        printf("No target was specified.\n");
+        return;
+    }
+
+    render(scene,
+           skRectangle(0,
+                       0,
+                       (skScalar)m_target->getWidth(),
+                       (skScalar)m_target->getHeight()));
+}
+
+void rtCpuRenderSystem::render(rtScene* scene, const skRectangle& rect)
+{
+    if (m_dirty)
+        initialize(scene);
+    if (m_dirty)
+        return;
+
+    m_scene->updateCaches();
+
+    // Clip the rectangle to whole pixels inside the target.
+    const skScalar width  = (skScalar)m_target->getWidth();
+    const skScalar height = (skScalar)m_target->getHeight();
+
+    const SKuint32 x0 = (SKuint32)skClamp<skScalar>(skFloor(rect.getLeft()), 0, width);
+    const SKuint32 y0 = (SKuint32)skClamp<skScalar>(skFloor(rect.getTop()), 0, height);
+    const SKuint32 x1 = (SKuint32)skClamp<skScalar>(skCeil(rect.getRight()), 0, width);
+    const SKuint32 y1 = (SKuint32)skClamp<skScalar>(skCeil(rect.getBottom()), 0, height);
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    // Targets that cannot hold the whole image are
+    // rendered one band of rows at a time.
+    const SKuint32 band = skClamp<SKuint32>(m_target->getBandHeight(), 1, (SKuint32)height);
+
+    for (SKuint32 first = y0; first < y1; first += band)
+    {
+        const SKuint32 count = skMin<SKuint32>(band, y1 - first);
+
+        m_target->lockBand(first, count);
+        renderBand(x0, x1 - x0, first, count);
+        m_target->unlockBand();
+    }
+}
+
+void rtCpuRenderSystem::render(rtScene* scene, const rtViews& views)
+{
+    // The tile threads are set up for the current target,
+    // which falls back to the first view when there is none.
+    if (!m_target && !views.empty())
+    {
+        setTarget(views.at(0).target);
+        invalidate();
+    }
+
     if (m_dirty)
         initialize(scene);
+    if (m_dirty)
+        return;
 
     m_scene->updateCaches();
 
-    m_tiles->synchronize();
+    // Each view renders from a copy of its camera with the pixel offsets
+    // of its own target, so a camera can be seen through several targets.
+    skArray<rtCameraType> cameras;
+    skArray<rtTileRegion> regions;
+    cameras.resize(views.size());
+    regions.reserve(views.size());
+
+    for (SKuint32 i = 0; i < views.size(); ++i)
+    {
+        const rtView& view = views.at(i);
+        if (!view.camera || !view.target)
+            continue;
+
+        const skVector4 offset = computePixelOffset(view.camera, view.target);
+
+        cameras[i]        = view.camera->getData();
+        cameras[i].aspect = offset.z;
+        cameras[i].offset = {offset.x, offset.y, offset.z, offset.w};
+    }
+
+    // Views are rendered band by band in lockstep, so each
+    // target that streams its rows still holds a single band.
+    for (SKuint32 band = 0;; ++band)
+    {
+        regions.resizeFast(0);
+
+        for (SKuint32 i = 0; i < views.size(); ++i)
+        {
+            const rtView& view = views.at(i);
+            if (!view.camera || !view.target)
+                continue;
+
+            rtTarget*      target = view.target;
+            const SKuint32 height = target->getHeight();
+            const SKuint32 rows   = skClamp<SKuint32>(target->getBandHeight(), 1, skMax<SKuint32>(height, 1));
+            const SKuint32 first  = band * rows;
+            if (first >= height)
+                continue;
+
+            const SKuint32 count = skMin<SKuint32>(rows, height - first);
+            target->lockBand(first, count);
+
+            // The kernel flips y when it writes.
+            regions.push_back({
+                target->getFrameBufferInfo(),
+                &cameras[i],
+                0,
+                (SKint32)(height - first - count),
+                (SKint32)target->getWidth(),
+                (SKint32)count,
+            });
+        }
+
+        if (regions.empty())
+            break;
+
+        m_tiles->synchronize(regions.ptr(), regions.size());
+
+        for (const rtView& view : views)
+        {
+            if (!view.camera || !view.target)
+                continue;
+
+            rtTarget*      target = view.target;
+            const SKuint32 height = target->getHeight();
+            const SKuint32 rows   = skClamp<SKuint32>(target->getBandHeight(), 1, skMax<SKuint32>(height, 1));
+            if (band * rows < height)
+                target->unlockBand();
+        }
+    }
+}
+
+void rtCpuRenderSystem::renderBand(const SKuint32 x, const SKuint32 width, const SKuint32 row, const SKuint32 rows)
+{
+    // The kernel flips y when it writes, so image rows
+    // [row, row + rows) come from the kernel rows below.
+    const SKint32 y = (SKint32)(m_target->getHeight() - row - rows);
+
+    m_tiles->synchronize(m_target->getFrameBufferInfo(), (SKint32)x, y, (SKint32)width, (SKint32)rows);
+}
+
+bool rtCpuRenderSystem::prepareQueries(rtScene* scene)
+{
+    if (!scene)
+    {
+        printf("Invalid supplied scene.\n");
+        return false;
+    }
+
+    // The next frame picks up the new scene as well.
+    if (scene != m_scene)
+    {
+        m_scene = scene;
+        m_dirty = true;
+    }
+
+    if (!m_tiles)
+    {
+        m_tiles = new rtTileManager(this, m_target ? m_target->getFrameBufferInfo() : rtFrameBufferInfo{});
+        m_tiles->initialize();
+    }
+
+    m_scene->updateCaches();
+    return true;
+}
+
+void rtCpuRenderSystem::intersect(rtScene* scene, const rtCpuRayQuery* queries, rtCpuHitResult* hits, const SKuint32 count)
+{
+    if (!prepareQueries(scene))
+        return;
+
+    rtIntersectTask task(m_scene->getPtr(), queries, hits);
+    if (count < QueryBatch)
+        task.execute(0, count);
+    else
+        m_tiles->execute(&task, count, 4);
+}
+
+void rtCpuRenderSystem::occluded(rtScene* scene, const rtCpuRayQuery* queries, SKubyte* occluded, const SKuint32 count)
+{
+    if (!prepareQueries(scene))
+        return;
+
+    rtOccludedTask task(m_scene->getPtr(), queries, occluded);
+    if (count < QueryBatch)
+        task.execute(0, count);
+    else
+        m_tiles->execute(&task, count, 4);
 }
@@ -22,6 +22,7 @@
 #ifndef _rtCpuRenderSystem_h_
 #define _rtCpuRenderSystem_h_
 
+#include "RenderSystem/Cpu/rtCpuRayQuery.h"
 #include "RenderSystem/rtRenderSystem.h"
 #include "RenderSystem/rtScene.h"
 
@@ -37,11 +38,49 @@ private:
 
     void initialize(rtScene* scene);
 
+    void renderBand(SKuint32 x, SKuint32 width, SKuint32 row, SKuint32 rows);
+
+    bool prepareQueries(rtScene* scene);
+
 public:
     rtCpuRenderSystem();
     ~rtCpuRenderSystem() override;
 
     void render(rtScene* scene) override;
+
+    /// <summary>
+    /// Traces only the pixels inside the rectangle, so a crop or a
+    /// distributed tile costs in proportion to its area.
+    /// </summary>
+    void render(rtScene* scene, const skRectangle& rect) override;
+
+    /// <summary>
+    /// Renders every view in one pass over the tile threads, so all
+    /// views share the compiled scene and each thread is woken once per band.
+    /// </summary>
+    void render(rtScene* scene, const rtViews& views) override;
+
+    /// <summary>
+    /// Finds the nearest hit of each ray, spread over the tile threads.
+    /// </summary>
+    /// <remarks>
+    /// Queries only need a scene, a target and a camera are not required.
+    /// The scene is compiled first if it is out of date.
+    /// </remarks>
+    /// <param name="scene">The scene to query.</param>
+    /// <param name="queries">The rays and their distance limits.</param>
+    /// <param name="hits">Receives one result per ray, index is SK_NPOS32 for a miss.</param>
+    /// <param name="count">The number of rays.</param>
+    void intersect(rtScene* scene, const rtCpuRayQuery* queries, rtCpuHitResult* hits, SKuint32 count);
+
+    /// <summary>
+    /// Tests whether anything blocks each ray, spread over the tile threads.
+    /// </summary>
+    /// <param name="scene">The scene to query.</param>
+    /// <param name="queries">The rays and their distance limits.</param>
+    /// <param name="occluded">Receives 1 for each blocked ray and 0 otherwise.</param>
+    /// <param name="count">The number of rays.</param>
+    void occluded(rtScene* scene, const rtCpuRayQuery* queries, SKubyte* occluded, SKuint32 count);
 };
 
 #endif  //_rtCpuRenderSystem_h_
@@ -23,21 +23,39 @@
 #include "Utils/skRandom.h"
 #include "rtCpuKernel.h"
 #include "RenderSystem/rtCamera.h"
+#include "Threads/skCriticalSection.h"
+#include "Threads/skSemaphore.h"
 #include "Threads/skThread.h"
 
 class rtCpuRenderSystem;
 class rtTileManager;
 
 /// <summary>
-/// rtTile represents a subdivided region of the frame buffer
-/// that can be rendered to in parallel.
+/// rtTile represents the subdivided regions of one or more frame buffers
+/// that can be rendered to in parallel. Its thread is started once
+/// and then waits for work, so bands and frames reuse the same threads.
 /// </summary>
 class rtTile final : public skRunnable
 {
 private:
-    rtTileParams       m_params;
-    rtFrameBufferInfo  m_frameBuffer;
+    struct Work
+    {
+        rtFrameBufferInfo   frameBuffer;
+        const rtCameraType* camera;
+        rtTileParams        params;
+    };
+
+    skArray<Work>      m_work;
+    rtTileTask*        m_task;
+    SKuint32           m_first;
+    SKuint32           m_last;
     rtCpuRenderSystem* m_system;
+    skCriticalSection  m_cs;
+    skSemaphore        m_wake;
+    skSemaphore        m_done;
+    bool               m_pending;
+    bool               m_finished;
+    bool               m_quit;
 
 #ifdef RT_EXTRA_DEBUG
     skColor m_color;
@@ -49,20 +67,14 @@ public:
     /// Primary constructor.
     /// </summary>
     /// <param name="sys">Handle to the CPU render system.</param>
-    /// <param name="width">The width of this tile.</param>
-    /// <param name="height">The height of this tile.</param>
-    /// <param name="x">The starting x-coordinate.</param>
-    /// <param name="y">The starting y-coordinate.</param>
-    /// <param name="fbi">A const reference to the frame buffer.</param>
-    rtTile(rtCpuRenderSystem*       sys,
-           SKint32                 width,
-           SKint32                 height,
-           SKint32                 x,
-           SKint32                 y,
-           const rtFrameBufferInfo& fbi) :
-        m_params{x, y, x + width, y + height},
-        m_frameBuffer(fbi),
-        m_system(sys)
+    explicit rtTile(rtCpuRenderSystem* sys) :
+        m_task(nullptr),
+        m_first(0),
+        m_last(0),
+        m_system(sys),
+        m_pending(false),
+        m_finished(false),
+        m_quit(false)
 #ifdef RT_EXTRA_DEBUG
         ,
         m_overlayGrid(false)
@@ -72,6 +84,87 @@ public:
 
     ~rtTile() override = default;
 
+    /// <summary>
+    /// Hands the current regions to the tile's thread.
+    /// </summary>
+    void dispatch()
+    {
+        m_cs.lock();
+        m_pending  = true;
+        m_finished = false;
+        m_cs.unlock();
+
+        m_wake.signal();
+    }
+
+    /// <summary>
+    /// Blocks until the last dispatched regions have been rendered.
+    /// </summary>
+    void complete()
+    {
+        // The semaphores do not start at zero,
+        // so the state is checked on every wake up.
+        for (;;)
+        {
+            m_cs.lock();
+            const bool finished = m_finished;
+            m_cs.unlock();
+
+            if (finished)
+                return;
+            m_done.wait();
+        }
+    }
+
+    /// <summary>
+    /// Stops the tile's thread and joins it.
+    /// </summary>
+    void quit()
+    {
+        m_cs.lock();
+        m_quit = true;
+        m_cs.unlock();
+
+        m_wake.signal();
+        join();
+    }
+
+    /// <summary>
+    /// Drops the regions and the task of the last dispatch.
+    /// </summary>
+    void clear()
+    {
+        m_work.resizeFast(0);
+        m_task = nullptr;
+    }
+
+    /// <summary>
+    /// Sets a range of a task's items for the next dispatch.
+    /// </summary>
+    void setTask(rtTileTask* task, const SKuint32 first, const SKuint32 last)
+    {
+        m_task  = task;
+        m_first = first;
+        m_last  = last;
+    }
+
+    /// <summary>
+    /// Adds a region of a frame buffer to the next dispatch.
+    /// </summary>
+    void addRegion(const rtTileRegion& region)
+    {
+        m_work.push_back({
+            region.frameBuffer,
+            region.camera,
+            {region.x, region.y, region.x + region.width, region.y + region.rows},
+        });
+    }
+
+    bool hasWork() const
+    {
+        return m_task || !m_work.empty();
+    }
+
 #ifdef RT_EXTRA_DEBUG
     void setColor(const skColor& col)
     {
@@ -85,10 +178,40 @@ public:
     /// </summary>
     int update() override
     {
-        rtCpuKernelMain(m_frameBuffer,
-                        m_system->getKernelScene(),
-                        &m_params);
-        return 0;
+        for (;;)
+        {
+            m_wake.wait();
+
+            m_cs.lock();
+            if (m_quit)
+            {
+                m_cs.unlock();
+                return 0;
+            }
+            const bool pending = m_pending;
+            m_pending          = false;
+            m_cs.unlock();
+
+            if (!pending)
+                continue;
+
+            for (Work& work : m_work)
+            {
+                rtCpuKernelMain(work.frameBuffer,
+                                m_system->getKernelScene(),
+                                work.camera,
+                                &work.params);
+            }
+
+            if (m_task)
+                m_task->execute(m_first, m_last);
+
+            m_cs.lock();
+            m_finished = true;
+            m_cs.unlock();
+
+            m_done.signal();
+        }
     }
 };
 
@@ -111,25 +234,13 @@ rtTileManager::rtTileManager(rtCpuRenderSystem*       system,
 rtTileManager::~rtTileManager()
 {
     for (rtTile* element : m_threads)
-        element->join();
+        element->quit();
     for (rtTile* element : m_threads)
         delete element;
 };
 
 void rtTileManager::initialize()
 {
-    if (!m_frameBuffer.pixels)
-        return;
-
-    // calculate the total number of subdivisions that can fit
-    // in the height.  
-
-    SKint32 tRh = m_frameBuffer.height % m_subdivisions;
-    if (tRh > 0)
-        tRh = m_subdivisions - tRh;
-
-    const SKint32 h1 = (m_frameBuffer.height + tRh) / m_subdivisions;
-    const SKint32 h2 = m_frameBuffer.height - h1 * (m_subdivisions - 1);
 
 #ifdef RT_EXTRA_DEBUG
     m_overlayGrid = m_system->getMode() & RM_DEBUG_TILE;
@@ -139,22 +250,9 @@ void rtTileManager::initialize()
     {
         m_threads.reserve(m_subdivisions);
 
-        SKint32 h;
-        SKint32 jv = 0;
-
-        for (SKint32 j = 0; j < m_subdivisions; j++, jv += h)
+        for (SKint32 j = 0; j < m_subdivisions; j++)
         {
-            if (j == 0)
-                h = h2;
-            else
-                h = h1;
-
-            rtTile* tile = new rtTile(m_system,
-                                      m_frameBuffer.width,
-                                      h,
-                                      0,
-                                      jv,
-                                      m_frameBuffer);
+            rtTile* tile = new rtTile(m_system);
 #ifdef RT_EXTRA_DEBUG
             if (m_overlayGrid)
             {
@@ -166,6 +264,7 @@ void rtTileManager::initialize()
                 });
             }
 #endif
+            tile->start();
             m_threads.push_back(tile);
         }
     }
@@ -173,10 +272,109 @@ void rtTileManager::initialize()
 
 void rtTileManager::synchronize()
 {
-    // kick them off then join them
+    synchronize(m_frameBuffer, 0, (SKint32)m_frameBuffer.height);
+}
 
-    for (rtTile* element : m_threads)
-        element->start();
-    for (rtTile* element : m_threads)
-        element->join();
+void rtTileManager::synchronize(const rtFrameBufferInfo& fbi, const SKint32 y, const SKint32 rows)
+{
+    synchronize(fbi, 0, y, (SKint32)fbi.width, rows);
+}
+
+void rtTileManager::synchronize(const rtFrameBufferInfo& fbi,
+                                const SKint32            x,
+                                const SKint32            y,
+                                const SKint32            width,
+                                const SKint32            rows)
+{
+    const rtTileRegion region = {
+        fbi,
+        m_system->getKernelScene()->camera,
+        x,
+        y,
+        width,
+        rows,
+    };
+    synchronize(&region, 1);
+}
+
+void rtTileManager::synchronize(const rtTileRegion* regions, const SKuint32 count)
+{
+    if (m_threads.empty())
+        return;
+
+    for (rtTile* tile : m_threads)
+        tile->clear();
+
+    const SKint32 threads = (SKint32)m_threads.size();
+
+    // Split the rows of each region evenly, the first tiles take
+    // one extra row each when they do not divide. Successive regions
+    // start on the next thread, so small ones do not pile up on the first.
+    SKint32 next = 0;
+    for (SKuint32 i = 0; i < count; ++i)
+    {
+        const rtTileRegion& region = regions[i];
+        if (!region.frameBuffer.pixels || !region.camera || region.rows <= 0 || region.width <= 0)
+            continue;
+
+        const SKint32 subdivisions = skMin<SKint32>(threads, region.rows);
+        const SKint32 h1           = region.rows / subdivisions;
+        const SKint32 remainder    = region.rows % subdivisions;
+
+        rtTileRegion part = region;
+        for (SKint32 j = 0; j < subdivisions; j++)
+        {
+            part.rows = j < remainder ? h1 + 1 : h1;
+
+            m_threads[next]->addRegion(part);
+            next = (next + 1) % threads;
+            part.y += part.rows;
+        }
+    }
+
+    // kick them off then wait for them
+
+    dispatch();
+}
+
+void rtTileManager::execute(rtTileTask* task, const SKuint32 count, const SKuint32 granularity)
+{
+    if (m_threads.empty() || !task || count == 0)
+        return;
+
+    for (rtTile* tile : m_threads)
+        tile->clear();
+
+    // Hand each thread an even share, rounded up
+    // to a whole number of granules.
+    const SKuint32 step  = skMax<SKuint32>(granularity, 1);
+    const SKuint32 units = (count + step - 1) / step;
+    const SKuint32 share = (units + m_threads.size() - 1) / m_threads.size() * step;
+
+    SKuint32 first = 0;
+    for (rtTile* tile : m_threads)
+    {
+        if (first >= count)
+            break;
+
+        const SKuint32 last = skMin<SKuint32>(first + share, count);
+        tile->setTask(task, first, last);
+        first = last;
+    }
+
+    dispatch();
+}
+
+void rtTileManager::dispatch()
+{
+    for (rtTile* tile : m_threads)
+    {
+        if (tile->hasWork())
+            tile->dispatch();
+    }
+    for (rtTile* tile : m_threads)
+    {
+        if (tile->hasWork())
+            tile->complete();
+    }
 }
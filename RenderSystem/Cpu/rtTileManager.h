@@ -20,6 +20,7 @@
 #ifndef _rtTileManager_h_
 #define _rtTileManager_h_
 
+#include "RenderSystem/Data/rtCameraTypes.h"
 #include "RenderSystem/rtCommon.h"
 #include "RenderSystem/rtTarget.h"
 #include "Utils/skArray.h"
@@ -27,6 +28,34 @@
 class rtTile;
 class rtCpuRenderSystem;
 
+/// <summary>
+/// A rectangle of kernel rows and columns, the frame buffer
+/// that holds it and the camera that it is seen from.
+/// </summary>
+struct rtTileRegion
+{
+    rtFrameBufferInfo   frameBuffer;
+    const rtCameraType* camera;
+    SKint32             x;
+    SKint32             y;
+    SKint32             width;
+    SKint32             rows;
+};
+
+/// <summary>
+/// Work other than rendering that the tile threads share out by index.
+/// </summary>
+class rtTileTask
+{
+public:
+    virtual ~rtTileTask() = default;
+
+    /// <summary>
+    /// Processes the items in [first, last).
+    /// </summary>
+    virtual void execute(SKuint32 first, SKuint32 last) = 0;
+};
+
 /// <summary>
 /// Thread manager for rtTile
 /// </summary>
@@ -47,6 +76,11 @@ private:
     bool m_overlayGrid;
 #endif
 
+    /// <summary>
+    /// Wakes every tile that has work, then waits for them.
+    /// </summary>
+    void dispatch();
+
 public:
     /// <summary>
     /// Primary constructor.
@@ -70,15 +104,55 @@ public:
 #endif
 
     /// <summary>
-    /// Subdivides the frame buffer into rtTile instances.
+    /// Subdivides the frame buffer into rtTile instances and starts their threads.
+    /// The threads stay alive until the manager is destroyed.
     /// </summary>
     void initialize();
 
     /// <summary>
-    /// Starts all tile threads, then joins them back to the main thread.
+    /// Hands the whole frame buffer to the tile threads, then waits for them.
     /// </summary>
     /// <remarks>This is the main update method for a rtTile instance.</remarks>
     void synchronize();
+
+    /// <summary>
+    /// Splits a range of kernel rows over the tile threads, then
+    /// waits for them to finish.
+    /// </summary>
+    /// <param name="fbi">The frame buffer that holds the rows.</param>
+    /// <param name="y">The first kernel row.</param>
+    /// <param name="rows">The number of rows to render.</param>
+    void synchronize(const rtFrameBufferInfo& fbi, SKint32 y, SKint32 rows);
+
+    /// <summary>
+    /// Splits a rectangle of kernel rows and columns over the tile threads,
+    /// then waits for them to finish. Pixels outside it are not traced.
+    /// </summary>
+    /// <param name="fbi">The frame buffer that holds the rows.</param>
+    /// <param name="x">The first column.</param>
+    /// <param name="y">The first kernel row.</param>
+    /// <param name="width">The number of columns to render.</param>
+    /// <param name="rows">The number of rows to render.</param>
+    void synchronize(const rtFrameBufferInfo& fbi, SKint32 x, SKint32 y, SKint32 width, SKint32 rows);
+
+    /// <summary>
+    /// Splits every region over the tile threads, then waits for them.
+    /// </summary>
+    /// <remarks>
+    /// All regions are handed out in a single pass, so each thread
+    /// is woken once no matter how many views are being rendered.
+    /// </remarks>
+    /// <param name="regions">The regions to render.</param>
+    /// <param name="count">The number of regions.</param>
+    void synchronize(const rtTileRegion* regions, SKuint32 count);
+
+    /// <summary>
+    /// Splits count items over the tile threads, then waits for them.
+    /// </summary>
+    /// <param name="task">The work to run.</param>
+    /// <param name="count">The number of items.</param>
+    /// <param name="granularity">Each thread's first item is a multiple of this.</param>
+    void execute(rtTileTask* task, SKuint32 count, SKuint32 granularity);
 };
 
 #endif  //_rtTileManager_h_
@@ -23,6 +23,7 @@
 #include "RenderSystem/Cuda/rtCudaHostMath.h"
 #include "RenderSystem/Cuda/rtCudaUtils.h"
 #include "RenderSystem/rtCamera.h"
+#include "Utils/skMinMax.h"
 
 
 rtCudaRenderSystem::rtCudaRenderSystem() :
@@ -93,20 +94,10 @@ void rtCudaRenderSystem::initialize(rtScene* scene)
 
     // Cache any persistent per frame variables before spiting into tiles.
     // Any render method / sub method must be immutable.
-    m_camera = cameras.at(0);
-    
-    rtSceneType*  sc = m_scene->getPtr();
-    rtCameraType* ca = m_camera->getPtr();
-    updatePixelOffset();
-
-    ca->offset = {
-        m_iPixelOffset.x,
-        m_iPixelOffset.y,
-        m_iPixelOffset.z,
-        m_iPixelOffset.w,
-    };
-    sc->camera = ca;
-    sc->flags  = m_mode;
+    if (!m_camera || cameras.find(m_camera) == cameras.npos)
+        m_camera = cameras.at(0);
+    bindCamera();
+    m_scene->getPtr()->flags = m_mode;
 
     m_dirty = false;
 }
@@ -130,6 +121,19 @@ void rtCudaRenderSystem::render(rtScene* scene)
         m_scene->updateCaches();
 
         rtCudaKernelMain(&m_frameBuffer, m_cudaTarget, m_scene->getPtr());
-        rtCudaSwapBuffers(m_target->getFrameBufferInfo().pixels, m_cudaTarget);
+        const rtFrameBufferInfo& fbi = m_target->getFrameBufferInfo();
+        rtCudaSwapBuffers(fbi.pixels, m_cudaTarget);
+
+        if (fbi.bottomUp)
+        {
+            // The device buffer is top down.
+            for (SKuint32 top = 0, bottom = fbi.height - 1; top < bottom; ++top, --bottom)
+            {
+                SKubyte* a = fbi.pixels + (SKsize)top * fbi.pitch;
+                SKubyte* b = fbi.pixels + (SKsize)bottom * fbi.pitch;
+                for (SKuint32 i = 0; i < fbi.pitch; ++i)
+                    skSwap(a[i], b[i]);
+            }
+        }
     }
 }
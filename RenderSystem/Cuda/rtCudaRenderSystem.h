@@ -42,6 +42,8 @@ public:
     rtCudaRenderSystem();
     ~rtCudaRenderSystem() override;
 
+    using rtRenderSystem::render;
+
     void render(rtScene* scene) override;
 };
 
@@ -24,7 +24,10 @@
 #ifdef USING_CUDA
 #include "RenderSystem/Cuda/rtCudaUtils.h"
 #endif
-SKint32 rtAllocator::m_backend = RT_CPU;
+SKint32               rtAllocator::m_backend        = RT_CPU;
+thread_local rtArena* rtAllocator::m_arena          = nullptr;
+SKsize                rtAllocator::m_arenaBlockSize = rtArena::DefaultBlockSize;
+SKuint32              rtAllocator::m_arenaFlags     = RT_AF_NONE;
 
 void rtAllocator::setBackend(SKint32 allocator)
 {
@@ -33,6 +36,9 @@ void rtAllocator::setBackend(SKint32 allocator)
     case RT_CPU:
         m_backend = RT_CPU;
         break;
+    case RT_CPU_ARENA:
+        m_backend = RT_CPU_ARENA;
+        break;
 #ifdef USING_CUDA
     case RT_CUDA:
         m_backend = RT_CUDA;
@@ -44,3 +50,16 @@ void rtAllocator::setBackend(SKint32 allocator)
         throw std::runtime_error("Unknown allocator");
     }
 }
+
+void rtAllocator::setArenaOptions(const SKsize blockSize, const SKuint32 flags)
+{
+    m_arenaBlockSize = blockSize;
+    m_arenaFlags     = flags;
+}
+
+rtArena* rtAllocator::createArena()
+{
+    if (m_backend != RT_CPU_ARENA)
+        return nullptr;
+    return new rtArena(m_arenaBlockSize, m_arenaFlags);
+}
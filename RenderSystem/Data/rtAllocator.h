@@ -25,10 +25,13 @@
 #ifndef _rtAllocator_h_
 #define _rtAllocator_h_
 
+#include "RenderSystem/Data/rtArena.h"
 #include "RenderSystem/Data/rtBackendTypes.h"
 #include "Utils/skDisableWarnings.h"
+#include <cstring>
 #include <exception>
 #include <stdexcept>
+#include <type_traits>
 
 #ifdef USING_CUDA
 #include <cuda_runtime_api.h>
@@ -99,6 +102,15 @@ struct rtCpuObjectAllocator
         return (T*)mem;
     }
 
+    template <typename T>
+    static T* reallocateArray(T* ptr, SKuint32 capacity)
+    {
+        void* mem = realloc((void*)ptr, sizeof(T) * capacity);
+        if (mem == nullptr)
+            throw std::runtime_error("allocation failed.");
+        return (T*)mem;
+    }
+
     template <typename T>
     static void free(T* ptr)
     {
@@ -114,13 +126,56 @@ struct rtCpuObjectAllocator
     }
 };
 
+/// <summary>
+/// Allocates from an rtArena, or from the heap when no arena is given.
+/// </summary>
+struct rtArenaObjectAllocator
+{
+    template <typename T>
+    static T* allocate(rtArena* arena)
+    {
+        if (!arena)
+            return rtCpuObjectAllocator::allocate<T>();
+        return (T*)arena->allocate(sizeof(T));
+    }
+
+    template <typename T>
+    static T* allocateArray(rtArena* arena, SKuint32 capacity)
+    {
+        if (!arena)
+            return rtCpuObjectAllocator::allocateArray<T>(capacity);
+        return (T*)arena->allocate(sizeof(T) * (SKsize)capacity);
+    }
+
+    template <typename T>
+    static void free(rtArena* arena, T* ptr)
+    {
+        if (rtArena* owner = rtArena::find(ptr, arena))
+            owner->release(ptr);
+        else
+            rtCpuObjectAllocator::free<T>(ptr);
+    }
+
+    template <typename T>
+    static void freeArray(rtArena* arena, T* ptr)
+    {
+        if (rtArena* owner = rtArena::find(ptr, arena))
+            owner->release(ptr);
+        else
+            rtCpuObjectAllocator::freeArray<T>(ptr);
+    }
+};
+
 /// <summary>
 ///
 /// </summary>
 class rtAllocator
 {
 private:
-    static SKint32 m_backend;
+    static SKint32               m_backend;
+    static thread_local rtArena* m_arena;
+    static SKsize                m_arenaBlockSize;
+    static SKuint32              m_arenaFlags;
 
 public:
 
@@ -133,11 +188,50 @@ public:
     /// It is set to RT_CPU by default.
     /// If allocator parameter is set to RT_CUDA then
     /// the function rtCudaInitialize will be invoked.
+    /// If allocator parameter is set to RT_CPU_ARENA then every
+    /// rtScene allocates its data from its own arena, which is
+    /// freed in bulk when the scene is destroyed.
     /// An runtime_error will be thrown the parameter is anything other
     /// than a rtBackendTypes value or if Cuda fails to initialize.
     /// </remarks>
     static void setBackend(SKint32 allocator);
 
+    /// <summary>
+    /// Returns the current backend allocation type.
+    /// </summary>
+    static SKint32 getBackend();
+
+    /// <summary>
+    /// Sets the arena that RT_CPU_ARENA allocations made by the
+    /// calling thread are taken from.
+    /// </summary>
+    /// <param name="arena">The arena to use, or null to use the heap.</param>
+    /// <remarks>
+    /// Each thread has its own current arena, so a worker thread
+    /// allocates from the heap until it opens a scope of its own.
+    /// Prefer rtArenaScope, which restores the previous arena on exit.
+    /// </remarks>
+    static void setArena(rtArena* arena);
+
+    /// <summary>
+    /// Returns the arena that RT_CPU_ARENA allocations made by the
+    /// calling thread are taken from.
+    /// </summary>
+    static rtArena* getArena();
+
+    /// <summary>
+    /// Sets the options used when a scene creates its arena.
+    /// </summary>
+    /// <param name="blockSize">The minimum size of each arena block.</param>
+    /// <param name="flags">A combination of rtArenaFlags.</param>
+    static void setArenaOptions(SKsize blockSize, SKuint32 flags);
+
+    /// <summary>
+    /// Creates a new arena using the options given to setArenaOptions.
+    /// </summary>
+    /// <returns>A new arena when the backend is RT_CPU_ARENA, otherwise null.</returns>
+    static rtArena* createArena();
+
     /// <summary>
     /// 
     /// </summary>
@@ -149,6 +243,8 @@ public:
         T* mem;
         if (m_backend == RT_CPU)
             mem = rtCpuObjectAllocator::allocate<T>();
+        else if (m_backend == RT_CPU_ARENA)
+            mem = rtArenaObjectAllocator::allocate<T>(m_arena);
 #ifdef USING_CUDA
         else if (m_backend == RT_CUDA)
             mem = rtCudaObjectAllocator::allocate<T>();
@@ -172,6 +268,8 @@ public:
         T* mem;
         if (m_backend == RT_CPU)
             mem = rtCpuObjectAllocator::allocateArray<T>(capacity);
+        else if (m_backend == RT_CPU_ARENA)
+            mem = rtArenaObjectAllocator::allocateArray<T>(m_arena, capacity);
 #ifdef USING_CUDA
         else if (m_backend == RT_CUDA)
             mem = rtCudaObjectAllocator::allocateArray<T>(capacity);
@@ -183,7 +281,9 @@ public:
     }
 
     /// <summary>
-    ///
+    /// Grows an array to capacity elements, keeping the first oldSize
+    /// elements. The old block is released, so oldPtr must not be
+    /// used after this call.
     /// </summary>
     /// <typeparam name="T"></typeparam>
     /// <param name="oldPtr"></param>
@@ -195,20 +295,57 @@ public:
     {
         T* mem = nullptr;
         if (m_backend == RT_CPU)
+        {
+            if (std::is_trivially_copyable<T>::value)
+                return rtCpuObjectAllocator::reallocateArray<T>(oldPtr, capacity);
+
             mem = rtCpuObjectAllocator::allocateArray<T>(capacity);
+            copyArray<T>(mem, oldPtr, oldSize);
+            rtCpuObjectAllocator::freeArray<T>(oldPtr);
+        }
+        else if (m_backend == RT_CPU_ARENA)
+        {
+            // The last allocation of an arena can be extended
+            // without moving, which is the common case while a
+            // scene is being filled.
+            rtArena* owner = rtArena::find(oldPtr, m_arena);
+            if (owner && owner->grow(oldPtr, sizeof(T) * (SKsize)capacity))
+                return oldPtr;
+
+            mem = rtArenaObjectAllocator::allocateArray<T>(m_arena, capacity);
+            copyArray<T>(mem, oldPtr, oldSize);
+            rtArenaObjectAllocator::freeArray<T>(m_arena, oldPtr);
+        }
 #ifdef USING_CUDA
         else if (m_backend == RT_CUDA)
+        {
             mem = rtCudaObjectAllocator::allocateArray<T>(capacity);
+            copyArray<T>(mem, oldPtr, oldSize);
+            rtCudaObjectAllocator::freeArray<T>(oldPtr);
+        }
 #endif
         else
             throw std::runtime_error("reallocateArray: unknown allocator");
+        return mem;
+    }
 
-        if (mem && oldPtr && oldSize > 0)
+    /// <summary>
+    /// Copies count elements from src to dst, using memcpy
+    /// for trivially copyable types.
+    /// </summary>
+    template <typename T>
+    static void copyArray(T* dst, const T* src, SKuint32 count)
+    {
+        if (!dst || !src || count == 0)
+            return;
+
+        if (std::is_trivially_copyable<T>::value)
+            memcpy((void*)dst, (const void*)src, sizeof(T) * (SKsize)count);
+        else
         {
-            for (SKuint32 i = 0; i < oldSize; ++i)
-                mem[i] = oldPtr[i];
+            for (SKuint32 i = 0; i < count; ++i)
+                dst[i] = src[i];
         }
-        return mem;
     }
 
     /// <summary>
@@ -224,6 +361,8 @@ public:
 
         if (m_backend == RT_CPU)
             rtCpuObjectAllocator::free<T>(ptr);
+        else if (m_backend == RT_CPU_ARENA)
+            rtArenaObjectAllocator::free<T>(m_arena, ptr);
 #ifdef USING_CUDA
         else if (m_backend == RT_CUDA)
             rtCudaObjectAllocator::free<T>(ptr);
@@ -240,12 +379,52 @@ public:
     {
         if (m_backend == RT_CPU)
             rtCpuObjectAllocator::freeArray<T>(ptr);
+        else if (m_backend == RT_CPU_ARENA)
+            rtArenaObjectAllocator::freeArray<T>(m_arena, ptr);
 #ifdef USING_CUDA
         else if (m_backend == RT_CUDA)
             rtCudaObjectAllocator::freeArray<T>(ptr);
 #endif
     }
 };
+
+/// <summary>
+/// Directs RT_CPU_ARENA allocations to an arena for the
+/// lifetime of the scope.
+/// </summary>
+class rtArenaScope
+{
+private:
+    rtArena* m_previous;
+
+public:
+    explicit rtArenaScope(rtArena* arena) :
+        m_previous(rtAllocator::getArena())
+    {
+        rtAllocator::setArena(arena);
+    }
+
+    ~rtArenaScope()
+    {
+        rtAllocator::setArena(m_previous);
+    }
+};
+
 /*! @} */
 
+SK_INLINE SKint32 rtAllocator::getBackend()
+{
+    return m_backend;
+}
+
+SK_INLINE void rtAllocator::setArena(rtArena* arena)
+{
+    m_arena = arena;
+}
+
+SK_INLINE rtArena* rtAllocator::getArena()
+{
+    return m_arena;
+}
+
 #endif  //_rtAllocator_h_
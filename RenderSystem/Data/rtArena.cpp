@@ -0,0 +1,243 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "RenderSystem/Data/rtArena.h"
+#include "Utils/skMinMax.h"
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+
+#if SK_PLATFORM == SK_PLATFORM_WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+rtArena* rtArena::m_live = nullptr;
+
+// Guards m_live and the m_nextLive links.
+static std::mutex rtArenaLiveLock;
+
+// Every block starts with its header padded out to the alignment
+// so that the first allocation inside the block is aligned too.
+constexpr SKsize rtArenaHeaderSize = 64;
+constexpr SKsize rtArenaPageSize   = 0x1000;
+constexpr SKsize rtArenaHugePage   = 0x200000;
+
+static SKsize rtArenaAlign(const SKsize size, const SKsize alignment)
+{
+    return (size + (alignment - 1)) & ~(alignment - 1);
+}
+
+static void* rtArenaAlignedAlloc(const SKsize size)
+{
+#if SK_PLATFORM == SK_PLATFORM_WIN32
+    return _aligned_malloc(size, rtArena::Alignment);
+#else
+    void* mem = nullptr;
+    if (posix_memalign(&mem, rtArena::Alignment, size) != 0)
+        return nullptr;
+    return mem;
+#endif
+}
+
+static void rtArenaAlignedFree(void* ptr)
+{
+#if SK_PLATFORM == SK_PLATFORM_WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+rtArena::rtArena(const SKsize blockSize, const SKuint32 flags) :
+    m_head(nullptr),
+    m_nextLive(nullptr),
+    m_blockSize(rtArenaAlign(skMax<SKsize>(blockSize, rtArenaPageSize), rtArenaPageSize)),
+    m_reserved(0),
+    m_allocated(0),
+    m_flags(flags)
+{
+    std::lock_guard<std::mutex> lock(rtArenaLiveLock);
+    m_nextLive = m_live;
+    m_live     = this;
+}
+
+rtArena::~rtArena()
+{
+    reset();
+
+    std::lock_guard<std::mutex> lock(rtArenaLiveLock);
+    rtArena** link = &m_live;
+    while (*link && *link != this)
+        link = &(*link)->m_nextLive;
+    if (*link)
+        *link = m_nextLive;
+}
+
+rtArena::Block* rtArena::allocateBlock(const SKsize minimum)
+{
+    SKsize   total  = skMax<SKsize>(m_blockSize, minimum + rtArenaHeaderSize);
+    SKubyte* mem    = nullptr;
+    bool     mapped = false;
+
+#if SK_PLATFORM != SK_PLATFORM_WIN32
+    if (m_flags & RT_AF_HUGE_PAGES)
+    {
+        total = rtArenaAlign(total, rtArenaHugePage);
+        void* map;
+#ifdef MAP_HUGETLB
+        map = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (map == MAP_FAILED)
+#endif
+        {
+            // No reserved huge pages, so fall back to regular pages
+            // and ask for transparent huge pages instead.
+            map = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+            if (map != MAP_FAILED)
+                madvise(map, total, MADV_HUGEPAGE);
+#endif
+        }
+
+        if (map != MAP_FAILED)
+        {
+            mem    = (SKubyte*)map;
+            mapped = true;
+        }
+    }
+#endif
+
+    if (!mem)
+        mem = (SKubyte*)rtArenaAlignedAlloc(total);
+    if (!mem)
+        throw std::runtime_error("arena allocation failed.");
+
+    Block* block    = (Block*)mem;
+    block->next     = m_head;
+    block->base     = mem + rtArenaHeaderSize;
+    block->capacity = total - rtArenaHeaderSize;
+    block->used     = 0;
+    block->last     = 0;
+    block->mapped   = mapped;
+
+    m_head = block;
+    m_reserved += total;
+    return block;
+}
+
+void rtArena::freeBlock(Block* block)
+{
+#if SK_PLATFORM != SK_PLATFORM_WIN32
+    if (block->mapped)
+    {
+        munmap(block, block->capacity + rtArenaHeaderSize);
+        return;
+    }
+#endif
+    rtArenaAlignedFree(block);
+}
+
+void* rtArena::allocate(SKsize size)
+{
+    size = rtArenaAlign(skMax<SKsize>(size, 1), Alignment);
+
+    Block* block = m_head;
+    if (!block || block->used + size > block->capacity)
+        block = allocateBlock(size);
+
+    block->last = block->used;
+    block->used += size;
+    m_allocated += size;
+    return block->base + block->last;
+}
+
+bool rtArena::grow(void* ptr, SKsize size)
+{
+    Block* block = m_head;
+    if (!block || ptr != block->base + block->last)
+        return false;
+
+    size = rtArenaAlign(skMax<SKsize>(size, 1), Alignment);
+    if (block->last + size > block->capacity)
+        return false;
+
+    m_allocated -= block->used - block->last;
+    m_allocated += size;
+    block->used = block->last + size;
+    return true;
+}
+
+void rtArena::release(void* ptr)
+{
+    Block* block = m_head;
+    if (block && ptr == block->base + block->last && block->used != block->last)
+    {
+        m_allocated -= block->used - block->last;
+        block->used = block->last;
+    }
+}
+
+bool rtArena::owns(const void* ptr) const
+{
+    const SKubyte* mem = (const SKubyte*)ptr;
+
+    for (const Block* block = m_head; block; block = block->next)
+    {
+        if (mem >= block->base && mem < block->base + block->capacity)
+            return true;
+    }
+    return false;
+}
+
+void rtArena::reset()
+{
+    Block* block = m_head;
+    while (block)
+    {
+        Block* next = block->next;
+        freeBlock(block);
+        block = next;
+    }
+
+    m_head      = nullptr;
+    m_reserved  = 0;
+    m_allocated = 0;
+}
+
+rtArena* rtArena::find(const void* ptr, rtArena* hint)
+{
+    if (!ptr)
+        return nullptr;
+
+    // Nearly every pointer that is freed inside a scope came from
+    // that scope's arena, which avoids taking the lock.
+    if (hint && hint->owns(ptr))
+        return hint;
+
+    std::lock_guard<std::mutex> lock(rtArenaLiveLock);
+    for (rtArena* arena = m_live; arena; arena = arena->m_nextLive)
+    {
+        if (arena->owns(ptr))
+            return arena;
+    }
+    return nullptr;
+}
@@ -0,0 +1,186 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+/*! \addtogroup DataApi
+ * @{
+ */
+#ifndef _rtArena_h_
+#define _rtArena_h_
+
+#include "Utils/Config/skConfig.h"
+
+/// <summary>
+/// Flags that control how an rtArena acquires its blocks.
+/// </summary>
+enum rtArenaFlags
+{
+    /// <summary>
+    /// Blocks are allocated from the heap.
+    /// </summary>
+    RT_AF_NONE = 0x00,
+
+    /// <summary>
+    /// Blocks are backed by huge pages when the platform allows it.
+    /// If huge pages are unavailable the blocks silently
+    /// fall back to regular pages.
+    /// </summary>
+    RT_AF_HUGE_PAGES = 0x01,
+};
+
+/// <summary>
+/// Bump allocator that hands out 64-byte aligned memory from
+/// large blocks and releases every block at once when destroyed.
+/// </summary>
+/// <remarks>
+/// An arena is not thread safe. It is meant to be filled by the
+/// thread that loads a scene, and it is read by the kernel afterwards.
+/// The list of live arenas that find searches is shared, so arenas
+/// may be created and destroyed on any thread.
+/// </remarks>
+class rtArena
+{
+public:
+    /// <summary>
+    /// The alignment of every pointer returned by allocate.
+    /// </summary>
+    static const SKsize Alignment = 64;
+
+    /// <summary>
+    /// The default size of a single block.
+    /// </summary>
+    static const SKsize DefaultBlockSize = 0x200000;
+
+private:
+    struct Block
+    {
+        Block*   next;
+        SKubyte* base;
+        SKsize   capacity;
+        SKsize   used;
+        SKsize   last;
+        bool     mapped;
+    };
+
+    Block*   m_head;
+    rtArena* m_nextLive;
+    SKsize   m_blockSize;
+    SKsize   m_reserved;
+    SKsize   m_allocated;
+    SKuint32 m_flags;
+
+    static rtArena* m_live;
+
+    Block* allocateBlock(SKsize minimum);
+
+    static void freeBlock(Block* block);
+
+public:
+    /// <summary>
+    /// Creates an empty arena. No memory is reserved until the first allocation.
+    /// </summary>
+    /// <param name="blockSize">The minimum size of each block.</param>
+    /// <param name="flags">A combination of rtArenaFlags.</param>
+    explicit rtArena(SKsize blockSize = DefaultBlockSize, SKuint32 flags = RT_AF_NONE);
+
+    /// <summary>
+    /// Releases every block owned by this arena.
+    /// </summary>
+    ~rtArena();
+
+    /// <summary>
+    /// Returns a 64-byte aligned pointer to at least size bytes.
+    /// </summary>
+    /// <param name="size">The number of bytes requested.</param>
+    /// <returns>The memory or a runtime_error is thrown if the system is out of memory.</returns>
+    void* allocate(SKsize size);
+
+    /// <summary>
+    /// Attempts to grow the most recent allocation in place.
+    /// </summary>
+    /// <param name="ptr">A pointer previously returned by allocate.</param>
+    /// <param name="size">The new size in bytes.</param>
+    /// <returns>True if ptr now refers to at least size bytes.</returns>
+    bool grow(void* ptr, SKsize size);
+
+    /// <summary>
+    /// Gives back the memory of ptr if it was the most recent
+    /// allocation. Any other pointer is reclaimed when the arena is
+    /// reset or destroyed.
+    /// </summary>
+    /// <param name="ptr">A pointer previously returned by allocate.</param>
+    void release(void* ptr);
+
+    /// <summary>
+    /// Tests whether the pointer lies within one of this arena's blocks.
+    /// </summary>
+    /// <param name="ptr">Any pointer.</param>
+    bool owns(const void* ptr) const;
+
+    /// <summary>
+    /// Frees every block in a single pass.
+    /// </summary>
+    void reset();
+
+    /// <summary>
+    /// Returns the total number of bytes held in blocks.
+    /// </summary>
+    SKsize getReservedBytes() const;
+
+    /// <summary>
+    /// Returns the number of bytes handed out by allocate.
+    /// </summary>
+    SKsize getAllocatedBytes() const;
+
+    /// <summary>
+    /// Returns the flags this arena was created with.
+    /// </summary>
+    SKuint32 getFlags() const;
+
+    /// <summary>
+    /// Searches the live arenas for the one that owns ptr.
+    /// </summary>
+    /// <param name="ptr">Any pointer.</param>
+    /// <param name="hint">
+    /// An arena that is tested before the live list is searched,
+    /// usually the current arena of the calling thread.
+    /// </param>
+    /// <returns>The owning arena or null if the pointer came from elsewhere.</returns>
+    static rtArena* find(const void* ptr, rtArena* hint = nullptr);
+};
+
+/*! @} */
+
+SK_INLINE SKsize rtArena::getReservedBytes() const
+{
+    return m_reserved;
+}
+
+SK_INLINE SKsize rtArena::getAllocatedBytes() const
+{
+    return m_allocated;
+}
+
+SK_INLINE SKuint32 rtArena::getFlags() const
+{
+    return m_flags;
+}
+
+#endif  //_rtArena_h_
@@ -26,6 +26,7 @@
 #ifndef _rtArray_h_
 #define _rtArray_h_
 
+#include "Utils/skMinMax.h"
 #include "Utils/skTraits.h"
 #include "RenderSystem/Data/rtAllocator.h"
 
@@ -65,6 +66,7 @@ public:
         size     = 0;
         capacity = 0;
         rtAllocator::freeArray<T>(data);
+        data = nullptr;
     }
 
     /// <summary>
@@ -78,29 +80,59 @@ public:
             // This is using capacity plus one in order to reserve
             // and then push up to the max without expanding the
             // data. One more element after that will cause the expansion.
-            _capacity = skMin<SKuint32>(_capacity + 1, 0xFFFF);
+            if (_capacity < SK_MAX32)
+                ++_capacity;
+
             if (data)
-            {
                 data = rtAllocator::reallocateArray<T>(data, _capacity, size);
-
-                capacity = _capacity;
-            }
             else
-            {
                 data = rtAllocator::allocateArray<T>(_capacity);
 
-                capacity = _capacity;
-            }
+            capacity = _capacity;
         }
     }
 
+    /// <summary>
+    /// Sets the number of elements. New elements are default constructed.
+    /// </summary>
+    /// <param name="nr">The new size of the array.</param>
+    void resize(SKuint32 nr)
+    {
+        if (nr > capacity)
+            reserve(nr);
+
+        for (SKuint32 i = size; i < nr; ++i)
+            data[i] = ValueType();
+        size = nr;
+    }
+
+    /// <summary>
+    /// Appends count elements with a single capacity check.
+    /// </summary>
+    /// <param name="values">The elements to copy.</param>
+    /// <param name="count">The number of elements in values.</param>
+    void append(ConstPointerType values, SKuint32 count)
+    {
+        if (count == 0)
+            return;
+        if (count > SK_MAX32 - size)
+            throw std::runtime_error("Array limit exceeded.");
+
+        const SKuint32 nr = size + count;
+        if (nr > capacity)
+            reserve(skMax<SKuint32>(nr, skMin<SKuint32>(size, SK_MAX32 / 2) * 2));
+
+        rtAllocator::copyArray<T>(data + size, values, count);
+        size = nr;
+    }
+
     /// <summary>
     ///
     /// </summary>
     /// <param name="v"></param>
     void push_back(ConstReferenceType v)
     {
-        if (this->size + 1 <= 0xFFFF)
+        if (this->size < SK_MAX32)
         {
             // If the size of the array is known ahead of time
             // and the data is reserved before pushing any elements.
@@ -109,7 +141,7 @@ public:
             // push will not overflow the array.
             if (this->size + 1 > this->capacity)
             {
-                this->reserve(this->size == 0 ? SKInitalCap : this->size * 2);
+                this->reserve(this->size == 0 ? SKInitalCap : skMin<SKuint32>(this->size, SK_MAX32 / 2) * 2);
                 this->data[this->size++] = v;
             }
             else
@@ -104,6 +104,11 @@ enum rtBackendTypes
     /// TODO
     /// </summary>
     RT_OPEN_CL,
+
+    /// <summary>
+    /// Allocate from per-scene rtArena blocks on the CPU.
+    /// </summary>
+    RT_CPU_ARENA,
 };
 
 /*! @} */
@@ -0,0 +1,74 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+/*! \addtogroup DataApi
+ * @{
+ */
+
+#ifndef _rtMeshTypes_h_
+#define _rtMeshTypes_h_
+
+#include "RenderSystem/Math/rtVectorTypes.h"
+
+/// <summary>
+/// A strided view over indexed triangle data that may be owned by
+/// something other than the mesh, such as a loaded file.
+/// </summary>
+/// <remarks>
+/// Each vertex record starts with three rtScalar coordinates and each
+/// index record starts with a 32-bit index. Anything that follows them
+/// in a record is skipped over by the stride.
+/// </remarks>
+struct rtMeshView
+{
+    /// <summary>
+    /// The first vertex record.
+    /// </summary>
+    const SKubyte* vertices;
+
+    /// <summary>
+    /// The number of vertex records.
+    /// </summary>
+    SKuint32 vertexCount;
+
+    /// <summary>
+    /// The distance in bytes from one vertex record to the next.
+    /// </summary>
+    SKuint32 vertexStride;
+
+    /// <summary>
+    /// The first index record. Every three records make a triangle.
+    /// </summary>
+    const SKubyte* indices;
+
+    /// <summary>
+    /// The number of index records.
+    /// </summary>
+    SKuint32 indexCount;
+
+    /// <summary>
+    /// The distance in bytes from one index record to the next.
+    /// </summary>
+    SKuint32 indexStride;
+};
+
+/*! @} */
+#endif  //_rtMeshTypes_h_
@@ -0,0 +1,209 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+/*! \addtogroup DataApi
+ * @{
+ */
+#ifndef _rtPackedSceneType_h_
+#define _rtPackedSceneType_h_
+
+#include "RenderSystem/Data/rtArray.h"
+#include "RenderSystem/Data/rtMaterialTypes.h"
+#include "RenderSystem/Data/rtMeshTypes.h"
+#include "RenderSystem/Math/rtVectorTypes.h"
+
+class rtMeshBvh;
+
+/// <summary>
+/// Axis aligned bounds of a single packed object.
+/// </summary>
+struct rtPackedBounds
+{
+    /// <summary>
+    /// The minimum corner of the box.
+    /// </summary>
+    rtScalar bMin[3];
+
+    /// <summary>
+    /// The maximum corner of the box.
+    /// </summary>
+    rtScalar bMax[3];
+};
+
+/// <summary>
+/// A node of a bounding volume hierarchy. When count is zero the node is
+/// interior and its two children are stored next to each other, starting
+/// at first. Otherwise it is a leaf that holds count primitives, starting
+/// at first in the hierarchy's primitive order.
+/// </summary>
+struct rtPackedNode
+{
+    rtScalar bMin[3];
+    SKuint32 first;
+    rtScalar bMax[3];
+    SKuint32 count;
+};
+
+/// <summary>
+/// The transform that moves rays from world space into
+/// the space of a mesh, and the geometry that it instances.
+/// </summary>
+struct rtPackedInstance
+{
+    /// <summary>
+    /// The inverse of the object's rotation, by rows.
+    /// </summary>
+    rtScalar rotation[3][3];
+
+    /// <summary>
+    /// The object's world location.
+    /// </summary>
+    rtScalar location[3];
+
+    /// <summary>
+    /// The object's world scale. Rays are divided by it.
+    /// </summary>
+    rtScalar scale[3];
+
+    /// <summary>
+    /// An index into rtPackedSceneType::geometries,
+    /// or SK_NPOS32 if the object is not a mesh.
+    /// </summary>
+    SKuint32 geometry;
+};
+
+/// <summary>
+/// Geometry that is shared by one or more instances.
+/// </summary>
+struct rtPackedGeometry
+{
+    /// <summary>
+    /// The triangles, in mesh space.
+    /// </summary>
+    rtMeshView view;
+
+    /// <summary>
+    /// The hierarchy over the triangles. It is owned by the mesh geometry.
+    /// </summary>
+    const rtMeshBvh* bvh;
+};
+
+/// <summary>
+///
+/// </summary>
+using rtPackedBoundsArray = rtArray<rtPackedBounds>;
+
+/// <summary>
+///
+/// </summary>
+using rtPackedNodeArray = rtArray<rtPackedNode>;
+
+/// <summary>
+///
+/// </summary>
+using rtPackedInstanceArray = rtArray<rtPackedInstance>;
+
+/// <summary>
+///
+/// </summary>
+using rtPackedGeometryArray = rtArray<rtPackedGeometry>;
+
+/// <summary>
+///
+/// </summary>
+using rtPackedParamArray = rtArray<rtVector4>;
+
+/// <summary>
+///
+/// </summary>
+using rtPackedTypeArray = rtArray<SKint32>;
+
+/// <summary>
+///
+/// </summary>
+using rtPackedIndexArray = rtArray<SKuint32>;
+
+/// <summary>
+///
+/// </summary>
+using rtPackedMaterialArray = rtArray<rtMaterialType>;
+
+/// <summary>
+/// Flattened, structure of arrays copy of the scene's objects.
+/// </summary>
+/// <remarks>
+/// Every array is indexed by the object's position in rtSceneType::objects,
+/// so the kernel can traverse the scene without following the pointers
+/// stored in rtObjectType. It is compiled by rtScene::updateCaches.
+/// </remarks>
+struct rtPackedSceneType
+{
+    /// <summary>
+    /// The world space bounding box of each object.
+    /// </summary>
+    rtPackedBoundsArray bounds;
+
+    /// <summary>
+    /// The rtAttachedObjectType of each object.
+    /// </summary>
+    rtPackedTypeArray types;
+
+    /// <summary>
+    /// Per primitive parameters.
+    /// For spheres this is the center in xyz and the radius in w.
+    /// </summary>
+    rtPackedParamArray params;
+
+    /// <summary>
+    /// An index into the material table for each object.
+    /// </summary>
+    rtPackedIndexArray materials;
+
+    /// <summary>
+    /// The unique materials referenced by the objects.
+    /// </summary>
+    rtPackedMaterialArray materialTable;
+
+    /// <summary>
+    /// The instance transform of each object.
+    /// </summary>
+    rtPackedInstanceArray instances;
+
+    /// <summary>
+    /// The unique mesh geometry referenced by the instances.
+    /// </summary>
+    rtPackedGeometryArray geometries;
+
+    /// <summary>
+    /// The top level hierarchy over the bounds of the objects.
+    /// The first node is the root, and it is empty when there
+    /// are no objects.
+    /// </summary>
+    rtPackedNodeArray nodes;
+
+    /// <summary>
+    /// The object indices that the leaves of nodes reference.
+    /// </summary>
+    rtPackedIndexArray order;
+};
+
+/*! @} */
+#endif  //_rtPackedSceneType_h_
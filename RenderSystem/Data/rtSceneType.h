@@ -30,6 +30,7 @@
 #include "RenderSystem/Data/rtLightTypes.h"
 #include "RenderSystem/Data/rtCameraTypes.h"
 #include "RenderSystem/Data/rtObjectTypes.h"
+#include "RenderSystem/Data/rtPackedSceneType.h"
 
 
 /// <summary>
@@ -76,6 +77,11 @@ struct rtSceneType
     ///
     /// </summary>
     rtObjectArray objects;
+
+    /// <summary>
+    /// Packed copy of objects that is traversed by the CPU kernel.
+    /// </summary>
+    rtPackedSceneType packed;
 };
 
 /*! @} */
@@ -20,21 +20,103 @@
 -------------------------------------------------------------------------------
 */
 #include "rtAsciiLoader.h"
+#include <algorithm>
 #include <cstdio>
 #include "RenderSystem/rtCamera.h"
 #include "RenderSystem/rtCube.h"
 #include "RenderSystem/rtInteractiveCamera.h"
 #include "RenderSystem/rtLight.h"
+#include "RenderSystem/rtMesh.h"
 #include "RenderSystem/rtObject.h"
 #include "RenderSystem/rtPlane.h"
 #include "RenderSystem/rtScene.h"
 #include "RenderSystem/rtSphere.h"
 #include "RenderSystem/rtMaterial.h"
+#include "RenderSystem/rtTaskPool.h"
 #include "bAscii/bAscii.h"
 #include "bAscii/bAsciiArgument.h"
 #include "bAscii/bAsciiMain.h"
 #include "bAscii/bAsciiOpCodes.h"
 
+/// <summary>
+/// A mesh whose geometry is converted on a worker thread. Every object
+/// that uses the same bMesh is an instance of the one geometry.
+/// </summary>
+struct rtAsciiMeshJob
+{
+    bMesh*  me;
+    rtMesh* mesh;
+    bool    valid;
+};
+
+typedef skArray<rtAsciiMeshJob> rtAsciiMeshJobs;
+
+/// <summary>
+/// Fills in the triangles of each mesh job. Every job
+/// writes to its own geometry, so they may run in any order.
+/// </summary>
+class rtAsciiMeshTask final : public rtTask
+{
+private:
+    rtAsciiMeshJobs& m_jobs;
+    rtMesh::Indices& m_order;
+
+public:
+    rtAsciiMeshTask(rtAsciiMeshJobs& jobs, rtMesh::Indices& order) :
+        m_jobs(jobs),
+        m_order(order)
+    {
+    }
+
+    void execute(const SKuint32 index) override
+    {
+                // Finishing the triangles also builds their hierarchy. Called
+        // from a pool thread, the build stays on this thread rather
+        // than sharing its subtrees out over the pool again.
+rtAsciiMeshJob& job = m_jobs[m_order[index]];
+        job.valid           = convert(job.me, job.mesh);
+    }
+
+    static bool convert(bMesh* me, rtMesh* mesh)
+    {
+        // The vertices stay in mesh space,
+        // the object's scale is left to the transform.
+        const bSize vertexCount = me->vertices.size() / 3;
+        const bSize faceCount   = me->faces.size() / 4;
+
+        rtMesh::Vertices vertices;
+        rtMesh::Indices  indices;
+
+        vertices.reserve((SKuint32)vertexCount);
+        for (bSize v = 0; v < vertexCount; ++v)
+        {
+            const bNumber* co = &me->vertices[(SKuint32)(v * 3)];
+            vertices.push_back(skVector3(co[0], co[1], co[2]));
+        }
+
+        indices.reserve((SKuint32)faceCount * 6);
+        for (bSize f = 0; f < faceCount; ++f)
+        {
+            const bInteger* face = &me->faces[(SKuint32)(f * 4)];
+
+            indices.push_back((SKuint32)face[0]);
+            indices.push_back((SKuint32)face[1]);
+            indices.push_back((SKuint32)face[2]);
+            if (face[3] != 0)
+            {
+                indices.push_back((SKuint32)face[2]);
+                indices.push_back((SKuint32)face[3]);
+                indices.push_back((SKuint32)face[0]);
+            }
+        }
+
+        mesh->beginAddTriangles();
+        const bool valid = mesh->addIndexedTriangles(vertices.ptr(), vertices.size(), indices.ptr(), indices.size());
+        mesh->endAddTriangles();
+        return valid;
+    }
+};
+
 class rtAsciiLoaderPrivate
 {
 private:
@@ -102,27 +184,25 @@ public:
         }
         if (bv)
         {
-            if (ob->material)
-            {
-                rtMaterial* mat = bv->getMaterial();
-
-                bMaterial* ma = ob->material;
-
-                mat->setFlags(ma->flags);
-                mat->setColor(ma->color);
-                mat->setDiffuse(ma->diffuse);
-                mat->setAmbient(ma->ambient);
-                mat->setHardness(ma->hardness);
-                mat->setSpecular(ma->specular);
-
-            }
-
+            setMaterialProperties(ob, bv);
             setObjectProperties(ob, bv);
 
             m_current->addBoundingObject(bv);
         }
     }
 
+    void buildMesh(bObject* ob, rtMesh* mesh, const rtAsciiMeshJob& job) const
+    {
+        // Only the first instance reports a bad mesh.
+        if (!job.valid && job.mesh == mesh)
+            printf("mesh has out of range indices.\n");
+
+        setMaterialProperties(ob, mesh);
+        setObjectProperties(ob, mesh);
+
+        m_current->addMesh(mesh);
+    }
+
     void buildLight(bObject* ob) const
     {
         bLight* li = (bLight*)ob->data;
@@ -142,8 +222,71 @@ public:
         }
     }
 
+    void convertMeshes(rtAsciiMeshJobs& jobs) const
+    {
+        // Hand out the largest meshes first, so that one
+        // big mesh does not start after all the small ones.
+        rtMesh::Indices order;
+        order.resize(jobs.size());
+        for (SKuint32 i = 0; i < jobs.size(); ++i)
+            order[i] = i;
+
+        std::sort(order.begin(), order.end(), [&jobs](const SKuint32 a, const SKuint32 b) {
+            const bSize ca = jobs[a].me->faces.size();
+            const bSize cb = jobs[b].me->faces.size();
+            return ca != cb ? ca > cb : a < b;
+        });
+
+        rtAsciiMeshTask task(jobs, order);
+        rtTaskPool::execute(&task, order.size());
+    }
+
     int buildScene(bAscii* ascii) const
     {
+        typedef skHashTable<bMesh*, SKuint32> MeshLookup;
+
+        // The rtMesh objects are created up front, because their
+        // constructor allocates from the scene's arena, which is not
+        // shared between threads. Objects that use the same bMesh
+        // share its geometry, so it is converted once. The geometry
+        // is converted in parallel, then every object is added in
+        // file order.
+        rtAsciiMeshJobs  jobs;
+        rtMesh::Indices  meshJob;
+        skArray<rtMesh*> meshes;
+        MeshLookup       lookup;
+        meshJob.resize((SKuint32)m_active->objectCount);
+        meshes.resize((SKuint32)m_active->objectCount);
+
+        for (bSize i = 0; i < m_active->objectCount; ++i)
+        {
+            bObject* ob = m_active->objects[i];
+
+            meshJob[(SKuint32)i] = SK_NPOS32;
+            meshes[(SKuint32)i]  = nullptr;
+            if (ob->data && ob->type == LIB_BLOCK_MESH)
+            {
+                bMesh*  me   = (bMesh*)ob->data;
+                rtMesh* mesh = new rtMesh(m_current);
+
+                const SKsize pos = lookup.find(me);
+                if (pos != SK_NPOS)
+                {
+                    meshJob[(SKuint32)i] = lookup.at(pos);
+                    mesh->setGeometry(jobs[lookup.at(pos)].mesh->getGeometry());
+                }
+                else
+                {
+                    meshJob[(SKuint32)i] = jobs.size();
+                    lookup.insert(me, jobs.size());
+                    jobs.push_back({me, mesh, true});
+                }
+                meshes[(SKuint32)i] = mesh;
+            }
+        }
+
+        convertMeshes(jobs);
+
         for (bSize i = 0; i < m_active->objectCount; ++i)
         {
             bObject* ob = m_active->objects[i];
@@ -168,6 +311,9 @@ public:
             case LIB_BLOCK_PLANE:
                 buildObject(ob);
                 break;
+            case LIB_BLOCK_MESH:
+                buildMesh(ob, meshes[(SKuint32)i], jobs[meshJob[(SKuint32)i]]);
+                break;
             default:
                 break;
             }
@@ -178,6 +324,23 @@ public:
         return 0;
     }
 
+    static void setMaterialProperties(bObject* ob, rtBvObject* bv)
+    {
+        if (ob->material)
+        {
+            rtMaterial* mat = bv->getMaterial();
+
+            bMaterial* ma = ob->material;
+
+            mat->setFlags(ma->flags);
+            mat->setColor(ma->color);
+            mat->setDiffuse(ma->diffuse);
+            mat->setAmbient(ma->ambient);
+            mat->setHardness(ma->hardness);
+            mat->setSpecular(ma->specular);
+        }
+    }
+
     static void setObjectProperties(bObject* ob, rtObject* node)
     {
         node->setPosition(ob->location[0], ob->location[1], ob->location[2]);
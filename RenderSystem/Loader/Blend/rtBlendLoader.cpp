@@ -20,6 +20,7 @@
 -------------------------------------------------------------------------------
 */
 #include "rtBlendLoader.h"
+#include <algorithm>
 #include <cstdio>
 #include "Math/skColor.h"
 #include "RenderSystem/rtCamera.h"
@@ -28,6 +29,7 @@
 #include "RenderSystem/rtMesh.h"
 #include "RenderSystem/rtObject.h"
 #include "RenderSystem/rtScene.h"
+#include "RenderSystem/rtTaskPool.h"
 #include "Utils/skLogger.h"
 #include "ftBlend.h"
 
@@ -37,6 +39,145 @@ constexpr SKint32 OB_TYPE_LIGHT  = 10;
 
 using namespace ftFlags;
 
+// The structures that the loader reads. Chunks of any other
+// structure are skipped, rather than being rebuilt in memory.
+// Pointers to skipped chunks are linked as null.
+SKhash bfLoadedTypes[] = {
+    ftCharHashKey("FileGlobal").hash(),
+    ftCharHashKey("Scene").hash(),
+    ftCharHashKey("Base").hash(),
+    ftCharHashKey("World").hash(),
+    ftCharHashKey("Collection").hash(),
+    ftCharHashKey("CollectionChild").hash(),
+    ftCharHashKey("CollectionObject").hash(),
+    ftCharHashKey("Object").hash(),
+    ftCharHashKey("Mesh").hash(),
+    ftCharHashKey("MVert").hash(),
+    ftCharHashKey("MPoly").hash(),
+    ftCharHashKey("MLoop").hash(),
+    ftCharHashKey("Material").hash(),
+    ftCharHashKey("Camera").hash(),
+    ftCharHashKey("Lamp").hash(),
+    0,
+};
+
+/// <summary>
+/// A mesh whose geometry is converted on a worker thread. Every object
+/// that uses the same Blender mesh is an instance of the one geometry.
+/// </summary>
+struct bfMeshJob
+{
+    Blender::Mesh* me;
+    rtMesh*        mesh;
+    bool           valid;
+};
+
+/// <summary>
+/// An object in the order that it was found in the scene.
+/// </summary>
+struct bfObjectEntry
+{
+    Blender::Object* ob;
+    rtMesh*          mesh;
+    SKuint32         job;
+};
+
+typedef skArray<bfMeshJob>                    bfMeshJobs;
+typedef skArray<bfObjectEntry>                bfObjectEntries;
+typedef skHashTable<Blender::Mesh*, SKuint32> bfMeshLookup;
+
+/// <summary>
+/// Converts Blender polygons into the triangles of each mesh job.
+/// Every job writes to its own geometry, so they may run in any order.
+/// </summary>
+class bfMeshTask final : public rtTask
+{
+private:
+    bfMeshJobs&      m_jobs;
+    rtMesh::Indices& m_order;
+
+public:
+    bfMeshTask(bfMeshJobs& jobs, rtMesh::Indices& order) :
+        m_jobs(jobs),
+        m_order(order)
+    {
+    }
+
+    void execute(const SKuint32 index) override
+    {
+                // Finishing the triangles also builds their hierarchy. Called
+        // from a pool thread, the build stays on this thread rather
+        // than sharing its subtrees out over the pool again.
+bfMeshJob& job = m_jobs[m_order[index]];
+        job.valid      = convert(job.me, job.mesh);
+    }
+
+    static bool convert(Blender::Mesh* me, rtMesh* mesh)
+    {
+        // The vertices are referenced in place. They stay valid for as
+        // long as the loader, which keeps the file open until its scenes
+        // are deleted. The object's scale is left to the transform.
+        rtMeshView view = {
+            (const SKubyte*)me->mvert,
+            me->mvert ? (SKuint32)me->totvert : 0,
+            (SKuint32)sizeof(Blender::MVert),
+            nullptr,
+            0,
+            (SKuint32)sizeof(Blender::MLoop),
+        };
+
+        // A mesh made only of triangles whose loops follow each other
+        // is already a triangle list, so the loops are referenced too.
+        bool triangles = me->mloop != nullptr;
+        for (int f = 0; f < me->totpoly && triangles; ++f)
+            triangles = me->mpoly[f].totloop == 3 && me->mpoly[f].loopstart == f * 3;
+
+        if (triangles)
+        {
+            view.indices    = (const SKubyte*)me->mloop;
+            view.indexCount = (SKuint32)me->totpoly * 3;
+            return mesh->setView(view);
+        }
+
+        rtMesh::Indices& indices = mesh->getIndices();
+        indices.resizeFast(0);
+        indices.reserve((SKuint32)me->totpoly * 6);
+        for (int f = 0; f < me->totpoly; ++f)
+        {
+            Blender::MPoly& cp = me->mpoly[f];
+            if (cp.totloop == 4)
+            {
+                const Blender::MLoop& i0 = me->mloop[cp.loopstart];
+                const Blender::MLoop& i1 = me->mloop[cp.loopstart + 1];
+                const Blender::MLoop& i2 = me->mloop[cp.loopstart + 2];
+                const Blender::MLoop& i3 = me->mloop[cp.loopstart + 3];
+
+                indices.push_back(i0.v);
+                indices.push_back(i1.v);
+                indices.push_back(i2.v);
+                indices.push_back(i2.v);
+                indices.push_back(i3.v);
+                indices.push_back(i0.v);
+            }
+            else if (cp.totloop == 3)
+            {
+                const Blender::MLoop& i0 = me->mloop[cp.loopstart];
+                const Blender::MLoop& i1 = me->mloop[cp.loopstart + 1];
+                const Blender::MLoop& i2 = me->mloop[cp.loopstart + 2];
+
+                indices.push_back(i0.v);
+                indices.push_back(i1.v);
+                indices.push_back(i2.v);
+            }
+        }
+
+        view.indices     = (const SKubyte*)indices.ptr();
+        view.indexCount  = indices.size();
+        view.indexStride = (SKuint32)sizeof(SKuint32);
+        return mesh->setView(view);
+    }
+};
+
 class rtBlendLoaderPrivate
 {
 private:
@@ -44,6 +185,9 @@ private:
     ftBlend*        m_blend;
     rtScene*        m_current;
     Blender::Scene* m_blenderScene;
+    bfObjectEntries m_entries;
+    bfMeshJobs      m_jobs;
+    bfMeshLookup    m_lookup;
 
 public:
     rtBlendLoaderPrivate(rtBlendLoader* parent) :
@@ -54,16 +198,16 @@ public:
     {
     }
 
-    ~rtBlendLoaderPrivate()
-    {
-        delete m_blend;
-        m_blend = nullptr;
-    }
+    ~rtBlendLoaderPrivate() = default;
 
     int load(const char* path)
     {
+        // The parent owns the file, since its meshes reference it.
         m_blend = new ftBlend();
+        m_parent->m_files.push_back(m_blend);
+
         m_blend->setFileFlags(LF_DIAGNOSTICS | LF_MIS_REPORTED);
+        m_blend->setFilterList(bfLoadedTypes, sizeof(bfLoadedTypes) / sizeof(SKhash), true);
 
         int status = m_blend->load(path, RM_COMPRESSED);
         if (status != FS_OK)
@@ -101,7 +245,7 @@ public:
         return FS_OK;
     }
 
-    int bfLoadMesh(Blender::Mesh* me, Blender::Object* ob) const
+    rtMesh* bfCreateMesh(Blender::Mesh* me) const
     {
         rtMesh* mesh = new rtMesh(m_current);
 
@@ -123,46 +267,18 @@ public:
             rmat->setSpecular(mat->spec);
             rmat->setHardness(255);
         }
+        return mesh;
+    }
 
-        const skVector3& bakedScale = skVector3(ob->size[0], ob->size[1], ob->size[2]);
-        mesh->beginAddTriangles();
-
-        for (int f = 0; f < me->totpoly; ++f)
-        {
-            Blender::MPoly& cp = me->mpoly[f];
-            if (cp.totloop == 4)
-            {
-                const Blender::MLoop& i0 = me->mloop[cp.loopstart];
-                const Blender::MLoop& i1 = me->mloop[cp.loopstart + 1];
-                const Blender::MLoop& i2 = me->mloop[cp.loopstart + 2];
-                const Blender::MLoop& i3 = me->mloop[cp.loopstart + 3];
-
-                skVector3 v0 = skVector3(&me->mvert[i0.v].co[0]) * bakedScale;
-                skVector3 v1 = skVector3(&me->mvert[i1.v].co[0]) * bakedScale;
-                skVector3 v2 = skVector3(&me->mvert[i2.v].co[0]) * bakedScale;
-                skVector3 v3 = skVector3(&me->mvert[i3.v].co[0]) * bakedScale;
-
-                mesh->addTriangle(i0.v, i1.v, i2.v, v0, v1, v2);
-                mesh->addTriangle(i2.v, i3.v, i0.v, v2, v3, v0);
-            }
-            else if (cp.totloop == 3)
-            {
-                const Blender::MLoop& i0 = me->mloop[cp.loopstart];
-                const Blender::MLoop& i1 = me->mloop[cp.loopstart + 1];
-                const Blender::MLoop& i2 = me->mloop[cp.loopstart + 2];
-
-                skVector3 v0 = skVector3(&me->mvert[i0.v].co[0]) * bakedScale;
-                skVector3 v1 = skVector3(&me->mvert[i1.v].co[0]) * bakedScale;
-                skVector3 v2 = skVector3(&me->mvert[i2.v].co[0]) * bakedScale;
-
-                mesh->addTriangle(i0.v, i1.v, i2.v, v0, v1, v2);
-            }
-        }
-
-        mesh->endAddTriangles();
+    int bfLoadMesh(const bfObjectEntry& entry) const
+    {
+        // Only the first instance reports a bad mesh.
+        const bfMeshJob& job = m_jobs[entry.job];
+        if (!job.valid && job.mesh == entry.mesh)
+            printf("Mesh %s has out of range indices.\n", job.me->id.name + 2);
 
-        setObjectProperties(ob, mesh);
-        m_current->addMesh(mesh);
+        setObjectProperties(entry.ob, entry.mesh);
+        m_current->addMesh(entry.mesh);
         return FS_OK;
     }
 
@@ -193,46 +309,73 @@ public:
         return FS_OK;
     }
 
-    int bfLoadObject(Blender::Object* ob) const
+    int bfLoadObject(const bfObjectEntry& entry) const
     {
-        if (ob)
+        Blender::Object* ob = entry.ob;
+        switch (ob->type)
         {
-            if (ob->data)
+        case OB_TYPE_MESH:
+            bfLoadMesh(entry);
+            break;
+        case OB_TYPE_CAMERA:
+
+            // only interested in the main camera for now
+            if (m_blenderScene->camera == ob)
+                bfLoadCamera(ob, (Blender::Camera*)ob->data);
+            break;
+        case OB_TYPE_LIGHT:
+            bfLoadLight(ob, (Blender::Lamp*)ob->data);
+            break;
+        default:
+            break;
+        }
+        return FS_OK;
+    }
+
+    void bfGatherObject(Blender::Object* ob)
+    {
+        if (ob && ob->data)
+        {
+            rtMesh*  mesh = nullptr;
+            SKuint32 job  = SK_NPOS32;
+            if (ob->type == OB_TYPE_MESH)
             {
-                switch (ob->type)
+                // The rtMesh is created here, because its constructor
+                // allocates from the scene's arena, which is not shared
+                // between threads. Only its geometry is filled in later,
+                // once for all of the objects that share the Blender mesh.
+                Blender::Mesh* me = (Blender::Mesh*)ob->data;
+
+                mesh = bfCreateMesh(me);
+
+                const SKsize pos = m_lookup.find(me);
+                if (pos != SK_NPOS)
                 {
-                case OB_TYPE_MESH:
-                    bfLoadMesh((Blender::Mesh*)ob->data, ob);
-                    break;
-                case OB_TYPE_CAMERA:
-
-                    // only interested in the main camera for now
-                    if (m_blenderScene->camera == ob)
-                        bfLoadCamera(ob, (Blender::Camera*)ob->data);
-                    break;
-                case OB_TYPE_LIGHT:
-                    bfLoadLight(ob, (Blender::Lamp*)ob->data);
-                    break;
-                default:
-                    break;
+                    job = m_lookup.at(pos);
+                    mesh->setGeometry(m_jobs[job].mesh->getGeometry());
+                }
+                else
+                {
+                    job = m_jobs.size();
+                    m_lookup.insert(me, job);
+                    m_jobs.push_back({me, mesh, true});
                 }
             }
+            m_entries.push_back({ob, mesh, job});
         }
-        return FS_OK;
     }
 
-    int bfIterateCollectionObject(Blender::CollectionObject* colObject) const
+    void bfIterateCollectionObject(Blender::CollectionObject* colObject)
     {
         while (colObject)
         {
             if (colObject->ob)
-                bfLoadObject(colObject->ob);
+                bfGatherObject(colObject->ob);
             colObject = colObject->next;
         }
-        return FS_OK;
     }
 
-    int bfIterateCollectionChild(Blender::Collection* root) const
+    void bfIterateCollectionChild(Blender::Collection* root)
     {
         if (root)
         {
@@ -248,11 +391,29 @@ public:
             while (obj)
             {
                 if (obj->ob)
-                    bfLoadObject(obj->ob);
+                    bfGatherObject(obj->ob);
                 obj = obj->next;
             }
         }
-        return FS_OK;
+    }
+
+    void bfConvertMeshes()
+    {
+        // Hand out the largest meshes first, so that one
+        // big mesh does not start after all the small ones.
+        rtMesh::Indices order;
+        order.resize(m_jobs.size());
+        for (SKuint32 i = 0; i < m_jobs.size(); ++i)
+            order[i] = i;
+
+        std::sort(order.begin(), order.end(), [this](const SKuint32 a, const SKuint32 b) {
+            const int ca = m_jobs[a].me->totpoly;
+            const int cb = m_jobs[b].me->totpoly;
+            return ca != cb ? ca > cb : a < b;
+        });
+
+        bfMeshTask task(m_jobs, order);
+        rtTaskPool::execute(&task, order.size());
     }
 
     int bfLoadScene()
@@ -263,19 +424,27 @@ public:
         m_current = new rtScene();
         m_parent->addScene(m_current);
 
-        int status = FS_OK;
-
-        if (m_blenderScene->base.first)
+        // Objects are gathered in the order they are found, the meshes
+        // are converted in parallel, then everything is added to the
+        // scene in the gathered order. The result does not depend on
+        // the number of threads.
+        for (Blender::Base* base = (Blender::Base*)m_blenderScene->base.first;
+             base;
+             base = (Blender::Base*)base->next)
         {
-            for (Blender::Base* base = (Blender::Base*)m_blenderScene->base.first;
-                 base && status == FS_OK;
-                 base = (Blender::Base*)base->next)
-            {
-                if (base->object)
-                    status = bfLoadObject(base->object);
-            }
+            if (base->object)
+                bfGatherObject(base->object);
         }
 
+        if (m_blenderScene->master_collection)
+            bfIterateCollectionChild(m_blenderScene->master_collection);
+
+        bfConvertMeshes();
+
+        int status = FS_OK;
+        for (SKuint32 i = 0; i < m_entries.size() && status == FS_OK; ++i)
+            status = bfLoadObject(m_entries[i]);
+
         if (status == FS_OK)
         {
             Blender::World* wo = m_blenderScene->world;
@@ -284,14 +453,22 @@ public:
                 m_current->setHorizon(skColor(wo->horr, wo->horg, wo->horb));
                 m_current->setZenith(m_current->getHorizon());
             }
-
-            if (m_blenderScene->master_collection)
-                status = bfIterateCollectionChild(m_blenderScene->master_collection);
         }
         return status;
     }
 };
 
+rtBlendLoader::~rtBlendLoader()
+{
+    // The scenes go first, since their meshes reference the files.
+    for (rtScene* scene : m_scenes)
+        delete scene;
+    m_scenes.clear();
+
+    for (ftBlend* file : m_files)
+        delete file;
+}
+
 int rtBlendLoader::load(const char* path)
 {
     rtBlendLoaderPrivate impl(this);
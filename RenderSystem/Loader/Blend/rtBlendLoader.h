@@ -24,17 +24,25 @@
 
 #include "RenderSystem/Loader/rtLoader.h"
 
+class ftBlend;
+
 /// <summary>
 /// Blend file implementation of the rtLoader class
 /// </summary>
+/// <remarks>
+/// Mesh vertices are referenced in the loaded file rather than copied,
+/// so the files stay open until the loader and its scenes are deleted.
+/// </remarks>
 class rtBlendLoader final : public rtLoader
 {
 private:
     friend class rtBlendLoaderPrivate;
 
+    skArray<ftBlend*> m_files;
+
 public:
-    rtBlendLoader()           = default;
-    ~rtBlendLoader() override = default;
+    rtBlendLoader() = default;
+    ~rtBlendLoader() override;
 
     /// <seealso cref="rtLoader"/>
     int load(const char* path) override;
@@ -0,0 +1,171 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+/*! \addtogroup FrontEnd
+ * @{
+ */
+#ifndef _rtSceneFile_h_
+#define _rtSceneFile_h_
+
+#include "Math/skQuaternion.h"
+#include "Math/skVector3.h"
+#include "RenderSystem/Data/rtMaterialTypes.h"
+#include "RenderSystem/Data/rtPackedSceneType.h"
+
+/// <summary>
+/// Describes the layout of a .rtscene file.
+/// </summary>
+/// <remarks>
+/// A file is a Header, followed by an array of Section entries.
+/// Each section is an array of fixed size records that starts on an
+/// Alignment boundary, so that it can be used directly from a mapping
+/// of the file. Records are stored in the byte order and scalar size of
+/// the program that wrote them. A file that does not match is rejected
+/// rather than converted, since it can be written again from its source.
+/// Sections with unknown codes are skipped by the loader.
+/// The hierarchies are stored as they were built, so that the loader
+/// can trace them in place. One that does not match its triangles or
+/// objects is built again rather than used.
+/// </remarks>
+namespace rtSceneFile
+{
+    constexpr SKuint32 makeCode(const char a, const char b, const char c, const char d)
+    {
+        return (SKuint32)a | (SKuint32)b << 8 | (SKuint32)c << 16 | (SKuint32)d << 24;
+    }
+
+    constexpr SKuint32 Magic     = makeCode('R', 'T', 'S', 'C');
+    // Version 2 stores mesh vertices in mesh space, without the object's scale.
+    // Version 3 adds the hierarchies of the meshes and of the scene's objects.
+    constexpr SKuint32 Version   = 3;
+    constexpr SKuint32 ByteOrder = 0x01020304;
+    constexpr SKuint64 Alignment = 16;
+
+    enum SectionCode : SKuint32
+    {
+        SC_SCENE     = makeCode('S', 'C', 'N', 'E'),  //!< A single Scene record.
+        SC_MATERIALS = makeCode('M', 'A', 'T', 'L'),  //!< rtMaterialType records.
+        SC_OBJECTS   = makeCode('O', 'B', 'J', 'T'),  //!< Object records.
+        SC_MESHES    = makeCode('M', 'E', 'S', 'H'),  //!< Mesh records.
+        SC_VERTICES  = makeCode('V', 'E', 'R', 'T'),  //!< skVector3 records shared by every mesh.
+        SC_INDICES   = makeCode('I', 'N', 'D', 'X'),  //!< SKuint32 records shared by every mesh.
+        SC_LIGHTS    = makeCode('L', 'I', 'T', 'E'),  //!< Light records.
+        SC_CAMERAS   = makeCode('C', 'A', 'M', 'R'),  //!< Camera records.
+        SC_NODES     = makeCode('N', 'O', 'D', 'E'),  //!< rtPackedNode records shared by every mesh.
+        SC_TRIANGLES = makeCode('T', 'O', 'R', 'D'),  //!< SKuint32 triangle numbers shared by every mesh.
+        SC_TOP_NODES = makeCode('T', 'N', 'O', 'D'),  //!< rtPackedNode records over SC_OBJECTS.
+        SC_TOP_ORDER = makeCode('T', 'O', 'B', 'J'),  //!< SKuint32 object numbers in leaf order.
+    };
+
+    struct Header
+    {
+        SKuint32 magic;
+        SKuint32 version;
+        SKuint32 byteOrder;
+        SKuint16 scalarSize;      //!< sizeof(skScalar)
+        SKuint16 realSize;        //!< sizeof(rtScalar)
+        SKuint32 sectionCount;
+        SKuint32 reserved[3];
+    };
+
+    struct Section
+    {
+        SKuint32 code;
+        SKuint32 stride;  //!< The size of a single record.
+        SKuint64 offset;  //!< The offset of the first record from the start of the file.
+        SKuint64 count;   //!< The number of records.
+        SKuint64 reserved;
+    };
+
+    /// <summary>
+    /// The local transform of an object.
+    /// </summary>
+    struct Transform
+    {
+        skVector3    location;
+        skQuaternion orientation;
+        skVector3    scale;
+    };
+
+    struct Scene
+    {
+        SKuint32  flags;
+        rtVector3 horizon;
+        rtVector3 zenith;
+    };
+
+    struct Object
+    {
+        SKint32   type;      //!< One of the RT_AO_SHAPE_* values.
+        SKuint32  material;  //!< An index into SC_MATERIALS.
+        SKuint32  mesh;      //!< An index into SC_MESHES for RT_AO_SHAPE_MESH.
+        SKuint32  reserved;
+        Transform transform;
+
+        /// <summary>
+        /// The shape's parameters, the cube's extent, the sphere's
+        /// radius or the plane's normal followed by its point.
+        /// </summary>
+        skScalar params[6];
+    };
+
+    /// <summary>
+    /// A mesh's range of the shared vertex, index, node and triangle
+    /// sections. The indices are relative to the mesh's first vertex,
+    /// and the nodes and triangle numbers are those of its rtMeshBvh,
+    /// relative to its first node and first triangle number.
+    /// </summary>
+    struct Mesh
+    {
+        SKuint32 firstVertex;
+        SKuint32 vertexCount;
+        SKuint32 firstIndex;
+        SKuint32 indexCount;
+        SKuint32 firstNode;
+        SKuint32 nodeCount;
+        SKuint32 firstTriangle;
+        SKuint32 triangleCount;
+    };
+
+    struct Light
+    {
+        SKint32   mode;
+        rtScalar  energy;
+        rtScalar  elevation;
+        rtScalar  decay;
+        rtScalar  radius;
+        Transform transform;
+    };
+
+    struct Camera
+    {
+        SKint32   type;  //!< RT_AO_CAMERA or RT_AO_USER_CAMERA.
+        rtScalar  fovY;
+        rtScalar  zNear;
+        rtScalar  zFar;
+        skScalar  fixedDistance;
+        Transform transform;
+    };
+}  // namespace rtSceneFile
+
+/*! @} */
+
+#endif  //_rtSceneFile_h_
@@ -0,0 +1,390 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "rtSceneFileLoader.h"
+#include <cstdio>
+#include "RenderSystem/Loader/Scene/rtSceneFile.h"
+#include "RenderSystem/rtCamera.h"
+#include "RenderSystem/rtCube.h"
+#include "RenderSystem/rtInteractiveCamera.h"
+#include "RenderSystem/rtLight.h"
+#include "RenderSystem/rtMaterial.h"
+#include "RenderSystem/rtMesh.h"
+#include "RenderSystem/rtPlane.h"
+#include "RenderSystem/rtScene.h"
+#include "RenderSystem/rtSphere.h"
+#include "ftStreams.h"
+
+using namespace rtSceneFile;
+
+class rtSceneFileLoaderPrivate
+{
+private:
+    template <typename T>
+    struct Records
+    {
+        const T* ptr;
+        SKuint32 size;
+    };
+
+    rtSceneFileLoader* m_parent;
+    rtScene*           m_current;
+    ftMappedStream*    m_stream;
+    const SKbyte*      m_data;
+    SKsize             m_size;
+    const Section*     m_sections;
+    SKuint32           m_sectionCount;
+
+    Records<Scene>          m_scene;
+    Records<rtMaterialType> m_materials;
+    Records<Object>         m_objects;
+    Records<Mesh>           m_meshes;
+    Records<skVector3>      m_vertices;
+    Records<SKuint32>       m_indices;
+    Records<Light>          m_lights;
+    Records<Camera>         m_cameras;
+    Records<rtPackedNode>   m_nodes;
+    Records<SKuint32>       m_triangles;
+    Records<rtPackedNode>   m_topNodes;
+    Records<SKuint32>       m_topOrder;
+
+public:
+    explicit rtSceneFileLoaderPrivate(rtSceneFileLoader* parent) :
+        m_parent(parent),
+        m_current(nullptr),
+        m_stream(nullptr),
+        m_data(nullptr),
+        m_size(0),
+        m_sections(nullptr),
+        m_sectionCount(0),
+        m_scene(),
+        m_materials(),
+        m_objects(),
+        m_meshes(),
+        m_vertices(),
+        m_indices(),
+        m_lights(),
+        m_cameras(),
+        m_nodes(),
+        m_triangles(),
+        m_topNodes(),
+        m_topOrder()
+    {
+    }
+
+    ~rtSceneFileLoaderPrivate() = default;
+
+    bool readHeader()
+    {
+        if (m_size < sizeof(Header))
+            return false;
+
+        const Header* header = (const Header*)m_data;
+        if (header->magic != Magic ||
+            header->version != Version ||
+            header->byteOrder != ByteOrder ||
+            header->scalarSize != sizeof(skScalar) ||
+            header->realSize != sizeof(rtScalar))
+            return false;
+
+        if (header->sectionCount > (m_size - sizeof(Header)) / sizeof(Section))
+            return false;
+
+        m_sections     = (const Section*)(m_data + sizeof(Header));
+        m_sectionCount = header->sectionCount;
+        return true;
+    }
+
+    /// <summary>
+    /// Points dest at the records of the section with the supplied code.
+    /// A missing section is read as an empty one.
+    /// </summary>
+    /// <returns>False if the section does not fit in the file.</returns>
+    template <typename T>
+    bool findSection(const SKuint32 code, Records<T>& dest) const
+    {
+        dest = {nullptr, 0};
+        for (SKuint32 i = 0; i < m_sectionCount; ++i)
+        {
+            const Section& sec = m_sections[i];
+            if (sec.code != code)
+                continue;
+
+            if (sec.stride != sizeof(T) ||
+                sec.offset % Alignment != 0 ||
+                sec.offset > m_size ||
+                sec.count > (m_size - sec.offset) / sizeof(T) ||
+                sec.count >= SK_NPOS32)
+                return false;
+
+            if (sec.count > 0)
+                dest = {(const T*)(m_data + sec.offset), (SKuint32)sec.count};
+            return true;
+        }
+        return true;
+    }
+
+    bool findSections()
+    {
+        bool result = findSection(SC_SCENE, m_scene);
+        result      = result && findSection(SC_MATERIALS, m_materials);
+        result      = result && findSection(SC_OBJECTS, m_objects);
+        result      = result && findSection(SC_MESHES, m_meshes);
+        result      = result && findSection(SC_VERTICES, m_vertices);
+        result      = result && findSection(SC_INDICES, m_indices);
+        result      = result && findSection(SC_LIGHTS, m_lights);
+        result      = result && findSection(SC_CAMERAS, m_cameras);
+        result      = result && findSection(SC_NODES, m_nodes);
+        result      = result && findSection(SC_TRIANGLES, m_triangles);
+        result      = result && findSection(SC_TOP_NODES, m_topNodes);
+        result      = result && findSection(SC_TOP_ORDER, m_topOrder);
+        return result && m_scene.size == 1;
+    }
+
+    static void setObjectProperties(const Transform& transform, rtObject* node)
+    {
+        node->setPosition(transform.location);
+        node->setOrientation(transform.orientation);
+        node->setScale(transform.scale);
+    }
+
+    bool buildMesh(const Object& ob, rtMesh* mesh, skArray<rtMeshGeometry*>& geometries) const
+    {
+        if (ob.mesh >= m_meshes.size)
+            return false;
+
+        // Objects that reference the same mesh record are
+        // instances of the geometry that was built for the first.
+        if (geometries[ob.mesh])
+        {
+            mesh->setGeometry(geometries[ob.mesh]);
+            return true;
+        }
+
+        const Mesh& me = m_meshes.ptr[ob.mesh];
+        if ((SKuint64)me.firstVertex + me.vertexCount > m_vertices.size ||
+            (SKuint64)me.firstIndex + me.indexCount > m_indices.size)
+            return false;
+
+        // The records are referenced in the mapping rather than copied.
+        // They were indexed when the file was written, so nothing is welded.
+        const rtMeshView view = {
+            (const SKubyte*)(m_vertices.ptr + me.firstVertex),
+            me.vertexCount,
+            (SKuint32)sizeof(skVector3),
+            (const SKubyte*)(m_indices.ptr + me.firstIndex),
+            me.indexCount,
+            (SKuint32)sizeof(SKuint32),
+        };
+
+        // So is the hierarchy, if it is there. The geometry checks
+        // that it fits the triangles and builds one if it does not.
+        rtMeshBvh::View hierarchy = {};
+        if ((SKuint64)me.firstNode + me.nodeCount <= m_nodes.size &&
+            (SKuint64)me.firstTriangle + me.triangleCount <= m_triangles.size &&
+            me.nodeCount > 0)
+        {
+            hierarchy = {
+                m_nodes.ptr + me.firstNode,
+                me.nodeCount,
+                m_triangles.ptr + me.firstTriangle,
+                me.triangleCount,
+            };
+        }
+
+        const bool result = mesh->setView(view, hierarchy);
+
+        if (result)
+            geometries[ob.mesh] = mesh->getGeometry();
+        return result;
+    }
+
+    bool buildObject(const Object& ob, skArray<rtMeshGeometry*>& geometries) const
+    {
+        if (ob.material >= m_materials.size)
+            return false;
+
+        rtBvObject* bv     = nullptr;
+        rtMesh*     mesh   = nullptr;
+        bool        result = true;
+
+        switch (ob.type)
+        {
+        case RT_AO_SHAPE_CUBE:
+        {
+            rtCube* rc = new rtCube(m_current);
+            bv         = rc;
+            rc->setExtent(ob.params[0]);
+            break;
+        }
+        case RT_AO_SHAPE_SPHERE:
+        {
+            rtSphere* rs = new rtSphere(m_current);
+            bv           = rs;
+            rs->setRadius(ob.params[0]);
+            break;
+        }
+        case RT_AO_SHAPE_PLANE:
+        {
+            rtPlane* rp = new rtPlane(m_current);
+            bv          = rp;
+            rp->setNormal(skVector3(ob.params[0], ob.params[1], ob.params[2]));
+            rp->setPoint(skVector3(ob.params[3], ob.params[4], ob.params[5]));
+            break;
+        }
+        case RT_AO_SHAPE_MESH:
+            mesh   = new rtMesh(m_current);
+            bv     = mesh;
+            result = buildMesh(ob, mesh, geometries);
+            break;
+        default:
+            return false;
+        }
+
+        bv->getMaterial()->getData() = m_materials.ptr[ob.material];
+        setObjectProperties(ob.transform, bv);
+
+        if (mesh)
+            m_current->addMesh(mesh);
+        else
+            m_current->addBoundingObject(bv);
+        return result;
+    }
+
+    void buildLight(const Light& li) const
+    {
+        rtLight* light = new rtLight(m_current);
+
+        // The values were limited by the setters when the
+        // file was written, so they are copied as they are.
+        rtLightType& data = light->getData();
+        data.mode         = li.mode;
+        data.energy       = li.energy;
+        data.elevation    = li.elevation;
+        data.decay        = li.decay;
+        data.radius       = li.radius;
+
+        setObjectProperties(li.transform, light);
+        m_current->addLight(light);
+    }
+
+    void buildCamera(const Camera& ca) const
+    {
+        rtCamera* rc;
+        if (ca.type == RT_AO_USER_CAMERA)
+        {
+            rtInteractiveCamera* ic = new rtInteractiveCamera(m_current);
+            ic->setFixedDistance(ca.fixedDistance);
+            rc = ic;
+        }
+        else
+            rc = new rtCamera(m_current);
+
+        rc->setNear(ca.zNear);
+        rc->setFar(ca.zFar);
+        rc->setFieldOfViewAngle(ca.fovY);
+
+        setObjectProperties(ca.transform, rc);
+        m_current->addCamera(rc);
+    }
+
+    int buildScene() const
+    {
+        const Scene& sc = *m_scene.ptr;
+        m_current->setFlags(sc.flags);
+        m_current->setHorizon(skColor(sc.horizon.x, sc.horizon.y, sc.horizon.z));
+        m_current->setZenith(skColor(sc.zenith.x, sc.zenith.y, sc.zenith.z));
+
+        // Cameras go first, planes use the first camera to size their bounds.
+        for (SKuint32 i = 0; i < m_cameras.size; ++i)
+            buildCamera(m_cameras.ptr[i]);
+
+        skArray<rtMeshGeometry*> geometries;
+        geometries.resize(m_meshes.size);
+        for (SKuint32 i = 0; i < m_meshes.size; ++i)
+            geometries[i] = nullptr;
+
+        for (SKuint32 i = 0; i < m_objects.size; ++i)
+        {
+            if (!buildObject(m_objects.ptr[i], geometries))
+            {
+                printf("Object %u has invalid data.\n", i);
+                return -1;
+            }
+        }
+
+        for (SKuint32 i = 0; i < m_lights.size; ++i)
+            buildLight(m_lights.ptr[i]);
+
+        // The scene copies the top level hierarchy when it is first compiled.
+        if (m_topNodes.size > 0)
+            m_current->setPrebuiltHierarchy({m_topNodes.ptr, m_topNodes.size, m_topOrder.ptr, m_topOrder.size});
+        return 0;
+    }
+
+    int load(const char* path)
+    {
+        m_stream = new ftMappedStream();
+        m_parent->m_files.push_back(m_stream);
+
+        m_stream->open(path, skStream::READ);
+        if (!m_stream->isOpen())
+        {
+            printf("Failed to load %s.\n", path);
+            return -1;
+        }
+
+        m_data = m_stream->addressAtPosition();
+        m_size = m_stream->size();
+
+        if (!readHeader())
+        {
+            printf("'%s' is not a .rtscene file that this build can read.\n", path);
+            return -1;
+        }
+        if (!findSections())
+        {
+            printf("'%s' has invalid sections.\n", path);
+            return -1;
+        }
+
+        m_current = new rtScene();
+        m_parent->addScene(m_current);
+        return buildScene();
+    }
+};
+
+rtSceneFileLoader::~rtSceneFileLoader()
+{
+    // The scenes go first, since their meshes reference the mappings.
+    for (rtScene* scene : m_scenes)
+        delete scene;
+    m_scenes.clear();
+
+    for (ftMappedStream* file : m_files)
+        delete file;
+}
+
+int rtSceneFileLoader::load(const char* path)
+{
+    rtSceneFileLoaderPrivate impl(this);
+    return impl.load(path);
+}
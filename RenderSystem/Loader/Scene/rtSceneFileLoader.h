@@ -0,0 +1,60 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _rtSceneFileLoader_h_
+#define _rtSceneFileLoader_h_
+
+#include "RenderSystem/Loader/rtLoader.h"
+
+class ftMappedStream;
+
+/// <summary>
+/// .rtscene implementation of the rtLoader class
+/// </summary>
+/// <remarks>
+/// The file is mapped into memory and its sections are read in place,
+/// so there is nothing to parse and mesh vertices are not welded again.
+/// Meshes reference their vertices, indices and hierarchies in the
+/// mapping, so the files stay mapped until the loader and its scenes
+/// are deleted.
+/// </remarks>
+class rtSceneFileLoader final : public rtLoader
+{
+private:
+    friend class rtSceneFileLoaderPrivate;
+
+    skArray<ftMappedStream*> m_files;
+
+public:
+    rtSceneFileLoader() = default;
+    ~rtSceneFileLoader() override;
+
+    /// <see cref="rtLoader"/>
+    int load(const char* path) override;
+
+    /// <see cref="rtLoader"/>
+    void addScene(rtScene* sc)
+    {
+        m_scenes.push_back(sc);
+    }
+};
+
+#endif  //_rtSceneFileLoader_h_
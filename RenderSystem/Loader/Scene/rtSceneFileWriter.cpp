@@ -0,0 +1,319 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "rtSceneFileWriter.h"
+#include <cstdio>
+#include "RenderSystem/Loader/Scene/rtSceneFile.h"
+#include "RenderSystem/rtCamera.h"
+#include "RenderSystem/rtCube.h"
+#include "RenderSystem/rtInteractiveCamera.h"
+#include "RenderSystem/rtLight.h"
+#include "RenderSystem/rtMaterial.h"
+#include "RenderSystem/rtMesh.h"
+#include "RenderSystem/rtPlane.h"
+#include "RenderSystem/rtScene.h"
+#include "RenderSystem/rtSphere.h"
+#include "Utils/skFileStream.h"
+
+using namespace rtSceneFile;
+
+class rtSceneFileWriterPrivate
+{
+private:
+    struct Block
+    {
+        SKuint32    code;
+        SKuint32    stride;
+        SKuint32    count;
+        const void* data;
+    };
+
+    typedef skHashTable<rtMeshGeometry*, SKuint32> GeometryLookup;
+
+    Scene                   m_scene;
+    skArray<rtMaterialType> m_materials;
+    skArray<Object>         m_objects;
+    skArray<Mesh>           m_meshes;
+    GeometryLookup          m_geometries;
+    rtMesh::Vertices        m_vertices;
+    rtMesh::Indices         m_indices;
+    skArray<rtPackedNode>   m_nodes;
+    skArray<SKuint32>       m_triangles;
+    skArray<rtPackedNode>   m_topNodes;
+    skArray<SKuint32>       m_topOrder;
+    skArray<Light>          m_lights;
+    skArray<Camera>         m_cameras;
+
+    static SKuint64 align(const SKuint64 offset)
+    {
+        return (offset + Alignment - 1) & ~(Alignment - 1);
+    }
+
+    static void getTransform(rtObject* node, Transform& dest)
+    {
+        dest.location    = node->getPosition();
+        dest.orientation = node->getOrientation();
+        dest.scale       = node->getScale();
+    }
+
+    void addMesh(const rtMesh* mesh, Object& dest)
+    {
+        // Instances of the same geometry share one mesh record.
+        const SKsize pos = m_geometries.find(mesh->getGeometry());
+        if (pos != SK_NPOS)
+        {
+            dest.mesh = m_geometries.at(pos);
+            return;
+        }
+        m_geometries.insert(mesh->getGeometry(), m_meshes.size());
+
+        // The mesh may be a view over another file's arrays,
+        // so its records are read one at a time through it.
+        const SKuint32 vertexCount = mesh->getVertexCount();
+        const SKuint32 indexCount  = mesh->getIndexCount();
+
+        // The hierarchy is stored as it is, its node
+        // numbers are already relative to its first node.
+        const rtMeshBvh::View& bvh = mesh->getBvh().getView();
+
+        dest.mesh = m_meshes.size();
+        m_meshes.push_back({
+            m_vertices.size(),
+            vertexCount,
+            m_indices.size(),
+            indexCount,
+            m_nodes.size(),
+            bvh.nodeCount,
+            m_triangles.size(),
+            bvh.triangleCount,
+        });
+
+        m_nodes.reserve(m_nodes.size() + bvh.nodeCount);
+        for (SKuint32 i = 0; i < bvh.nodeCount; ++i)
+            m_nodes.push_back(bvh.nodes[i]);
+
+        m_triangles.reserve(m_triangles.size() + bvh.triangleCount);
+        for (SKuint32 i = 0; i < bvh.triangleCount; ++i)
+            m_triangles.push_back(bvh.triangles[i]);
+
+        m_vertices.reserve(m_vertices.size() + vertexCount);
+        for (SKuint32 i = 0; i < vertexCount; ++i)
+            m_vertices.push_back(mesh->getVertex(i));
+
+        m_indices.reserve(m_indices.size() + indexCount);
+        for (SKuint32 i = 0; i < indexCount; ++i)
+            m_indices.push_back(mesh->getIndex(i));
+    }
+
+    void addObject(rtBvObject* bv)
+    {
+        Object rec = {};
+        rec.type   = bv->getType();
+        rec.mesh   = SK_NPOS32;
+        getTransform(bv, rec.transform);
+
+        switch (rec.type)
+        {
+        case RT_AO_SHAPE_CUBE:
+            rec.params[0] = ((rtCube*)bv)->getExtent();
+            break;
+        case RT_AO_SHAPE_SPHERE:
+            rec.params[0] = ((rtSphere*)bv)->getRadius();
+            break;
+        case RT_AO_SHAPE_PLANE:
+        {
+            const skPlane& pl = ((rtPlane*)bv)->getLocalPlane();
+
+            rec.params[0] = pl.n.x;
+            rec.params[1] = pl.n.y;
+            rec.params[2] = pl.n.z;
+            rec.params[3] = pl.p0.x;
+            rec.params[4] = pl.p0.y;
+            rec.params[5] = pl.p0.z;
+            break;
+        }
+        case RT_AO_SHAPE_MESH:
+            addMesh((rtMesh*)bv, rec);
+            break;
+        default:
+            printf("Skipping an object of unknown type %i.\n", rec.type);
+            return;
+        }
+
+        // Every object owns its material, so each one gets a record.
+        rec.material = m_materials.size();
+        m_materials.push_back(bv->getMaterial()->getData());
+        m_objects.push_back(rec);
+    }
+
+    void addLight(rtLight* light)
+    {
+        Light rec     = {};
+        rec.mode      = light->getMode();
+        rec.energy    = light->getEnergy();
+        rec.elevation = light->getElevation();
+        rec.decay     = light->getDecay();
+        rec.radius    = light->getRadius();
+        getTransform(light, rec.transform);
+        m_lights.push_back(rec);
+    }
+
+    void addCamera(rtCamera* camera)
+    {
+        Camera rec = {};
+        rec.type   = camera->getType();
+        rec.fovY   = camera->getFieldOfViewAngle();
+        rec.zNear  = camera->getNear();
+        rec.zFar   = camera->getFar();
+
+        if (rec.type == RT_AO_USER_CAMERA)
+            rec.fixedDistance = ((rtInteractiveCamera*)camera)->getFixedDistance();
+
+        getTransform(camera, rec.transform);
+        m_cameras.push_back(rec);
+    }
+
+public:
+    rtSceneFileWriterPrivate() :
+        m_scene()
+    {
+    }
+
+    void build(rtScene* scene)
+    {
+        const rtSceneType& data = scene->getData();
+
+        m_scene.flags   = scene->getFlags();
+        m_scene.horizon = data.horizon;
+        m_scene.zenith  = data.zenith;
+
+        for (rtBvObject* bv : scene->getBoundingVolumes())
+            addObject(bv);
+
+        // The top level hierarchy numbers the objects in the order that
+        // they were added, so it can only be kept if none were skipped.
+        const rtMeshBvh::View& bvh = scene->getHierarchy().getView();
+        if (m_objects.size() == scene->getBoundingVolumes().size() && bvh.triangleCount == m_objects.size())
+        {
+            m_topNodes.reserve(bvh.nodeCount);
+            for (SKuint32 i = 0; i < bvh.nodeCount; ++i)
+                m_topNodes.push_back(bvh.nodes[i]);
+
+            m_topOrder.reserve(bvh.triangleCount);
+            for (SKuint32 i = 0; i < bvh.triangleCount; ++i)
+                m_topOrder.push_back(bvh.triangles[i]);
+        }
+
+        for (rtCamera* camera : scene->getCameras())
+            addCamera(camera);
+
+        for (rtObject* node : scene->getObjects())
+        {
+            if (node->getType() == RT_AO_LIGHT)
+                addLight((rtLight*)node);
+        }
+    }
+
+    int write(const char* path) const
+    {
+        const Block blocks[] = {
+            {SC_SCENE, sizeof(Scene), 1, &m_scene},
+            {SC_MATERIALS, sizeof(rtMaterialType), m_materials.size(), m_materials.ptr()},
+            {SC_OBJECTS, sizeof(Object), m_objects.size(), m_objects.ptr()},
+            {SC_MESHES, sizeof(Mesh), m_meshes.size(), m_meshes.ptr()},
+            {SC_VERTICES, sizeof(skVector3), m_vertices.size(), m_vertices.ptr()},
+            {SC_INDICES, sizeof(SKuint32), m_indices.size(), m_indices.ptr()},
+            {SC_LIGHTS, sizeof(Light), m_lights.size(), m_lights.ptr()},
+            {SC_CAMERAS, sizeof(Camera), m_cameras.size(), m_cameras.ptr()},
+            {SC_NODES, sizeof(rtPackedNode), m_nodes.size(), m_nodes.ptr()},
+            {SC_TRIANGLES, sizeof(SKuint32), m_triangles.size(), m_triangles.ptr()},
+            {SC_TOP_NODES, sizeof(rtPackedNode), m_topNodes.size(), m_topNodes.ptr()},
+            {SC_TOP_ORDER, sizeof(SKuint32), m_topOrder.size(), m_topOrder.ptr()},
+        };
+
+        constexpr SKuint32 count = sizeof(blocks) / sizeof(Block);
+
+        Header header       = {};
+        header.magic        = Magic;
+        header.version      = Version;
+        header.byteOrder    = ByteOrder;
+        header.scalarSize   = (SKuint16)sizeof(skScalar);
+        header.realSize     = (SKuint16)sizeof(rtScalar);
+        header.sectionCount = count;
+
+        Section  sections[count] = {};
+        SKuint64 offset          = align(sizeof(Header) + sizeof(sections));
+        for (SKuint32 i = 0; i < count; ++i)
+        {
+            sections[i].code   = blocks[i].code;
+            sections[i].stride = blocks[i].stride;
+            sections[i].offset = offset;
+            sections[i].count  = blocks[i].count;
+
+            offset = align(offset + (SKuint64)blocks[i].stride * blocks[i].count);
+        }
+
+        skFileStream fs(path, skStream::WRITE);
+        if (!fs.isOpen())
+        {
+            printf("Failed to open %s.\n", path);
+            return -1;
+        }
+
+        bool result = fs.write(&header, sizeof(Header)) == sizeof(Header);
+        result      = result && fs.write(sections, sizeof(sections)) == sizeof(sections);
+
+        SKuint64 position = sizeof(Header) + sizeof(sections);
+        for (SKuint32 i = 0; i < count && result; ++i)
+        {
+            static const SKubyte padding[Alignment] = {};
+
+            const SKsize pad = (SKsize)(sections[i].offset - position);
+            const SKsize len = (SKsize)blocks[i].stride * blocks[i].count;
+
+            if (pad > 0)
+                result = fs.write(padding, pad) == pad;
+            if (len > 0)
+                result = result && fs.write(blocks[i].data, len) == len;
+            position = sections[i].offset + len;
+        }
+
+        if (!result)
+        {
+            printf("Failed to write %s.\n", path);
+            return -1;
+        }
+        return 0;
+    }
+};
+
+int rtSceneFileWriter::save(rtScene* scene, const char* path)
+{
+    if (!scene || !path)
+        return -1;
+
+    // The scene is compiled first, so that its top level hierarchy is current.
+    scene->updateCaches();
+
+    rtSceneFileWriterPrivate impl;
+    impl.build(scene);
+    return impl.write(path);
+}
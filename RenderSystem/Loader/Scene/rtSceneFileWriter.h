@@ -0,0 +1,43 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _rtSceneFileWriter_h_
+#define _rtSceneFileWriter_h_
+
+#include "RenderSystem/rtCommon.h"
+
+/// <summary>
+/// Writes a loaded scene to a .rtscene file, so that
+/// it can be loaded later with rtSceneFileLoader.
+/// </summary>
+class rtSceneFileWriter
+{
+public:
+    /// <summary>
+    /// Writes the scene to the supplied path.
+    /// </summary>
+    /// <param name="scene">The scene to write.</param>
+    /// <param name="path">File system path to the output file.</param>
+    /// <returns>Returns -1 on error or 0 on success.</returns>
+    static int save(rtScene* scene, const char* path);
+};
+
+#endif  //_rtSceneFileWriter_h_
@@ -20,7 +20,11 @@
 -------------------------------------------------------------------------------
 */
 #include "RenderSystem/Loader/rtLoader.h"
+#include "RenderSystem/Loader/Ascii/rtAsciiLoader.h"
+#include "RenderSystem/Loader/Blend/rtBlendLoader.h"
+#include "RenderSystem/Loader/Scene/rtSceneFileLoader.h"
 #include "RenderSystem/rtScene.h"
+#include "Utils/skString.h"
 
 rtLoader::rtLoader() = default;
 
@@ -29,3 +33,16 @@ rtLoader::~rtLoader()
     for (rtScene* scene : m_scenes)
         delete scene;
 }
+
+rtLoader* rtLoader::create(const char* path)
+{
+    const skString file(path);
+
+    if (file.endsWith(".blend"))
+        return new rtBlendLoader();
+    if (file.endsWith(".bascii"))
+        return new rtAsciiLoader();
+    if (file.endsWith(".rtscene"))
+        return new rtSceneFileLoader();
+    return nullptr;
+}
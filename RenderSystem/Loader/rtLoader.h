@@ -57,6 +57,12 @@ public:
     /// <returns>Should return -1 on error or 0 on success.</returns>
     virtual int load(const char* path) = 0;
 
+    /// <summary>
+    /// Creates a loader for the extension of path.
+    /// </summary>
+    /// <param name="path">A path that ends with .blend, .bascii or .rtscene.</param>
+    /// <returns>A new loader, or null if the extension is not supported.</returns>
+    static rtLoader* create(const char* path);
 
     /// <summary>
     /// Access to scene instances
@@ -0,0 +1,138 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+#include <thread>
+#include "RenderSystem/Data/rtAllocator.h"
+#include "RenderSystem/Data/rtArena.h"
+
+GTEST_TEST(Arena, Allocate)
+{
+    rtArena arena(0x1000);
+
+    void* a = arena.allocate(1);
+    void* b = arena.allocate(100);
+    EXPECT_EQ(0u, (SKsize)a % rtArena::Alignment);
+    EXPECT_EQ(0u, (SKsize)b % rtArena::Alignment);
+    EXPECT_EQ((SKubyte*)a + rtArena::Alignment, (SKubyte*)b);
+    EXPECT_EQ(3 * rtArena::Alignment, arena.getAllocatedBytes());
+
+    // Larger than a block, so it gets a block of its own.
+    void* c = arena.allocate(0x3000);
+    EXPECT_TRUE(arena.owns(c));
+    EXPECT_TRUE(arena.owns((SKubyte*)c + 0x2FFF));
+    EXPECT_GE(arena.getReservedBytes(), (SKsize)0x4000);
+
+    arena.reset();
+    EXPECT_EQ(0u, arena.getAllocatedBytes());
+    EXPECT_EQ(0u, arena.getReservedBytes());
+    EXPECT_FALSE(arena.owns(a));
+}
+
+GTEST_TEST(Arena, GrowAndRelease)
+{
+    rtArena arena(0x1000);
+
+    void* a = arena.allocate(64);
+    void* b = arena.allocate(64);
+
+    // Only the most recent allocation can grow or be given back.
+    EXPECT_FALSE(arena.grow(a, 256));
+    EXPECT_TRUE(arena.grow(b, 256));
+    EXPECT_EQ(320u, arena.getAllocatedBytes());
+    EXPECT_FALSE(arena.grow(b, 0x2000));
+
+    arena.release(a);
+    EXPECT_EQ(320u, arena.getAllocatedBytes());
+    arena.release(b);
+    EXPECT_EQ(64u, arena.getAllocatedBytes());
+    EXPECT_EQ(b, arena.allocate(64));
+}
+
+GTEST_TEST(Arena, Find)
+{
+    rtArena first, second;
+
+    void* a = first.allocate(16);
+    void* b = second.allocate(16);
+    int   c = 0;
+
+    EXPECT_EQ(&first, rtArena::find(a));
+    EXPECT_EQ(&second, rtArena::find(b));
+    EXPECT_EQ(nullptr, rtArena::find(&c));
+    EXPECT_EQ(nullptr, rtArena::find(nullptr));
+
+    // A hint that does not own the pointer falls back to the search.
+    EXPECT_EQ(&first, rtArena::find(a, &first));
+    EXPECT_EQ(&first, rtArena::find(a, &second));
+}
+
+GTEST_TEST(Arena, Backend)
+{
+    rtAllocator::setBackend(RT_CPU_ARENA);
+    {
+        rtArena      arena;
+        rtArenaScope scope(&arena);
+
+        SKuint32* values = rtAllocator::allocateArray<SKuint32>(16);
+        for (SKuint32 i = 0; i < 16; ++i)
+            values[i] = i;
+        EXPECT_EQ(&arena, rtArena::find(values));
+
+        // The last allocation grows in place and keeps its contents.
+        SKuint32* grown = rtAllocator::reallocateArray<SKuint32>(values, 64, 16);
+        EXPECT_EQ(values, grown);
+        for (SKuint32 i = 0; i < 16; ++i)
+            EXPECT_EQ(i, grown[i]);
+
+        rtAllocator::freeArray<SKuint32>(grown);
+        EXPECT_EQ(0u, arena.getAllocatedBytes());
+    }
+
+    // Without a scope the arena backend allocates from the heap.
+    SKuint32* heap = rtAllocator::allocateArray<SKuint32>(16);
+    EXPECT_EQ(nullptr, rtArena::find(heap));
+    rtAllocator::freeArray<SKuint32>(heap);
+
+    rtAllocator::setBackend(RT_CPU);
+}
+
+GTEST_TEST(Arena, ScopeIsPerThread)
+{
+    rtArena      arena;
+    rtArenaScope scope(&arena);
+    EXPECT_EQ(&arena, rtAllocator::getArena());
+
+    rtArena* seen  = &arena;
+    rtArena* inner = nullptr;
+    std::thread worker([&seen, &inner] {
+        seen = rtAllocator::getArena();
+
+        rtArena      own;
+        rtArenaScope workerScope(&own);
+        inner = rtAllocator::getArena() == &own ? &own : nullptr;
+    });
+    worker.join();
+
+    EXPECT_EQ(nullptr, seen);
+    EXPECT_NE(nullptr, inner);
+    EXPECT_EQ(&arena, rtAllocator::getArena());
+}
@@ -0,0 +1,262 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include "RenderSystem/Cpu/rtCpuRayQuery.h"
+#include "RenderSystem/Data/rtAllocator.h"
+#include "RenderSystem/Data/rtArray.h"
+#include "RenderSystem/rtScene.h"
+#include "RenderSystem/rtSphere.h"
+
+// More elements than a 16 bit index can reach.
+constexpr SKuint32 LargeCount = 70000;
+
+const SKint32 Backends[] = {RT_CPU, RT_CPU_ARENA};
+
+// Selects an allocation backend, and an arena for
+// RT_CPU_ARENA, for the lifetime of the scope.
+class BackendScope
+{
+private:
+    rtArena      m_arena;
+    rtArenaScope m_scope;
+
+public:
+    explicit BackendScope(const SKint32 backend) :
+        m_scope(backend == RT_CPU_ARENA ? &m_arena : nullptr)
+    {
+        rtAllocator::setBackend(backend);
+    }
+
+    ~BackendScope()
+    {
+        rtAllocator::setBackend(RT_CPU);
+    }
+
+    rtArena& getArena()
+    {
+        return m_arena;
+    }
+};
+
+// Not trivially copyable, so reallocateArray has to copy it element by element.
+struct Counted
+{
+    SKuint32 value;
+
+    static SKuint32 copies;
+
+    Counted& operator=(const Counted& rhs)
+    {
+        value = rhs.value;
+        ++copies;
+        return *this;
+    }
+};
+
+SKuint32 Counted::copies = 0;
+
+GTEST_TEST(Array, PushBackLarge)
+{
+    for (const SKint32 backend : Backends)
+    {
+        SCOPED_TRACE(backend);
+        BackendScope scope(backend);
+
+        // Pushing to both in turn means that, in the arena, the array
+        // that grows is rarely the last allocation, so it is moved.
+        rtArray<SKuint32> a, b;
+        for (SKuint32 i = 0; i < LargeCount; ++i)
+        {
+            a.push_back(i);
+            b.push_back(LargeCount - i);
+        }
+
+        ASSERT_EQ(LargeCount, a.size);
+        ASSERT_EQ(LargeCount, b.size);
+        EXPECT_LE(a.size, a.capacity);
+
+        for (SKuint32 i = 0; i < LargeCount; ++i)
+        {
+            ASSERT_EQ(i, a.data[i]);
+            ASSERT_EQ(LargeCount - i, b.data[i]);
+        }
+
+        if (backend == RT_CPU_ARENA)
+            EXPECT_EQ(&scope.getArena(), rtArena::find(a.data));
+    }
+}
+
+GTEST_TEST(Array, AppendAndResize)
+{
+    for (const SKint32 backend : Backends)
+    {
+        SCOPED_TRACE(backend);
+        BackendScope scope(backend);
+
+        skArray<SKuint32> values;
+        for (SKuint32 i = 0; i < LargeCount; ++i)
+            values.push_back(i * 3);
+
+        rtArray<SKuint32> a;
+        a.resize(10);
+        for (SKuint32 i = 0; i < 10; ++i)
+        {
+            EXPECT_EQ(0u, a.data[i]);
+            a.data[i] = 1000 + i;
+        }
+
+        // One append grows past 65535 elements at once.
+        a.append(values.ptr(), values.size());
+        ASSERT_EQ(LargeCount + 10, a.size);
+
+        // Appending from a second array keeps both contents.
+        rtArray<SKuint32> b;
+        b.append(values.ptr(), 100);
+        a.append(values.ptr(), 100);
+        ASSERT_EQ(LargeCount + 110, a.size);
+        ASSERT_EQ(100u, b.size);
+
+        for (SKuint32 i = 0; i < 10; ++i)
+            ASSERT_EQ(1000 + i, a.data[i]);
+        for (SKuint32 i = 0; i < LargeCount; ++i)
+            ASSERT_EQ(i * 3, a.data[i + 10]);
+        for (SKuint32 i = 0; i < 100; ++i)
+        {
+            ASSERT_EQ(i * 3, a.data[i + LargeCount + 10]);
+            ASSERT_EQ(i * 3, b.data[i]);
+        }
+
+        // Shrinking keeps the front, and growing again clears the new elements.
+        a.resize(5);
+        EXPECT_EQ(5u, a.size);
+        a.resize(LargeCount * 2);
+        ASSERT_EQ(LargeCount * 2, a.size);
+        for (SKuint32 i = 0; i < 5; ++i)
+            ASSERT_EQ(1000 + i, a.data[i]);
+        for (SKuint32 i = 5; i < LargeCount * 2; ++i)
+            ASSERT_EQ(0u, a.data[i]);
+    }
+}
+
+GTEST_TEST(Array, Limit)
+{
+    rtArray<SKuint32> a;
+    a.push_back(1);
+
+    // Neither call allocates, both fail on the 32 bit size first.
+    const SKuint32 value = 2;
+    EXPECT_THROW(a.append(&value, SK_MAX32), std::runtime_error);
+    EXPECT_EQ(1u, a.size);
+
+    // The members are public, so the full array is faked.
+    a.size = SK_MAX32;
+    EXPECT_THROW(a.push_back(value), std::runtime_error);
+    a.size = 1;
+    EXPECT_EQ(1u, a.data[0]);
+}
+
+GTEST_TEST(Allocator, ReallocateArray)
+{
+    for (const SKint32 backend : Backends)
+    {
+        SCOPED_TRACE(backend);
+        BackendScope scope(backend);
+
+        SKuint32* a = rtAllocator::allocateArray<SKuint32>(16);
+        SKuint32* b = rtAllocator::allocateArray<SKuint32>(16);
+        for (SKuint32 i = 0; i < 16; ++i)
+        {
+            a[i] = i;
+            b[i] = i + 16;
+        }
+
+        // In the arena a is not the last allocation, so it is
+        // copied to a new block and the old one is released.
+        a = rtAllocator::reallocateArray<SKuint32>(a, LargeCount, 16);
+        ASSERT_NE(nullptr, a);
+        for (SKuint32 i = 0; i < 16; ++i)
+        {
+            EXPECT_EQ(i, a[i]);
+            EXPECT_EQ(i + 16, b[i]);
+        }
+        a[LargeCount - 1] = 7;
+
+        if (backend == RT_CPU_ARENA)
+            EXPECT_EQ(&scope.getArena(), rtArena::find(a));
+
+        Counted* c = rtAllocator::allocateArray<Counted>(4);
+        for (SKuint32 i = 0; i < 4; ++i)
+            c[i].value = i * 5;
+
+        Counted::copies = 0;
+        c               = rtAllocator::reallocateArray<Counted>(c, 8, 4);
+        ASSERT_NE(nullptr, c);
+        for (SKuint32 i = 0; i < 4; ++i)
+            EXPECT_EQ(i * 5, c[i].value);
+
+        // The CPU backend copies each element rather than calling realloc.
+        // The arena grows c in place, as it is the last allocation.
+        EXPECT_EQ(backend == RT_CPU ? 4u : 0u, Counted::copies);
+
+        rtAllocator::freeArray<Counted>(c);
+        rtAllocator::freeArray<SKuint32>(b);
+        rtAllocator::freeArray<SKuint32>(a);
+    }
+}
+
+GTEST_TEST(Array, SceneObjects)
+{
+    for (const SKint32 backend : Backends)
+    {
+        SCOPED_TRACE(backend);
+        rtAllocator::setBackend(backend);
+        {
+            rtScene scene;
+            for (SKuint32 i = 0; i < LargeCount; ++i)
+            {
+                rtSphere* sphere = new rtSphere(&scene);
+                sphere->setRadius(skScalar(0.25));
+                sphere->setPosition((skScalar)i, 0, 0);
+                scene.addBoundingObject(sphere);
+            }
+            scene.updateCaches();
+
+            const rtSceneType& data = scene.getData();
+            ASSERT_EQ(LargeCount, data.objects.size);
+            ASSERT_EQ(LargeCount, data.packed.bounds.size);
+            ASSERT_EQ(LargeCount, data.packed.instances.size);
+
+            // Objects past the old 16 bit limit are traced.
+            for (const SKuint32 index : {SKuint32(0), SKuint32(0x10000), LargeCount - 1})
+            {
+                const rtCpuRayQuery query = {{{(rtScalar)index, 0, 10}, {0, 0, -1}}, {0, SK_INFINITY}};
+
+                rtCpuHitResult hit;
+                EXPECT_TRUE(rtCpuIntersectRay(scene.getPtr(), query, hit));
+                EXPECT_EQ(index, hit.index);
+                EXPECT_NEAR(9.75, hit.distance, 1e-4);
+            }
+        }
+        rtAllocator::setBackend(RT_CPU);
+    }
+}
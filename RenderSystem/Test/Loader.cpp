@@ -0,0 +1,415 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <thread>
+#include "RenderSystem/Cpu/rtCpuRayQuery.h"
+#include "RenderSystem/Cpu/rtCpuRenderSystem.h"
+#include "RenderSystem/Loader/rtLoader.h"
+#include "RenderSystem/rtMesh.h"
+#include "RenderSystem/rtScene.h"
+#include "Blender.h"
+#include "TestDirectory.h"
+#include "ftBlend.h"
+#include "ftTableCache.h"
+#include "Utils/skMinMax.h"
+#include "Utils/skString.h"
+#if FT_USE_ZLIB == 1
+#include <zlib.h>
+#endif
+
+rtScene* Load(rtLoader*& loader, const char* path)
+{
+    loader = rtLoader::create(path);
+    if (!loader)
+        return nullptr;
+    if (loader->load(path) != 0 || loader->getScenes().empty())
+        return nullptr;
+    return loader->getScenes().at(0);
+}
+
+rtCpuHitResult Intersect(rtScene* scene, const rtScalar x, const rtScalar y)
+{
+    const rtCpuRayQuery query = {{{x, y, 10}, {0, 0, -1}}, {0, SK_INFINITY}};
+
+    rtCpuRenderSystem system;
+    rtCpuHitResult    hit;
+    system.intersect(scene, &query, &hit, 1);
+    return hit;
+}
+
+GTEST_TEST(Loader, AsciiMesh)
+{
+    rtLoader* loader = nullptr;
+    rtScene*  scene  = Load(loader, GetTestFilePath("Extern/bAscii/Test/MeshLibrary/T1.bascii"));
+    ASSERT_NE(nullptr, scene);
+
+    ASSERT_EQ(1, scene->getMeshes().size());
+    rtMesh* mesh = scene->getMeshes().at(0);
+
+    // The quad is split in two and the
+    // face that ends in zero is a triangle.
+    EXPECT_EQ(5, mesh->getVertexCount());
+    ASSERT_EQ(9, mesh->getIndexCount());
+
+    const SKuint32 expected[] = {0, 1, 2, 2, 3, 0, 1, 4, 2};
+    for (SKuint32 i = 0; i < 9; ++i)
+        EXPECT_EQ(expected[i], mesh->getIndex(i));
+
+    EXPECT_FLOAT_EQ(12345.678f, mesh->getVertex(4).z);
+    EXPECT_FLOAT_EQ(12345.678f, mesh->getLocalBoundingBox().max().z);
+
+    // Object A is moved up by one.
+    const rtCpuHitResult hit = Intersect(scene, -0.5f, 0.5f);
+    EXPECT_NE(SK_NPOS32, hit.index);
+    EXPECT_FLOAT_EQ(9, hit.distance);
+    EXPECT_EQ(SK_NPOS32, Intersect(scene, -1.5f, 0.5f).index);
+
+    delete loader;
+}
+
+GTEST_TEST(Loader, AsciiInstances)
+{
+    rtLoader* loader = nullptr;
+    rtScene*  scene  = Load(loader, GetTestFilePath("RenderSystem/Test/Instances.bascii"));
+    ASSERT_NE(nullptr, scene);
+
+    // The meshes are converted on the pool's threads,
+    // but the objects keep the order of the file.
+    rtScene::MeshArray& meshes = scene->getMeshes();
+    ASSERT_EQ(5, meshes.size());
+
+    const SKuint32 indexCount[] = {3, 6, 3, 18, 3};
+    const skScalar height[]     = {0, 0, 1, 2, 3};
+    for (SKuint32 i = 0; i < 5; ++i)
+    {
+        EXPECT_EQ(indexCount[i], meshes[i]->getIndexCount()) << "mesh " << i;
+        EXPECT_FLOAT_EQ(height[i], meshes[i]->getPosition().z) << "mesh " << i;
+    }
+
+    // Every object that uses Tri shares one geometry.
+    rtMeshGeometry* tri = meshes[0]->getGeometry();
+    EXPECT_EQ(tri, meshes[2]->getGeometry());
+    EXPECT_EQ(tri, meshes[4]->getGeometry());
+    EXPECT_EQ(3, tri->getReferenceCount());
+    EXPECT_NE(tri, meshes[1]->getGeometry());
+    EXPECT_EQ(1, meshes[3]->getGeometry()->getReferenceCount());
+
+    EXPECT_FLOAT_EQ(10, Intersect(scene, -5.8f, 0.2f).distance);
+    EXPECT_FLOAT_EQ(9, Intersect(scene, 0.2f, 0.2f).distance);
+    EXPECT_FLOAT_EQ(8, Intersect(scene, 4.5f, 0.5f).distance);
+    EXPECT_FLOAT_EQ(7, Intersect(scene, 6.2f, 0.2f).distance);
+    EXPECT_EQ(SK_NPOS32, Intersect(scene, 6.8f, 0.8f).index);
+
+    delete loader;
+}
+
+GTEST_TEST(Loader, BlendView)
+{
+    rtLoader* loader = nullptr;
+    rtScene*  scene  = Load(loader, GetTestFilePath("Extern/FileTools/FileFormats/Blend/Test/Test.blend"));
+    ASSERT_NE(nullptr, scene);
+    ASSERT_EQ(1, scene->getMeshes().size());
+
+    // The cube's vertices are read where the file keeps them,
+    // and its quads are split into indices of the geometry's own.
+    rtMesh* cube = scene->getMeshes().at(0);
+    EXPECT_TRUE(cube->isView());
+    EXPECT_EQ(0, cube->getVertices().size());
+    EXPECT_EQ(8, cube->getVertexCount());
+    EXPECT_EQ(36, cube->getIndexCount());
+    EXPECT_EQ((const SKubyte*)cube->getIndices().ptr(), cube->getView().indices);
+    EXPECT_LT((SKuint32)sizeof(skVector3), cube->getView().vertexStride);
+
+    const skBoundingBox& box = cube->getLocalBoundingBox();
+    EXPECT_FLOAT_EQ(-1, box.min().z);
+    EXPECT_FLOAT_EQ(1, box.max().z);
+
+    const rtCpuHitResult hit = Intersect(scene, 0.25f, 0.25f);
+    EXPECT_NE(SK_NPOS32, hit.index);
+    EXPECT_FLOAT_EQ(9, hit.distance);
+
+    delete loader;
+}
+
+bool CopyFile(const char* source, const char* dest)
+{
+    FILE* in = fopen(source, "rb");
+    if (!in)
+        return false;
+
+    FILE* out = fopen(dest, "wb");
+    if (!out)
+    {
+        fclose(in);
+        return false;
+    }
+
+    char   buffer[4096];
+    size_t read;
+    bool   result = true;
+    while ((read = fread(buffer, 1, sizeof(buffer), in)) > 0 && result)
+        result = fwrite(buffer, 1, read, out) == read;
+
+    fclose(in);
+    return fclose(out) == 0 && result;
+}
+
+GTEST_TEST(Loader, BlendMapped)
+{
+    const char*    source = GetTestFilePath("Extern/FileTools/FileFormats/Blend/Test/Test1.blend");
+    const skString path   = skString(testing::TempDir().c_str()) + "Mapped.blend";
+    ASSERT_TRUE(CopyFile(source, path.c_str()));
+
+    rtLoader* copyLoader = nullptr;
+    rtScene*  copy       = Load(copyLoader, path.c_str());
+    ASSERT_NE(nullptr, copy);
+
+    // The meshes read their vertices from a private mapping of the
+    // file, which stays readable after the file itself is gone.
+    remove(path.c_str());
+
+    rtLoader* loader = nullptr;
+    rtScene*  scene  = Load(loader, source);
+    ASSERT_NE(nullptr, scene);
+    ASSERT_EQ(scene->getMeshes().size(), copy->getMeshes().size());
+
+    for (SKuint32 i = 0; i < scene->getMeshes().size(); ++i)
+    {
+        const rtMesh* a = scene->getMeshes().at(i);
+        const rtMesh* b = copy->getMeshes().at(i);
+        EXPECT_TRUE(b->isView());
+
+        ASSERT_EQ(a->getVertexCount(), b->getVertexCount()) << "mesh " << i;
+        for (SKuint32 v = 0; v < a->getVertexCount(); ++v)
+            EXPECT_EQ(a->getVertex(v), b->getVertex(v));
+    }
+
+    // Each load keeps its own mapping open.
+    delete loader;
+    const rtCpuHitResult hit = Intersect(copy, -1.4f, 6.1f);
+    EXPECT_NE(SK_NPOS32, hit.index);
+
+    delete copyLoader;
+}
+
+GTEST_TEST(Loader, BlendFilterList)
+{
+    // The structures that lead from the file to its objects,
+    // but not to the data of the objects.
+    SKhash types[] = {
+        ftCharHashKey("FileGlobal").hash(),
+        ftCharHashKey("Scene").hash(),
+        ftCharHashKey("Collection").hash(),
+        ftCharHashKey("CollectionChild").hash(),
+        ftCharHashKey("CollectionObject").hash(),
+        ftCharHashKey("Object").hash(),
+    };
+    constexpr SKuint32 count = sizeof(types) / sizeof(SKhash);
+
+    // Every type is found wherever it is in the list, the last one included.
+    for (SKuint32 r = 0; r < count; ++r)
+    {
+        SKhash list[count];
+        for (SKuint32 i = 0; i < count; ++i)
+            list[i] = types[(i + r) % count];
+
+        ftBlend fp;
+        fp.setFilterList(list, count, true);
+        ASSERT_EQ(ftFlags::FS_OK, fp.load(GetTestFilePath("Extern/FileTools/FileFormats/Blend/Test/Test.blend")));
+        ASSERT_NE(nullptr, fp.m_fg);
+        ASSERT_NE(nullptr, fp.m_fg->curscene);
+
+        Blender::Collection* master = fp.m_fg->curscene->master_collection;
+        ASSERT_NE(nullptr, master);
+
+        const Blender::CollectionChild* child = (const Blender::CollectionChild*)master->children.first;
+        ASSERT_NE(nullptr, child);
+        ASSERT_NE(nullptr, child->collection);
+
+        SKuint32 objects = 0;
+        for (const Blender::CollectionObject* co = (const Blender::CollectionObject*)child->collection->gobject.first; co; co = co->next)
+        {
+            ASSERT_NE(nullptr, co->ob);
+
+            // Meshes, lights and cameras were skipped.
+            EXPECT_EQ(nullptr, co->ob->data);
+            ++objects;
+        }
+        EXPECT_EQ(3, objects);
+    }
+}
+
+GTEST_TEST(Loader, BlendCachedTables)
+{
+    const char* paths[] = {
+        GetTestFilePath("Extern/FileTools/FileFormats/Blend/Test/Test.blend"),
+        GetTestFilePath("Extern/FileTools/FileFormats/Blend/Test/Test1.blend"),
+    };
+    const SKuint32 meshes[] = {1, 69};
+
+    // Loads on several threads at once race to build and
+    // cache the tables, then go on to share them.
+    ftTableCache::clear();
+
+    SKuint32    results[8] = {};
+    std::thread threads[8];
+    for (SKuint32 i = 0; i < 8; ++i)
+    {
+        threads[i] = std::thread([&paths, &meshes, &results, i] {
+            for (SKuint32 n = 0; n < 3; ++n)
+            {
+                rtLoader* loader = nullptr;
+                rtScene*  scene  = Load(loader, paths[(i + n) % 2]);
+                if (scene && scene->getMeshes().size() == meshes[(i + n) % 2])
+                    ++results[i];
+                delete loader;
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    for (SKuint32 i = 0; i < 8; ++i)
+        EXPECT_EQ(3, results[i]) << "thread " << i;
+
+    for (SKuint32 i = 0; i < 2; ++i)
+    {
+        rtLoader* loader = nullptr;
+        rtScene*  scene  = Load(loader, paths[i]);
+        ASSERT_NE(nullptr, scene);
+        EXPECT_EQ(meshes[i], scene->getMeshes().size());
+        delete loader;
+    }
+    ftTableCache::clear();
+}
+
+#if FT_USE_ZLIB == 1
+
+// Writes a gzip'd copy of a file, the way Blender saves compressed files.
+// A non zero split starts a second gzip member at that offset, which leaves
+// only the size of the second member in the trailer.
+bool Compress(const char* source, const char* dest, const SKsize split = 0)
+{
+    FILE* fp = fopen(source, "rb");
+    if (!fp)
+        return false;
+
+    gzFile gz = gzopen(dest, "wb");
+    if (!gz)
+    {
+        fclose(fp);
+        return false;
+    }
+
+    char   buffer[4096];
+    SKsize written = 0;
+    bool   result  = true;
+    while (result)
+    {
+        SKsize len = sizeof(buffer);
+        if (split > written)
+            len = skMin<SKsize>(len, split - written);
+
+        const size_t read = fread(buffer, 1, len, fp);
+        if (read == 0)
+            break;
+
+        result = gzwrite(gz, buffer, (unsigned int)read) == (int)read;
+        written += read;
+
+        if (result && written == split)
+        {
+            result = gzclose(gz) == Z_OK;
+            gz     = gzopen(dest, "ab");
+            result = result && gz;
+        }
+    }
+
+    fclose(fp);
+    return gz && gzclose(gz) == Z_OK && result;
+}
+
+GTEST_TEST(Loader, BlendCompressed)
+{
+    const char*    source = GetTestFilePath("Extern/FileTools/FileFormats/Blend/Test/Test1.blend");
+    const skString path   = skString(testing::TempDir().c_str()) + "Compressed.blend";
+    ASSERT_TRUE(Compress(source, path.c_str()));
+
+    rtLoader* mappedLoader = nullptr;
+    rtLoader* packedLoader = nullptr;
+    rtScene*  mapped       = Load(mappedLoader, source);
+    rtScene*  packed       = Load(packedLoader, path.c_str());
+    ASSERT_NE(nullptr, mapped);
+    ASSERT_NE(nullptr, packed);
+
+    // Inflating the file gives the same scene as mapping it.
+    ASSERT_EQ(mapped->getMeshes().size(), packed->getMeshes().size());
+    EXPECT_LT(1, mapped->getMeshes().size());
+    EXPECT_EQ(mapped->getCameras().size(), packed->getCameras().size());
+
+    for (SKuint32 i = 0; i < mapped->getMeshes().size(); ++i)
+    {
+        rtMesh* a = mapped->getMeshes().at(i);
+        rtMesh* b = packed->getMeshes().at(i);
+        EXPECT_EQ(a->getPosition(), b->getPosition()) << "mesh " << i;
+
+        ASSERT_EQ(a->getVertexCount(), b->getVertexCount()) << "mesh " << i;
+        ASSERT_EQ(a->getIndexCount(), b->getIndexCount()) << "mesh " << i;
+        for (SKuint32 v = 0; v < a->getVertexCount(); ++v)
+            EXPECT_EQ(a->getVertex(v), b->getVertex(v));
+        for (SKuint32 n = 0; n < a->getIndexCount(); ++n)
+            EXPECT_EQ(a->getIndex(n), b->getIndex(n));
+    }
+
+    delete packedLoader;
+    delete mappedLoader;
+    remove(path.c_str());
+}
+
+GTEST_TEST(Loader, BlendCompressedMembers)
+{
+    // The trailer understates the size, so the inflated copy has to grow.
+    const char*    source = GetTestFilePath("Extern/FileTools/FileFormats/Blend/Test/Test1.blend");
+    const skString path   = skString(testing::TempDir().c_str()) + "Members.blend";
+    ASSERT_TRUE(Compress(source, path.c_str(), 0x100000));
+
+    rtLoader* mappedLoader = nullptr;
+    rtLoader* packedLoader = nullptr;
+    rtScene*  mapped       = Load(mappedLoader, source);
+    rtScene*  packed       = Load(packedLoader, path.c_str());
+    ASSERT_NE(nullptr, mapped);
+    ASSERT_NE(nullptr, packed);
+
+    ASSERT_EQ(mapped->getMeshes().size(), packed->getMeshes().size());
+    for (SKuint32 i = 0; i < mapped->getMeshes().size(); ++i)
+    {
+        EXPECT_EQ(mapped->getMeshes().at(i)->getVertexCount(), packed->getMeshes().at(i)->getVertexCount());
+        EXPECT_EQ(mapped->getMeshes().at(i)->getIndexCount(), packed->getMeshes().at(i)->getIndexCount());
+    }
+
+    delete packedLoader;
+    delete mappedLoader;
+    remove(path.c_str());
+}
+
+#endif
@@ -0,0 +1,379 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+#include "RenderSystem/rtMeshGeometry.h"
+
+GTEST_TEST(Mesh, Weld)
+{
+    // Two triangles of a quad, with the shared edge listed twice.
+    const skVector3 soup[] = {
+        {-1, -1, 0},
+        {1, -1, 0},
+        {1, 1, 0},
+        {-1, -1, 0},
+        {1, 1, 0},
+        {-1, 1, 0},
+    };
+
+    rtMeshGeometry* geometry = new rtMeshGeometry();
+    geometry->beginAddTriangles();
+    geometry->addTriangleSoup(soup, 6);
+    geometry->endAddTriangles();
+
+    EXPECT_EQ(4, geometry->getVertexCount());
+    ASSERT_EQ(6, geometry->getIndexCount());
+    EXPECT_EQ(geometry->getIndex(0), geometry->getIndex(3));
+    EXPECT_EQ(geometry->getIndex(2), geometry->getIndex(4));
+
+    for (SKuint32 i = 0; i < 6; ++i)
+        EXPECT_EQ(soup[i], geometry->getVertex(geometry->getIndex(i)));
+
+    const skBoundingBox& box = geometry->getLocalBoundingBox();
+    EXPECT_EQ(skVector3(-1, -1, 0), box.min());
+    EXPECT_EQ(skVector3(1, 1, 0), box.max());
+
+    geometry->release();
+}
+
+GTEST_TEST(Mesh, WeldTolerance)
+{
+    const skVector3 soup[] = {
+        {0, 0, 0},
+        {1, 0, 0},
+        {0, 1, 0},
+        {0.0001f, 0, 0},
+        {0, 1, 0},
+        {-1, 0, 0},
+    };
+
+    rtMeshGeometry* geometry = new rtMeshGeometry();
+    geometry->beginAddTriangles();
+    geometry->addTriangleSoup(soup, 6, 0);
+    geometry->endAddTriangles();
+    EXPECT_EQ(5, geometry->getVertexCount());
+
+    geometry->beginAddTriangles();
+    geometry->addTriangleSoup(soup, 6, skScalar(0.001));
+    geometry->endAddTriangles();
+    EXPECT_EQ(4, geometry->getVertexCount());
+    EXPECT_EQ(geometry->getIndex(0), geometry->getIndex(3));
+
+    geometry->release();
+}
+
+GTEST_TEST(Mesh, WideIndices)
+{
+    // More vertices than a 16-bit index can reach.
+    constexpr SKuint32 Count = 70000;
+
+    rtMeshGeometry::Vertices vertices;
+    vertices.resize(Count);
+    for (SKuint32 i = 0; i < Count; ++i)
+        vertices[i] = skVector3((skScalar)i, 0, 0);
+    vertices[Count - 1] = skVector3(0, 1, 0);
+
+    const SKuint32 indices[] = {0, 1, Count - 1};
+
+    rtMeshGeometry* geometry = new rtMeshGeometry();
+    geometry->beginAddTriangles();
+    EXPECT_TRUE(geometry->addIndexedTriangles(vertices.ptr(), Count, indices, 3));
+    geometry->endAddTriangles();
+
+    EXPECT_EQ(Count, geometry->getVertexCount());
+    ASSERT_EQ(3, geometry->getIndexCount());
+    EXPECT_EQ(Count - 1, geometry->getIndex(2));
+    EXPECT_EQ(skVector3(0, 1, 0), geometry->getVertex(geometry->getIndex(2)));
+
+    geometry->release();
+}
+
+GTEST_TEST(Mesh, IndexOutOfRange)
+{
+    const skVector3 vertices[] = {
+        {0, 0, 0},
+        {1, 0, 0},
+        {0, 1, 0},
+    };
+    const SKuint32 valid[]   = {0, 1, 2};
+    const SKuint32 invalid[] = {0, 1, 3};
+
+    rtMeshGeometry* geometry = new rtMeshGeometry();
+    geometry->beginAddTriangles();
+    EXPECT_TRUE(geometry->addIndexedTriangles(vertices, 3, valid, 3));
+    EXPECT_FALSE(geometry->addIndexedTriangles(vertices, 3, invalid, 3));
+    geometry->endAddTriangles();
+
+    EXPECT_EQ(3, geometry->getVertexCount());
+    EXPECT_EQ(3, geometry->getIndexCount());
+
+    geometry->release();
+}
+
+// Records laid out the way a file stores them, with
+// more in each one than the geometry reads.
+struct ViewVertex
+{
+    float   co[3];
+    SKint16 no[3];
+    SKubyte flag;
+    SKubyte pad;
+};
+
+struct ViewLoop
+{
+    SKuint32 v;
+    SKuint32 e;
+};
+
+GTEST_TEST(Mesh, View)
+{
+    const ViewVertex vertices[] = {
+        {{-1, -1, 0}, {0, 0, 1}, 1, 0},
+        {{1, -1, 0}, {0, 0, 1}, 1, 0},
+        {{1, 1, 0}, {0, 0, 1}, 1, 0},
+        {{-1, 1, 0}, {0, 0, 1}, 1, 0},
+    };
+    const ViewLoop loops[] = {
+        {0, 0},
+        {1, 1},
+        {2, 5},
+        {0, 5},
+        {2, 2},
+        {3, 3},
+    };
+
+    rtMeshView view = {
+        (const SKubyte*)vertices,
+        4,
+        (SKuint32)sizeof(ViewVertex),
+        (const SKubyte*)&loops[0].v,
+        6,
+        (SKuint32)sizeof(ViewLoop),
+    };
+
+    rtMeshGeometry* geometry = new rtMeshGeometry();
+    ASSERT_TRUE(geometry->setView(view));
+    EXPECT_TRUE(geometry->isView());
+    EXPECT_EQ(4, geometry->getVertexCount());
+    EXPECT_EQ(6, geometry->getIndexCount());
+    EXPECT_EQ(3, geometry->getIndex(5));
+    EXPECT_EQ(skVector3(-1, 1, 0), geometry->getVertex(geometry->getIndex(5)));
+
+    // Nothing is copied.
+    EXPECT_EQ((const SKubyte*)vertices, geometry->getView().vertices);
+    EXPECT_EQ(0, geometry->getVertices().size());
+
+    const skBoundingBox& box = geometry->getLocalBoundingBox();
+    EXPECT_EQ(skVector3(-1, -1, 0), box.min());
+    EXPECT_EQ(skVector3(1, 1, 0), box.max());
+
+    // The hierarchy is built over the view.
+    skScalar tMax     = SK_INFINITY;
+    SKuint32 triangle = SK_NPOS32;
+    EXPECT_TRUE(geometry->getBvh().intersect(geometry->getView(), {-0.5f, 0.5f, 5}, {0, 0, -1}, 0, tMax, triangle));
+    EXPECT_FLOAT_EQ(5, tMax);
+    EXPECT_EQ(1, triangle);
+
+    // With a stride of one index, the edges are read as vertices.
+    view.indexStride = (SKuint32)sizeof(SKuint32);
+    EXPECT_FALSE(geometry->setView(view));
+    EXPECT_FALSE(geometry->isView());
+    EXPECT_EQ(0, geometry->getIndexCount());
+
+    // Copying triangles in ends the view.
+    geometry->beginAddTriangles();
+    geometry->addTriangle(0, 1, 2, {0, 0, 0}, {1, 0, 0}, {0, 1, 0});
+    geometry->endAddTriangles();
+    EXPECT_FALSE(geometry->isView());
+    EXPECT_EQ(3, geometry->getIndexCount());
+
+    geometry->release();
+}
+
+GTEST_TEST(Mesh, BuildModes)
+{
+    // A rolling height field, big enough that the build
+    // splits into subtrees and the leaves are deep.
+    constexpr SKuint32 Cells = 48;
+
+    const skScalar bump[] = {0, 0.3f, -0.2f, 0.5f, 0.1f, -0.4f, 0.2f};
+
+    rtMeshGeometry::Vertices vertices;
+    for (SKuint32 y = 0; y <= Cells; ++y)
+    {
+        for (SKuint32 x = 0; x <= Cells; ++x)
+            vertices.push_back(skVector3((skScalar)x, (skScalar)y, bump[(x * 3 + y * 5) % 7]));
+    }
+
+    rtMeshGeometry::Indices indices;
+    for (SKuint32 y = 0; y < Cells; ++y)
+    {
+        for (SKuint32 x = 0; x < Cells; ++x)
+        {
+            const SKuint32 i = y * (Cells + 1) + x;
+            indices.push_back(i);
+            indices.push_back(i + 1);
+            indices.push_back(i + Cells + 2);
+            indices.push_back(i);
+            indices.push_back(i + Cells + 2);
+            indices.push_back(i + Cells + 1);
+        }
+    }
+
+    const rtMeshView view = {
+        (const SKubyte*)vertices.ptr(),
+        vertices.size(),
+        (SKuint32)sizeof(skVector3),
+        (const SKubyte*)indices.ptr(),
+        indices.size(),
+        (SKuint32)sizeof(SKuint32),
+    };
+
+    rtMeshBvh serial, threaded, morton;
+    serial.build(view, rtMeshBvh::BM_SAH, 1);
+    threaded.build(view, rtMeshBvh::BM_SAH, 4);
+    morton.build(view, rtMeshBvh::BM_MORTON);
+
+    // Splitting the build over threads gives the same tree.
+    ASSERT_EQ(serial.getView().nodeCount, threaded.getView().nodeCount);
+    for (SKuint32 i = 0; i < serial.getView().nodeCount; ++i)
+    {
+        EXPECT_EQ(serial.getView().nodes[i].first, threaded.getView().nodes[i].first);
+        EXPECT_EQ(serial.getView().nodes[i].count, threaded.getView().nodes[i].count);
+    }
+
+    // Every build finds the same triangle, and each ray
+    // that starts over the field hits it somewhere.
+    for (SKuint32 r = 0; r < 500; ++r)
+    {
+        const skVector3 origin(skScalar(r % 25) * 1.9f + 0.13f, skScalar(r / 25) * 2.3f + 0.31f, 5);
+        const skVector3 direction(0, 0, -1);
+
+        skScalar tSerial = SK_INFINITY, tMorton = SK_INFINITY;
+        SKuint32 hSerial = SK_NPOS32, hMorton = SK_NPOS32;
+
+        ASSERT_TRUE(serial.intersect(view, origin, direction, 0, tSerial, hSerial)) << "ray " << r;
+        ASSERT_TRUE(morton.intersect(view, origin, direction, 0, tMorton, hMorton)) << "ray " << r;
+        EXPECT_EQ(hSerial, hMorton) << "ray " << r;
+        EXPECT_FLOAT_EQ(tSerial, tMorton) << "ray " << r;
+
+        // The two triangles of a cell meet along its diagonal.
+        const SKuint32 cx = (SKuint32)origin.x, cy = (SKuint32)origin.y;
+        EXPECT_EQ((cy * Cells + cx) * 2, hSerial & ~1u) << "ray " << r;
+
+        EXPECT_TRUE(morton.occluded(view, origin, direction, 0, SK_INFINITY));
+        EXPECT_FALSE(morton.occluded(view, origin, direction, 0, tSerial * 0.5f));
+    }
+}
+
+GTEST_TEST(Mesh, PrebuiltHierarchy)
+{
+    constexpr SKuint32 Cells = 16;
+
+    rtMeshGeometry::Vertices vertices;
+    for (SKuint32 y = 0; y <= Cells; ++y)
+    {
+        for (SKuint32 x = 0; x <= Cells; ++x)
+            vertices.push_back(skVector3((skScalar)x, (skScalar)y, (skScalar)((x + y) % 3) * 0.25f));
+    }
+
+    rtMeshGeometry::Indices indices;
+    for (SKuint32 y = 0; y < Cells; ++y)
+    {
+        for (SKuint32 x = 0; x < Cells; ++x)
+        {
+            const SKuint32 i = y * (Cells + 1) + x;
+            indices.push_back(i);
+            indices.push_back(i + 1);
+            indices.push_back(i + Cells + 2);
+            indices.push_back(i);
+            indices.push_back(i + Cells + 2);
+            indices.push_back(i + Cells + 1);
+        }
+    }
+
+    const rtMeshView view = {
+        (const SKubyte*)vertices.ptr(),
+        vertices.size(),
+        (SKuint32)sizeof(skVector3),
+        (const SKubyte*)indices.ptr(),
+        indices.size(),
+        (SKuint32)sizeof(SKuint32),
+    };
+
+    rtMeshBvh built;
+    built.build(view);
+    ASSERT_FALSE(built.empty());
+    EXPECT_FALSE(built.isView());
+
+    // The records are referenced, not copied or rebuilt.
+    rtMeshGeometry* geometry = new rtMeshGeometry();
+    ASSERT_TRUE(geometry->setView(view, built.getView()));
+    EXPECT_TRUE(geometry->getBvh().isView());
+    EXPECT_EQ(built.getView().nodes, geometry->getBvh().getView().nodes);
+    EXPECT_EQ(built.getView().triangles, geometry->getBvh().getView().triangles);
+    EXPECT_FLOAT_EQ(built.getCost(), geometry->getBvh().getCost());
+    EXPECT_EQ(0, geometry->getBvh().getMemorySize());
+
+    for (SKuint32 r = 0; r < 64; ++r)
+    {
+        const skVector3 origin(skScalar(r % 8) * 1.9f + 0.3f, skScalar(r / 8) * 1.7f + 0.6f, 5);
+
+        skScalar tBuilt = SK_INFINITY, tView = SK_INFINITY;
+        SKuint32 hBuilt = SK_NPOS32, hView = SK_NPOS32;
+        ASSERT_TRUE(built.intersect(view, origin, {0, 0, -1}, 0, tBuilt, hBuilt));
+        ASSERT_TRUE(geometry->getBvh().intersect(view, origin, {0, 0, -1}, 0, tView, hView));
+        EXPECT_EQ(hBuilt, hView);
+        EXPECT_EQ(tBuilt, tView);
+    }
+
+    // A copy of a referencing hierarchy references the same records.
+    const rtMeshBvh copy = geometry->getBvh();
+    EXPECT_TRUE(copy.isView());
+    EXPECT_EQ(built.getView().nodes, copy.getView().nodes);
+
+    // A branch that points back at itself is not a tree,
+    // so the geometry builds its own hierarchy instead.
+    rtMeshBvh::Nodes nodes;
+    for (SKuint32 i = 0; i < built.getView().nodeCount; ++i)
+        nodes.push_back(built.getView().nodes[i]);
+    ASSERT_EQ(0, nodes[0].count);
+    nodes[0].first = 0;
+
+    rtMeshBvh::View broken = built.getView();
+    broken.nodes           = nodes.ptr();
+
+    rtMeshBvh rejected;
+    EXPECT_FALSE(rejected.setView(broken, view));
+    EXPECT_TRUE(rejected.empty());
+
+    ASSERT_TRUE(geometry->setView(view, broken));
+    EXPECT_FALSE(geometry->getBvh().isView());
+    EXPECT_EQ(built.getView().nodeCount, geometry->getBvh().getView().nodeCount);
+
+    // So does one with fewer triangles than the view.
+    broken = built.getView();
+    broken.triangleCount -= 1;
+    EXPECT_FALSE(rejected.setView(broken, view));
+
+    geometry->release();
+}
@@ -0,0 +1,415 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+#include "RenderSystem/Cpu/rtCpuRayQuery.h"
+#include "RenderSystem/Cpu/rtCpuRenderSystem.h"
+#include "RenderSystem/rtCube.h"
+#include "RenderSystem/rtMesh.h"
+#include "RenderSystem/rtScene.h"
+#include "RenderSystem/rtSphere.h"
+
+constexpr rtScalar Tolerance = rtScalar(1e-4);
+
+rtCpuRayQuery MakeQuery(const rtScalar ox,
+                        const rtScalar oy,
+                        const rtScalar oz,
+                        const rtScalar dx,
+                        const rtScalar dy,
+                        const rtScalar dz,
+                        const rtScalar tMin = 0,
+                        const rtScalar tMax = SK_INFINITY)
+{
+    return {{{ox, oy, oz}, {dx, dy, dz}}, {tMin, tMax}};
+}
+
+// Runs a query through the render system and through the single
+// ray call, which must agree, and returns the single ray's hit.
+rtCpuHitResult Intersect(rtScene& scene, const rtCpuRayQuery& query)
+{
+    rtCpuRenderSystem system;
+    rtCpuHitResult    batched;
+    system.intersect(&scene, &query, &batched, 1);
+
+    rtCpuHitResult hit;
+    const bool     result = rtCpuIntersectRay(scene.getPtr(), query, hit);
+    EXPECT_EQ(result, hit.index != SK_NPOS32);
+    EXPECT_EQ(hit.index, batched.index);
+    if (result && hit.index == batched.index)
+        EXPECT_FLOAT_EQ(hit.distance, batched.distance);
+    return hit;
+}
+
+bool Occluded(rtScene& scene, const rtCpuRayQuery& query)
+{
+    rtCpuRenderSystem system;
+    SKubyte           batched = 2;
+    system.occluded(&scene, &query, &batched, 1);
+
+    const bool result = rtCpuOccludedRay(scene.getPtr(), query);
+    EXPECT_EQ(result ? 1 : 0, batched);
+    return result;
+}
+
+void ExpectHit(const rtCpuHitResult& hit,
+               const SKuint32        index,
+               const rtScalar        distance,
+               const rtScalar        nx,
+               const rtScalar        ny,
+               const rtScalar        nz)
+{
+    ASSERT_EQ(index, hit.index);
+    EXPECT_NEAR(distance, hit.distance, Tolerance);
+    EXPECT_NEAR(nx, hit.normal.x, Tolerance);
+    EXPECT_NEAR(ny, hit.normal.y, Tolerance);
+    EXPECT_NEAR(nz, hit.normal.z, Tolerance);
+}
+
+void ExpectMiss(const rtCpuHitResult& hit)
+{
+    EXPECT_EQ(SK_NPOS32, hit.index);
+}
+
+rtCube* AddCube(rtScene& scene, const skScalar x, const skScalar y, const skScalar z, const skScalar extent)
+{
+    rtCube* cube = new rtCube(&scene);
+    cube->setExtent(extent);
+    cube->setPosition(x, y, z);
+    scene.addBoundingObject(cube);
+    return cube;
+}
+
+rtSphere* AddSphere(rtScene& scene, const skScalar x, const skScalar y, const skScalar z, const skScalar radius)
+{
+    rtSphere* sphere = new rtSphere(&scene);
+    sphere->setRadius(radius);
+    sphere->setPosition(x, y, z);
+    scene.addBoundingObject(sphere);
+    return sphere;
+}
+
+// A two triangle square from -1 to 1 in the mesh's xy plane.
+rtMesh* AddQuad(rtScene& scene)
+{
+    const skVector3 vertices[] = {
+        {-1, -1, 0},
+        {1, -1, 0},
+        {1, 1, 0},
+        {-1, 1, 0},
+    };
+    const SKuint32 indices[] = {0, 1, 2, 0, 2, 3};
+
+    rtMesh* mesh = new rtMesh(&scene);
+    mesh->beginAddTriangles();
+    mesh->addIndexedTriangles(vertices, 4, indices, 6);
+    mesh->endAddTriangles();
+    scene.addMesh(mesh);
+    return mesh;
+}
+
+// A unit direction that passes through (0, 0, 1) at a distance of
+// 11.25 from (-5.4, -4.05, 10), with no zero components.
+constexpr rtScalar Slant[3] = {rtScalar(0.48), rtScalar(0.36), rtScalar(-0.8)};
+
+GTEST_TEST(RayQuery, Box)
+{
+    rtScene scene;
+    AddCube(scene, 0, 0, 0, 2);
+
+    ExpectHit(Intersect(scene, MakeQuery(-5.4f, -4.05f, 10, Slant[0], Slant[1], Slant[2])), 0, 11.25f, 0, 0, 1);
+
+    // The same ray shifted past the top face's edge.
+    ExpectMiss(Intersect(scene, MakeQuery(-3.4f, -4.05f, 10, Slant[0], Slant[1], Slant[2])));
+
+    // Pointing away from the box.
+    ExpectMiss(Intersect(scene, MakeQuery(-5.4f, -4.05f, 10, -Slant[0], -Slant[1], -Slant[2])));
+}
+
+GTEST_TEST(RayQuery, Sphere)
+{
+    rtScene scene;
+    AddSphere(scene, 0, 0, 0, 1);
+
+    ExpectHit(Intersect(scene, MakeQuery(-5.4f, -4.05f, 10, Slant[0], Slant[1], Slant[2])), 0, 11.25f, 0, 0, 1);
+
+    // Off center, the surface is at z = sqrt(1 - 0.6^2) = 0.8.
+    ExpectHit(Intersect(scene, MakeQuery(0.6f, 0, 10, 0, 0, -1)), 0, 9.2f, 0.6f, 0, 0.8f);
+
+    // Inside the sphere's bounds but outside the sphere.
+    ExpectMiss(Intersect(scene, MakeQuery(0.9f, 0.9f, 10, 0, 0, -1)));
+    ExpectMiss(Intersect(scene, MakeQuery(1.2f, 0, 10, 0, 0, -1)));
+}
+
+GTEST_TEST(RayQuery, MeshInstance)
+{
+    rtScene scene;
+
+    // The quad spans 1 to 5 in x and -2 to 2 in y, at a height of 1.
+    rtMesh* mesh = AddQuad(scene);
+    mesh->setPosition(3, 0, 1);
+    mesh->setScale(2, 2, 2);
+
+    ExpectHit(Intersect(scene, MakeQuery(4, 1, 10, 0, 0, -1)), 0, 9, 0, 0, 1);
+
+    // Triangles are two sided, and the normal faces the ray.
+    ExpectHit(Intersect(scene, MakeQuery(4, 1, -10, 0, 0, 1)), 0, 11, 0, 0, -1);
+
+    ExpectMiss(Intersect(scene, MakeQuery(5.5f, 0, 10, 0, 0, -1)));
+    ExpectMiss(Intersect(scene, MakeQuery(0.5f, 0, 10, 0, 0, -1)));
+
+    // Turned on its side, the quad spans -1 to 3 in z at y = 0.
+    mesh->setOrientation(skPiH, 0, 0);
+    ExpectHit(Intersect(scene, MakeQuery(4, 10, 2, 0, -1, 0)), 0, 10, 0, 1, 0);
+    ExpectMiss(Intersect(scene, MakeQuery(4, 1, 10, 0, 0, -1)));
+}
+
+GTEST_TEST(RayQuery, Nearest)
+{
+    rtScene scene;
+    AddCube(scene, 0, 0, -6, 2);
+    AddSphere(scene, 0, 0, 0, 1);
+
+    // The sphere is in front of the box, whichever order they were added in.
+    ExpectHit(Intersect(scene, MakeQuery(-5.4f, -4.05f, 10, Slant[0], Slant[1], Slant[2])), 1, 11.25f, 0, 0, 1);
+}
+
+GTEST_TEST(RayQuery, Occluded)
+{
+    rtScene scene;
+    AddSphere(scene, 0, 0, 0, 1);
+
+    EXPECT_TRUE(Occluded(scene, MakeQuery(0, 0, 10, 0, 0, -1)));
+    EXPECT_TRUE(Occluded(scene, MakeQuery(0, 0, 10, 0, 0, -1, 0, 9.1f)));
+    EXPECT_FALSE(Occluded(scene, MakeQuery(0, 0, 10, 0, 0, -1, 0, 8.9f)));
+    EXPECT_FALSE(Occluded(scene, MakeQuery(0, 0, 10, 0, 0, 1)));
+    EXPECT_FALSE(Occluded(scene, MakeQuery(1.2f, 0, 10, 0, 0, -1)));
+}
+
+GTEST_TEST(RayQuery, Limits)
+{
+    rtScene scene;
+    AddSphere(scene, 0, 0, 0, 1);
+    AddSphere(scene, 0, 0, -5, 1);
+
+    // The first sphere is between 9 and 11 along the ray, the second between 14 and 16.
+    ExpectHit(Intersect(scene, MakeQuery(0, 0, 10, 0, 0, -1)), 0, 9, 0, 0, 1);
+    ExpectHit(Intersect(scene, MakeQuery(0, 0, 10, 0, 0, -1, 11.5f)), 1, 14, 0, 0, 1);
+
+    // Starting inside the first sphere, the ray leaves through its far side.
+    ExpectHit(Intersect(scene, MakeQuery(0, 0, 10, 0, 0, -1, 10)), 0, 11, 0, 0, -1);
+
+    ExpectMiss(Intersect(scene, MakeQuery(0, 0, 10, 0, 0, -1, 0, 8.5f)));
+    ExpectMiss(Intersect(scene, MakeQuery(0, 0, 10, 0, 0, -1, 16.5f)));
+    EXPECT_FALSE(Occluded(scene, MakeQuery(0, 0, 10, 0, 0, -1, 11.5f, 13.5f)));
+    EXPECT_TRUE(Occluded(scene, MakeQuery(0, 0, 10, 0, 0, -1, 11.5f, 14.5f)));
+}
+
+GTEST_TEST(RayQuery, AxisParallel)
+{
+    rtScene scene;
+    AddCube(scene, 0, 0, 0, 2);
+
+    // From 10 units out along each axis, aimed back at the box.
+    for (int a = 0; a < 3; ++a)
+    {
+        for (int s = -1; s <= 1; s += 2)
+        {
+            rtScalar d[3] = {0, 0, 0};
+            rtScalar o[3] = {0.25f, 0.5f, 0.75f};
+
+            d[a] = rtScalar(-s);
+            o[a] = rtScalar(10 * s);
+
+            rtScalar n[3] = {0, 0, 0};
+            n[a]          = rtScalar(s);
+
+            ExpectHit(Intersect(scene, MakeQuery(o[0], o[1], o[2], d[0], d[1], d[2])), 0, 9, n[0], n[1], n[2]);
+            EXPECT_TRUE(Occluded(scene, MakeQuery(o[0], o[1], o[2], d[0], d[1], d[2])));
+
+            // Parallel to the box's faces, but beside it.
+            o[(a + 1) % 3] = 1.5f;
+            ExpectMiss(Intersect(scene, MakeQuery(o[0], o[1], o[2], d[0], d[1], d[2])));
+            EXPECT_FALSE(Occluded(scene, MakeQuery(o[0], o[1], o[2], d[0], d[1], d[2])));
+        }
+    }
+}
+
+GTEST_TEST(RayQuery, Batched)
+{
+    rtScene scene;
+    AddCube(scene, -3, 0, 0, 2);
+    AddSphere(scene, 0, 0, 0, 1);
+    rtMesh* mesh = AddQuad(scene);
+    mesh->setPosition(3, 0, 0);
+
+    // Rays over the three objects in groups of four, so that the
+    // render system splits them over its threads and tests them
+    // as packets. Every result must match the single ray calls.
+    const SKuint32 count = 256;
+
+    rtCpuRayQuery queries[count];
+    for (SKuint32 i = 0; i < count; ++i)
+    {
+        const rtScalar x = -5 + rtScalar(i % 64) * rtScalar(10) / 64;
+        const rtScalar y = -1.5f + rtScalar(i / 64) * rtScalar(0.9);
+        const rtScalar z = rtScalar(i % 3) * rtScalar(0.01);
+
+        queries[i] = MakeQuery(x, y, 10, z, -z, -1);
+    }
+
+    rtCpuRenderSystem system;
+    rtCpuHitResult    hits[count];
+    SKubyte           blocked[count];
+    system.intersect(&scene, queries, hits, count);
+    system.occluded(&scene, queries, blocked, count);
+
+    SKuint32 hitCount = 0;
+    for (SKuint32 i = 0; i < count; ++i)
+    {
+        rtCpuHitResult hit;
+        const bool     result = rtCpuIntersectRay(scene.getPtr(), queries[i], hit);
+
+        EXPECT_EQ(hit.index, hits[i].index) << "ray " << i;
+        if (result && hit.index == hits[i].index)
+            EXPECT_FLOAT_EQ(hit.distance, hits[i].distance) << "ray " << i;
+
+        EXPECT_EQ(rtCpuOccludedRay(scene.getPtr(), queries[i]) ? 1 : 0, blocked[i]) << "ray " << i;
+        hitCount += result ? 1 : 0;
+    }
+
+    EXPECT_GT(hitCount, 0u);
+    EXPECT_LT(hitCount, count);
+}
+
+GTEST_TEST(RayQuery, SharedGeometry)
+{
+    rtScene scene;
+
+    rtMesh* first  = AddQuad(scene);
+    rtMesh* second = new rtMesh(&scene);
+    second->setGeometry(first->getGeometry());
+    scene.addMesh(second);
+
+    EXPECT_EQ(first->getGeometry(), second->getGeometry());
+    EXPECT_EQ(2, first->getGeometry()->getReferenceCount());
+
+    first->setPosition(-3, 0, 0);
+    second->setPosition(3, 0, 2);
+    second->setScale(0.5f, 0.5f, 0.5f);
+
+    // The two instances place the one set of triangles apart.
+    ExpectHit(Intersect(scene, MakeQuery(-3.5f, 0.5f, 10, 0, 0, -1)), 0, 10, 0, 0, 1);
+    ExpectHit(Intersect(scene, MakeQuery(3.25f, -0.25f, 10, 0, 0, -1)), 1, 8, 0, 0, 1);
+    ExpectMiss(Intersect(scene, MakeQuery(3.75f, 0, 10, 0, 0, -1)));
+    ExpectMiss(Intersect(scene, MakeQuery(0, 0, 10, 0, 0, -1)));
+
+    // Giving an instance geometry of its own releases the shared one.
+    second->setGeometry(new rtMeshGeometry());
+    second->getGeometry()->release();
+    EXPECT_EQ(1, first->getGeometry()->getReferenceCount());
+    EXPECT_EQ(1, second->getGeometry()->getReferenceCount());
+}
+
+GTEST_TEST(RayQuery, Moved)
+{
+    // A field of boxes and spheres, some of which move every frame.
+    // Each one has a height of its own, so that where they come to
+    // overlap, one is always nearer to the rays than the other.
+    const SKuint32 count = 200;
+
+    skArray<skVector3> positions;
+    for (SKuint32 i = 0; i < count; ++i)
+        positions.push_back(skVector3(skScalar(i % 20) * 3 - 30, skScalar(i / 20) * 3 - 15, skScalar(i) / 256));
+
+    rtScene             scene;
+    skArray<rtObject*> objects;
+    for (SKuint32 i = 0; i < count; ++i)
+    {
+        const skVector3& p = positions[i];
+        if (i % 2)
+            objects.push_back(AddSphere(scene, p.x, p.y, p.z, 1));
+        else
+            objects.push_back(AddCube(scene, p.x, p.y, p.z, 2));
+    }
+
+    SKuint32 started = 0, checked = 0;
+    for (SKuint32 frame = 0; frame < 8; ++frame)
+    {
+        // The first frames take small steps, the later
+        // ones move boxes across the whole field.
+        for (SKuint32 i = frame; i < count; i += 7)
+        {
+            const skScalar step = frame < 4 ? skScalar(0.5) : skScalar(23);
+            skVector3&     p    = positions[i];
+            p.x += step;
+            if (p.x > 30)
+                p.x -= 60;
+            p.z = skScalar(frame % 3) + skScalar(i) / 256;
+            objects[i]->setPosition(p);
+        }
+
+        // The large steps degrade the hierarchy enough to start a rebuild.
+        // Waiting for it makes the next frame swap it in, rather than
+        // whichever frame happens to run after the thread finishes.
+        const SKuint32 rebuilds = scene.getRebuildCount();
+        scene.updateCaches();
+        const bool swapped = scene.getRebuildCount() > rebuilds;
+
+        if (scene.isRebuilding())
+        {
+            EXPECT_LE(4u, frame);
+            ++started;
+            scene.waitForRebuild();
+        }
+
+        rtScene fresh;
+        for (SKuint32 i = 0; i < count; ++i)
+        {
+            const skVector3& p = positions[i];
+            if (i % 2)
+                AddSphere(fresh, p.x, p.y, p.z, 1);
+            else
+                AddCube(fresh, p.x, p.y, p.z, 2);
+        }
+
+        for (SKuint32 r = 0; r < 120; ++r)
+        {
+            const rtScalar x = -31 + rtScalar(r) * rtScalar(62) / 120;
+            const rtScalar y = -16 + rtScalar(r % 11) * rtScalar(3.1);
+
+            const rtCpuRayQuery  query    = MakeQuery(x, y, 10, 0, 0, -1);
+            const rtCpuHitResult moved    = Intersect(scene, query);
+            const rtCpuHitResult expected = Intersect(fresh, query);
+
+            EXPECT_EQ(expected.index, moved.index) << "frame " << frame << " ray " << r;
+            if (expected.index != SK_NPOS32 && expected.index == moved.index)
+                EXPECT_FLOAT_EQ(expected.distance, moved.distance);
+        }
+
+        if (swapped)
+            ++checked;
+    }
+
+    // At least one rebuild was swapped in, and traced, before the last frame.
+    EXPECT_LE(1u, started);
+    EXPECT_LE(1u, checked);
+    EXPECT_LE(checked, scene.getRebuildCount());
+}
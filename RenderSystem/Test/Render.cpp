@@ -0,0 +1,401 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include "RenderSystem/Cpu/rtCpuRenderSystem.h"
+#include "RenderSystem/Loader/rtLoader.h"
+#include "RenderSystem/rtBufferTarget.h"
+#include "RenderSystem/rtCamera.h"
+#include "RenderSystem/rtImageTarget.h"
+#include "Image/skImage.h"
+#include "Math/skRectangle.h"
+#include "RenderSystem/rtScene.h"
+#include "RenderSystem/rtTiledImageTarget.h"
+#include "TestDirectory.h"
+#include "Utils/skArray.h"
+#include "Utils/skString.h"
+
+constexpr SKuint32 Width  = 96;
+constexpr SKuint32 Height = 72;
+
+using Pixels = skArray<SKubyte>;
+
+// Holds the first scene of a sample file for the length of a test.
+class SampleScene
+{
+private:
+    rtLoader* m_loader;
+    rtScene*  m_scene;
+
+public:
+    explicit SampleScene(const char* path) :
+        m_loader(rtLoader::create(path)),
+        m_scene(nullptr)
+    {
+        if (m_loader && m_loader->load(path) == 0 && !m_loader->getScenes().empty())
+            m_scene = m_loader->getScenes().at(0);
+    }
+
+    ~SampleScene()
+    {
+        delete m_loader;
+    }
+
+    rtScene* get() const
+    {
+        return m_scene;
+    }
+};
+
+// Keeps every band it is handed, so a banded render
+// can be compared with one into a whole image.
+class BandCapture : public rtBufferTarget
+{
+private:
+    Pixels   m_image;
+    SKuint32 m_bands;
+
+public:
+    BandCapture(const SKuint32 w, const SKuint32 h, const SKuint32 bandHeight) :
+        rtBufferTarget(w, h, bandHeight),
+        m_bands(0)
+    {
+        m_image.resize((SKuint32)w * h * 4);
+        memset(m_image.ptr(), 0, m_image.size());
+    }
+
+    void unlockBand() override
+    {
+        const rtFrameBufferInfo& fb = getFrameBufferInfo();
+        SK_ASSERT(fb.offsetY * fb.pitch + fb.maxSize <= m_image.size());
+
+        memcpy(m_image.ptr() + (SKsize)fb.offsetY * fb.pitch, fb.pixels, fb.maxSize);
+        ++m_bands;
+    }
+
+    const Pixels& getImage() const
+    {
+        return m_image;
+    }
+
+    SKuint32 getBands() const
+    {
+        return m_bands;
+    }
+};
+
+Pixels Copy(rtBufferTarget& target)
+{
+    Pixels pixels;
+    pixels.resize((SKuint32)target.getSizeInBytes());
+    memcpy(pixels.ptr(), target.getPixels(), pixels.size());
+    return pixels;
+}
+
+// Renders the scene's first camera into a whole image.
+Pixels RenderFrame(rtScene* scene)
+{
+    rtCpuRenderSystem system;
+    rtBufferTarget    target(Width, Height);
+    system.setTarget(&target);
+    system.setMode(scene->getFlags());
+    system.render(scene);
+    return Copy(target);
+}
+
+bool NotBlank(const Pixels& pixels)
+{
+    for (const SKubyte& byte : pixels)
+    {
+        if (byte != 0)
+            return true;
+    }
+    return false;
+}
+
+GTEST_TEST(Render, Bands)
+{
+    SampleScene scene(GetTestFilePath("Samples/Viewer/Test01.bascii"));
+    ASSERT_NE(nullptr, scene.get());
+
+    const Pixels whole = RenderFrame(scene.get());
+    ASSERT_EQ(Width * Height * 4, whole.size());
+    EXPECT_TRUE(NotBlank(whole));
+
+    // 7 does not divide the height, so the last band is short.
+    for (const SKuint32 bandHeight : {1u, 7u, Height / 2})
+    {
+        rtCpuRenderSystem system;
+        BandCapture       target(Width, Height, bandHeight);
+        system.setTarget(&target);
+        system.setMode(scene.get()->getFlags());
+        system.render(scene.get());
+
+        EXPECT_EQ((Height + bandHeight - 1) / bandHeight, target.getBands());
+        EXPECT_EQ(0, memcmp(whole.ptr(), target.getImage().ptr(), whole.size()));
+    }
+}
+
+GTEST_TEST(Render, ImageTarget)
+{
+    SampleScene scene(GetTestFilePath("Samples/Viewer/Test01.bascii"));
+    ASSERT_NE(nullptr, scene.get());
+
+    const Pixels whole = RenderFrame(scene.get());
+
+    rtCpuRenderSystem system;
+    rtImageTarget     target(Width, Height);
+    system.setTarget(&target);
+    system.setMode(scene.get()->getFlags());
+    system.render(scene.get());
+
+    // The bitmap stores its rows bottom up.
+    const rtFrameBufferInfo& fb = target.getFrameBufferInfo();
+    ASSERT_TRUE(fb.bottomUp);
+    for (SKuint32 y = 0; y < Height; ++y)
+    {
+        const SKubyte* row = fb.pixels + (SKsize)(Height - 1 - y) * fb.pitch;
+        EXPECT_EQ(0, memcmp(whole.ptr() + (SKsize)y * Width * 4, row, Width * 4)) << "row " << y;
+    }
+}
+
+GTEST_TEST(Render, Region)
+{
+    SampleScene scene(GetTestFilePath("Samples/Viewer/Test01.bascii"));
+    ASSERT_NE(nullptr, scene.get());
+
+    const Pixels whole = RenderFrame(scene.get());
+
+    rtCpuRenderSystem system;
+    rtBufferTarget    target(Width, Height);
+    system.setTarget(&target);
+    system.setMode(scene.get()->getFlags());
+
+    // The second rectangle hangs off the bottom right corner,
+    // so only the part of it inside the target is rendered.
+    system.render(scene.get(), skRectangle(20, 10, 30, 25));
+    system.render(scene.get(), skRectangle(Width - 8, Height - 6, 16, 12));
+
+    const Pixels region = Copy(target);
+    ASSERT_EQ(whole.size(), region.size());
+
+    for (SKuint32 y = 0; y < Height; ++y)
+    {
+        for (SKuint32 x = 0; x < Width; ++x)
+        {
+            const bool inside = (x >= 20 && x < 50 && y >= 10 && y < 35) ||
+                                (x >= Width - 8 && y >= Height - 6);
+
+            const SKsize loc = ((SKsize)y * Width + x) * 4;
+            for (SKsize c = 0; c < 4; ++c)
+                EXPECT_EQ(inside ? whole[loc + c] : 0, region[loc + c]) << x << ", " << y;
+        }
+    }
+}
+
+GTEST_TEST(Render, Views)
+{
+    SampleScene scene(GetTestFilePath("Samples/Viewer/Test01.bascii"));
+    ASSERT_NE(nullptr, scene.get());
+    ASSERT_FALSE(scene.get()->getCameras().empty());
+
+    rtCamera* main = scene.get()->getCameras().at(0);
+    main->update();
+
+    rtCamera* side = new rtCamera(scene.get());
+    side->setNear(main->getNear());
+    side->setFar(main->getFar());
+    side->setFieldOfViewAngle(main->getFieldOfViewAngle());
+    side->setPosition(main->getDerivedPosition() + skVector3(2, -1, 0.5));
+    side->setOrientation(main->getDerivedOrientation());
+    scene.get()->addCamera(side);
+
+    // Each view renders into its own size.
+    rtBufferTarget first(Width, Height);
+    rtBufferTarget second(Width / 2, Height / 3);
+
+    rtCpuRenderSystem system;
+    system.setTarget(&first);
+    system.setMode(scene.get()->getFlags());
+
+    rtViews views;
+    views.push_back({main, &first});
+    views.push_back({side, &second});
+    system.render(scene.get(), views);
+
+    EXPECT_EQ(&first, system.getTarget());
+
+    for (const rtView& view : views)
+    {
+        rtCpuRenderSystem single;
+        rtBufferTarget    target(view.target->getWidth(), view.target->getHeight());
+        single.setTarget(&target);
+        single.setMode(scene.get()->getFlags());
+        single.setCamera(view.camera);
+        single.render(scene.get());
+
+        const Pixels expected = Copy(target);
+        const Pixels actual   = Copy(*(rtBufferTarget*)view.target);
+        ASSERT_EQ(expected.size(), actual.size());
+        EXPECT_TRUE(NotBlank(actual));
+        EXPECT_EQ(0, memcmp(expected.ptr(), actual.ptr(), expected.size()));
+    }
+}
+
+GTEST_TEST(Render, SwitchCameras)
+{
+    SampleScene scene(GetTestFilePath("Samples/Viewer/Test01.bascii"));
+    ASSERT_NE(nullptr, scene.get());
+    ASSERT_FALSE(scene.get()->getCameras().empty());
+
+    rtCamera* main = scene.get()->getCameras().at(0);
+    main->update();
+
+    rtCamera* side = new rtCamera(scene.get());
+    side->setNear(main->getNear());
+    side->setFar(main->getFar());
+    side->setFieldOfViewAngle(main->getFieldOfViewAngle() * skScalar(0.75));
+    side->setPosition(main->getDerivedPosition() + skVector3(-1, 2, 0.5));
+    side->setOrientation(main->getDerivedOrientation());
+    scene.get()->addCamera(side);
+
+    // One system renders every frame, as a batch does, so the frames
+    // after the first switch cameras on the compiled scene and reuse
+    // the render threads. Each has to match a system that starts fresh.
+    rtCpuRenderSystem system;
+    rtBufferTarget    target(Width, Height);
+    system.setTarget(&target);
+    system.setMode(scene.get()->getFlags());
+
+    rtCamera* cameras[] = {main, side, main};
+    Pixels    frames[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        system.setCamera(cameras[i]);
+        system.render(scene.get());
+        frames[i] = Copy(target);
+
+        rtCpuRenderSystem fresh;
+        rtBufferTarget    expected(Width, Height);
+        fresh.setTarget(&expected);
+        fresh.setMode(scene.get()->getFlags());
+        fresh.setCamera(cameras[i]);
+        fresh.render(scene.get());
+
+        const Pixels pixels = Copy(expected);
+        ASSERT_EQ(pixels.size(), frames[i].size());
+        EXPECT_TRUE(NotBlank(frames[i]));
+        EXPECT_EQ(0, memcmp(pixels.ptr(), frames[i].ptr(), pixels.size())) << "frame " << i;
+    }
+
+    EXPECT_NE(0, memcmp(frames[0].ptr(), frames[1].ptr(), frames[0].size()));
+    EXPECT_EQ(0, memcmp(frames[0].ptr(), frames[2].ptr(), frames[0].size()));
+}
+
+// Reads the RGB samples of a binary PPM file.
+bool ReadPpm(const char* path, SKuint32& w, SKuint32& h, Pixels& rgb)
+{
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+        return false;
+
+    unsigned int mw = 0, mh = 0, max = 0;
+    bool         result = fscanf(fp, "P6 %u %u %u", &mw, &mh, &max) == 3 && max == 255 && fgetc(fp) == '\n';
+    if (result)
+    {
+        w = mw;
+        h = mh;
+        rgb.resize(w * h * 3);
+        result = fread(rgb.ptr(), 1, rgb.size(), fp) == rgb.size();
+    }
+    fclose(fp);
+    return result;
+}
+
+GTEST_TEST(Render, Encoded)
+{
+    SampleScene scene(GetTestFilePath("Samples/Viewer/Test01.bascii"));
+    ASSERT_NE(nullptr, scene.get());
+
+    const Pixels whole = RenderFrame(scene.get());
+
+    skImage::initialize();
+    for (const char* name : {"Encoded.ppm", "Encoded.png"})
+    {
+        const skString path = skString(testing::TempDir().c_str()) + name;
+
+        // Bands of 7 rows are encoded while the next band renders.
+        rtTiledImageTarget target(Width, Height, 7);
+        ASSERT_TRUE(target.open(path.c_str()));
+
+        rtCpuRenderSystem system;
+        system.setTarget(&target);
+        system.setMode(scene.get()->getFlags());
+        system.render(scene.get());
+        ASSERT_TRUE(target.close());
+
+        // The files only hold the color, without alpha.
+        Pixels   rgb;
+        SKuint32 w = 0, h = 0;
+        if (path.find(".ppm") != SK_NPOS)
+            ASSERT_TRUE(ReadPpm(path.c_str(), w, h, rgb));
+        else
+        {
+            skImage image;
+            ASSERT_TRUE(image.load(path.c_str()));
+            w = image.getWidth();
+            h = image.getHeight();
+            rgb.resize(w * h * 3);
+
+            // The bitmap's rows are bottom up, and its
+            // pixels are in the order of rtPixelRGBA.
+            ASSERT_EQ(3, image.getBPP());
+            for (SKuint32 y = 0; y < h; ++y)
+            {
+                const SKubyte* row = image.getBytes() + (SKsize)(h - 1 - y) * image.getPitch();
+                for (SKuint32 x = 0; x < w; ++x)
+                {
+                    const rtPixelRGBA* pixel = (const rtPixelRGBA*)(row + x * 3);
+
+                    SKubyte* dst = &rgb[(y * w + x) * 3];
+                    dst[0]       = pixel->r;
+                    dst[1]       = pixel->g;
+                    dst[2]       = pixel->b;
+                }
+            }
+        }
+
+        ASSERT_EQ(Width, w) << name;
+        ASSERT_EQ(Height, h) << name;
+
+        const rtPixelRGBA* src = (const rtPixelRGBA*)whole.ptr();
+        for (SKuint32 i = 0; i < Width * Height; ++i)
+        {
+            ASSERT_EQ(src[i].r, rgb[i * 3 + 0]) << name << " pixel " << i;
+            ASSERT_EQ(src[i].g, rgb[i * 3 + 1]) << name << " pixel " << i;
+            ASSERT_EQ(src[i].b, rgb[i * 3 + 2]) << name << " pixel " << i;
+        }
+        remove(path.c_str());
+    }
+    skImage::finalize();
+}
@@ -0,0 +1,141 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include "RenderSystem/Cpu/rtCpuRenderSystem.h"
+#include "RenderSystem/Loader/Scene/rtSceneFileLoader.h"
+#include "RenderSystem/Loader/Scene/rtSceneFileWriter.h"
+#include "RenderSystem/Loader/rtLoader.h"
+#include "RenderSystem/rtBufferTarget.h"
+#include "RenderSystem/rtScene.h"
+#include "TestDirectory.h"
+#include "Utils/skArray.h"
+#include "Utils/skString.h"
+
+constexpr SKuint32 Width  = 80;
+constexpr SKuint32 Height = 60;
+
+using Pixels = skArray<SKubyte>;
+
+Pixels Render(rtScene* scene)
+{
+    rtCpuRenderSystem system;
+    rtBufferTarget    target(Width, Height);
+    system.setTarget(&target);
+    system.setMode(scene->getFlags());
+    system.render(scene);
+
+    Pixels pixels;
+    pixels.resize((SKuint32)target.getSizeInBytes());
+    memcpy(pixels.ptr(), target.getPixels(), pixels.size());
+    return pixels;
+}
+
+void RoundTrip(const char* source)
+{
+    rtLoader* loader = rtLoader::create(source);
+    ASSERT_NE(nullptr, loader);
+    ASSERT_EQ(0, loader->load(source));
+    ASSERT_FALSE(loader->getScenes().empty());
+
+    rtScene*       scene = loader->getScenes().at(0);
+    const skString path  = skString(testing::TempDir().c_str()) + "RoundTrip.rtscene";
+    EXPECT_EQ(0, rtSceneFileWriter::save(scene, path.c_str()));
+
+    rtLoader* mapped = rtLoader::create(path.c_str());
+    ASSERT_NE(nullptr, mapped);
+    EXPECT_NE(nullptr, dynamic_cast<rtSceneFileLoader*>(mapped));
+    EXPECT_EQ(0, mapped->load(path.c_str()));
+
+    if (!mapped->getScenes().empty())
+    {
+        rtScene* copy = mapped->getScenes().at(0);
+        EXPECT_EQ(scene->getFlags(), copy->getFlags());
+        EXPECT_EQ(scene->getCameras().size(), copy->getCameras().size());
+        EXPECT_EQ(scene->getLights().size(), copy->getLights().size());
+        EXPECT_EQ(scene->getObjects().size(), copy->getObjects().size());
+
+        // Meshes and their hierarchies are read from the mapping in place.
+        ASSERT_EQ(scene->getMeshes().size(), copy->getMeshes().size());
+        for (SKuint32 i = 0; i < copy->getMeshes().size(); ++i)
+        {
+            const rtMesh* source = scene->getMeshes().at(i);
+            const rtMesh* mesh   = copy->getMeshes().at(i);
+            EXPECT_EQ(source->getIndexCount(), mesh->getIndexCount());
+            if (mesh->getIndexCount() == 0)
+                continue;
+
+            EXPECT_TRUE(mesh->isView()) << "mesh " << i;
+            EXPECT_TRUE(mesh->getBvh().isView()) << "mesh " << i;
+            EXPECT_EQ(source->getBvh().getView().nodeCount, mesh->getBvh().getView().nodeCount);
+        }
+
+        const Pixels expected = Render(scene);
+        const Pixels actual   = Render(copy);
+        ASSERT_EQ(expected.size(), actual.size());
+        EXPECT_EQ(0, memcmp(expected.ptr(), actual.ptr(), expected.size()));
+
+        // The top level hierarchy is the one that was saved. A scene
+        // without a camera is not rendered, so it is compiled here.
+        copy->updateCaches();
+        const rtMeshBvh::View& saved  = scene->getHierarchy().getView();
+        const rtMeshBvh::View& loaded = copy->getHierarchy().getView();
+        ASSERT_EQ(saved.nodeCount, loaded.nodeCount);
+        ASSERT_EQ(saved.triangleCount, loaded.triangleCount);
+        EXPECT_EQ(0, memcmp(saved.triangles, loaded.triangles, (SKsize)saved.triangleCount * sizeof(SKuint32)));
+        for (SKuint32 i = 0; i < saved.nodeCount; ++i)
+        {
+            EXPECT_EQ(saved.nodes[i].first, loaded.nodes[i].first);
+            EXPECT_EQ(saved.nodes[i].count, loaded.nodes[i].count);
+        }
+    }
+    else
+        ADD_FAILURE() << "no scene in " << path.c_str();
+
+    delete mapped;
+    delete loader;
+    remove(path.c_str());
+}
+
+GTEST_TEST(SceneFile, RoundTrip)
+{
+    RoundTrip(GetTestFilePath("Samples/Viewer/Test01.bascii"));
+    RoundTrip(GetTestFilePath("Samples/Viewer/Test02.bascii"));
+}
+
+GTEST_TEST(SceneFile, RoundTripMeshes)
+{
+    RoundTrip(GetTestFilePath("RenderSystem/Test/Instances.bascii"));
+    RoundTrip(GetTestFilePath("Extern/FileTools/FileFormats/Blend/Test/Test.blend"));
+}
+
+GTEST_TEST(SceneFile, Missing)
+{
+    rtSceneFileLoader loader;
+    EXPECT_EQ(-1, loader.load(GetTestFilePath("Samples/Viewer/Missing.rtscene")));
+    EXPECT_TRUE(loader.getScenes().empty());
+
+    // A file that is not a scene file is rejected.
+    EXPECT_EQ(-1, loader.load(GetTestFilePath("Samples/Viewer/Test01.bascii")));
+    EXPECT_TRUE(loader.getScenes().empty());
+}
@@ -0,0 +1,139 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include "RenderSystem/rtTaskPool.h"
+#include "Utils/skArray.h"
+
+// Counts the number of times each of its items runs.
+class CountingTask : public rtTask
+{
+private:
+    std::atomic<SKuint32>* m_runs;
+    SKuint32               m_count;
+
+public:
+    explicit CountingTask(const SKuint32 count) :
+        m_runs(new std::atomic<SKuint32>[count]),
+        m_count(count)
+    {
+        for (SKuint32 i = 0; i < m_count; ++i)
+            m_runs[i] = 0;
+    }
+
+    ~CountingTask() override
+    {
+        delete[] m_runs;
+    }
+
+    void execute(const SKuint32 index) override
+    {
+        ASSERT_LT(index, m_count);
+        ++m_runs[index];
+    }
+
+    void expectOnce() const
+    {
+        for (SKuint32 i = 0; i < m_count; ++i)
+            EXPECT_EQ(1u, m_runs[i].load()) << "item " << i;
+    }
+};
+
+// Starts a nested task from each of its items.
+class NestingTask : public rtTask
+{
+private:
+    skArray<CountingTask*> m_nested;
+
+public:
+    explicit NestingTask(const SKuint32 count)
+    {
+        for (SKuint32 i = 0; i < count; ++i)
+            m_nested.push_back(new CountingTask(i + 1));
+    }
+
+    ~NestingTask() override
+    {
+        for (CountingTask* task : m_nested)
+            delete task;
+    }
+
+    void execute(const SKuint32 index) override
+    {
+        rtTaskPool::execute(m_nested[index], index + 1, 4);
+    }
+
+    void expectOnce() const
+    {
+        for (const CountingTask* task : m_nested)
+            task->expectOnce();
+    }
+};
+
+GTEST_TEST(TaskPool, Items)
+{
+    for (const SKuint32 threads : {0u, 1u, 4u})
+    {
+        CountingTask task(1000);
+        rtTaskPool::execute(&task, 1000, threads);
+        task.expectOnce();
+    }
+
+    // Nothing to do returns straight away.
+    CountingTask empty(1);
+    rtTaskPool::execute(&empty, 0, 4);
+}
+
+GTEST_TEST(TaskPool, Repeated)
+{
+    // The same threads pick up one call after another.
+    for (SKuint32 i = 1; i < 64; ++i)
+    {
+        CountingTask task(i);
+        rtTaskPool::execute(&task, i, 4);
+        task.expectOnce();
+    }
+}
+
+GTEST_TEST(TaskPool, Nested)
+{
+    NestingTask task(32);
+    rtTaskPool::execute(&task, 32, 4);
+    task.expectOnce();
+}
+
+GTEST_TEST(TaskPool, Concurrent)
+{
+    // Whichever call does not get the pool runs on its own thread.
+    CountingTask first(500);
+    CountingTask second(500);
+
+    std::thread other([&second] {
+        rtTaskPool::execute(&second, 500, 4);
+    });
+    rtTaskPool::execute(&first, 500, 4);
+    other.join();
+
+    first.expectOnce();
+    second.expectOnce();
+}
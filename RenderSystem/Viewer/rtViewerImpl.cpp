@@ -75,10 +75,12 @@ rtViewerImpl::rtViewerImpl(SKuint32        width,
     m_camera(nullptr),
     m_frameBuffer{
         nullptr,
-        (SKuint16)width,
-        (SKuint16)height,
-        (SKuint16)(width * 4),
-        (SKuint32)(width * height * 4),
+        width,
+        height,
+        width * 4,
+        (SKsize)width * height * 4,
+        0,
+        false,
     },
     m_tick(new rtFrameRateSmoother(this)),
     m_quit(false),
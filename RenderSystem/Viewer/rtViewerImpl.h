@@ -113,7 +113,7 @@ public:
     ///
     /// </summary>
     /// <returns></returns>
-    SKuint32 getSizeInBytes() override;
+    SKsize getSizeInBytes() override;
 
     /// <summary>
     ///
@@ -141,7 +141,7 @@ SK_INLINE SKuint32 rtViewerImpl::getPitch()
     return m_frameBuffer.pitch;
 }
 
-SK_INLINE SKuint32 rtViewerImpl::getSizeInBytes()
+SK_INLINE SKsize rtViewerImpl::getSizeInBytes()
 {
     return m_frameBuffer.maxSize;
 }
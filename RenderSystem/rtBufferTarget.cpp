@@ -0,0 +1,56 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "rtBufferTarget.h"
+#include <cstring>
+#include "Utils/skMinMax.h"
+
+rtBufferTarget::rtBufferTarget(SKuint32 w, SKuint32 h, SKuint32 bandHeight) :
+    m_frameBuffer(),
+    m_bandHeight(bandHeight == 0 ? h : skClamp<SKuint32>(bandHeight, 1, skMax<SKuint32>(h, 1)))
+{
+    m_frameBuffer.width    = w;
+    m_frameBuffer.height   = h;
+    m_frameBuffer.pitch    = w * 4;
+    m_frameBuffer.maxSize  = (SKsize)m_frameBuffer.pitch * m_bandHeight;
+    m_frameBuffer.offsetY  = 0;
+    m_frameBuffer.bottomUp = false;
+    m_frameBuffer.pixels   = new SKubyte[m_frameBuffer.maxSize];
+
+    memset(m_frameBuffer.pixels, 0, m_frameBuffer.maxSize);
+}
+
+rtBufferTarget::~rtBufferTarget()
+{
+    delete[] m_frameBuffer.pixels;
+}
+
+void rtBufferTarget::lockBand(const SKuint32 y, const SKuint32 rows)
+{
+    SK_ASSERT(rows <= m_bandHeight);
+
+    // A buffer that holds the whole image keeps every row in place.
+    if (m_bandHeight < m_frameBuffer.height)
+    {
+        m_frameBuffer.offsetY = y;
+        m_frameBuffer.maxSize = (SKsize)m_frameBuffer.pitch * skMin(rows, m_bandHeight);
+    }
+}
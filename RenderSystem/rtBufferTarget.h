@@ -0,0 +1,142 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+/*! \addtogroup FrontEnd
+ * @{
+ */
+
+#ifndef _rtBufferTarget_h_
+#define _rtBufferTarget_h_
+
+#include "RenderSystem/rtTarget.h"
+
+/// <summary>
+/// Implementation of the rtTarget class that renders into a
+/// plain, top down block of rtPixelRGBA pixels in memory.
+/// The block can hold the whole image, or a band of it.
+/// </summary>
+class rtBufferTarget : public rtTarget
+{
+private:
+    rtFrameBufferInfo m_frameBuffer;
+    SKuint32          m_bandHeight;
+
+public:
+    /// <summary>
+    ///
+    /// </summary>
+    /// <param name="w">The width of the image.</param>
+    /// <param name="h">The height of the image.</param>
+    /// <param name="bandHeight">
+    /// The number of rows the buffer holds, or zero for the whole image.
+    /// When it is less than h, the last locked band starts at the first byte.
+    /// </param>
+    rtBufferTarget(SKuint32 w, SKuint32 h, SKuint32 bandHeight = 0);
+
+    ~rtBufferTarget() override;
+
+    /// <summary>
+    /// Returns the first byte of the top row.
+    /// </summary>
+    /// <returns></returns>
+    const SKubyte* getPixels() const;
+
+    /// <summary>
+    ///
+    /// </summary>
+    /// <returns></returns>
+    SKuint32 getWidth() override;
+
+    /// <summary>
+    ///
+    /// </summary>
+    /// <returns></returns>
+    SKuint32 getHeight() override;
+
+    /// <summary>
+    ///
+    /// </summary>
+    /// <returns></returns>
+    SKsize getSizeInBytes() override;
+
+    /// <summary>
+    ///
+    /// </summary>
+    /// <returns></returns>
+    SKuint32 getPitch() override;
+
+    /// <summary>
+    ///
+    /// </summary>
+    /// <returns></returns>
+    const rtFrameBufferInfo& getFrameBufferInfo() override;
+
+    /// <summary>
+    ///
+    /// </summary>
+    /// <returns></returns>
+    SKuint32 getBandHeight() override;
+
+    /// <summary>
+    ///
+    /// </summary>
+    /// <param name="y"></param>
+    /// <param name="rows"></param>
+    void lockBand(SKuint32 y, SKuint32 rows) override;
+};
+/*! @} */
+
+SK_INLINE const SKubyte* rtBufferTarget::getPixels() const
+{
+    return m_frameBuffer.pixels;
+}
+
+SK_INLINE SKuint32 rtBufferTarget::getWidth()
+{
+    return m_frameBuffer.width;
+}
+
+SK_INLINE SKuint32 rtBufferTarget::getHeight()
+{
+    return m_frameBuffer.height;
+}
+
+SK_INLINE SKsize rtBufferTarget::getSizeInBytes()
+{
+    return (SKsize)m_frameBuffer.pitch * m_bandHeight;
+}
+
+SK_INLINE SKuint32 rtBufferTarget::getPitch()
+{
+    return m_frameBuffer.pitch;
+}
+
+SK_INLINE const rtFrameBufferInfo& rtBufferTarget::getFrameBufferInfo()
+{
+    return m_frameBuffer;
+}
+
+SK_INLINE SKuint32 rtBufferTarget::getBandHeight()
+{
+    return m_bandHeight;
+}
+
+#endif  //_rtBufferTarget_h_
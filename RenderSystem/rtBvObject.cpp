@@ -25,8 +25,11 @@
 
 rtBvObject::rtBvObject(rtScene* sc) :
     rtObject(sc),
-    m_material()
+    m_material(),
+    m_index(SK_NPOS32)
 {
+    rtArenaScope scope(sc ? sc->getArena() : nullptr);
+
     m_data = rtAllocator::allocate<rtObjectType>();
     m_data->type = 0;
 
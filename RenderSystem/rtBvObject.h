@@ -35,8 +35,11 @@
 class rtBvObject : public rtObject
 {
 protected:
+    friend class rtScene;
+
     rtObjectType* m_data;
     rtMaterial*   m_material;
+    SKuint32      m_index;
 
 public:
     explicit rtBvObject(rtScene* sc);
@@ -66,6 +69,12 @@ public:
     /// <returns></returns>
     rtMaterial* getMaterial() const;
 
+    /// <summary>
+    /// Returns the location of this object in the scene's object array.
+    /// </summary>
+    /// <returns>The index or SK_NPOS32 if it has not been added to a scene.</returns>
+    SKuint32 getIndex() const;
+
     /// <summary>
     ///
     /// </summary>
@@ -87,6 +96,11 @@ public:
 
 /*! @} */
 
+SK_INLINE SKuint32 rtBvObject::getIndex() const
+{
+    return m_index;
+}
+
 SK_INLINE rtObjectType* rtBvObject::getPtr() const
 {
     return m_data;
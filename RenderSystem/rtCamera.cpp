@@ -28,6 +28,8 @@ rtCamera::rtCamera(rtScene* sc) :
     rtObject(sc),
     m_data(nullptr)
 {
+    rtArenaScope scope(sc ? sc->getArena() : nullptr);
+
     m_data = rtAllocator::allocate<rtCameraType>();
     m_data->location = {};
     m_data->rotation = {};
@@ -25,7 +25,7 @@
 #include "Utils/Config/skConfig.h"
 
 /* #undef RayTracer_USING_CUDA */
-#define RayTracer_OPT_GEN_INTRINSIC 1
+/* #undef RayTracer_OPT_GEN_INTRINSIC */
 #define RayTracer_EXTRA_DEBUG 1
 /* #undef RayTracer_SLOW_INTERSECTIONS */
 /* #undef RayTracer_FULL_PROFILE */
@@ -56,6 +56,12 @@ public:
     /// <param name="extent"></param>
     /// <returns></returns>
     void setExtent(const skScalar& extent);
+
+    /// <summary>
+    ///
+    /// </summary>
+    /// <returns></returns>
+    const skScalar& getExtent() const;
 };
 
 /*! @} */
@@ -70,4 +76,9 @@ SK_INLINE void rtCube::setExtent(const skScalar& extent)
     m_extent = extent;
 }
 
+SK_INLINE const skScalar& rtCube::getExtent() const
+{
+    return m_extent;
+}
+
 #endif  //_rtCube_h_
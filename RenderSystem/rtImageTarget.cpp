@@ -26,17 +26,21 @@ rtImageTarget::rtImageTarget(SKuint32 w, SKuint32 h) :
     m_frameBuffer()
 {
     m_image = new skImage(w, h, SK_RGBA);
-    m_image->setFlipY(true);
-    m_frameBuffer.width   = (SKuint16)m_image->getWidth();
-    m_frameBuffer.height  = (SKuint16)m_image->getHeight();
-    m_frameBuffer.maxSize = (SKuint32)m_image->getSizeInBytes();
-    m_frameBuffer.pitch   = (SKuint16)m_image->getPitch();
-    m_frameBuffer.pixels  = new SKubyte[m_frameBuffer.maxSize];
+    SK_ASSERT(m_image->getBPP() == sizeof(rtPixelRGBA));
+
+    // The kernel renders straight into the bitmap. Its rows
+    // are stored bottom up, which the kernel accounts for.
+    m_frameBuffer.pixels   = m_image->getBytes();
+    m_frameBuffer.width    = m_image->getWidth();
+    m_frameBuffer.height   = m_image->getHeight();
+    m_frameBuffer.pitch    = m_image->getPitch();
+    m_frameBuffer.maxSize  = (SKsize)m_frameBuffer.pitch * m_frameBuffer.height;
+    m_frameBuffer.offsetY  = 0;
+    m_frameBuffer.bottomUp = true;
 }
 
 rtImageTarget::~rtImageTarget()
 {
-    delete[] m_frameBuffer.pixels;
     delete m_image;
     m_image = nullptr;
 }
@@ -44,17 +48,7 @@ rtImageTarget::~rtImageTarget()
 void rtImageTarget::save(const char* path) const
 {
     if (m_image)
-    {
-        for (SKuint32 y = 0; y < m_frameBuffer.height; ++y)
-        {
-            for (SKuint32 x = 0; x < m_frameBuffer.width; ++x)
-            {
-                rtPixelRGBA* rgba = (rtPixelRGBA*)&m_frameBuffer.pixels[x * 4 + y * m_frameBuffer.pitch];
-                m_image->setPixel(x, y, {rgba->r, rgba->g, rgba->b, 255});
-            }
-        }
         m_image->save(path);
-    }
 }
 
 SKuint32 rtImageTarget::getWidth()
@@ -71,14 +65,10 @@ SKuint32 rtImageTarget::getHeight()
     return 0;
 }
 
-SKuint32 rtImageTarget::getSizeInBytes()
+SKsize rtImageTarget::getSizeInBytes()
 {
     if (m_image)
-    {
-        const SKsize sz = m_image->getSizeInBytes();
-        SK_ASSERT(sz < SK_NPOS32);
-        return (SKuint32)sz;
-    }
+        return m_image->getSizeInBytes();
     return 0;
 }
 
@@ -71,7 +71,7 @@ public:
     ///
     /// </summary>
     /// <returns></returns>
-    SKuint32 getSizeInBytes() override;
+    SKsize getSizeInBytes() override;
 
     /// <summary>
     ///
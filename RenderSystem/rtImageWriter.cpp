@@ -0,0 +1,285 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "rtImageWriter.h"
+#include <cstdio>
+#include <cstring>
+#include "Utils/skArray.h"
+#include "rtCommon.h"
+#include "zlib.h"
+
+/// <summary>
+/// Binary PPM (P6) writer.
+/// </summary>
+class rtPpmWriter final : public rtImageWriter
+{
+private:
+    FILE*            m_file;
+    SKuint32         m_width;
+    skArray<SKubyte> m_row;
+
+public:
+    rtPpmWriter() :
+        m_file(nullptr),
+        m_width(0)
+    {
+    }
+
+    ~rtPpmWriter() override
+    {
+        close();
+    }
+
+    bool open(const char* path, const SKuint32 width, const SKuint32 height) override
+    {
+        close();
+
+        m_file = fopen(path, "wb");
+        if (!m_file)
+            return false;
+
+        m_width = width;
+        m_row.resizeFast((SKuint32)width * 3);
+
+        fprintf(m_file, "P6\n%u %u\n255\n", width, height);
+        return true;
+    }
+
+    bool writeRows(const SKubyte* pixels, const SKuint32 pitch, const SKuint32 rows) override
+    {
+        if (!m_file)
+            return false;
+
+        for (SKuint32 y = 0; y < rows; ++y)
+        {
+            const rtPixelRGBA* src = (const rtPixelRGBA*)&pixels[(SKsize)y * pitch];
+
+            SKubyte* dst = m_row.ptr();
+            for (SKuint32 x = 0; x < m_width; ++x, ++src)
+            {
+                *dst++ = src->r;
+                *dst++ = src->g;
+                *dst++ = src->b;
+            }
+
+            if (fwrite(m_row.ptr(), 3, m_width, m_file) != m_width)
+                return false;
+        }
+        return true;
+    }
+
+    bool close() override
+    {
+        if (!m_file)
+            return true;
+
+        const bool result = fclose(m_file) == 0;
+        m_file            = nullptr;
+        return result;
+    }
+};
+
+/// <summary>
+/// 8-bit RGB PNG writer that deflates each row as it arrives
+/// and emits the compressed data in IDAT chunks.
+/// </summary>
+class rtPngWriter final : public rtImageWriter
+{
+private:
+    static const SKuint32 ChunkSize = 0x10000;
+
+    FILE*            m_file;
+    SKuint32         m_width;
+    z_stream         m_stream;
+    skArray<SKubyte> m_row;
+    skArray<SKubyte> m_out;
+    bool             m_ok;
+
+    static void putU32(SKubyte* dst, const SKuint32 v)
+    {
+        dst[0] = (SKubyte)(v >> 24);
+        dst[1] = (SKubyte)(v >> 16);
+        dst[2] = (SKubyte)(v >> 8);
+        dst[3] = (SKubyte)v;
+    }
+
+    void writeChunk(const char* type, const SKubyte* data, const SKuint32 len)
+    {
+        SKubyte header[8];
+        putU32(header, len);
+        memcpy(&header[4], type, 4);
+
+        uLong crc = crc32(0, &header[4], 4);
+        if (len > 0)
+            crc = crc32(crc, data, len);
+
+        SKubyte footer[4];
+        putU32(footer, (SKuint32)crc);
+
+        m_ok = m_ok && fwrite(header, 1, 8, m_file) == 8;
+        if (len > 0)
+            m_ok = m_ok && fwrite(data, 1, len, m_file) == len;
+        m_ok = m_ok && fwrite(footer, 1, 4, m_file) == 4;
+    }
+
+    void deflateRows(const int flush)
+    {
+        do
+        {
+            const int st = deflate(&m_stream, flush);
+            if (st == Z_STREAM_ERROR)
+            {
+                m_ok = false;
+                return;
+            }
+
+            if (m_stream.avail_out == 0 || (flush == Z_FINISH && m_stream.avail_out < ChunkSize))
+            {
+                writeChunk("IDAT", m_out.ptr(), ChunkSize - m_stream.avail_out);
+                m_stream.next_out  = m_out.ptr();
+                m_stream.avail_out = ChunkSize;
+            }
+
+            if (flush == Z_FINISH && st == Z_STREAM_END)
+                return;
+        } while (m_stream.avail_in > 0 || flush == Z_FINISH);
+    }
+
+public:
+    rtPngWriter() :
+        m_file(nullptr),
+        m_width(0),
+        m_stream(),
+        m_ok(false)
+    {
+    }
+
+    ~rtPngWriter() override
+    {
+        close();
+    }
+
+    bool open(const char* path, const SKuint32 width, const SKuint32 height) override
+    {
+        close();
+
+        m_file = fopen(path, "wb");
+        if (!m_file)
+            return false;
+
+        m_ok    = true;
+        m_width = width;
+        m_row.resizeFast(1 + (SKuint32)width * 3);
+        m_out.resizeFast(ChunkSize);
+
+        memset(&m_stream, 0, sizeof(z_stream));
+        if (deflateInit(&m_stream, Z_DEFAULT_COMPRESSION) != Z_OK)
+        {
+            fclose(m_file);
+            m_file = nullptr;
+            return false;
+        }
+        m_stream.next_out  = m_out.ptr();
+        m_stream.avail_out = ChunkSize;
+
+        static const SKubyte signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        m_ok = fwrite(signature, 1, 8, m_file) == 8;
+
+        // 8-bit RGB, deflate, adaptive filtering, no interlace
+        SKubyte ihdr[13];
+        putU32(&ihdr[0], width);
+        putU32(&ihdr[4], height);
+        ihdr[8]  = 8;
+        ihdr[9]  = 2;
+        ihdr[10] = 0;
+        ihdr[11] = 0;
+        ihdr[12] = 0;
+        writeChunk("IHDR", ihdr, 13);
+        return m_ok;
+    }
+
+    bool writeRows(const SKubyte* pixels, const SKuint32 pitch, const SKuint32 rows) override
+    {
+        if (!m_file)
+            return false;
+
+        for (SKuint32 y = 0; y < rows && m_ok; ++y)
+        {
+            const rtPixelRGBA* src = (const rtPixelRGBA*)&pixels[(SKsize)y * pitch];
+
+            // Every row uses the Sub filter, which stores each
+            // byte as the difference from the pixel to its left.
+            SKubyte* dst = m_row.ptr();
+            *dst++       = 1;
+
+            SKubyte r = 0, g = 0, b = 0;
+            for (SKuint32 x = 0; x < m_width; ++x, ++src)
+            {
+                *dst++ = (SKubyte)(src->r - r);
+                *dst++ = (SKubyte)(src->g - g);
+                *dst++ = (SKubyte)(src->b - b);
+
+                r = src->r;
+                g = src->g;
+                b = src->b;
+            }
+
+            m_stream.next_in  = m_row.ptr();
+            m_stream.avail_in = m_row.size();
+            deflateRows(Z_NO_FLUSH);
+        }
+        return m_ok;
+    }
+
+    bool close() override
+    {
+        if (!m_file)
+            return true;
+
+        m_stream.next_in  = nullptr;
+        m_stream.avail_in = 0;
+        deflateRows(Z_FINISH);
+        deflateEnd(&m_stream);
+
+        writeChunk("IEND", nullptr, 0);
+
+        m_ok   = fclose(m_file) == 0 && m_ok;
+        m_file = nullptr;
+        return m_ok;
+    }
+};
+
+rtImageWriter* rtImageWriter::create(const char* path)
+{
+    if (!path)
+        return nullptr;
+
+    const SKsize len = strlen(path);
+    if (len < 4)
+        return nullptr;
+
+    const char* ext = path + len - 4;
+    if (strcmp(ext, ".ppm") == 0)
+        return new rtPpmWriter();
+    if (strcmp(ext, ".png") == 0)
+        return new rtPngWriter();
+    return nullptr;
+}
@@ -0,0 +1,75 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+/*! \addtogroup FrontEnd
+ * @{
+ */
+
+#ifndef _rtImageWriter_h_
+#define _rtImageWriter_h_
+
+#include "Utils/Config/skConfig.h"
+
+/// <summary>
+/// Encodes an image to a file one group of rows at a time, so that
+/// the whole image never needs to be resident.
+/// </summary>
+class rtImageWriter
+{
+public:
+    rtImageWriter()          = default;
+    virtual ~rtImageWriter() = default;
+
+    /// <summary>
+    /// Creates the file and writes its header.
+    /// </summary>
+    /// <param name="path">The file-system path of the image.</param>
+    /// <param name="width">The width of the image in pixels.</param>
+    /// <param name="height">The height of the image in pixels.</param>
+    /// <returns>True if the file was created.</returns>
+    virtual bool open(const char* path, SKuint32 width, SKuint32 height) = 0;
+
+    /// <summary>
+    /// Encodes the next rows of the image, from the top down.
+    /// </summary>
+    /// <param name="pixels">The rows as rtPixelRGBA pixels.</param>
+    /// <param name="pitch">The step in bytes from one row to the next.</param>
+    /// <param name="rows">The number of rows to encode.</param>
+    /// <returns>False if the rows could not be written.</returns>
+    virtual bool writeRows(const SKubyte* pixels, SKuint32 pitch, SKuint32 rows) = 0;
+
+    /// <summary>
+    /// Finishes and closes the file.
+    /// </summary>
+    /// <returns>False if the file could not be completed.</returns>
+    virtual bool close() = 0;
+
+    /// <summary>
+    /// Creates a writer for the extension of path.
+    /// </summary>
+    /// <param name="path">A path that ends with .ppm or .png.</param>
+    /// <returns>A new writer, or null if the extension is not supported.</returns>
+    static rtImageWriter* create(const char* path);
+};
+
+/*! @} */
+
+#endif  //_rtImageWriter_h_
@@ -26,6 +26,8 @@
 rtLight::rtLight(rtScene* sc) :
     rtObject(sc)
 {
+    rtArenaScope scope(sc ? sc->getArena() : nullptr);
+
     m_data = rtAllocator::allocate<rtLightType>();
 
     m_data->energy = 60;
@@ -20,170 +20,75 @@
 -------------------------------------------------------------------------------
 */
 #include "rtMesh.h"
-#include "Cpu/rtCpuMath.h"
-
-/// <summary>
-/// Mesh sort
-/// </summary>
-class rtMeshPrivate
-{
-public:
-    typedef skHashTable<SKuint32, SKuint32> Table;
-
-private:
-    rtMesh::Indices  m_indices;
-    Table            m_lookup;
-    rtMesh::Vertices m_vertices;
-
-public:
-    rtMeshPrivate() = default;
-
-    ~rtMeshPrivate() = default;
-
-    void clear()
-    {
-        m_indices.clear();
-        m_lookup.clear();
-        m_vertices.clear();
-    }
-
-    void freeLookup()
-    {
-        m_lookup.clear();
-    }
-
-    rtMesh::Indices& getIndices()
-    {
-        return m_indices;
-    }
-
-    rtMesh::Vertices& getVertices()
-    {
-        return m_vertices;
-    }
-
-    static bool equals(const skVector3& a, const skVector3& b)
-    {
-        bool res = true;
-        res      = res && skEq(a.x, b.x);
-        res      = res && skEq(a.y, b.y);
-        res      = res && skEq(a.z, b.z);
-        return res;
-    }
-
-    /// <summary>
-    /// Tracks a new indexed vertex based on an old index.
-    /// </summary>
-    /// <param name="index">The old index.</param>
-    /// <param name="v">The vertex to store</param>
-    /// <returns>Returns SK_NPOS32 if the total number of indices exceeds
-    /// 65,535, otherwise it returns the new index
-    /// </returns>
-    SKuint32 addVertex(const SKuint32& index, const skVector3& v)
-    {
-        if (index >= 0xFFFF)
-            return -1;
-
-        SKuint32 pos = (SKuint32)m_lookup.find(index);
-        if (pos != SK_NPOS32)
-        {
-            pos = m_lookup.at(pos);
-            if (pos < m_vertices.size() && !equals(m_vertices[pos], v))
-                pos = -1;
-        }
-
-        if (pos == SK_NPOS32)
-        {
-            m_vertices.push_back(v);
-            m_lookup.insert(index, (SKuint32)pos);
-        }
-        return pos;
-    }
-
-    void addTriangle(SKuint32         i1,
-                     SKuint32         i2,
-                     SKuint32         i3,
-                     const skVector3& v1,
-                     const skVector3& v2,
-                     const skVector3& v3)
-    {
-        i1 = addVertex(i1, v1);
-        if (i1 != SK_NPOS32)
-            m_indices.push_back(i1);
-        i2 = addVertex(i2, v2);
-        if (i2 != SK_NPOS32)
-            m_indices.push_back(i2);
-        i3 = addVertex(i3, v3);
-        if (i3 != SK_NPOS32)
-            m_indices.push_back(i3);
-    }
-};
+#include "Math/skMatrix3.h"
 
 rtMesh::rtMesh(rtScene* sc) :
     rtBvObject(sc),
-    m_private(new rtMeshPrivate())
+    m_geometry(new rtMeshGeometry())
 {
     m_data->type = RT_AO_SHAPE_MESH;
 }
 
 rtMesh::~rtMesh()
 {
-    delete m_private;
+    m_geometry->release();
 }
 
-void rtMesh::beginAddTriangles() const
+void rtMesh::setGeometry(rtMeshGeometry* geometry)
 {
-    rtCpuScalarZero(m_data->bounds.bMin, 3);
-    rtCpuScalarZero(m_data->bounds.bMax, 3);
-
-    m_private->clear();
+    SK_ASSERT(geometry);
+    if (geometry && geometry != m_geometry)
+    {
+        geometry->addReference();
+        m_geometry->release();
+        m_geometry = geometry;
+    }
 }
 
-void rtMesh::addTriangle(const SKuint32&  i0,
-                         const SKuint32&  i1,
-                         const SKuint32&  i2,
-                         const skVector3& v0,
-                         const skVector3& v1,
-                         const skVector3& v2) const
+void rtMesh::updateBounds()
 {
-    m_private->addTriangle(i0, i1, i2, v0, v1, v2);
-
-    rtCpuCompareBounding(&m_data->bounds.bMin[0],
-                         &m_data->bounds.bMax[0],
-                         v0);
-    rtCpuCompareBounding(&m_data->bounds.bMin[0],
-                         &m_data->bounds.bMax[0],
-                         v1);
-    rtCpuCompareBounding(&m_data->bounds.bMin[0],
-                         &m_data->bounds.bMax[0],
-                         v2);
-}
+    const skBoundingBox& local = m_geometry->getLocalBoundingBox();
 
-void rtMesh::endAddTriangles() const
-{
-    m_private->freeLookup();
-}
+    skMatrix3 rotation;
+    rotation.fromQuat(m_derived.orientation);
 
-rtMesh::Indices& rtMesh::getIndices() const
-{
-    return m_private->getIndices();
-}
+    // The box is scaled and rotated about the mesh's origin, then the
+    // rotated half extents are projected back onto the world axes. A
+    // negative scale only mirrors the box, so it is taken as is.
+    const skVector3 center = rotation * (local.center() * m_derived.scale) + m_derived.location;
+    const skVector3 half   = local.extent() * skScalar(0.5);
 
-rtMesh::Vertices& rtMesh::getVertices() const
-{
-    return m_private->getVertices();
-}
+    skScalar extent[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        extent[i] = skAbs(rotation.m[i][0] * m_derived.scale.x) * half.x +
+                    skAbs(rotation.m[i][1] * m_derived.scale.y) * half.y +
+                    skAbs(rotation.m[i][2] * m_derived.scale.z) * half.z;
+    }
 
-void rtMesh::postUpdateImpl()
-{
-    m_derivedBoundingBox = getBoundingBox();
-    m_derivedBoundingBox.translate(m_derived.location);
+    m_derivedBoundingBox.bMin[0] = center.x - extent[0];
+    m_derivedBoundingBox.bMin[1] = center.y - extent[1];
+    m_derivedBoundingBox.bMin[2] = center.z - extent[2];
+    m_derivedBoundingBox.bMax[0] = center.x + extent[0];
+    m_derivedBoundingBox.bMax[1] = center.y + extent[1];
+    m_derivedBoundingBox.bMax[2] = center.z + extent[2];
 
     m_derivedBoundingSphere = skBoundingSphere{
         m_derivedBoundingBox.center(),
         m_derivedBoundingBox.halfLength() * skScalar(0.5),
     };
 
+    m_data->bounds.bMin[0] = m_derivedBoundingBox.bMin[0];
+    m_data->bounds.bMin[1] = m_derivedBoundingBox.bMin[1];
+    m_data->bounds.bMin[2] = m_derivedBoundingBox.bMin[2];
+
+    m_data->bounds.bMax[0] = m_derivedBoundingBox.bMax[0];
+    m_data->bounds.bMax[1] = m_derivedBoundingBox.bMax[1];
+    m_data->bounds.bMax[2] = m_derivedBoundingBox.bMax[2];
+}
+
+void rtMesh::postUpdateImpl()
+{
     getData().location = {
         m_derived.location.x,
         m_derived.location.y,
@@ -195,12 +100,11 @@ void rtMesh::postUpdateImpl()
         m_derived.orientation.z,
         m_derived.orientation.w,
     };
+    getData().scale = {
+        m_derived.scale.x,
+        m_derived.scale.y,
+        m_derived.scale.z,
+    };
 
-    m_data->bounds.bMin[0] = m_derivedBoundingBox.bMin[0];
-    m_data->bounds.bMin[1] = m_derivedBoundingBox.bMin[1];
-    m_data->bounds.bMin[2] = m_derivedBoundingBox.bMin[2];
-
-    m_data->bounds.bMax[0] = m_derivedBoundingBox.bMax[0];
-    m_data->bounds.bMax[1] = m_derivedBoundingBox.bMax[1];
-    m_data->bounds.bMax[2] = m_derivedBoundingBox.bMax[2];
+    updateBounds();
 }
@@ -28,25 +28,33 @@
 #include "Math/skBoundingBox.h"
 #include "Math/skBoundingSphere.h"
 #include "rtBvObject.h"
-
-class rtMeshPrivate;
+#include "rtMeshGeometry.h"
 
 /// <summary>
-///
+/// An instance of an indexed triangle mesh.
 /// </summary>
+/// <remarks>
+/// The triangles and their hierarchy are held by an rtMeshGeometry, which
+/// any number of meshes may share through setGeometry. Each mesh adds its
+/// own transform and material. The triangle methods below operate on the
+/// geometry, so they change every mesh that shares it. The vertices are in
+/// mesh space, and rays are moved into it when the mesh is traced.
+/// </remarks>
 class rtMesh final : public rtBvObject
 {
 public:
-    typedef skArray<SKuint32>  Indices;
-    typedef skArray<skVector3> Vertices;
+    typedef rtMeshGeometry::Indices  Indices;
+    typedef rtMeshGeometry::Vertices Vertices;
 
 private:
-    friend rtMeshPrivate;
+    friend class rtScene;
 
-    rtMeshPrivate*   m_private;
+    rtMeshGeometry*  m_geometry;
     skBoundingBox    m_derivedBoundingBox;
     skBoundingSphere m_derivedBoundingSphere;
 
+    void updateBounds();
+
     void postUpdateImpl() override;
 
 public:
@@ -58,48 +66,122 @@ public:
     ~rtMesh() override;
 
     /// <summary>
-    ///
+    /// Returns the geometry that this mesh is an instance of.
     /// </summary>
-    void beginAddTriangles() const;
+    rtMeshGeometry* getGeometry() const;
 
     /// <summary>
-    ///
+    /// Makes this mesh an instance of another geometry, usually one
+    /// that is already used by a different mesh. The reference to the
+    /// previous geometry is released.
+    /// </summary>
+    /// <param name="geometry">The geometry to share. It must not be null.</param>
+    void setGeometry(rtMeshGeometry* geometry);
+
+    /// <summary>
+    /// See rtMeshGeometry::beginAddTriangles.
+    /// </summary>
+    void beginAddTriangles();
+
+    /// <summary>
+    /// See rtMeshGeometry::addTriangle.
     /// </summary>
-    /// <param name="i0"></param>
-    /// <param name="i1"></param>
-    /// <param name="i2"></param>
-    /// <param name="v0"></param>
-    /// <param name="v1"></param>
-    /// <param name="v2"></param>
     void addTriangle(const SKuint32&  i0,
                      const SKuint32&  i1,
                      const SKuint32&  i2,
                      const skVector3& v0,
                      const skVector3& v1,
-                     const skVector3& v2) const;
+                     const skVector3& v2);
 
     /// <summary>
-    ///
+    /// See rtMeshGeometry::addIndexedTriangles.
     /// </summary>
-    void endAddTriangles() const;
+    bool addIndexedTriangles(const skVector3* vertices,
+                             SKuint32         vertexCount,
+                             const SKuint32*  indices,
+                             SKuint32         indexCount);
 
     /// <summary>
-    ///
+    /// See rtMeshGeometry::addTriangleSoup.
+    /// </summary>
+    void addTriangleSoup(const skVector3* vertices,
+                         SKuint32         vertexCount,
+                         skScalar         tolerance = SK_EPSILON);
+
+    /// <summary>
+    /// See rtMeshGeometry::endAddTriangles.
+    /// </summary>
+    void endAddTriangles();
+
+    /// <summary>
+    /// See rtMeshGeometry::setView.
+    /// </summary>
+    bool setView(const rtMeshView& view);
+
+    /// <summary>
+    /// See rtMeshGeometry::setView.
+    /// </summary>
+    bool setView(const rtMeshView& view, const rtMeshBvh::View& hierarchy);
+
+    /// <summary>
+    /// Returns the triangles that the geometry is made of.
+    /// </summary>
+    const rtMeshView& getView() const;
+
+    /// <summary>
+    /// Returns true if the vertices are referenced through setView.
+    /// </summary>
+    bool isView() const;
+
+    /// <summary>
+    /// Returns the number of vertices in the view.
+    /// </summary>
+    SKuint32 getVertexCount() const;
+
+    /// <summary>
+    /// Returns the number of indices in the view.
+    /// </summary>
+    SKuint32 getIndexCount() const;
+
+    /// <summary>
+    /// Reads a vertex from the view.
+    /// </summary>
+    skVector3 getVertex(SKuint32 i) const;
+
+    /// <summary>
+    /// Reads an index from the view.
+    /// </summary>
+    SKuint32 getIndex(SKuint32 i) const;
+
+    /// <summary>
+    /// Returns the geometry's own index array.
     /// </summary>
-    /// <returns></returns>
     Indices& getIndices() const;
 
     /// <summary>
-    ///
+    /// Returns the geometry's own vertex array.
     /// </summary>
-    /// <returns></returns>
     Vertices& getVertices() const;
 
     /// <summary>
-    ///
+    /// Returns the geometry's triangle hierarchy.
     /// </summary>
-    /// <returns></returns>
-    skBoundingBox getBoundingBox() const override;
+    const rtMeshBvh& getBvh() const;
+
+    /// <summary>
+    /// Sets the way the geometry's hierarchy is built.
+    /// </summary>
+    void setBuildMode(rtMeshBvh::BuildMode mode);
+
+    /// <summary>
+    /// Returns the way the geometry's hierarchy is built.
+    /// </summary>
+    rtMeshBvh::BuildMode getBuildMode() const;
+
+    /// <summary>
+    /// Returns the bounds of the vertices, in mesh space.
+    /// </summary>
+    const skBoundingBox& getLocalBoundingBox() const;
 
     /// <summary>
     /// Returns a sphere that aligns with smallest volume
@@ -122,9 +204,114 @@ public:
 
 /*! @} */
 
-SK_INLINE skBoundingBox rtMesh::getBoundingBox() const
+SK_INLINE rtMeshGeometry* rtMesh::getGeometry() const
+{
+    return m_geometry;
+}
+
+SK_INLINE void rtMesh::beginAddTriangles()
+{
+    m_geometry->beginAddTriangles();
+}
+
+SK_INLINE void rtMesh::addTriangle(const SKuint32&  i0,
+                                   const SKuint32&  i1,
+                                   const SKuint32&  i2,
+                                   const skVector3& v0,
+                                   const skVector3& v1,
+                                   const skVector3& v2)
+{
+    m_geometry->addTriangle(i0, i1, i2, v0, v1, v2);
+}
+
+SK_INLINE bool rtMesh::addIndexedTriangles(const skVector3* vertices,
+                                           const SKuint32   vertexCount,
+                                           const SKuint32*  indices,
+                                           const SKuint32   indexCount)
+{
+    return m_geometry->addIndexedTriangles(vertices, vertexCount, indices, indexCount);
+}
+
+SK_INLINE void rtMesh::addTriangleSoup(const skVector3* vertices,
+                                       const SKuint32   vertexCount,
+                                       const skScalar   tolerance)
+{
+    m_geometry->addTriangleSoup(vertices, vertexCount, tolerance);
+}
+
+SK_INLINE void rtMesh::endAddTriangles()
+{
+    m_geometry->endAddTriangles();
+}
+
+SK_INLINE bool rtMesh::setView(const rtMeshView& view)
+{
+    return m_geometry->setView(view);
+}
+
+SK_INLINE bool rtMesh::setView(const rtMeshView& view, const rtMeshBvh::View& hierarchy)
+{
+    return m_geometry->setView(view, hierarchy);
+}
+
+SK_INLINE const rtMeshView& rtMesh::getView() const
+{
+    return m_geometry->getView();
+}
+
+SK_INLINE bool rtMesh::isView() const
+{
+    return m_geometry->isView();
+}
+
+SK_INLINE SKuint32 rtMesh::getVertexCount() const
+{
+    return m_geometry->getVertexCount();
+}
+
+SK_INLINE SKuint32 rtMesh::getIndexCount() const
+{
+    return m_geometry->getIndexCount();
+}
+
+SK_INLINE skVector3 rtMesh::getVertex(const SKuint32 i) const
+{
+    return m_geometry->getVertex(i);
+}
+
+SK_INLINE SKuint32 rtMesh::getIndex(const SKuint32 i) const
+{
+    return m_geometry->getIndex(i);
+}
+
+SK_INLINE rtMesh::Indices& rtMesh::getIndices() const
+{
+    return m_geometry->getIndices();
+}
+
+SK_INLINE rtMesh::Vertices& rtMesh::getVertices() const
+{
+    return m_geometry->getVertices();
+}
+
+SK_INLINE const rtMeshBvh& rtMesh::getBvh() const
+{
+    return m_geometry->getBvh();
+}
+
+SK_INLINE void rtMesh::setBuildMode(const rtMeshBvh::BuildMode mode)
+{
+    m_geometry->setBuildMode(mode);
+}
+
+SK_INLINE rtMeshBvh::BuildMode rtMesh::getBuildMode() const
+{
+    return m_geometry->getBuildMode();
+}
+
+SK_INLINE const skBoundingBox& rtMesh::getLocalBoundingBox() const
 {
-    return {m_data->bounds.bMin, m_data->bounds.bMax};
+    return m_geometry->getLocalBoundingBox();
 }
 
 SK_INLINE skBoundingSphere rtMesh::getDerivedBoundingSphere() const
@@ -0,0 +1,1052 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "rtMeshBvh.h"
+#include <algorithm>
+#include "rtTaskPool.h"
+#include "Math/skMath.h"
+#include "Utils/skMinMax.h"
+
+namespace
+{
+    /// <summary>
+    /// The bounds and centroid of a single triangle or box.
+    /// </summary>
+    struct rtBvhPrimitive
+    {
+        skScalar bMin[3];
+        skScalar bMax[3];
+        skScalar centroid[3];
+    };
+
+    /// <summary>
+    /// An axis aligned box that starts out empty.
+    /// </summary>
+    struct rtBvhBounds
+    {
+        skScalar bMin[3];
+        skScalar bMax[3];
+
+        rtBvhBounds()
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                bMin[i] = SK_INFINITY;
+                bMax[i] = -SK_INFINITY;
+            }
+        }
+
+        void grow(const skScalar* mi, const skScalar* ma)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                bMin[i] = skMin(bMin[i], mi[i]);
+                bMax[i] = skMax(bMax[i], ma[i]);
+            }
+        }
+
+        void grow(const skScalar* pt)
+        {
+            grow(pt, pt);
+        }
+
+        skScalar area() const
+        {
+            const skScalar x = bMax[0] - bMin[0];
+            const skScalar y = bMax[1] - bMin[1];
+            const skScalar z = bMax[2] - bMin[2];
+            if (x < 0 || y < 0 || z < 0)
+                return 0;
+            return x * y + y * z + z * x;
+        }
+    };
+
+    struct rtBvhBin
+    {
+        rtBvhBounds bounds;
+        SKuint32    count = 0;
+    };
+
+    /// <summary>
+    /// A range of the triangle list that still has to be placed in a node.
+    /// </summary>
+    struct rtBvhRange
+    {
+        SKuint32 node;
+        SKuint32 first;
+        SKuint32 count;
+        SKuint32 depth;
+    };
+
+    SK_INLINE skScalar rtBvhArea(const rtMeshBvh::Node& node)
+    {
+        const skScalar x = (skScalar)node.bMax[0] - (skScalar)node.bMin[0];
+        const skScalar y = (skScalar)node.bMax[1] - (skScalar)node.bMin[1];
+        const skScalar z = (skScalar)node.bMax[2] - (skScalar)node.bMin[2];
+        if (x < 0 || y < 0 || z < 0)
+            return 0;
+        return x * y + y * z + z * x;
+    }
+
+    /// <summary>
+    /// Returns the number of intersection tests that a ray which
+    /// reaches the node pays for, on top of the node's own box test.
+    /// </summary>
+    SK_INLINE SKuint32 rtBvhWeight(const rtMeshBvh::Node& node)
+    {
+        return node.count == 0 ? 1 : node.count;
+    }
+
+    /// <summary>
+    /// Measures the boxes that a leaf holds.
+    /// </summary>
+    rtBvhBounds rtBvhLeafBounds(const rtMeshBvh::Node&      node,
+                                const rtMeshBvh::Triangles& order,
+                                const rtPackedBounds*       bounds)
+    {
+        rtBvhBounds result;
+        for (SKuint32 i = node.first; i < node.first + node.count; ++i)
+        {
+            const rtPackedBounds& box = bounds[order[i]];
+            for (int a = 0; a < 3; ++a)
+            {
+                result.bMin[a] = skMin<skScalar>(result.bMin[a], box.bMin[a]);
+                result.bMax[a] = skMax<skScalar>(result.bMax[a], box.bMax[a]);
+            }
+        }
+        return result;
+    }
+
+    /// <summary>
+    /// Measures the two children of a branch.
+    /// </summary>
+    rtBvhBounds rtBvhBranchBounds(const rtMeshBvh::Node& node, const rtMeshBvh::Nodes& nodes)
+    {
+        rtBvhBounds result;
+        for (SKuint32 i = node.first; i < node.first + 2; ++i)
+        {
+            const rtMeshBvh::Node& child = nodes[i];
+            for (int a = 0; a < 3; ++a)
+            {
+                result.bMin[a] = skMin<skScalar>(result.bMin[a], child.bMin[a]);
+                result.bMax[a] = skMax<skScalar>(result.bMax[a], child.bMax[a]);
+            }
+        }
+        return result;
+    }
+
+    SK_INLINE const rtScalar* rtBvhVertex(const rtMeshView& view, const SKuint32 index)
+    {
+        return (const rtScalar*)(view.vertices + (SKsize)index * view.vertexStride);
+    }
+
+    SK_INLINE SKuint32 rtBvhIndex(const rtMeshView& view, const SKuint32 index)
+    {
+        return *(const SKuint32*)(view.indices + (SKsize)index * view.indexStride);
+    }
+
+    SK_INLINE SKuint32 rtBvhBinOf(const rtBvhPrimitive& prim,
+                                  const int             axis,
+                                  const skScalar        lo,
+                                  const skScalar        scale)
+    {
+        const SKint32 bin = (SKint32)((prim.centroid[axis] - lo) * scale);
+        return (SKuint32)skClamp<SKint32>(bin, 0, (SKint32)rtMeshBvh::BinCount - 1);
+    }
+
+    typedef skArray<rtBvhRange> rtBvhRanges;
+
+    /// <summary>
+    /// Builds the nodes below root with binned surface area splits. The
+    /// root node must already exist, and root's range of the order must
+    /// hold the primitive numbers that it covers. When deferred is set,
+    /// ranges of at most cutoff primitives are added to it in place of
+    /// being split, to be built later as separate subtrees.
+    /// </summary>
+    void rtBvhBuild(rtMeshBvh::Nodes&              nodes,
+                    rtMeshBvh::Triangles&          order,
+                    const skArray<rtBvhPrimitive>& prims,
+                    const rtBvhRange&              root,
+                    rtBvhRanges*                   deferred,
+                    const SKuint32                 cutoff)
+    {
+        // Most leaves are close to full, so this is usually enough.
+        nodes.reserve(nodes.size() + 2 * ((root.count + rtMeshBvh::LeafSize - 1) / rtMeshBvh::LeafSize));
+
+        rtBvhRange stack[rtMeshBvh::MaxDepth + 1];
+        SKuint32   top = 0;
+        stack[top++]   = root;
+
+        while (top > 0)
+        {
+            const rtBvhRange range = stack[--top];
+
+            rtBvhBounds bounds, centroids;
+            for (SKuint32 i = range.first; i < range.first + range.count; ++i)
+            {
+                const rtBvhPrimitive& prim = prims[order[i]];
+                bounds.grow(prim.bMin, prim.bMax);
+                centroids.grow(prim.centroid);
+            }
+
+            rtMeshBvh::Node& node = nodes[range.node];
+            for (int a = 0; a < 3; ++a)
+            {
+                node.bMin[a] = (rtScalar)bounds.bMin[a];
+                node.bMax[a] = (rtScalar)bounds.bMax[a];
+            }
+            node.first = range.first;
+            node.count = range.count;
+
+            if (range.count <= rtMeshBvh::LeafSize || range.depth >= rtMeshBvh::MaxDepth - 1)
+                continue;
+
+            if (deferred && range.count <= cutoff)
+            {
+                deferred->push_back(range);
+                continue;
+            }
+
+            // Find the cheapest split over the bins of every axis.
+            int      bestAxis = -1;
+            SKuint32 bestBin  = 0;
+            skScalar bestCost = SK_INFINITY;
+
+            for (int a = 0; a < 3; ++a)
+            {
+                const skScalar extent = centroids.bMax[a] - centroids.bMin[a];
+                if (extent <= 0)
+                    continue;
+
+                const skScalar scale = skScalar(rtMeshBvh::BinCount) / extent;
+
+                rtBvhBin bins[rtMeshBvh::BinCount];
+                for (SKuint32 i = range.first; i < range.first + range.count; ++i)
+                {
+                    const rtBvhPrimitive& prim = prims[order[i]];
+                    rtBvhBin&             bin  = bins[rtBvhBinOf(prim, a, centroids.bMin[a], scale)];
+                    bin.bounds.grow(prim.bMin, prim.bMax);
+                    bin.count++;
+                }
+
+                // Sweep from the right to find the cost of the right
+                // side of each split, then from the left to finish it.
+                skScalar    rightArea[rtMeshBvh::BinCount];
+                SKuint32    rightCount[rtMeshBvh::BinCount];
+                rtBvhBounds right;
+                SKuint32    n = 0;
+                for (SKuint32 b = rtMeshBvh::BinCount - 1; b > 0; --b)
+                {
+                    right.grow(bins[b].bounds.bMin, bins[b].bounds.bMax);
+                    n += bins[b].count;
+                    rightArea[b]  = right.area();
+                    rightCount[b] = n;
+                }
+
+                rtBvhBounds left;
+                n = 0;
+                for (SKuint32 b = 1; b < rtMeshBvh::BinCount; ++b)
+                {
+                    left.grow(bins[b - 1].bounds.bMin, bins[b - 1].bounds.bMax);
+                    n += bins[b - 1].count;
+                    if (n == 0 || rightCount[b] == 0)
+                        continue;
+
+                    const skScalar cost = left.area() * (skScalar)n + rightArea[b] * (skScalar)rightCount[b];
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestAxis = a;
+                        bestBin  = b;
+                    }
+                }
+            }
+
+            SKuint32 mid;
+            if (bestAxis >= 0)
+            {
+                // A leaf costs one intersection per triangle. A split costs
+                // about one more box test, plus the triangles of each side
+                // weighted by how likely a ray that hits this node hits it.
+                const skScalar area = bounds.area();
+                if (area > 0 && range.count <= rtMeshBvh::LeafSize * 4 &&
+                    1 + bestCost / area >= (skScalar)range.count)
+                    continue;
+
+                const skScalar lo    = centroids.bMin[bestAxis];
+                const skScalar scale = skScalar(rtMeshBvh::BinCount) / (centroids.bMax[bestAxis] - lo);
+
+                SKuint32 i = range.first;
+                SKuint32 j = range.first + range.count;
+                while (i < j)
+                {
+                    if (rtBvhBinOf(prims[order[i]], bestAxis, lo, scale) < bestBin)
+                        ++i;
+                    else
+                        skSwap(order[i], order[--j]);
+                }
+                mid = i;
+            }
+            else
+            {
+                // Every centroid is in the same place,
+                // so the range is simply cut in half.
+                mid = range.first + range.count / 2;
+            }
+
+            const SKuint32 children = nodes.size();
+            nodes.push_back({});
+            nodes.push_back({});
+
+            // node may have moved when the children were added.
+            nodes[range.node].first = children;
+            nodes[range.node].count = 0;
+
+            stack[top++] = {children + 1, mid, range.first + range.count - mid, range.depth + 1};
+            stack[top++] = {children, range.first, mid - range.first, range.depth + 1};
+        }
+    }
+
+    /// <summary>
+    /// Builds the subtrees that the top levels of a build deferred,
+    /// each into nodes of its own, so that they can run in parallel.
+    /// </summary>
+    class rtBvhSubtreeTask final : public rtTask
+    {
+    private:
+        rtMeshBvh::Triangles&          m_order;
+        const skArray<rtBvhPrimitive>& m_prims;
+        const rtBvhRanges&             m_ranges;
+        skArray<rtMeshBvh::Nodes*>&    m_results;
+
+    public:
+        rtBvhSubtreeTask(rtMeshBvh::Triangles&          order,
+                         const skArray<rtBvhPrimitive>& prims,
+                         const rtBvhRanges&             ranges,
+                         skArray<rtMeshBvh::Nodes*>&    results) :
+            m_order(order),
+            m_prims(prims),
+            m_ranges(ranges),
+            m_results(results)
+        {
+        }
+
+        void execute(const SKuint32 index) override
+        {
+            // Each range is a separate part of the order,
+            // so the subtrees can partition it at the same time.
+            const rtBvhRange& range = m_ranges[index];
+
+            rtMeshBvh::Nodes* nodes = m_results[index];
+            nodes->push_back({});
+            rtBvhBuild(*nodes, m_order, m_prims, {0, range.first, range.count, range.depth}, nullptr, 0);
+        }
+    };
+
+    /// <summary>
+    /// Builds the nodes with binned surface area splits. Large inputs are
+    /// split serially until the ranges left are small enough to share out
+    /// over worker threads, then each of those is built as a subtree.
+    /// The order must hold the primitive numbers 0 to count - 1.
+    /// </summary>
+    void rtBvhBuildSah(rtMeshBvh::Nodes&              nodes,
+                       rtMeshBvh::Triangles&          order,
+                       const skArray<rtBvhPrimitive>& prims,
+                       const SKuint32                 threads)
+    {
+        const SKuint32 count = prims.size();
+        nodes.push_back({});
+
+        if (count < 2 * rtMeshBvh::SubtreeSize || threads == 1)
+        {
+            rtBvhBuild(nodes, order, prims, {0, 0, count, 0}, nullptr, 0);
+            return;
+        }
+
+        // Enough subtrees that the threads stay busy when they
+        // come out uneven, but not so many that they are tiny.
+        const SKuint32 cutoff = skMax<SKuint32>(rtMeshBvh::SubtreeSize, count / 64);
+
+        rtBvhRanges deferred;
+        rtBvhBuild(nodes, order, prims, {0, 0, count, 0}, &deferred, cutoff);
+
+        // The largest subtrees are handed out first.
+        std::sort(deferred.begin(), deferred.end(), [](const rtBvhRange& a, const rtBvhRange& b) {
+            return a.count != b.count ? a.count > b.count : a.first < b.first;
+        });
+
+        skArray<rtMeshBvh::Nodes*> results;
+        results.reserve(deferred.size());
+        for (SKuint32 i = 0; i < deferred.size(); ++i)
+            results.push_back(new rtMeshBvh::Nodes());
+
+        rtBvhSubtreeTask task(order, prims, deferred, results);
+        rtTaskPool::execute(&task, deferred.size(), threads);
+
+        // Each subtree's root replaces the node that deferred it, and the
+        // rest of its nodes are appended. Children stay next to each other,
+        // so only the index of a branch's first child has to move.
+        for (SKuint32 i = 0; i < deferred.size(); ++i)
+        {
+            const rtMeshBvh::Nodes& subtree = *results[i];
+            const SKuint32          base    = nodes.size() - 1;
+
+            for (SKuint32 j = 0; j < subtree.size(); ++j)
+            {
+                rtMeshBvh::Node node = subtree[j];
+                if (node.count == 0)
+                    node.first += base;
+
+                if (j == 0)
+                    nodes[deferred[i].node] = node;
+                else
+                    nodes.push_back(node);
+            }
+            delete results[i];
+        }
+    }
+
+    /// <summary>
+    /// Spreads the low ten bits of a value out to every third bit.
+    /// </summary>
+    SK_INLINE SKuint32 rtBvhExpandBits(SKuint32 v)
+    {
+        v = (v * 0x00010001u) & 0xFF0000FFu;
+        v = (v * 0x00000101u) & 0x0F00F00Fu;
+        v = (v * 0x00000011u) & 0xC30C30C3u;
+        v = (v * 0x00000005u) & 0x49249249u;
+        return v;
+    }
+
+    SK_INLINE SKuint32 rtBvhHighestBit(SKuint32 v)
+    {
+        SKuint32 bit = 0;
+        for (SKuint32 shift = 16; shift > 0; shift >>= 1)
+        {
+            if (v >> shift)
+            {
+                v >>= shift;
+                bit += shift;
+            }
+        }
+        return bit;
+    }
+
+    /// <summary>
+    /// Builds the nodes from the Morton codes of the centroids. The
+    /// primitives are sorted along the curve, then each range is split
+    /// where the highest bit that differs inside of it changes, so the
+    /// structure comes from the sort alone and the bounds are filled in
+    /// afterwards. The order must hold the primitive numbers 0 to count - 1.
+    /// </summary>
+    void rtBvhBuildMorton(rtMeshBvh::Nodes&              nodes,
+                          rtMeshBvh::Triangles&          order,
+                          const skArray<rtBvhPrimitive>& prims)
+    {
+        const SKuint32 count = prims.size();
+
+        rtBvhBounds centroids;
+        for (SKuint32 i = 0; i < count; ++i)
+            centroids.grow(prims[i].centroid);
+
+        skScalar scale[3];
+        for (int a = 0; a < 3; ++a)
+        {
+            const skScalar extent = centroids.bMax[a] - centroids.bMin[a];
+            scale[a]              = extent > 0 ? skScalar(1023) / extent : 0;
+        }
+
+        skArray<SKuint32> keys, sortedKeys, sortedOrder;
+        keys.resizeFast(count);
+        sortedKeys.resizeFast(count);
+        sortedOrder.resizeFast(count);
+
+        for (SKuint32 i = 0; i < count; ++i)
+        {
+            SKuint32 code = 0;
+            for (int a = 0; a < 3; ++a)
+            {
+                const SKuint32 q = (SKuint32)((prims[i].centroid[a] - centroids.bMin[a]) * scale[a]);
+                code |= rtBvhExpandBits(skMin<SKuint32>(q, 1023)) << (2 - a);
+            }
+            keys[i] = code;
+        }
+
+        // A least significant digit radix sort over the 30 bits
+        // of the codes, ten at a time. It is stable, so primitives
+        // with equal codes keep their original order.
+        SKuint32 histogram[1024];
+        for (SKuint32 shift = 0; shift < 30; shift += 10)
+        {
+            memset(histogram, 0, sizeof histogram);
+            for (SKuint32 i = 0; i < count; ++i)
+                histogram[(keys[i] >> shift) & 1023]++;
+
+            SKuint32 sum = 0;
+            for (SKuint32& bucket : histogram)
+            {
+                const SKuint32 n = bucket;
+                bucket           = sum;
+                sum += n;
+            }
+
+            for (SKuint32 i = 0; i < count; ++i)
+            {
+                const SKuint32 slot = histogram[(keys[i] >> shift) & 1023]++;
+                sortedKeys[slot]    = keys[i];
+                sortedOrder[slot]   = order[i];
+            }
+
+            for (SKuint32 i = 0; i < count; ++i)
+            {
+                keys[i]  = sortedKeys[i];
+                order[i] = sortedOrder[i];
+            }
+        }
+
+        nodes.reserve(2 * ((count + rtMeshBvh::LeafSize - 1) / rtMeshBvh::LeafSize));
+        nodes.push_back({});
+
+        rtBvhRange stack[rtMeshBvh::MaxDepth + 1];
+        SKuint32   top = 0;
+        stack[top++]   = {0, 0, count, 0};
+
+        while (top > 0)
+        {
+            const rtBvhRange range = stack[--top];
+
+            nodes[range.node].first = range.first;
+            nodes[range.node].count = range.count;
+
+            if (range.count <= rtMeshBvh::LeafSize || range.depth >= rtMeshBvh::MaxDepth - 1)
+                continue;
+
+            const SKuint32 last = range.first + range.count - 1;
+
+            SKuint32 mid;
+            if (keys[range.first] == keys[last])
+                mid = range.first + range.count / 2;
+            else
+            {
+                // Everything above the highest differing bit is shared by the
+                // range, so the first key with that bit set starts the right side.
+                const SKuint32 bit = rtBvhHighestBit(keys[range.first] ^ keys[last]);
+
+                SKuint32 lo = range.first, hi = last;
+                while (lo < hi)
+                {
+                    const SKuint32 m = lo + (hi - lo) / 2;
+                    if ((keys[m] >> bit) & 1)
+                        hi = m;
+                    else
+                        lo = m + 1;
+                }
+                mid = lo;
+            }
+
+            const SKuint32 children = nodes.size();
+            nodes.push_back({});
+            nodes.push_back({});
+
+            nodes[range.node].first = children;
+            nodes[range.node].count = 0;
+
+            stack[top++] = {children + 1, mid, range.first + range.count - mid, range.depth + 1};
+            stack[top++] = {children, range.first, mid - range.first, range.depth + 1};
+        }
+
+        // Children are stored after their parent, so walking
+        // backwards fills in the bounds from the leaves up.
+        for (SKuint32 i = nodes.size(); i > 0; --i)
+        {
+            rtMeshBvh::Node& node = nodes[i - 1];
+
+            rtBvhBounds bounds;
+            if (node.count == 0)
+            {
+                for (SKuint32 c = node.first; c < node.first + 2; ++c)
+                {
+                    const rtMeshBvh::Node& child = nodes[c];
+                    for (int a = 0; a < 3; ++a)
+                    {
+                        bounds.bMin[a] = skMin<skScalar>(bounds.bMin[a], child.bMin[a]);
+                        bounds.bMax[a] = skMax<skScalar>(bounds.bMax[a], child.bMax[a]);
+                    }
+                }
+            }
+            else
+            {
+                for (SKuint32 k = node.first; k < node.first + node.count; ++k)
+                    bounds.grow(prims[order[k]].bMin, prims[order[k]].bMax);
+            }
+
+            for (int a = 0; a < 3; ++a)
+            {
+                node.bMin[a] = (rtScalar)bounds.bMin[a];
+                node.bMax[a] = (rtScalar)bounds.bMax[a];
+            }
+        }
+    }
+
+    void rtBvhBuildNodes(rtMeshBvh::Nodes&              nodes,
+                         rtMeshBvh::Triangles&          order,
+                         const skArray<rtBvhPrimitive>& prims,
+                         const rtMeshBvh::BuildMode     mode,
+                         const SKuint32                 threads)
+    {
+        if (mode == rtMeshBvh::BM_MORTON)
+            rtBvhBuildMorton(nodes, order, prims);
+        else
+            rtBvhBuildSah(nodes, order, prims, threads);
+    }
+
+    /// <summary>
+    /// Traverses the nodes depth first. AnyHit returns with the
+    /// first triangle that is found instead of the nearest one.
+    /// </summary>
+    template <bool AnyHit>
+    bool rtBvhIntersect(const rtMeshBvh::View& hierarchy,
+                        const rtMeshView&      view,
+                        const skVector3&       origin,
+                        const skVector3&       direction,
+                        const skScalar         tMin,
+                        skScalar&              tMax,
+                        SKuint32&              triangle)
+    {
+        if (hierarchy.nodeCount == 0)
+            return false;
+
+        const rtMeshBvh::Node* nodes     = hierarchy.nodes;
+        const SKuint32*        triangles = hierarchy.triangles;
+
+        const skScalar o[3]   = {origin.x, origin.y, origin.z};
+        const skScalar inv[3] = {
+            skScalar(1) / direction.x,
+            skScalar(1) / direction.y,
+            skScalar(1) / direction.z,
+        };
+
+        bool hit = false;
+
+        SKuint32 stack[rtMeshBvh::MaxDepth + 1];
+        SKuint32 top = 0;
+        stack[top++] = 0;
+
+        while (top > 0)
+        {
+            const rtMeshBvh::Node& node = nodes[stack[--top]];
+
+            skScalar t0 = tMin, t1 = tMax;
+            for (int a = 0; a < 3; ++a)
+            {
+                skScalar n = ((skScalar)node.bMin[a] - o[a]) * inv[a];
+                skScalar f = ((skScalar)node.bMax[a] - o[a]) * inv[a];
+                if (n > f)
+                    skSwap(n, f);
+                t0 = n > t0 ? n : t0;
+                t1 = f < t1 ? f : t1;
+            }
+            if (t0 > t1)
+                continue;
+
+            if (node.count == 0)
+            {
+                stack[top++] = node.first + 1;
+                stack[top++] = node.first;
+                continue;
+            }
+
+            for (SKuint32 i = node.first; i < node.first + node.count; ++i)
+            {
+                const SKuint32  tri = triangles[i];
+                const rtScalar* p0  = rtBvhVertex(view, rtBvhIndex(view, tri * 3));
+                const rtScalar* p1  = rtBvhVertex(view, rtBvhIndex(view, tri * 3 + 1));
+                const rtScalar* p2  = rtBvhVertex(view, rtBvhIndex(view, tri * 3 + 2));
+
+                const skVector3 v0(p0[0], p0[1], p0[2]);
+                const skVector3 e1 = skVector3(p1[0], p1[1], p1[2]) - v0;
+                const skVector3 e2 = skVector3(p2[0], p2[1], p2[2]) - v0;
+
+                const skVector3 p   = direction.cross(e2);
+                const skScalar  det = e1.dot(p);
+                if (skAbs(det) < SK_EPSILON * SK_EPSILON)
+                    continue;
+
+                const skScalar  id = skScalar(1) / det;
+                const skVector3 s  = origin - v0;
+                const skScalar  u  = s.dot(p) * id;
+                if (u < 0 || u > 1)
+                    continue;
+
+                const skVector3 q = s.cross(e1);
+                const skScalar  v = direction.dot(q) * id;
+                if (v < 0 || u + v > 1)
+                    continue;
+
+                const skScalar t = e2.dot(q) * id;
+                if (t >= tMin && t < tMax)
+                {
+                    tMax     = t;
+                    triangle = tri;
+                    hit      = true;
+
+                    if (AnyHit)
+                        return true;
+                }
+            }
+        }
+        return hit;
+    }
+}  // namespace
+
+rtMeshBvh::rtMeshBvh() :
+    m_view({}),
+    m_cost(0),
+    m_buildCost(0)
+{
+}
+
+rtMeshBvh::rtMeshBvh(const rtMeshBvh& other) :
+    m_view({}),
+    m_cost(0),
+    m_buildCost(0)
+{
+    *this = other;
+}
+
+rtMeshBvh& rtMeshBvh::operator=(const rtMeshBvh& other)
+{
+    if (this != &other)
+    {
+        m_nodes     = other.m_nodes;
+        m_triangles = other.m_triangles;
+        m_parents   = other.m_parents;
+        m_leaves    = other.m_leaves;
+        m_cost      = other.m_cost;
+        m_buildCost = other.m_buildCost;
+
+        // A copy of a hierarchy that references its records references
+        // the same ones, otherwise it has to point at its own arrays.
+        if (other.isView())
+            m_view = other.m_view;
+        else
+            viewOwned();
+    }
+    return *this;
+}
+
+void rtMeshBvh::clear()
+{
+    m_nodes.clear();
+    m_triangles.clear();
+    m_parents.clear();
+    m_leaves.clear();
+    m_view      = {};
+    m_cost      = 0;
+    m_buildCost = 0;
+}
+
+void rtMeshBvh::viewOwned()
+{
+    m_view = {m_nodes.ptr(), m_nodes.size(), m_triangles.ptr(), m_triangles.size()};
+}
+
+bool rtMeshBvh::validate(const View& view, const SKuint32 count) const
+{
+    if (view.nodeCount == 0 || count == 0)
+        return view.nodeCount == 0 && count == 0;
+
+    if (!view.nodes || !view.triangles || view.triangleCount != count)
+        return false;
+
+    for (SKuint32 i = 0; i < view.triangleCount; ++i)
+    {
+        if (view.triangles[i] >= count)
+            return false;
+    }
+
+    // Children must follow their parent, which rules out cycles, and no
+    // leaf may be deeper than a build makes them, which bounds the stack
+    // that traversal uses.
+    skArray<SKuint32> depths;
+    depths.resizeFast(view.nodeCount);
+    for (SKuint32& depth : depths)
+        depth = 0;
+
+    for (SKuint32 i = 0; i < view.nodeCount; ++i)
+    {
+        const Node& node = view.nodes[i];
+        if (node.count == 0)
+        {
+            if (node.first <= i || node.first >= view.nodeCount - 1 || depths[i] + 1 >= MaxDepth)
+                return false;
+            depths[node.first]     = depths[i] + 1;
+            depths[node.first + 1] = depths[i] + 1;
+        }
+        else if (node.first > view.triangleCount || node.count > view.triangleCount - node.first)
+            return false;
+    }
+    return true;
+}
+
+bool rtMeshBvh::setView(const View& hierarchy, const rtMeshView& view)
+{
+    clear();
+
+    const SKuint32 count = view.vertices && view.indices ? view.indexCount / 3 : 0;
+    if (!validate(hierarchy, count))
+        return false;
+
+    m_view = hierarchy;
+    measure();
+    return true;
+}
+
+bool rtMeshBvh::adopt(const View& hierarchy, const rtPackedBounds* bounds, const SKuint32 count)
+{
+    clear();
+
+    if (!validate(hierarchy, bounds ? count : 0))
+        return false;
+    if (hierarchy.nodeCount == 0)
+        return true;
+
+    m_nodes.resizeFast(hierarchy.nodeCount);
+    memcpy(m_nodes.ptr(), hierarchy.nodes, (SKsize)hierarchy.nodeCount * sizeof(Node));
+    m_triangles.resizeFast(hierarchy.triangleCount);
+    memcpy(m_triangles.ptr(), hierarchy.triangles, (SKsize)hierarchy.triangleCount * sizeof(SKuint32));
+
+    viewOwned();
+    link();
+
+    // The boxes may not be exactly the ones that it was built
+    // over, so its bounds are taken from them rather than trusted.
+    refit(bounds);
+    m_buildCost = getCost();
+    return true;
+}
+
+void rtMeshBvh::measure()
+{
+    m_cost = 0;
+    for (SKuint32 i = 0; i < m_view.nodeCount; ++i)
+        m_cost += (double)rtBvhArea(m_view.nodes[i]) * (double)rtBvhWeight(m_view.nodes[i]);
+
+    m_buildCost = getCost();
+}
+
+void rtMeshBvh::link()
+{
+    m_parents.resizeFast(m_nodes.size());
+    m_leaves.resizeFast(m_triangles.size());
+
+    m_parents[0] = SK_NPOS32;
+    for (SKuint32 i = 0; i < m_nodes.size(); ++i)
+    {
+        const Node& node = m_nodes[i];
+        if (node.count == 0)
+        {
+            m_parents[node.first]     = i;
+            m_parents[node.first + 1] = i;
+        }
+        else
+        {
+            for (SKuint32 j = node.first; j < node.first + node.count; ++j)
+                m_leaves[m_triangles[j]] = i;
+        }
+    }
+}
+
+skScalar rtMeshBvh::getCost() const
+{
+    if (m_view.nodeCount == 0)
+        return 0;
+
+    const skScalar root = rtBvhArea(m_view.nodes[0]);
+    return root > 0 ? (skScalar)(m_cost / (double)root) : 0;
+}
+
+bool rtMeshBvh::refitNode(const SKuint32  index,
+                          const skScalar* bMin,
+                          const skScalar* bMax,
+                          const SKuint32  weight)
+{
+    Node& node = m_nodes[index];
+
+    bool same = true;
+    for (int a = 0; a < 3 && same; ++a)
+        same = node.bMin[a] == (rtScalar)bMin[a] && node.bMax[a] == (rtScalar)bMax[a];
+    if (same)
+        return false;
+
+    const skScalar before = rtBvhArea(node);
+    for (int a = 0; a < 3; ++a)
+    {
+        node.bMin[a] = (rtScalar)bMin[a];
+        node.bMax[a] = (rtScalar)bMax[a];
+    }
+    m_cost += (double)(rtBvhArea(node) - before) * (double)weight;
+    return true;
+}
+
+void rtMeshBvh::refit(const rtPackedBounds* bounds, const SKuint32* changed, const SKuint32 count)
+{
+    if (!bounds || m_nodes.empty() || m_parents.size() != m_nodes.size())
+        return;
+
+    // When most of the boxes have moved, a single pass over
+    // every node is cheaper than walking up from each of them.
+    if (count > m_leaves.size() / 4)
+    {
+        refit(bounds);
+        return;
+    }
+
+    for (SKuint32 k = 0; k < count; ++k)
+    {
+        if (changed[k] >= m_leaves.size())
+            continue;
+
+        SKuint32 index = m_leaves[changed[k]];
+
+        const rtBvhBounds leaf = rtBvhLeafBounds(m_nodes[index], m_triangles, bounds);
+        if (!refitNode(index, leaf.bMin, leaf.bMax, rtBvhWeight(m_nodes[index])))
+            continue;
+
+        // Nodes above one that did not change can not have changed either.
+        for (index = m_parents[index]; index != SK_NPOS32; index = m_parents[index])
+        {
+            const rtBvhBounds branch = rtBvhBranchBounds(m_nodes[index], m_nodes);
+            if (!refitNode(index, branch.bMin, branch.bMax, 1))
+                break;
+        }
+    }
+}
+
+void rtMeshBvh::refit(const rtPackedBounds* bounds)
+{
+    if (!bounds || m_nodes.empty() || m_parents.size() != m_nodes.size())
+        return;
+
+    // Children are always stored after their parent,
+    // so walking backwards visits them first.
+    for (SKuint32 i = m_nodes.size(); i > 0; --i)
+    {
+        const Node& node = m_nodes[i - 1];
+
+        const rtBvhBounds box = node.count == 0
+                                    ? rtBvhBranchBounds(node, m_nodes)
+                                    : rtBvhLeafBounds(node, m_triangles, bounds);
+        refitNode(i - 1, box.bMin, box.bMax, rtBvhWeight(node));
+    }
+
+    // Start the running total over, so that rounding
+    // errors do not build up from one refit to the next.
+    const skScalar buildCost = m_buildCost;
+    measure();
+    m_buildCost = buildCost;
+}
+
+void rtMeshBvh::build(const rtMeshView& view, const BuildMode mode, const SKuint32 threads)
+{
+    clear();
+
+    const SKuint32 count = view.indexCount / 3;
+    if (count == 0 || !view.vertices || !view.indices)
+        return;
+
+    skArray<rtBvhPrimitive> prims;
+    prims.resizeFast(count);
+    m_triangles.resizeFast(count);
+
+    for (SKuint32 i = 0; i < count; ++i)
+    {
+        rtBvhPrimitive& prim = prims[i];
+
+        const rtScalar* v0 = rtBvhVertex(view, rtBvhIndex(view, i * 3));
+        const rtScalar* v1 = rtBvhVertex(view, rtBvhIndex(view, i * 3 + 1));
+        const rtScalar* v2 = rtBvhVertex(view, rtBvhIndex(view, i * 3 + 2));
+
+        for (int a = 0; a < 3; ++a)
+        {
+            prim.bMin[a]     = skMin3<skScalar>(v0[a], v1[a], v2[a]);
+            prim.bMax[a]     = skMax3<skScalar>(v0[a], v1[a], v2[a]);
+            prim.centroid[a] = (prim.bMin[a] + prim.bMax[a]) * skScalar(0.5);
+        }
+        m_triangles[i] = i;
+    }
+
+    rtBvhBuildNodes(m_nodes, m_triangles, prims, mode, threads);
+    viewOwned();
+    measure();
+}
+
+void rtMeshBvh::build(const rtPackedBounds* bounds,
+                      const SKuint32        count,
+                      const BuildMode       mode,
+                      const SKuint32        threads)
+{
+    clear();
+
+    if (count == 0 || !bounds)
+        return;
+
+    skArray<rtBvhPrimitive> prims;
+    prims.resizeFast(count);
+    m_triangles.resizeFast(count);
+
+    for (SKuint32 i = 0; i < count; ++i)
+    {
+        rtBvhPrimitive& prim = prims[i];
+        for (int a = 0; a < 3; ++a)
+        {
+            prim.bMin[a]     = bounds[i].bMin[a];
+            prim.bMax[a]     = bounds[i].bMax[a];
+            prim.centroid[a] = (prim.bMin[a] + prim.bMax[a]) * skScalar(0.5);
+        }
+        m_triangles[i] = i;
+    }
+
+    rtBvhBuildNodes(m_nodes, m_triangles, prims, mode, threads);
+    viewOwned();
+    measure();
+    link();
+}
+
+bool rtMeshBvh::intersect(const rtMeshView& view,
+                          const skVector3&  origin,
+                          const skVector3&  direction,
+                          const skScalar    tMin,
+                          skScalar&         tMax,
+                          SKuint32&         triangle) const
+{
+    return rtBvhIntersect<false>(m_view, view, origin, direction, tMin, tMax, triangle);
+}
+
+bool rtMeshBvh::occluded(const rtMeshView& view,
+                         const skVector3&  origin,
+                         const skVector3&  direction,
+                         const skScalar    tMin,
+                         skScalar          tMax) const
+{
+    SKuint32 triangle;
+    return rtBvhIntersect<true>(m_view, view, origin, direction, tMin, tMax, triangle);
+}
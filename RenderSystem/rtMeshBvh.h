@@ -0,0 +1,308 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+/*! \addtogroup FrontEnd
+ * @{
+ */
+#ifndef _rtMeshBvh_h_
+#define _rtMeshBvh_h_
+
+#include "Math/skVector3.h"
+#include "RenderSystem/Data/rtMeshTypes.h"
+#include "RenderSystem/Data/rtPackedSceneType.h"
+#include "Utils/skArray.h"
+
+/// <summary>
+/// A bounding volume hierarchy over the triangles of a mesh, in mesh space.
+/// </summary>
+/// <remarks>
+/// It is either built top down with binned surface area splits, which
+/// traces fastest, or from the Morton codes of the triangle centroids,
+/// which builds several times faster and suits geometry that is being
+/// edited. The surface area build hands large ranges out to worker
+/// threads as independent subtrees once the top levels are split.
+/// It is built from an rtMeshView, so the vertices are read in place and
+/// only the nodes and a reordered list of triangle numbers are stored.
+/// The view must stay valid for as long as the hierarchy is used.
+/// A hierarchy that was built before, such as one stored in a file, can
+/// also be referenced in place through setView rather than being rebuilt.
+/// The scene also builds one over the bounds of its objects, in which
+/// case the triangle numbers are object indices. A hierarchy built over
+/// boxes also links each node to its parent, so that it can be refit to
+/// boxes that have moved without being rebuilt.
+/// </remarks>
+class rtMeshBvh
+{
+public:
+    /// <summary>
+    /// A node of the hierarchy, see rtPackedNode.
+    /// </summary>
+    typedef rtPackedNode Node;
+
+    typedef skArray<Node>     Nodes;
+    typedef skArray<SKuint32> Triangles;
+    typedef skArray<SKuint32> Links;
+
+    /// <summary>
+    /// The nodes and the triangle order that are traced. They are either
+    /// the hierarchy's own arrays or records that it references.
+    /// </summary>
+    struct View
+    {
+        const Node*     nodes;
+        SKuint32        nodeCount;
+        const SKuint32* triangles;
+        SKuint32        triangleCount;
+    };
+
+    /// <summary>
+    /// The ways that the hierarchy can be built.
+    /// </summary>
+    enum BuildMode
+    {
+        /// <summary>
+        /// Binned surface area splits, the default.
+        /// </summary>
+        BM_SAH,
+
+        /// <summary>
+        /// Splits at the highest differing bit of sorted Morton codes.
+        /// </summary>
+        BM_MORTON,
+    };
+
+    /// <summary>
+    /// The largest number of triangles a leaf is made of
+    /// without first checking whether splitting it is cheaper.
+    /// </summary>
+    static constexpr SKuint32 LeafSize = 4;
+
+    /// <summary>
+    /// The number of bins that split positions are sampled from.
+    /// </summary>
+    static constexpr SKuint32 BinCount = 12;
+
+    /// <summary>
+    /// The deepest a leaf can be. Ranges that reach it become leaves
+    /// whatever their size, which bounds the traversal stack.
+    /// </summary>
+    static constexpr SKuint32 MaxDepth = 64;
+
+    /// <summary>
+    /// The fewest triangles that a surface area build splits up into
+    /// subtrees for worker threads. Below it the build is serial.
+    /// </summary>
+    static constexpr SKuint32 SubtreeSize = 4096;
+
+private:
+    Nodes     m_nodes;
+    Triangles m_triangles;
+    Links     m_parents;
+    Links     m_leaves;
+    View      m_view;
+    double    m_cost;
+    skScalar  m_buildCost;
+
+    void viewOwned();
+
+    bool validate(const View& view, SKuint32 count) const;
+
+    void measure();
+
+    void link();
+
+    bool refitNode(SKuint32 index, const skScalar* bMin, const skScalar* bMax, SKuint32 weight);
+
+public:
+    rtMeshBvh();
+
+    rtMeshBvh(const rtMeshBvh& other);
+
+    ~rtMeshBvh() = default;
+
+    rtMeshBvh& operator=(const rtMeshBvh& other);
+
+    /// <summary>
+    /// Rebuilds the hierarchy.
+    /// </summary>
+    /// <param name="view">The triangles to build it over.</param>
+    /// <param name="mode">The way to build it.</param>
+    /// <param name="threads">The most threads a BM_SAH build may use, or zero for one per core.</param>
+    void build(const rtMeshView& view, BuildMode mode = BM_SAH, SKuint32 threads = 0);
+
+    /// <summary>
+    /// Rebuilds the hierarchy over boxes rather than triangles.
+    /// </summary>
+    /// <param name="bounds">The boxes to build it over.</param>
+    /// <param name="count">The number of elements in bounds.</param>
+    /// <param name="mode">The way to build it.</param>
+    /// <param name="threads">The most threads a BM_SAH build may use, or zero for one per core.</param>
+    void build(const rtPackedBounds* bounds, SKuint32 count, BuildMode mode = BM_SAH, SKuint32 threads = 0);
+
+    /// <summary>
+    /// References a hierarchy over the triangles of a view that was built
+    /// before, rather than building it again. The records are not copied,
+    /// so they must outlive the hierarchy, or the next call to build or clear.
+    /// </summary>
+    /// <param name="hierarchy">The nodes and triangle order to reference.</param>
+    /// <param name="view">The triangles that the hierarchy was built over.</param>
+    /// <returns>
+    /// False, and the hierarchy is left empty, if the records do not
+    /// describe a tree over every triangle of the view.
+    /// </returns>
+    bool setView(const View& hierarchy, const rtMeshView& view);
+
+    /// <summary>
+    /// Copies a hierarchy over boxes that was built before, rather than
+    /// building it again, then refits it to the boxes as they are now.
+    /// </summary>
+    /// <param name="hierarchy">The nodes and box order to copy.</param>
+    /// <param name="bounds">The boxes that the hierarchy was built over.</param>
+    /// <param name="count">The number of elements in bounds.</param>
+    /// <returns>
+    /// False, and the hierarchy is left empty, if the records do
+    /// not describe a tree over every one of the boxes.
+    /// </returns>
+    bool adopt(const View& hierarchy, const rtPackedBounds* bounds, SKuint32 count);
+
+    /// <summary>
+    /// Frees the nodes and the triangle list.
+    /// </summary>
+    void clear();
+
+    /// <summary>
+    /// Grows or shrinks the nodes above boxes that have moved, leaving
+    /// the structure of the hierarchy as it is. Only the leaves that hold
+    /// the changed boxes and the nodes above them are visited, and a
+    /// walk stops early at the first node whose bounds did not change.
+    /// </summary>
+    /// <remarks>
+    /// It must have been built with build(const rtPackedBounds*, SKuint32)
+    /// or adopt, and the number of boxes must not have changed since.
+    /// </remarks>
+    /// <param name="bounds">The boxes that it was built over.</param>
+    /// <param name="changed">The numbers of the boxes that have moved.</param>
+    /// <param name="count">The number of elements in changed.</param>
+    void refit(const rtPackedBounds* bounds, const SKuint32* changed, SKuint32 count);
+
+    /// <summary>
+    /// Refits every node to the boxes, see refit above.
+    /// </summary>
+    /// <param name="bounds">The boxes that it was built over.</param>
+    void refit(const rtPackedBounds* bounds);
+
+    /// <summary>
+    /// Finds the nearest triangle that a ray passes through.
+    /// </summary>
+    /// <param name="view">The view that the hierarchy was built from.</param>
+    /// <param name="origin">The mesh space origin of the ray.</param>
+    /// <param name="direction">The mesh space direction of the ray.</param>
+    /// <param name="tMin">The nearest distance that is accepted.</param>
+    /// <param name="tMax">The farthest distance that is accepted. On a hit it is set to the hit's distance.</param>
+    /// <param name="triangle">Set to the number of the triangle that was hit.</param>
+    /// <returns>True if a triangle was hit.</returns>
+    bool intersect(const rtMeshView& view,
+                   const skVector3&  origin,
+                   const skVector3&  direction,
+                   skScalar          tMin,
+                   skScalar&         tMax,
+                   SKuint32&         triangle) const;
+
+    /// <summary>
+    /// Tests whether a ray passes through any triangle, stopping at the first one found.
+    /// </summary>
+    /// <param name="view">The view that the hierarchy was built from.</param>
+    /// <param name="origin">The mesh space origin of the ray.</param>
+    /// <param name="direction">The mesh space direction of the ray.</param>
+    /// <param name="tMin">The nearest distance that is accepted.</param>
+    /// <param name="tMax">The farthest distance that is accepted.</param>
+    /// <returns>True if a triangle was hit.</returns>
+    bool occluded(const rtMeshView& view,
+                  const skVector3&  origin,
+                  const skVector3&  direction,
+                  skScalar          tMin,
+                  skScalar          tMax) const;
+
+    /// <summary>
+    /// Returns the nodes, the first of which is the root, and the
+    /// triangle numbers in the order that the leaves reference them.
+    /// </summary>
+    const View& getView() const;
+
+    /// <summary>
+    /// Returns true if the records are referenced through setView.
+    /// </summary>
+    bool isView() const;
+
+    /// <summary>
+    /// Returns the surface area cost of tracing the hierarchy, relative to the
+    /// area of the root. It counts one for every node that a ray visits and
+    /// one for every triangle it tests, so lower is better.
+    /// </summary>
+    skScalar getCost() const;
+
+    /// <summary>
+    /// Returns what getCost returned when the hierarchy was last built.
+    /// The ratio of the two measures how far refitting has degraded it.
+    /// </summary>
+    skScalar getBuildCost() const;
+
+    /// <summary>
+    /// Returns the number of bytes held by the nodes and the triangle list.
+    /// </summary>
+    SKsize getMemorySize() const;
+
+    /// <summary>
+    /// Returns true if the hierarchy holds no triangles.
+    /// </summary>
+    bool empty() const;
+};
+
+/*! @} */
+
+SK_INLINE const rtMeshBvh::View& rtMeshBvh::getView() const
+{
+    return m_view;
+}
+
+SK_INLINE bool rtMeshBvh::isView() const
+{
+    return m_view.nodes != nullptr && m_view.nodes != m_nodes.ptr();
+}
+
+SK_INLINE SKsize rtMeshBvh::getMemorySize() const
+{
+    return (SKsize)m_nodes.capacity() * sizeof(Node) +
+           (SKsize)m_triangles.capacity() * sizeof(SKuint32) +
+           (SKsize)(m_parents.capacity() + m_leaves.capacity()) * sizeof(SKuint32);
+}
+
+SK_INLINE skScalar rtMeshBvh::getBuildCost() const
+{
+    return m_buildCost;
+}
+
+SK_INLINE bool rtMeshBvh::empty() const
+{
+    return m_view.nodeCount == 0;
+}
+
+#endif  //_rtMeshBvh_h_
@@ -0,0 +1,438 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "rtMeshGeometry.h"
+#include "Utils/skMap.h"
+
+// Views read vertices as rtScalar triples, so the mesh's own
+// vertices can only be viewed if they are stored the same way.
+static_assert(sizeof(skVector3) == sizeof(rtScalar) * 3, "skVector3 must be three rtScalar values");
+
+/// <summary>
+/// Mesh sort
+/// </summary>
+class rtMeshPrivate
+{
+public:
+    typedef skHashTable<SKuint32, SKuint32> Table;
+
+private:
+    rtMeshGeometry::Indices  m_indices;
+    Table            m_lookup;
+    rtMeshGeometry::Vertices m_vertices;
+
+public:
+    rtMeshPrivate() = default;
+
+    ~rtMeshPrivate() = default;
+
+    void clear()
+    {
+        m_indices.clear();
+        m_lookup.clear();
+        m_vertices.clear();
+    }
+
+    void freeLookup()
+    {
+        m_lookup.clear();
+    }
+
+    rtMeshGeometry::Indices& getIndices()
+    {
+        return m_indices;
+    }
+
+    rtMeshGeometry::Vertices& getVertices()
+    {
+        return m_vertices;
+    }
+
+    static bool equals(const skVector3& a, const skVector3& b)
+    {
+        bool res = true;
+        res      = res && skEq(a.x, b.x);
+        res      = res && skEq(a.y, b.y);
+        res      = res && skEq(a.z, b.z);
+        return res;
+    }
+
+    /// <summary>
+    /// Tracks a new indexed vertex based on an old index.
+    /// </summary>
+    /// <param name="index">The old index.</param>
+    /// <param name="v">The vertex to store</param>
+    /// <returns>Returns the new index</returns>
+    SKuint32 addVertex(const SKuint32& index, const skVector3& v)
+    {
+        SKuint32 pos = (SKuint32)m_lookup.find(index);
+        if (pos != SK_NPOS32)
+        {
+            pos = m_lookup.at(pos);
+            if (!equals(m_vertices[pos], v))
+                pos = SK_NPOS32;
+        }
+
+        if (pos == SK_NPOS32)
+        {
+            pos = m_vertices.size();
+            m_vertices.push_back(v);
+            m_lookup.insert(index, pos);
+        }
+        return pos;
+    }
+
+    void addTriangle(SKuint32         i1,
+                     SKuint32         i2,
+                     SKuint32         i3,
+                     const skVector3& v1,
+                     const skVector3& v2,
+                     const skVector3& v3)
+    {
+        m_indices.push_back(addVertex(i1, v1));
+        m_indices.push_back(addVertex(i2, v2));
+        m_indices.push_back(addVertex(i3, v3));
+    }
+
+    bool addIndexed(const skVector3* vertices,
+                    const SKuint32   vertexCount,
+                    const SKuint32*  indices,
+                    SKuint32         indexCount)
+    {
+        indexCount -= indexCount % 3;
+
+        for (SKuint32 i = 0; i < indexCount; ++i)
+        {
+            if (indices[i] >= vertexCount)
+                return false;
+        }
+
+        const SKuint32 base = m_vertices.size();
+
+        m_vertices.reserve(base + vertexCount);
+        for (SKuint32 i = 0; i < vertexCount; ++i)
+            m_vertices.push_back(vertices[i]);
+
+        m_indices.reserve(m_indices.size() + indexCount);
+        for (SKuint32 i = 0; i < indexCount; ++i)
+            m_indices.push_back(base + indices[i]);
+        return true;
+    }
+
+    void addSoup(const skVector3* vertices, SKuint32 vertexCount, const skScalar tolerance)
+    {
+        vertexCount -= vertexCount % 3;
+        if (vertexCount == 0)
+            return;
+
+        const SKuint32 base = m_vertices.size();
+
+        // The grid cells are twice the weld distance wide, so any
+        // vertex within the tolerance of v lies in one of the eight
+        // cells nearest to v. A zero tolerance only needs v's own cell.
+        const bool     exact = tolerance <= 0;
+        const skScalar size  = exact ? skScalar(1) : tolerance * 2;
+        const skScalar inv   = skScalar(1) / size;
+        const skScalar tol2  = exact ? skScalar(0) : tolerance * tolerance;
+
+        SKuint32 bucketCount = 64;
+        while (bucketCount < vertexCount)
+            bucketCount <<= 1;
+
+        rtMeshGeometry::Indices buckets, next;
+        buckets.resizeFast(bucketCount);
+        for (SKuint32 i = 0; i < bucketCount; ++i)
+            buckets[i] = SK_NPOS32;
+        next.reserve(vertexCount);
+
+        m_vertices.reserve(base + vertexCount);
+        m_indices.reserve(m_indices.size() + vertexCount);
+
+        for (SKuint32 i = 0; i < vertexCount; ++i)
+        {
+            const skVector3& v = vertices[i];
+
+            const skScalar fx = v.x * inv, fy = v.y * inv, fz = v.z * inv;
+            const SKint64  cx = (SKint64)skFloor(fx);
+            const SKint64  cy = (SKint64)skFloor(fy);
+            const SKint64  cz = (SKint64)skFloor(fz);
+
+            SKuint32 found = SK_NPOS32;
+            if (exact)
+                found = findWelded(buckets, next, base, cell(cx, cy, cz), v, tol2);
+            else
+            {
+                // Step towards the half of the cell v sits in.
+                const SKint64 sx = fx - (skScalar)cx < skScalar(0.5) ? -1 : 1;
+                const SKint64 sy = fy - (skScalar)cy < skScalar(0.5) ? -1 : 1;
+                const SKint64 sz = fz - (skScalar)cz < skScalar(0.5) ? -1 : 1;
+
+                for (int n = 0; n < 8 && found == SK_NPOS32; ++n)
+                {
+                    found = findWelded(buckets,
+                                       next,
+                                       base,
+                                       cell(cx + (n & 1 ? sx : 0),
+                                            cy + (n & 2 ? sy : 0),
+                                            cz + (n & 4 ? sz : 0)),
+                                       v,
+                                       tol2);
+                }
+            }
+
+            if (found == SK_NPOS32)
+            {
+                found = m_vertices.size();
+                m_vertices.push_back(v);
+
+                SKuint32& head = buckets[cell(cx, cy, cz) & (bucketCount - 1)];
+                next.push_back(head);
+                head = found - base;
+            }
+            m_indices.push_back(found);
+        }
+    }
+
+private:
+    static SKuint64 cell(const SKint64 x, const SKint64 y, const SKint64 z)
+    {
+        return (SKuint64)(x * 73856093) ^ (SKuint64)(y * 19349663) ^ (SKuint64)(z * 83492791);
+    }
+
+    SKuint32 findWelded(const rtMeshGeometry::Indices& buckets,
+                        const rtMeshGeometry::Indices& next,
+                        const SKuint32         base,
+                        const SKuint64         key,
+                        const skVector3&       v,
+                        const skScalar         tol2) const
+    {
+        SKuint32 i = buckets[(SKuint32)(key & (buckets.size() - 1))];
+        while (i != SK_NPOS32)
+        {
+            const skVector3& o = m_vertices[base + i];
+            if (o.distance2(v) <= tol2)
+                return base + i;
+            i = next[i];
+        }
+        return SK_NPOS32;
+    }
+};
+
+rtMeshGeometry::rtMeshGeometry() :
+    m_private(new rtMeshPrivate()),
+    m_view({}),
+    m_bvhOutOfDate(true),
+    m_buildMode(rtMeshBvh::BM_SAH),
+    m_references(1)
+{
+    m_localBoundingBox.clear();
+    geometryChanged();
+}
+
+rtMeshGeometry::~rtMeshGeometry()
+{
+    delete m_private;
+}
+
+void rtMeshGeometry::addReference()
+{
+    ++m_references;
+}
+
+void rtMeshGeometry::release()
+{
+    SK_ASSERT(m_references > 0);
+    if (--m_references == 0)
+        delete this;
+}
+
+void rtMeshGeometry::beginAddTriangles()
+{
+    m_view = {};
+    m_localBoundingBox.clear();
+    m_bvhOutOfDate = true;
+
+    m_private->clear();
+}
+
+void rtMeshGeometry::addTriangle(const SKuint32&  i0,
+                         const SKuint32&  i1,
+                         const SKuint32&  i2,
+                         const skVector3& v0,
+                         const skVector3& v1,
+                         const skVector3& v2)
+{
+    m_private->addTriangle(i0, i1, i2, v0, v1, v2);
+
+    m_localBoundingBox.compare(v0);
+    m_localBoundingBox.compare(v1);
+    m_localBoundingBox.compare(v2);
+}
+
+bool rtMeshGeometry::addIndexedTriangles(const skVector3* vertices,
+                                 const SKuint32   vertexCount,
+                                 const SKuint32*  indices,
+                                 const SKuint32   indexCount)
+{
+    if (!vertices || !indices)
+        return false;
+    if (!m_private->addIndexed(vertices, vertexCount, indices, indexCount))
+        return false;
+
+    for (SKuint32 i = 0; i < vertexCount; ++i)
+        m_localBoundingBox.compare(vertices[i]);
+    return true;
+}
+
+void rtMeshGeometry::addTriangleSoup(const skVector3* vertices,
+                             const SKuint32   vertexCount,
+                             const skScalar   tolerance)
+{
+    if (!vertices)
+        return;
+
+    m_private->addSoup(vertices, vertexCount, tolerance);
+
+    for (SKuint32 i = 0; i < vertexCount; ++i)
+        m_localBoundingBox.compare(vertices[i]);
+}
+
+void rtMeshGeometry::endAddTriangles()
+{
+    m_private->freeLookup();
+
+    const Vertices& vertices = m_private->getVertices();
+    const Indices&  indices  = m_private->getIndices();
+
+    m_view = {
+        (const SKubyte*)vertices.ptr(),
+        vertices.size(),
+        (SKuint32)sizeof(skVector3),
+        (const SKubyte*)indices.ptr(),
+        indices.size(),
+        (SKuint32)sizeof(SKuint32),
+    };
+    geometryChanged();
+    getBvh();
+}
+
+bool rtMeshGeometry::setView(const rtMeshView& view)
+{
+    if (!applyView(view))
+        return false;
+
+    getBvh();
+    return true;
+}
+
+bool rtMeshGeometry::setView(const rtMeshView& view, const rtMeshBvh::View& hierarchy)
+{
+    if (!applyView(view))
+        return false;
+
+    if (m_bvh.setView(hierarchy, m_view))
+        m_bvhOutOfDate = false;
+    else
+        getBvh();
+    return true;
+}
+
+bool rtMeshGeometry::applyView(const rtMeshView& view)
+{
+    m_view = {};
+    m_localBoundingBox.clear();
+    m_bvhOutOfDate = true;
+
+    // Any vertices that were copied before are no longer used.
+    m_private->getVertices().clear();
+
+    if (view.indexCount > 0 && (!view.vertices || !view.indices))
+        return false;
+
+    m_view            = view;
+    m_view.indexCount = view.indexCount - view.indexCount % 3;
+
+    for (SKuint32 i = 0; i < m_view.indexCount; ++i)
+    {
+        if (getIndex(i) >= m_view.vertexCount)
+        {
+            m_view = {};
+            geometryChanged();
+            return false;
+        }
+    }
+
+    for (SKuint32 i = 0; i < m_view.vertexCount; ++i)
+        m_localBoundingBox.compare(getVertex(i));
+
+    geometryChanged();
+    return true;
+}
+
+void rtMeshGeometry::geometryChanged()
+{
+    // A mesh without vertices is a point at its origin.
+    if (m_view.vertexCount == 0)
+        m_localBoundingBox = skBoundingBox(skVector3::Zero, skVector3::Zero);
+    m_bvhOutOfDate = true;
+}
+
+bool rtMeshGeometry::isView() const
+{
+    return m_view.vertices != nullptr &&
+           m_view.vertices != (const SKubyte*)m_private->getVertices().ptr();
+}
+
+rtMeshGeometry::Indices& rtMeshGeometry::getIndices() const
+{
+    return m_private->getIndices();
+}
+
+rtMeshGeometry::Vertices& rtMeshGeometry::getVertices() const
+{
+    return m_private->getVertices();
+}
+
+const rtMeshBvh& rtMeshGeometry::getBvh() const
+{
+    if (m_bvhOutOfDate)
+    {
+        m_bvh.build(m_view, m_buildMode);
+        m_bvhOutOfDate = false;
+    }
+    return m_bvh;
+}
+
+void rtMeshGeometry::setBuildMode(const rtMeshBvh::BuildMode mode)
+{
+    if (m_buildMode != mode)
+    {
+        m_buildMode    = mode;
+        m_bvhOutOfDate = true;
+    }
+}
+
+SKsize rtMeshGeometry::getMemorySize() const
+{
+    return (SKsize)m_private->getVertices().capacity() * sizeof(skVector3) +
+           (SKsize)m_private->getIndices().capacity() * sizeof(SKuint32) +
+           m_bvh.getMemorySize();
+}
@@ -0,0 +1,284 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+/*! \addtogroup FrontEnd
+ * @{
+ */
+#ifndef _rtMeshGeometry_h_
+#define _rtMeshGeometry_h_
+
+#include "Math/skBoundingBox.h"
+#include "RenderSystem/Data/rtMeshTypes.h"
+#include "rtMeshBvh.h"
+
+class rtMeshPrivate;
+
+/// <summary>
+/// The triangles of a mesh and their hierarchy, which may be
+/// shared by any number of rtMesh objects.
+/// </summary>
+/// <remarks>
+/// The triangles are either copied into arrays that the geometry owns,
+/// through beginAddTriangles, the add methods and endAddTriangles, or
+/// referenced in place through setView. Either way they are read through
+/// getView. The vertices are in mesh space. Each rtMesh that uses it
+/// holds a reference, and it is deleted when the last one is released.
+/// </remarks>
+class rtMeshGeometry
+{
+public:
+    typedef skArray<SKuint32>  Indices;
+    typedef skArray<skVector3> Vertices;
+
+private:
+    friend rtMeshPrivate;
+
+    rtMeshPrivate*       m_private;
+    rtMeshView           m_view;
+    skBoundingBox        m_localBoundingBox;
+    mutable rtMeshBvh    m_bvh;
+    mutable bool         m_bvhOutOfDate;
+    rtMeshBvh::BuildMode m_buildMode;
+    SKuint32             m_references;
+
+    void geometryChanged();
+
+    bool applyView(const rtMeshView& view);
+
+    ~rtMeshGeometry();
+
+public:
+    /// <summary>
+    /// Creates an empty geometry that has one reference.
+    /// </summary>
+    rtMeshGeometry();
+
+    /// <summary>
+    /// Adds a reference to the geometry.
+    /// </summary>
+    void addReference();
+
+    /// <summary>
+    /// Releases a reference, and deletes the geometry with the last one.
+    /// </summary>
+    void release();
+
+    /// <summary>
+    /// Returns the number of meshes that hold a reference.
+    /// </summary>
+    SKuint32 getReferenceCount() const;
+
+    /// <summary>
+    ///
+    /// </summary>
+    void beginAddTriangles();
+
+    /// <summary>
+    ///
+    /// </summary>
+    /// <param name="i0"></param>
+    /// <param name="i1"></param>
+    /// <param name="i2"></param>
+    /// <param name="v0"></param>
+    /// <param name="v1"></param>
+    /// <param name="v2"></param>
+    void addTriangle(const SKuint32&  i0,
+                     const SKuint32&  i1,
+                     const SKuint32&  i2,
+                     const skVector3& v0,
+                     const skVector3& v1,
+                     const skVector3& v2);
+
+    /// <summary>
+    /// Appends a mesh that is already indexed. The vertices are
+    /// copied as is, without searching for duplicates.
+    /// </summary>
+    /// <param name="vertices">The vertex array.</param>
+    /// <param name="vertexCount">The number of elements in vertices.</param>
+    /// <param name="indices">Three indices per triangle, relative to vertices.</param>
+    /// <param name="indexCount">The number of elements in indices.</param>
+    /// <returns>False, and nothing is added, if any index is out of range.</returns>
+    bool addIndexedTriangles(const skVector3* vertices,
+                             SKuint32         vertexCount,
+                             const SKuint32*  indices,
+                             SKuint32         indexCount);
+
+    /// <summary>
+    /// Appends an unindexed triangle list, where every three vertices
+    /// make a triangle. Vertices that lie within tolerance of each other
+    /// are welded into one through a spatial hash.
+    /// </summary>
+    /// <param name="vertices">The triangle vertices.</param>
+    /// <param name="vertexCount">The number of elements in vertices.</param>
+    /// <param name="tolerance">The weld distance. Zero only welds exact copies.</param>
+    void addTriangleSoup(const skVector3* vertices,
+                         SKuint32         vertexCount,
+                         skScalar         tolerance = SK_EPSILON);
+
+    /// <summary>
+    /// Finishes adding triangles, points the view at the geometry's
+    /// own arrays and builds the triangle hierarchy over them.
+    /// </summary>
+    void endAddTriangles();
+
+    /// <summary>
+    /// References triangles that the geometry does not own, rather than copying them.
+    /// </summary>
+    /// <remarks>
+    /// The arrays must outlive the geometry, or the next call to setView or
+    /// beginAddTriangles. The indices may also be the geometry's own array,
+    /// filled through getIndices, for faces that had to be triangulated.
+    /// </remarks>
+    /// <param name="view">The vertex and index records.</param>
+    /// <returns>
+    /// False, and the geometry is left empty, if any index is out of range.
+    /// Otherwise the triangle hierarchy is built over the view.
+    /// </returns>
+    bool setView(const rtMeshView& view);
+
+    /// <summary>
+    /// References triangles and a hierarchy over them that was built before,
+    /// such as one read from a file, so that neither is copied or rebuilt.
+    /// </summary>
+    /// <remarks>
+    /// The hierarchy's records have the same lifetime as the view's. If
+    /// they do not describe a tree over the view's triangles, one is built.
+    /// </remarks>
+    /// <param name="view">The vertex and index records.</param>
+    /// <param name="hierarchy">The nodes and triangle order to reference.</param>
+    /// <returns>False, and the geometry is left empty, if any index is out of range.</returns>
+    bool setView(const rtMeshView& view, const rtMeshBvh::View& hierarchy);
+
+    /// <summary>
+    /// Returns the triangles that the geometry is made of.
+    /// </summary>
+    const rtMeshView& getView() const;
+
+    /// <summary>
+    /// Returns true if the vertices are referenced through setView.
+    /// </summary>
+    bool isView() const;
+
+    /// <summary>
+    /// Returns the number of vertices in the view.
+    /// </summary>
+    SKuint32 getVertexCount() const;
+
+    /// <summary>
+    /// Returns the number of indices in the view.
+    /// </summary>
+    SKuint32 getIndexCount() const;
+
+    /// <summary>
+    /// Reads a vertex from the view.
+    /// </summary>
+    skVector3 getVertex(SKuint32 i) const;
+
+    /// <summary>
+    /// Reads an index from the view.
+    /// </summary>
+    SKuint32 getIndex(SKuint32 i) const;
+
+    /// <summary>
+    /// Returns the geometry's own index array.
+    /// </summary>
+    Indices& getIndices() const;
+
+    /// <summary>
+    /// Returns the geometry's own vertex array. It is empty when
+    /// the vertices are referenced through setView.
+    /// </summary>
+    Vertices& getVertices() const;
+
+    /// <summary>
+    /// Returns the triangle hierarchy. It is built by endAddTriangles
+    /// and setView, and rebuilt here if the build mode changed since.
+    /// </summary>
+    const rtMeshBvh& getBvh() const;
+
+    /// <summary>
+    /// Sets the way the hierarchy is built. BM_MORTON builds faster,
+    /// for geometry that is edited often, at some cost to tracing.
+    /// The hierarchy is rebuilt when the mode changes, so the mode
+    /// is best set before the triangles are added.
+    /// </summary>
+    void setBuildMode(rtMeshBvh::BuildMode mode);
+
+    /// <summary>
+    /// Returns the way the hierarchy is built. The default is BM_SAH.
+    /// </summary>
+    rtMeshBvh::BuildMode getBuildMode() const;
+
+    /// <summary>
+    /// Returns the bounds of the vertices, in mesh space.
+    /// </summary>
+    const skBoundingBox& getLocalBoundingBox() const;
+
+    /// <summary>
+    /// Returns the number of bytes held by the owned arrays and the hierarchy.
+    /// </summary>
+    SKsize getMemorySize() const;
+};
+
+/*! @} */
+
+SK_INLINE rtMeshBvh::BuildMode rtMeshGeometry::getBuildMode() const
+{
+    return m_buildMode;
+}
+
+SK_INLINE SKuint32 rtMeshGeometry::getReferenceCount() const
+{
+    return m_references;
+}
+
+SK_INLINE const rtMeshView& rtMeshGeometry::getView() const
+{
+    return m_view;
+}
+
+SK_INLINE SKuint32 rtMeshGeometry::getVertexCount() const
+{
+    return m_view.vertexCount;
+}
+
+SK_INLINE SKuint32 rtMeshGeometry::getIndexCount() const
+{
+    return m_view.indexCount;
+}
+
+SK_INLINE skVector3 rtMeshGeometry::getVertex(const SKuint32 i) const
+{
+    const rtScalar* co = (const rtScalar*)(m_view.vertices + (SKsize)i * m_view.vertexStride);
+    return {co[0], co[1], co[2]};
+}
+
+SK_INLINE SKuint32 rtMeshGeometry::getIndex(const SKuint32 i) const
+{
+    return *(const SKuint32*)(m_view.indices + (SKsize)i * m_view.indexStride);
+}
+
+SK_INLINE const skBoundingBox& rtMeshGeometry::getLocalBoundingBox() const
+{
+    return m_localBoundingBox;
+}
+
+#endif  //_rtMeshGeometry_h_
@@ -68,6 +68,11 @@ public:
     /// <param name="p0"></param>
     void setPoint(const skVector3& p0);
 
+    /// <summary>
+    /// Returns the plane before it is transformed by the object.
+    /// </summary>
+    const skPlane& getLocalPlane() const;
+
 };
 /*! @} */
 
@@ -86,4 +91,9 @@ SK_INLINE void rtPlane::setPoint(const skVector3& p0)
     m_plane.p0 = p0;
 }
 
+SK_INLINE const skPlane& rtPlane::getLocalPlane() const
+{
+    return m_plane;
+}
+
 #endif  //_rtPlane_h_
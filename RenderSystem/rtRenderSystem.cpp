@@ -41,6 +41,82 @@ void rtRenderSystem::setTarget(rtTarget* target)
     updatePixelOffset();
 }
 
+void rtRenderSystem::render(rtScene* scene, const skRectangle&)
+{
+    render(scene);
+}
+
+void rtRenderSystem::render(rtScene* scene, const rtViews& views)
+{
+    rtTarget* target = m_target;
+    rtCamera* camera = m_camera;
+
+    for (const rtView& view : views)
+    {
+        if (!view.camera || !view.target)
+            continue;
+
+        if (view.target != m_target)
+        {
+            setTarget(view.target);
+            invalidate();
+        }
+
+        setCamera(view.camera);
+        render(scene);
+    }
+
+    if (target && target != m_target)
+    {
+        setTarget(target);
+        invalidate();
+    }
+
+    // Without a camera of its own, the next frame
+    // picks the scene's first camera again.
+    if (camera)
+        setCamera(camera);
+    else
+        invalidate();
+}
+
+void rtRenderSystem::setCamera(rtCamera* camera)
+{
+    m_camera = camera;
+
+    // Before the first frame, initialize binds it.
+    if (m_camera && m_scene && !m_dirty)
+        bindCamera();
+}
+
+void rtRenderSystem::bindCamera()
+{
+    updatePixelOffset();
+
+    rtCameraType* ca = m_camera->getPtr();
+
+    ca->offset = {
+        m_iPixelOffset.x,
+        m_iPixelOffset.y,
+        m_iPixelOffset.z,
+        m_iPixelOffset.w,
+    };
+    m_scene->getPtr()->camera = ca;
+}
+
+skVector4 rtRenderSystem::computePixelOffset(const rtCamera* camera, rtTarget* target)
+{
+    const skScalar iW = skScalar(target->getWidth());
+    const skScalar iH = skScalar(target->getHeight());
+
+    return {
+        skScalar(1.0) / iW,
+        skScalar(1.0) / iH,
+        iW / iH,
+        -skTan(skRPD * camera->getFieldOfViewAngle() * 0.5f),
+    };
+}
+
 void rtRenderSystem::updatePixelOffset()
 {
     const skScalar iW = skScalar(m_target->getWidth());
@@ -51,11 +127,7 @@ void rtRenderSystem::updatePixelOffset()
         m_limit.x = m_camera->getNear();
         m_limit.y = m_camera->getFar();
 
-        m_iPixelOffset.x = skScalar(1.0) / iW;
-        m_iPixelOffset.y = skScalar(1.0) / iH;
-
-        m_iPixelOffset.z = iW / iH;
-        m_iPixelOffset.w = -skTan(skRPD * m_camera->getFieldOfViewAngle() * 0.5f);
+        m_iPixelOffset = computePixelOffset(m_camera, m_target);
 
         m_camera->setAspect(m_iPixelOffset.z);
     }
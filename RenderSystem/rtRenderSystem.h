@@ -38,6 +38,7 @@ using rtBVOs    = rtScene::BoundingVolumeArray;
 
 class skRay;
 class skImage;
+class skRectangle;
 
 /// <summary>
 /// Render mode flags.
@@ -81,6 +82,17 @@ enum rtRenderMode
     RM_AA = 0x040,
 };
 
+/// <summary>
+/// A camera and the target that it is rendered to.
+/// </summary>
+struct rtView
+{
+    rtCamera* camera;
+    rtTarget* target;
+};
+
+using rtViews = skArray<rtView>;
+
 /// <summary>
 /// Base class for a custom renderer implementation.
 /// </summary>
@@ -100,6 +112,16 @@ protected:
     /// </summary>
     void updatePixelOffset();
 
+    /// <summary>
+    /// Makes the current camera the one the kernel scene renders from.
+    /// </summary>
+    void bindCamera();
+
+    /// <summary>
+    /// Computes the pixel offsets of a camera for the size of a target.
+    /// </summary>
+    static skVector4 computePixelOffset(const rtCamera* camera, rtTarget* target);
+
 public:
     rtRenderSystem();
     virtual ~rtRenderSystem() = default;
@@ -129,12 +151,46 @@ public:
     /// <param name="target">Instance of an implementation of the rtTarget class.</param>
     void setTarget(rtTarget* target);
 
+    /// <summary>
+    /// Sets the camera that the next frame is rendered from.
+    /// </summary>
+    /// <remarks>
+    /// Switching cameras keeps the compiled scene and the worker threads,
+    /// so a sequence of frames only pays for the frames themselves.
+    /// When no camera is set, the first camera in the scene is used.
+    /// </remarks>
+    /// <param name="camera">A camera that belongs to the rendered scene.</param>
+    void setCamera(rtCamera* camera);
+
     /// <summary>
     /// The main implementation method to render a scene.
     /// </summary>
     /// <param name="scene">The rtScene instance that should be rendered.</param>
     virtual void render(rtScene* scene) = 0;
 
+    /// <summary>
+    /// Renders a rectangle of the target, leaving the rest of it untouched.
+    /// </summary>
+    /// <remarks>
+    /// The rectangle is in pixels, with its origin at the top left of the image.
+    /// The default implementation renders the whole frame.
+    /// </remarks>
+    /// <param name="scene">The rtScene instance that should be rendered.</param>
+    /// <param name="rect">The region of the target to render.</param>
+    virtual void render(rtScene* scene, const skRectangle& rect);
+
+    /// <summary>
+    /// Renders several views of a scene from the same compiled scene data.
+    /// </summary>
+    /// <remarks>
+    /// Each view needs its own target, and its camera must belong to the
+    /// scene. The default implementation renders the views one after another.
+    /// The current target and camera are restored afterwards.
+    /// </remarks>
+    /// <param name="scene">The rtScene instance that should be rendered.</param>
+    /// <param name="views">The cameras and the targets they render to.</param>
+    virtual void render(rtScene* scene, const rtViews& views);
+
     /// <summary>
     /// Returns the reciprocal of the current targets width and height.
     /// </summary>
@@ -20,15 +20,74 @@
 -------------------------------------------------------------------------------
 */
 #include "RenderSystem/rtScene.h"
+#include <atomic>
 #include "RenderSystem/Data/rtAllocator.h"
 #include "RenderSystem/rtCamera.h"
 #include "RenderSystem/rtLight.h"
 #include "RenderSystem/rtMesh.h"
 #include "RenderSystem/rtObject.h"
 #include "RenderSystem/rtRenderSystem.h"
+#include "Math/skMatrix3.h"
+#include "Threads/skThread.h"
+#include "Utils/skMap.h"
 
-rtScene::rtScene()
+/// <summary>
+/// Builds a top level hierarchy on its own thread, from a copy of the
+/// packed bounds, so that frames can keep refitting the old one meanwhile.
+/// </summary>
+class rtSceneRebuild final : public skRunnable
 {
+private:
+    skArray<rtPackedBounds> m_bounds;
+    rtMeshBvh               m_bvh;
+    rtMeshBvh::BuildMode    m_mode;
+    std::atomic<bool>       m_done;
+
+public:
+    rtSceneRebuild(const rtPackedBounds* bounds, const SKuint32 count, const rtMeshBvh::BuildMode mode) :
+        m_mode(mode),
+        m_done(false)
+    {
+        m_bounds.resizeFast(count);
+        for (SKuint32 i = 0; i < count; ++i)
+            m_bounds[i] = bounds[i];
+    }
+
+    ~rtSceneRebuild() override = default;
+
+    int update() override
+    {
+        m_bvh.build(m_bounds.ptr(), m_bounds.size(), m_mode);
+        m_done.store(true);
+        return 0;
+    }
+
+    bool isDone() const
+    {
+        return m_done.load();
+    }
+
+    SKuint32 getCount() const
+    {
+        return m_bounds.size();
+    }
+
+    const rtMeshBvh& getBvh() const
+    {
+        return m_bvh;
+    }
+};
+
+rtScene::rtScene() :
+    m_arena(rtAllocator::createArena()),
+    m_rebuild(nullptr),
+    m_rebuildCount(0),
+    m_prebuilt({}),
+    m_hierarchyMode(rtMeshBvh::BM_SAH),
+    m_packedOutOfDate(true)
+{
+    rtArenaScope scope(m_arena);
+
     m_data              = rtAllocator::allocate<rtSceneType>();
     m_data->flags       = RM_COLOR_AND_LIGHT;
     m_data->camera      = nullptr;
@@ -38,6 +97,8 @@ rtScene::rtScene()
 
 rtScene::~rtScene()
 {
+    cancelRebuild();
+
     if (m_data)
     {
         rtAllocator::free<rtSceneType>(m_data);
@@ -50,14 +111,24 @@ rtScene::~rtScene()
     m_lights.clear();
     m_cameras.clear();
     m_meshes.clear();
+
+    // Everything allocated on behalf of this scene is released here at once.
+    delete m_arena;
 }
 
 void rtScene::addBoundingObject(rtBvObject* bvo)
 {
     if (bvo)
     {
+        rtArenaScope scope(m_arena);
+
+        bvo->m_index = getData().objects.size;
+
         getData().objects.push_back(bvo->getPtr());
         m_objects.push_back((rtObject*)bvo);
+        m_boundingVolumes.push_back(bvo);
+
+        m_packedOutOfDate = true;
     }
 }
 
@@ -83,12 +154,29 @@ void rtScene::addLight(rtLight* light)
 {
     if (light)
     {
+        rtArenaScope scope(m_arena);
+
         getData().lights.push_back(light->getPtr());
 
         m_objects.push_back((rtObject*)light);
     }
 }
 
+static bool rtIsBoundingType(const int type)
+{
+    switch (type)
+    {
+    case RT_AO_BVO:
+    case RT_AO_SHAPE_CUBE:
+    case RT_AO_SHAPE_SPHERE:
+    case RT_AO_SHAPE_PLANE:
+    case RT_AO_SHAPE_MESH:
+        return true;
+    default:
+        return false;
+    }
+}
+
 void rtScene::updateCaches()
 {
     if (!m_outOfDateTransforms.empty())
@@ -96,8 +184,259 @@ void rtScene::updateCaches()
         for (rtObject* element : m_outOfDateTransforms)
             element->update();
 
+        if (!m_packedOutOfDate)
+        {
+            m_movedBounds.resizeFast(0);
+            for (rtObject* element : m_outOfDateTransforms)
+            {
+                if (rtIsBoundingType(element->getType()))
+                {
+                    rtBvObject* bvo = (rtBvObject*)element;
+                    compileObject(bvo);
+                    m_movedBounds.push_back(bvo->getIndex());
+                }
+            }
+
+            if (!m_movedBounds.empty())
+            {
+                rtArenaScope scope(m_arena);
+                refitHierarchy();
+            }
+        }
+
         m_outOfDateTransforms.resizeFast(0);
     }
+
+    if (m_packedOutOfDate)
+    {
+        rtArenaScope scope(m_arena);
+        compile();
+    }
+}
+
+void rtScene::compile()
+{
+    typedef skHashTable<rtMaterialType*, SKuint32> MaterialLookup;
+    typedef skHashTable<rtMeshGeometry*, SKuint32> GeometryLookup;
+
+    rtPackedSceneType& packed = getData().packed;
+
+    const SKuint32 count = m_boundingVolumes.size();
+
+    packed.bounds.clear();
+    packed.types.clear();
+    packed.params.clear();
+    packed.materials.clear();
+    packed.materialTable.clear();
+    packed.instances.clear();
+    packed.geometries.clear();
+
+    packed.bounds.resize(count);
+    packed.types.resize(count);
+    packed.params.resize(count);
+    packed.materials.resize(count);
+    packed.instances.resize(count);
+
+    MaterialLookup lookup;
+    GeometryLookup geometries;
+
+    for (SKuint32 i = 0; i < count; ++i)
+    {
+        const rtObjectType* obj = m_boundingVolumes.at(i)->getPtr();
+        SK_ASSERT(m_boundingVolumes.at(i)->getIndex() == i);
+
+        SKuint32     material = 0;
+        const SKsize pos      = lookup.find(obj->material);
+        if (pos != SK_NPOS)
+            material = lookup.at(pos);
+        else
+        {
+            material = packed.materialTable.size;
+            packed.materialTable.push_back(*obj->material);
+            lookup.insert(obj->material, material);
+        }
+        packed.materials.data[i] = material;
+
+        // Meshes that share geometry share a single packed entry,
+        // so its triangles and hierarchy are only stored once.
+        SKuint32 geometry = SK_NPOS32;
+        if (obj->type == RT_AO_SHAPE_MESH)
+        {
+            rtMesh* mesh = (rtMesh*)m_boundingVolumes.at(i);
+
+            rtMeshGeometry* source = mesh->getGeometry();
+            const SKsize    found  = geometries.find(source);
+            if (found != SK_NPOS)
+                geometry = geometries.at(found);
+            else
+            {
+                geometry = packed.geometries.size;
+                packed.geometries.push_back({source->getView(), &source->getBvh()});
+                geometries.insert(source, geometry);
+            }
+
+            // The geometry may have changed since the mesh's
+            // transform was last updated.
+            mesh->updateBounds();
+        }
+        packed.instances.data[i].geometry = geometry;
+
+        compileObject(m_boundingVolumes.at(i));
+    }
+
+    compileHierarchy();
+    m_packedOutOfDate = false;
+}
+
+void rtScene::compileObject(rtBvObject* bvo)
+{
+    rtPackedSceneType& packed = getData().packed;
+
+    const SKuint32 i = bvo->getIndex();
+    if (i >= packed.bounds.size)
+        return;
+
+    const rtObjectType* obj = bvo->getPtr();
+
+    rtPackedBounds& bounds = packed.bounds.data[i];
+    bounds.bMin[0]         = obj->bounds.bMin[0];
+    bounds.bMin[1]         = obj->bounds.bMin[1];
+    bounds.bMin[2]         = obj->bounds.bMin[2];
+    bounds.bMax[0]         = obj->bounds.bMax[0];
+    bounds.bMax[1]         = obj->bounds.bMax[1];
+    bounds.bMax[2]         = obj->bounds.bMax[2];
+
+    packed.types.data[i] = obj->type;
+
+    if (obj->type == RT_AO_SHAPE_SPHERE && obj->bounds.data)
+    {
+        const rtSphereVolume* sphere = (const rtSphereVolume*)obj->bounds.data;
+
+        packed.params.data[i] = {
+            sphere->center.x,
+            sphere->center.y,
+            sphere->center.z,
+            sphere->radius,
+        };
+    }
+
+    packed.materialTable.data[packed.materials.data[i]] = *obj->material;
+
+    rtPackedInstance& instance = packed.instances.data[i];
+    if (instance.geometry != SK_NPOS32)
+    {
+        skMatrix3 rotation;
+        rotation.fromQuat(skQuaternion(obj->rotation.w,
+                                       obj->rotation.x,
+                                       obj->rotation.y,
+                                       obj->rotation.z));
+
+        // The inverse of a rotation is its transpose.
+        for (int r = 0; r < 3; ++r)
+        {
+            for (int c = 0; c < 3; ++c)
+                instance.rotation[r][c] = rotation.m[c][r];
+        }
+
+        instance.location[0] = obj->location.x;
+        instance.location[1] = obj->location.y;
+        instance.location[2] = obj->location.z;
+        instance.scale[0]    = obj->scale.x;
+        instance.scale[1]    = obj->scale.y;
+        instance.scale[2]    = obj->scale.z;
+    }
+}
+
+void rtScene::compileHierarchy()
+{
+    // Any rebuild in flight was started from bounds that are now out of date.
+    cancelRebuild();
+
+    const rtPackedSceneType& packed = getData().packed;
+
+    // A supplied hierarchy is only good for the objects that it was
+    // built over, so it is not looked at again after the first compile.
+    const bool adopted = m_prebuilt.nodes &&
+                         m_objectBvh.adopt(m_prebuilt, packed.bounds.data, packed.bounds.size);
+    m_prebuilt = {};
+
+    if (!adopted)
+        m_objectBvh.build(packed.bounds.data, packed.bounds.size, m_hierarchyMode);
+    publishHierarchy(true);
+}
+
+void rtScene::refitHierarchy()
+{
+    const rtPackedSceneType& packed = getData().packed;
+
+    if (m_rebuild && m_rebuild->isDone())
+    {
+        m_rebuild->join();
+
+        // The hierarchy was built from the bounds as they were when it
+        // started, so it is refit to every object that moved since.
+        const bool current = m_rebuild->getCount() == packed.bounds.size;
+        if (current)
+        {
+            m_objectBvh = m_rebuild->getBvh();
+            m_objectBvh.refit(packed.bounds.data);
+            ++m_rebuildCount;
+        }
+
+        delete m_rebuild;
+        m_rebuild = nullptr;
+
+        if (current)
+        {
+            publishHierarchy(true);
+            return;
+        }
+    }
+
+    m_objectBvh.refit(packed.bounds.data, m_movedBounds.ptr(), m_movedBounds.size());
+    publishHierarchy(false);
+
+    if (!m_rebuild && m_objectBvh.getCost() > m_objectBvh.getBuildCost() * RebuildRatio)
+    {
+        m_rebuild = new rtSceneRebuild(packed.bounds.data, packed.bounds.size, m_hierarchyMode);
+        m_rebuild->start();
+    }
+}
+
+void rtScene::publishHierarchy(const bool order)
+{
+    rtPackedSceneType& packed = getData().packed;
+
+    const rtMeshBvh::View& bvh = m_objectBvh.getView();
+
+    // A refit leaves the order and the number of nodes as they were,
+    // so the nodes can be copied over the ones that are already there.
+    if (!order && packed.nodes.size == bvh.nodeCount)
+    {
+        memcpy(packed.nodes.data, bvh.nodes, (SKsize)bvh.nodeCount * sizeof(rtPackedNode));
+        return;
+    }
+
+    packed.nodes.resize(0);
+    packed.order.resize(0);
+    packed.nodes.append(bvh.nodes, bvh.nodeCount);
+    packed.order.append(bvh.triangles, bvh.triangleCount);
+}
+
+void rtScene::waitForRebuild()
+{
+    if (m_rebuild)
+        m_rebuild->join();
+}
+
+void rtScene::cancelRebuild()
+{
+    if (m_rebuild)
+    {
+        m_rebuild->join();
+        delete m_rebuild;
+        m_rebuild = nullptr;
+    }
 }
 
 void rtScene::pushOutOfDate(rtObject* node)
@@ -32,10 +32,12 @@
 #include "Utils/skArray.h"
 
 struct rtSceneType;
+class rtArena;
 class rtPlane;
 class rtSphere;
 class rtCube;
 class rtOctree;
+class rtSceneRebuild;
 
 /// <summary>
 /// rtScene is defined as a container for rtObject types
@@ -48,6 +50,14 @@ public:
     typedef skArray<rtLight*>    LightArray;
     typedef skArray<rtMesh*>     MeshArray;
     typedef skArray<rtBvObject*> BoundingVolumeArray;
+    typedef skArray<SKuint32>    IndexArray;
+
+    /// <summary>
+    /// How much worse than when it was built the top level hierarchy's
+    /// surface area cost is allowed to get from refitting, before a
+    /// new one is built in the background.
+    /// </summary>
+    static constexpr skScalar RebuildRatio = skScalar(1.5);
 
 protected:
     /// <summary>
@@ -57,13 +67,56 @@ protected:
 
     ObjectArray m_outOfDateTransforms;
 
-    MeshArray           m_meshes;
-    LightArray          m_lights;
-    CameraArray         m_cameras;
-    BoundingVolumeArray m_boundingVolumes;
-    skColor             m_horizon;
-    skColor             m_zenith;
-    rtSceneType*        m_data;
+    MeshArray            m_meshes;
+    LightArray           m_lights;
+    CameraArray          m_cameras;
+    BoundingVolumeArray  m_boundingVolumes;
+    skColor              m_horizon;
+    skColor              m_zenith;
+    rtSceneType*         m_data;
+    rtArena*             m_arena;
+    rtMeshBvh            m_objectBvh;
+    IndexArray           m_movedBounds;
+    rtSceneRebuild*      m_rebuild;
+    SKuint32             m_rebuildCount;
+    rtMeshBvh::View      m_prebuilt;
+    rtMeshBvh::BuildMode m_hierarchyMode;
+    bool                 m_packedOutOfDate;
+
+    /// <summary>
+    /// Rebuilds every array in rtSceneType::packed.
+    /// </summary>
+    void compile();
+
+    /// <summary>
+    /// Refreshes the packed entry of a single object.
+    /// </summary>
+    /// <param name="bvo">An object that was previously compiled.</param>
+    void compileObject(rtBvObject* bvo);
+
+    /// <summary>
+    /// Rebuilds the top level hierarchy over the packed bounds, or adopts
+    /// the one set with setPrebuiltHierarchy, and copies it into rtSceneType::packed.
+    /// </summary>
+    void compileHierarchy();
+
+    /// <summary>
+    /// Refits the top level hierarchy to the objects in m_movedBounds,
+    /// and copies it into rtSceneType::packed. It also starts a rebuild
+    /// when the hierarchy has degraded, and swaps in a finished one.
+    /// </summary>
+    void refitHierarchy();
+
+    /// <summary>
+    /// Copies m_objectBvh into rtSceneType::packed.
+    /// </summary>
+    /// <param name="order">Also copy the order of the leaves.</param>
+    void publishHierarchy(bool order);
+
+    /// <summary>
+    /// Waits for a background rebuild to finish, then discards it.
+    /// </summary>
+    void cancelRebuild();
 
 public:
     rtScene();
@@ -87,6 +140,56 @@ public:
     /// <returns></returns>
     const rtSceneType& getData() const;
 
+    /// <summary>
+    /// Returns the arena that holds this scene's kernel data.
+    /// </summary>
+    /// <returns>The arena, or null when the backend is not RT_CPU_ARENA.</returns>
+    rtArena* getArena() const;
+
+    /// <summary>
+    /// Returns the top level hierarchy over the bounds of the objects,
+    /// as of the last call to updateCaches.
+    /// </summary>
+    const rtMeshBvh& getHierarchy() const;
+
+    /// <summary>
+    /// Sets the way the top level hierarchy is built. It takes effect
+    /// the next time the hierarchy is built, rather than refit.
+    /// </summary>
+    void setHierarchyBuildMode(rtMeshBvh::BuildMode mode);
+
+    /// <summary>
+    /// Returns the way the top level hierarchy is built. The default is BM_SAH.
+    /// </summary>
+    rtMeshBvh::BuildMode getHierarchyBuildMode() const;
+
+    /// <summary>
+    /// Returns the number of background rebuilds of the top level
+    /// hierarchy that have been swapped in since the scene was created.
+    /// </summary>
+    SKuint32 getRebuildCount() const;
+
+    /// <summary>
+    /// Returns true from the time a background rebuild of the top level
+    /// hierarchy is started, until it is swapped in or discarded.
+    /// </summary>
+    bool isRebuilding() const;
+
+    /// <summary>
+    /// Waits for a background rebuild, if one is running, to finish building.
+    /// The next call to updateCaches that refits the hierarchy swaps it in.
+    /// </summary>
+    void waitForRebuild();
+
+    /// <summary>
+    /// Supplies a top level hierarchy that was built before, such as one
+    /// read from a file, to be copied the next time the scene is compiled
+    /// in place of building one. It is only used if it covers every object,
+    /// and is refit to their bounds when it is copied.
+    /// </summary>
+    /// <param name="hierarchy">The nodes, and the object numbers as the triangle order.</param>
+    void setPrebuiltHierarchy(const rtMeshBvh::View& hierarchy);
+
     /// <summary>
     ///
     /// </summary>
@@ -160,8 +263,15 @@ public:
     void addLight(rtLight* light);
 
     /// <summary>
-    ///
+    /// Updates any out of date transforms, then compiles
+    /// their changes into the packed kernel data.
     /// </summary>
+    /// <remarks>
+    /// The packed data is fully rebuilt only when objects have been
+    /// added since the last call, otherwise only the entries of the
+    /// objects that changed are refreshed, and the top level hierarchy
+    /// is refit above them rather than rebuilt.
+    /// </remarks>
     void updateCaches();
 
     /// <summary>
@@ -203,6 +313,16 @@ SK_INLINE rtSceneType* rtScene::getPtr() const
     return m_data;
 }
 
+SK_INLINE SKuint32 rtScene::getRebuildCount() const
+{
+    return m_rebuildCount;
+}
+
+SK_INLINE bool rtScene::isRebuilding() const
+{
+    return m_rebuild != nullptr;
+}
+
 SK_INLINE rtSceneType& rtScene::getData()
 {
     SK_ASSERT(m_data);
@@ -215,6 +335,31 @@ SK_INLINE const rtSceneType& rtScene::getData() const
     return *m_data;
 }
 
+SK_INLINE rtArena* rtScene::getArena() const
+{
+    return m_arena;
+}
+
+SK_INLINE const rtMeshBvh& rtScene::getHierarchy() const
+{
+    return m_objectBvh;
+}
+
+SK_INLINE void rtScene::setHierarchyBuildMode(const rtMeshBvh::BuildMode mode)
+{
+    m_hierarchyMode = mode;
+}
+
+SK_INLINE rtMeshBvh::BuildMode rtScene::getHierarchyBuildMode() const
+{
+    return m_hierarchyMode;
+}
+
+SK_INLINE void rtScene::setPrebuiltHierarchy(const rtMeshBvh::View& hierarchy)
+{
+    m_prebuilt = hierarchy;
+}
+
 SK_INLINE rtScene::ObjectArray& rtScene::getObjects()
 {
     return m_objects;
@@ -22,10 +22,13 @@
 #include "rtSphere.h"
 #include "Cpu/rtCpuMath.h"
 #include "Data/rtAllocator.h"
+#include "rtScene.h"
 
 rtSphere::rtSphere(rtScene* sc) :
     rtBvObject(sc)
 {
+    rtArenaScope scope(sc ? sc->getArena() : nullptr);
+
     m_sphere = rtAllocator::allocate<rtSphereVolume>();
 
     m_sphere->center = {0, 0, 0};
@@ -44,6 +44,8 @@ public:
 
     void setRadius(const skScalar& radius) const;
 
+    skScalar getRadius() const;
+
     skBoundingSphere getBoundingSphere() const;
 };
 /*! @} */
@@ -58,6 +60,11 @@ SK_INLINE void rtSphere::setRadius(const skScalar& radius) const
     m_sphere->radius = radius;
 }
 
+SK_INLINE skScalar rtSphere::getRadius() const
+{
+    return m_sphere->radius;
+}
+
 SK_INLINE skBoundingSphere rtSphere::getBoundingSphere() const
 {
     return {m_derived.location, m_sphere->radius};
@@ -24,6 +24,8 @@
 #ifndef _rtTarget_h_
 #define _rtTarget_h_
 
+#include "Utils/Config/skConfig.h"
+
 /// <summary>
 /// Structure to hold information about a frame buffer.
 /// </summary>
@@ -39,24 +41,38 @@ struct rtFrameBufferInfo
     /// <summary>
     /// The total width of the buffer.
     /// </summary>
-    SKuint16 width;
+    SKuint32 width;
 
     /// <summary>
-    /// The total height of the buffer.
+    /// The total height of the image.
     /// </summary>
-    SKuint16 height;
+    SKuint32 height;
 
     /// <summary>
     /// The pitch or the step in y for the buffer.
     /// width * 4
     /// </summary>
-    SKuint16 pitch;
+    SKuint32 pitch;
 
     /// <summary>
     /// The total size in bytes of the buffer.
-    /// Set to width * height * 4
+    /// Set to pitch * the number of resident rows.
+    /// </summary>
+    SKsize maxSize;
+
+    /// <summary>
+    /// The image row stored at the start of pixels.
+    /// This is zero unless the target only keeps a band of
+    /// rows resident, see rtTarget::getBandHeight.
     /// </summary>
-    SKuint32 maxSize;
+    SKuint32 offsetY;
+
+    /// <summary>
+    /// Set when rows are stored from the bottom of the image up,
+    /// as they are in a FreeImage bitmap. Bottom up buffers keep
+    /// the whole image resident, so offsetY must be zero.
+    /// </summary>
+    bool bottomUp;
 };
 
 
@@ -93,13 +109,39 @@ public:
     /// Gets total memory for the target.
     /// </summary>
     /// <returns>The W*H*4 </returns>
-    virtual SKuint32 getSizeInBytes() = 0;
+    virtual SKsize getSizeInBytes() = 0;
 
     /// <summary>
     /// 
     /// </summary>
     /// <returns></returns>
     virtual const rtFrameBufferInfo& getFrameBufferInfo() = 0;
+
+    /// <summary>
+    /// Gets the number of image rows the frame buffer can hold at once.
+    /// </summary>
+    /// <returns>The band height, by default the full height.</returns>
+    virtual SKuint32 getBandHeight()
+    {
+        return getHeight();
+    }
+
+    /// <summary>
+    /// Makes the frame buffer refer to a band of the image
+    /// before any rows in it are rendered.
+    /// </summary>
+    /// <param name="y">The first image row in the band.</param>
+    /// <param name="rows">The number of rows, which is at most getBandHeight.</param>
+    virtual void lockBand(SKuint32 y, SKuint32 rows)
+    {
+    }
+
+    /// <summary>
+    /// Called once every row in the locked band has been rendered.
+    /// </summary>
+    virtual void unlockBand()
+    {
+    }
 };
 /*! @} */
 
@@ -0,0 +1,233 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "rtTaskPool.h"
+#include <atomic>
+#include <thread>
+#include "Threads/skCriticalSection.h"
+#include "Threads/skSemaphore.h"
+#include "Threads/skThread.h"
+#include "Utils/skArray.h"
+#include "Utils/skMinMax.h"
+
+// Set while a thread is running a pooled task's items.
+static thread_local bool rtTaskPoolActive = false;
+
+// Set while a task holds the pool's threads.
+static std::atomic<bool> rtTaskPoolBusy(false);
+
+/// <summary>
+/// A pool thread. It is started once and then waits for tasks,
+/// taking items from a shared counter until there are none left.
+/// </summary>
+class rtTaskWorker final : public skRunnable
+{
+private:
+    rtTask*                m_task;
+    std::atomic<SKuint32>* m_next;
+    SKuint32               m_count;
+    skCriticalSection      m_cs;
+    skSemaphore            m_wake;
+    skSemaphore            m_done;
+    bool                   m_pending;
+    bool                   m_finished;
+    bool                   m_quit;
+
+public:
+    rtTaskWorker() :
+        m_task(nullptr),
+        m_next(nullptr),
+        m_count(0),
+        m_pending(false),
+        m_finished(false),
+        m_quit(false)
+    {
+    }
+
+    ~rtTaskWorker() override = default;
+
+    static void run(rtTask* task, std::atomic<SKuint32>& next, const SKuint32 count)
+    {
+        for (;;)
+        {
+            const SKuint32 i = next.fetch_add(1);
+            if (i >= count)
+                break;
+            task->execute(i);
+        }
+    }
+
+    /// <summary>
+    /// Hands a task to the worker's thread.
+    /// </summary>
+    void dispatch(rtTask* task, std::atomic<SKuint32>* next, const SKuint32 count)
+    {
+        m_cs.lock();
+        m_task     = task;
+        m_next     = next;
+        m_count    = count;
+        m_pending  = true;
+        m_finished = false;
+        m_cs.unlock();
+
+        m_wake.signal();
+    }
+
+    /// <summary>
+    /// Blocks until the last dispatched task has run out of items.
+    /// </summary>
+    void complete()
+    {
+        // The semaphores do not start at zero,
+        // so the state is checked on every wake up.
+        for (;;)
+        {
+            m_cs.lock();
+            const bool finished = m_finished;
+            m_cs.unlock();
+
+            if (finished)
+                return;
+            m_done.wait();
+        }
+    }
+
+    /// <summary>
+    /// Stops the worker's thread and joins it.
+    /// </summary>
+    void quit()
+    {
+        m_cs.lock();
+        m_quit = true;
+        m_cs.unlock();
+
+        m_wake.signal();
+        join();
+    }
+
+    int update() override
+    {
+        rtTaskPoolActive = true;
+
+        for (;;)
+        {
+            m_wake.wait();
+
+            m_cs.lock();
+            if (m_quit)
+            {
+                m_cs.unlock();
+                return 0;
+            }
+            const bool pending = m_pending;
+            m_pending          = false;
+            m_cs.unlock();
+
+            if (!pending)
+                continue;
+
+            run(m_task, *m_next, m_count);
+
+            m_cs.lock();
+            m_finished = true;
+            m_cs.unlock();
+
+            m_done.signal();
+        }
+    }
+};
+
+/// <summary>
+/// Owns the pool's threads and stops them when the program exits.
+/// </summary>
+class rtTaskWorkers
+{
+private:
+    skArray<rtTaskWorker*> m_workers;
+
+public:
+    rtTaskWorkers() = default;
+
+    ~rtTaskWorkers()
+    {
+        for (rtTaskWorker* worker : m_workers)
+        {
+            worker->quit();
+            delete worker;
+        }
+    }
+
+    /// <summary>
+    /// Starts threads until there are at least count of them.
+    /// </summary>
+    void reserve(const SKuint32 count)
+    {
+        while (m_workers.size() < count)
+        {
+            rtTaskWorker* worker = new rtTaskWorker();
+            worker->start();
+            m_workers.push_back(worker);
+        }
+    }
+
+    rtTaskWorker* operator[](const SKuint32 index) const
+    {
+        return m_workers[index];
+    }
+};
+
+// Only touched by the thread that holds rtTaskPoolBusy.
+static rtTaskWorkers rtTaskPoolWorkers;
+
+void rtTaskPool::execute(rtTask* task, const SKuint32 count, SKuint32 threads)
+{
+    if (!task || count == 0)
+        return;
+
+    if (threads == 0)
+        threads = skMax<SKuint32>(1, std::thread::hardware_concurrency());
+    threads = skMin<SKuint32>(threads, count);
+
+    std::atomic<SKuint32> next(0);
+
+    bool idle = false;
+    if (threads == 1 || rtTaskPoolActive || !rtTaskPoolBusy.compare_exchange_strong(idle, true))
+    {
+        rtTaskWorker::run(task, next, count);
+        return;
+    }
+
+    // The calling thread is one of the workers.
+    const SKuint32 helpers = threads - 1;
+    rtTaskPoolWorkers.reserve(helpers);
+
+    for (SKuint32 i = 0; i < helpers; ++i)
+        rtTaskPoolWorkers[i]->dispatch(task, &next, count);
+
+    rtTaskPoolActive = true;
+    rtTaskWorker::run(task, next, count);
+    rtTaskPoolActive = false;
+
+    for (SKuint32 i = 0; i < helpers; ++i)
+        rtTaskPoolWorkers[i]->complete();
+
+    rtTaskPoolBusy.store(false);
+}
@@ -0,0 +1,78 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+/*! \addtogroup FrontEnd
+ * @{
+ */
+#ifndef _rtTaskPool_h_
+#define _rtTaskPool_h_
+
+#include "Utils/Config/skConfig.h"
+
+/// <summary>
+/// Work that is shared out over the pool's threads by index.
+/// </summary>
+class rtTask
+{
+public:
+    virtual ~rtTask() = default;
+
+    /// <summary>
+    /// Processes a single item. This is called from more than one
+    /// thread at a time, so it may only touch the item's own data.
+    /// </summary>
+    virtual void execute(SKuint32 index) = 0;
+};
+
+/// <summary>
+/// A process wide set of worker threads that loaders and
+/// hierarchy builds share their work out over.
+/// </summary>
+/// <remarks>
+/// The threads are started the first time they are needed and
+/// then wait for work until the program exits, so repeated calls
+/// do not pay for starting threads.
+/// </remarks>
+class rtTaskPool
+{
+public:
+    /// <summary>
+    /// Runs every item of a task on the pool's threads, then waits for them.
+    /// </summary>
+    /// <remarks>
+    /// Items are handed out one at a time in index order, so a
+    /// task should order its largest items first. The calling
+    /// thread takes items too.
+    ///
+    /// The pool runs one task at a time. A call made from inside
+    /// an item, or while another thread's task holds the pool,
+    /// runs all of its items on the calling thread instead, so
+    /// nested work never starts more threads than the pool has.
+    /// </remarks>
+    /// <param name="task">The work to run.</param>
+    /// <param name="count">The number of items.</param>
+    /// <param name="threads">The most threads to use, or zero for one per core.</param>
+    static void execute(rtTask* task, SKuint32 count, SKuint32 threads = 0);
+};
+
+/*! @} */
+
+#endif  //_rtTaskPool_h_
@@ -0,0 +1,233 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "rtTiledImageTarget.h"
+#include <cstdio>
+#include "Threads/skCriticalSection.h"
+#include "Threads/skSemaphore.h"
+#include "Threads/skThread.h"
+#include "Utils/skArray.h"
+#include "Utils/skMinMax.h"
+#include "Utils/skQueue.h"
+#include "rtImageWriter.h"
+
+/// <summary>
+/// Encodes finished bands on its own thread, so the render
+/// threads can fill the next band while the last one is written.
+/// </summary>
+class rtBandWriter final : public skRunnable
+{
+private:
+    struct Band
+    {
+        SKubyte* pixels;
+        SKuint32 rows;
+    };
+
+    rtImageWriter*     m_writer;
+    SKuint32           m_pitch;
+    skCriticalSection  m_cs;
+    skSemaphore        m_pending;
+    skSemaphore        m_released;
+    skQueue<Band>      m_queue;
+    skArray<SKubyte*>  m_free;
+    bool               m_stop;
+    bool               m_failed;
+
+public:
+    rtBandWriter(rtImageWriter* writer, SKubyte** bands, const SKuint32 count, const SKuint32 pitch) :
+        m_writer(writer),
+        m_pitch(pitch),
+        m_stop(false),
+        m_failed(false)
+    {
+        m_queue.reserve(count + 1);
+        for (SKuint32 i = 0; i < count; ++i)
+            m_free.push_back(bands[i]);
+    }
+
+    ~rtBandWriter() override
+    {
+        delete m_writer;
+    }
+
+    /// <summary>
+    /// Blocks until a band buffer has been written and can be reused.
+    /// </summary>
+    SKubyte* acquire()
+    {
+        for (;;)
+        {
+            m_cs.lock();
+            if (!m_free.empty())
+            {
+                SKubyte* band = m_free.back();
+                m_free.pop_back();
+                m_cs.unlock();
+                return band;
+            }
+            m_cs.unlock();
+
+            m_released.wait();
+        }
+    }
+
+    void submit(SKubyte* pixels, const SKuint32 rows)
+    {
+        m_cs.lock();
+        m_queue.enqueue({pixels, rows});
+        m_cs.unlock();
+
+        m_pending.signal();
+    }
+
+    /// <summary>
+    /// Writes any queued bands, stops the thread and closes the file.
+    /// </summary>
+    /// <returns>False if any band or the file itself failed to write.</returns>
+    bool finish()
+    {
+        m_cs.lock();
+        m_stop = true;
+        m_cs.unlock();
+
+        m_pending.signal();
+        join();
+
+        const bool closed = m_writer->close();
+        return closed && !m_failed;
+    }
+
+    int update() override
+    {
+        for (;;)
+        {
+            m_pending.wait();
+
+            for (;;)
+            {
+                m_cs.lock();
+                if (m_queue.empty())
+                {
+                    const bool stop = m_stop;
+                    m_cs.unlock();
+
+                    if (stop)
+                        return 0;
+                    break;
+                }
+                const Band band = m_queue.dequeue();
+                m_cs.unlock();
+
+                if (!m_failed && !m_writer->writeRows(band.pixels, m_pitch, band.rows))
+                    m_failed = true;
+
+                m_cs.lock();
+                m_free.push_back(band.pixels);
+                m_cs.unlock();
+
+                m_released.signal();
+            }
+        }
+    }
+};
+
+rtTiledImageTarget::rtTiledImageTarget(SKuint32 w, SKuint32 h, SKuint32 bandHeight) :
+    m_frameBuffer(),
+    m_bandHeight(skClamp<SKuint32>(bandHeight, 1, skMax<SKuint32>(h, 1))),
+    m_bands(),
+    m_writer(nullptr)
+{
+    m_frameBuffer.width    = w;
+    m_frameBuffer.height   = h;
+    m_frameBuffer.pitch    = w * 4;
+    m_frameBuffer.maxSize  = (SKsize)m_frameBuffer.pitch * m_bandHeight;
+    m_frameBuffer.offsetY  = 0;
+    m_frameBuffer.bottomUp = false;
+
+    for (SKubyte*& band : m_bands)
+        band = new SKubyte[m_frameBuffer.maxSize];
+
+    // lockBand swaps in whichever buffer is free
+    m_frameBuffer.pixels = m_bands[0];
+}
+
+rtTiledImageTarget::~rtTiledImageTarget()
+{
+    close();
+
+    for (const SKubyte* band : m_bands)
+        delete[] band;
+}
+
+bool rtTiledImageTarget::open(const char* path)
+{
+    close();
+
+    rtImageWriter* writer = rtImageWriter::create(path);
+    if (!writer)
+    {
+        printf("Unsupported image type '%s', expected .ppm or .png.\n", path);
+        return false;
+    }
+
+    if (!writer->open(path, m_frameBuffer.width, m_frameBuffer.height))
+    {
+        printf("Failed to open '%s' for writing.\n", path);
+        delete writer;
+        return false;
+    }
+
+    m_writer = new rtBandWriter(writer, m_bands, BandCount, m_frameBuffer.pitch);
+    m_writer->start();
+    return true;
+}
+
+bool rtTiledImageTarget::close()
+{
+    if (!m_writer)
+        return true;
+
+    const bool result = m_writer->finish();
+    if (!result)
+        printf("Failed to write the image.\n");
+
+    delete m_writer;
+    m_writer = nullptr;
+    return result;
+}
+
+void rtTiledImageTarget::lockBand(const SKuint32 y, const SKuint32 rows)
+{
+    SK_ASSERT(rows <= m_bandHeight);
+
+    if (m_writer)
+        m_frameBuffer.pixels = m_writer->acquire();
+
+    m_frameBuffer.offsetY = y;
+    m_frameBuffer.maxSize = (SKsize)m_frameBuffer.pitch * skMin(rows, m_bandHeight);
+}
+
+void rtTiledImageTarget::unlockBand()
+{
+    if (m_writer)
+        m_writer->submit(m_frameBuffer.pixels, (SKuint32)(m_frameBuffer.maxSize / m_frameBuffer.pitch));
+}
@@ -0,0 +1,153 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+/*! \addtogroup FrontEnd
+ * @{
+ */
+
+#ifndef _rtTiledImageTarget_h_
+#define _rtTiledImageTarget_h_
+
+#include "RenderSystem/rtTarget.h"
+
+class rtBandWriter;
+
+/// <summary>
+/// Implementation of the rtTarget class for images that are too
+/// large to keep in memory. Two bands of rows are resident: while
+/// one is rendered, the other is encoded to a PPM or PNG file on a
+/// writer thread.
+/// </summary>
+class rtTiledImageTarget : public rtTarget
+{
+private:
+    static const SKuint32 BandCount = 2;
+
+    rtFrameBufferInfo m_frameBuffer;
+    SKuint32          m_bandHeight;
+    SKubyte*          m_bands[BandCount];
+    rtBandWriter*     m_writer;
+
+public:
+    /// <summary>
+    ///
+    /// </summary>
+    /// <param name="w">The width of the full image.</param>
+    /// <param name="h">The height of the full image.</param>
+    /// <param name="bandHeight">The number of rows kept in memory.</param>
+    rtTiledImageTarget(SKuint32 w, SKuint32 h, SKuint32 bandHeight = 256);
+
+    ~rtTiledImageTarget() override;
+
+    /// <summary>
+    /// Creates the output file and starts the writer thread.
+    /// </summary>
+    /// <param name="path">The file-system path of a .ppm or .png file.</param>
+    /// <returns>True if the file was created.</returns>
+    bool open(const char* path);
+
+    /// <summary>
+    /// Waits for the pending bands to be encoded and closes the output file.
+    /// </summary>
+    /// <returns>False if any part of the image failed to write.</returns>
+    bool close();
+
+    /// <summary>
+    ///
+    /// </summary>
+    /// <returns></returns>
+    SKuint32 getWidth() override;
+
+    /// <summary>
+    ///
+    /// </summary>
+    /// <returns></returns>
+    SKuint32 getHeight() override;
+
+    /// <summary>
+    /// Returns the size of the resident band.
+    /// </summary>
+    /// <returns></returns>
+    SKsize getSizeInBytes() override;
+
+    /// <summary>
+    ///
+    /// </summary>
+    /// <returns></returns>
+    SKuint32 getPitch() override;
+
+    /// <summary>
+    ///
+    /// </summary>
+    /// <returns></returns>
+    const rtFrameBufferInfo& getFrameBufferInfo() override;
+
+    /// <summary>
+    ///
+    /// </summary>
+    /// <returns></returns>
+    SKuint32 getBandHeight() override;
+
+    /// <summary>
+    /// Waits until a band buffer is free to render into.
+    /// </summary>
+    /// <param name="y"></param>
+    /// <param name="rows"></param>
+    void lockBand(SKuint32 y, SKuint32 rows) override;
+
+    /// <summary>
+    /// Hands the finished band to the writer thread.
+    /// </summary>
+    void unlockBand() override;
+};
+/*! @} */
+
+SK_INLINE SKuint32 rtTiledImageTarget::getWidth()
+{
+    return m_frameBuffer.width;
+}
+
+SK_INLINE SKuint32 rtTiledImageTarget::getHeight()
+{
+    return m_frameBuffer.height;
+}
+
+SK_INLINE SKsize rtTiledImageTarget::getSizeInBytes()
+{
+    return (SKsize)m_frameBuffer.pitch * m_bandHeight;
+}
+
+SK_INLINE SKuint32 rtTiledImageTarget::getPitch()
+{
+    return m_frameBuffer.pitch;
+}
+
+SK_INLINE const rtFrameBufferInfo& rtTiledImageTarget::getFrameBufferInfo()
+{
+    return m_frameBuffer;
+}
+
+SK_INLINE SKuint32 rtTiledImageTarget::getBandHeight()
+{
+    return m_bandHeight;
+}
+
+#endif  //_rtTiledImageTarget_h_
@@ -0,0 +1,1048 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include "Math/skMath.h"
+#include "Math/skQuaternion.h"
+#include "Math/skRectangle.h"
+#include "RenderSystem/Cpu/rtCpuRenderSystem.h"
+#include "RenderSystem/Loader/Scene/rtSceneFileWriter.h"
+#include "RenderSystem/Loader/rtLoader.h"
+#include "RenderSystem/rtBufferTarget.h"
+#include "RenderSystem/rtCamera.h"
+#include "RenderSystem/rtCube.h"
+#include "RenderSystem/rtMesh.h"
+#include "RenderSystem/rtScene.h"
+#include "RenderSystem/rtSphere.h"
+#include "Utils/CommandLine/skCommandLineParser.h"
+#include "Utils/skFileStream.h"
+#include "Utils/skLogger.h"
+#include "Utils/skTimer.h"
+#include "bAscii/bAscii.h"
+#include "ftBlend.h"
+#include "ftStreams.h"
+
+using skCmd = skCommandLine::Parser;
+
+enum BenchmarkAppIds
+{
+    ID_BENCH,
+    ID_TRIANGLES,
+    ID_FILE,
+    ID_MAX,
+};
+
+const skCommandLine::Switch Switches[ID_MAX] = {
+    {
+        ID_BENCH,
+        'b',
+        "bench",
+        "Run a single benchmark.\n"
+        " - Where the value is one of the following values:\n"
+        "   - mesh: Mesh ingestion, vertex welding, views and the triangle hierarchy\n"
+        "   - region: Full frame and region of interest rendering\n"
+        "   - rays: Batched nearest hit and occlusion queries\n"
+        "   - inflate: Synchronous and read-ahead decompression of a gzip'd .blend\n"
+        "   - load: Loading a scene from its source and from a converted .rtscene\n"
+        "   - parse: Scanning and compiling a .bascii file\n"
+        "   - refit: Keeping the top level hierarchy up to date as objects move\n"
+        "   - build: Hierarchy build time and trace speed for each builder\n",
+        true,
+        1,
+    },
+    {
+        ID_TRIANGLES,
+        't',
+        "triangles",
+        "Specify the number of triangles to generate for the mesh and build benchmarks.\n"
+        " - The default is 1000000.\n",
+        true,
+        1,
+    },
+    {
+        ID_FILE,
+        'f',
+        "file",
+        "Specify the scene for the region, rays, inflate, load, parse and build benchmarks.\n"
+        " - Where the value is a .blend or .bascii file.\n",
+        true,
+        1,
+    },
+};
+
+class Benchmark
+{
+private:
+    skString m_bench;
+    skString m_file;
+    SKuint32 m_triangles;
+
+    static void report(const char* name, skTimer& timer, const rtMesh* mesh)
+    {
+        const double ms = (double)timer.getMicroseconds() / 1000.0;
+        printf("  %-24s %10.3f ms  %9u vertices %9u indices\n",
+               name,
+               ms,
+               mesh->getVertexCount(),
+               mesh->getIndexCount());
+    }
+
+    void benchMesh() const
+    {
+        // A regular grid gives a known number of unique vertices,
+        // each of which is shared by up to six triangles.
+        const SKuint32 n  = skMax<SKuint32>(1, (SKuint32)skSqrt((skScalar)m_triangles / 2));
+        const SKuint32 n1 = n + 1;
+
+        rtMesh::Vertices grid;
+        rtMesh::Indices  indices;
+        rtMesh::Vertices soup;
+
+        grid.reserve(n1 * n1);
+        for (SKuint32 y = 0; y < n1; ++y)
+        {
+            for (SKuint32 x = 0; x < n1; ++x)
+                grid.push_back(skVector3((skScalar)x, (skScalar)y, 0));
+        }
+
+        indices.reserve(n * n * 6);
+        soup.reserve(n * n * 6);
+        for (SKuint32 y = 0; y < n; ++y)
+        {
+            for (SKuint32 x = 0; x < n; ++x)
+            {
+                const SKuint32 i0 = y * n1 + x;
+                const SKuint32 i1 = i0 + 1;
+                const SKuint32 i2 = i0 + n1 + 1;
+                const SKuint32 i3 = i0 + n1;
+
+                const SKuint32 tri[6] = {i0, i1, i2, i2, i3, i0};
+                for (SKuint32 i : tri)
+                {
+                    indices.push_back(i);
+                    soup.push_back(grid[i]);
+                }
+            }
+        }
+
+        printf("mesh: %u triangles, %u unique vertices\n", indices.size() / 3, grid.size());
+
+        rtScene scene;
+        skTimer timer;
+
+        rtMesh* mesh = new rtMesh(&scene);
+        scene.addMesh(mesh);
+
+        timer.reset();
+        mesh->beginAddTriangles();
+        for (SKuint32 i = 0; i < indices.size(); i += 3)
+        {
+            mesh->addTriangle(indices[i],
+                              indices[i + 1],
+                              indices[i + 2],
+                              grid[indices[i]],
+                              grid[indices[i + 1]],
+                              grid[indices[i + 2]]);
+        }
+        mesh->endAddTriangles();
+        report("addTriangle", timer, mesh);
+
+        timer.reset();
+        mesh->beginAddTriangles();
+        mesh->addIndexedTriangles(grid.ptr(), grid.size(), indices.ptr(), indices.size());
+        mesh->endAddTriangles();
+        report("addIndexedTriangles", timer, mesh);
+
+        timer.reset();
+        mesh->beginAddTriangles();
+        mesh->addTriangleSoup(soup.ptr(), soup.size(), 0);
+        mesh->endAddTriangles();
+        report("addTriangleSoup (exact)", timer, mesh);
+
+        timer.reset();
+        mesh->beginAddTriangles();
+        mesh->addTriangleSoup(soup.ptr(), soup.size(), skScalar(0.01));
+        mesh->endAddTriangles();
+        report("addTriangleSoup (0.01)", timer, mesh);
+
+        // The same grid referenced in place rather than copied.
+        const rtMeshView view = {
+            (const SKubyte*)grid.ptr(),
+            grid.size(),
+            (SKuint32)sizeof(skVector3),
+            (const SKubyte*)indices.ptr(),
+            indices.size(),
+            (SKuint32)sizeof(SKuint32),
+        };
+
+        timer.reset();
+        mesh->setView(view);
+        report("setView", timer, mesh);
+
+        // Every call above includes building the hierarchy, which
+        // is timed on its own here.
+        rtMeshBvh bvh;
+        timer.reset();
+        bvh.build(mesh->getView(), mesh->getBuildMode());
+
+        printf("  %-24s %10.3f ms  %9u nodes     %9.2f MB\n",
+               "triangle bvh",
+               (double)timer.getMicroseconds() / 1000.0,
+               bvh.getView().nodeCount,
+               (double)bvh.getMemorySize() / (1024.0 * 1024.0));
+
+        // Every ray straight down at a point inside the grid hits it.
+        SKuint32 hits = 0;
+        for (SKuint32 i = 0; i < 1000; ++i)
+        {
+            const skVector3 origin(skScalar(0.5) + skScalar(i % 37) * (skScalar)(n - 1) / 37,
+                                   skScalar(0.5) + skScalar(i / 37) * (skScalar)(n - 1) / 28,
+                                   10);
+
+            skScalar t   = SK_INFINITY;
+            SKuint32 tri = SK_NPOS32;
+            if (bvh.intersect(mesh->getView(), origin, skVector3(0, 0, -1), 0, t, tri) && skEq(t, skScalar(10)))
+                ++hits;
+        }
+        printf("  %-24s %u of 1000 rays hit the grid\n", "triangle bvh", hits);
+    }
+
+    void benchRegion() const
+    {
+        if (m_file.empty())
+        {
+            printf("region: skipped, no scene was given with --file\n");
+            return;
+        }
+
+        rtLoader* loader = rtLoader::create(m_file.c_str());
+        if (!loader || loader->load(m_file.c_str()) != 0 || loader->getScenes().empty())
+        {
+            skLogf(LD_ERROR, "Failed to load '%s'.\n", m_file.c_str());
+            delete loader;
+            return;
+        }
+
+        const SKuint32 width  = 1280;
+        const SKuint32 height = 720;
+        const SKuint32 frames = 8;
+
+        rtScene*          scene = loader->getScenes().at(0);
+        rtBufferTarget    full(width, height);
+        rtCpuRenderSystem system;
+
+        system.setMode(RM_COLOR_AND_LIGHT | RM_AA);
+        system.setTarget(&full);
+        system.render(scene);
+
+        printf("region: %s, %ux%u, %u frames each\n", m_file.c_str(), width, height, frames);
+
+        const skRectangle regions[] = {
+            {0, 0, (skScalar)width, (skScalar)height},
+            {0, 0, (skScalar)width * .5f, (skScalar)height * .5f},
+            {(skScalar)width * .375f, (skScalar)height * .375f, (skScalar)width * .25f, (skScalar)height * .25f},
+            {(skScalar)width * .5f - 32, (skScalar)height * .5f - 32, 64, 64},
+        };
+
+        const char* names[] = {
+            "full frame",
+            "quarter",
+            "1/16 center crop",
+            "64x64 crop",
+        };
+
+        skTimer timer;
+        double  baseline = 0;
+        for (SKuint32 i = 0; i < 4; ++i)
+        {
+            // Each region starts from a cleared target, so the
+            // comparison below only sees pixels that it traced.
+            const skRectangle& rect = regions[i];
+            rtBufferTarget     part(width, height);
+
+            system.setTarget(&part);
+            system.invalidate();
+            system.render(scene, rect);
+
+            timer.reset();
+            for (SKuint32 f = 0; f < frames; ++f)
+                system.render(scene, rect);
+            const double ms = (double)timer.getMicroseconds() / 1000.0 / frames;
+            if (i == 0)
+                baseline = ms;
+
+            // The traced pixels must match the same pixels of a full frame.
+            const SKuint32 x0 = (SKuint32)rect.getLeft();
+            const SKuint32 y0 = (SKuint32)rect.getTop();
+            const SKuint32 w  = (SKuint32)rect.getWidth();
+            const SKuint32 h  = (SKuint32)rect.getHeight();
+
+            bool matches = true;
+            for (SKuint32 y = y0; y < y0 + h && matches; ++y)
+            {
+                const SKsize offs = (SKsize)y * full.getPitch() + (SKsize)x0 * 4;
+                matches           = memcmp(full.getPixels() + offs, part.getPixels() + offs, (SKsize)w * 4) == 0;
+            }
+
+            printf("  %-24s %10.3f ms  %8.2fx  %s\n",
+                   names[i],
+                   ms,
+                   ms > 0 ? baseline / ms : 0.0,
+                   matches ? "matches" : "DIFFERS");
+        }
+
+        delete loader;
+    }
+
+    static void reportRays(const char*    name,
+                           const double   ms,
+                           const SKuint32 rays,
+                           const SKuint32 hits,
+                           const SKuint32 mismatches)
+    {
+        printf("  %-24s %10.3f ms  %8.2f Mrays/s  %8u hits  %s\n",
+               name,
+               ms,
+               ms > 0 ? (double)rays / (ms * 1000.0) : 0.0,
+               hits,
+               mismatches == 0 ? "matches" : "DIFFERS");
+    }
+
+    static double elapsed(skTimer& timer)
+    {
+        return (double)timer.getMicroseconds() / 1000.0;
+    }
+
+    void runRays(rtCpuRenderSystem& system, rtScene* scene, const char* name, const skArray<rtCpuRayQuery>& queries) const
+    {
+        const SKuint32 count = queries.size();
+
+        skArray<rtCpuHitResult> hits;
+        skArray<SKubyte>        occluded;
+        hits.resize(count);
+        occluded.resize(count);
+
+        // The first call compiles the scene, so it is not timed.
+        system.intersect(scene, queries.ptr(), hits.ptr(), skMin<SKuint32>(count, 1));
+
+        const rtSceneType* sc = scene->getPtr();
+        printf("%s: %u rays\n", name, count);
+
+        skTimer timer;
+
+        // Both ways write their results to an array, so
+        // they pay for the same amount of memory traffic.
+        SKuint32 found = 0;
+        timer.reset();
+        for (SKuint32 i = 0; i < count; ++i)
+            found += rtCpuIntersectRay(sc, queries[i], hits[i]) ? 1 : 0;
+        reportRays("nearest, one by one", elapsed(timer), count, found, 0);
+
+        timer.reset();
+        system.intersect(scene, queries.ptr(), hits.ptr(), count);
+        double ms = elapsed(timer);
+
+        SKuint32 mismatches = 0;
+        found               = 0;
+        for (SKuint32 i = 0; i < count; ++i)
+        {
+            rtCpuHitResult hit;
+            rtCpuIntersectRay(sc, queries[i], hit);
+            if (hit.index != hits[i].index ||
+                (hit.index != SK_NPOS32 && memcmp(&hit, &hits[i], sizeof hit) != 0))
+                ++mismatches;
+            found += hits[i].index != SK_NPOS32 ? 1 : 0;
+        }
+        reportRays("nearest, batched", ms, count, found, mismatches);
+
+        timer.reset();
+        found = 0;
+        for (SKuint32 i = 0; i < count; ++i)
+        {
+            occluded[i] = rtCpuOccludedRay(sc, queries[i]) ? 1 : 0;
+            found += occluded[i];
+        }
+        reportRays("occluded, one by one", elapsed(timer), count, found, 0);
+
+        timer.reset();
+        system.occluded(scene, queries.ptr(), occluded.ptr(), count);
+        ms = elapsed(timer);
+
+        mismatches = 0;
+        found      = 0;
+        for (SKuint32 i = 0; i < count; ++i)
+        {
+            if ((rtCpuOccludedRay(sc, queries[i]) ? 1 : 0) != occluded[i])
+                ++mismatches;
+            found += occluded[i];
+        }
+        reportRays("occluded, batched", ms, count, found, mismatches);
+    }
+
+    void benchRays() const
+    {
+        if (m_file.empty())
+        {
+            printf("rays: skipped, no scene was given with --file\n");
+            return;
+        }
+
+        rtLoader* loader = rtLoader::create(m_file.c_str());
+        if (!loader || loader->load(m_file.c_str()) != 0 || loader->getScenes().empty() ||
+            loader->getScenes().at(0)->getCameras().empty())
+        {
+            skLogf(LD_ERROR, "Failed to load '%s' or it has no camera.\n", m_file.c_str());
+            delete loader;
+            return;
+        }
+
+        rtScene*          scene  = loader->getScenes().at(0);
+        rtCamera*         camera = scene->getCameras().at(0);
+        rtCpuRenderSystem system;
+
+        camera->update();
+        const skVector3&    eye = camera->getDerivedPosition();
+        const skQuaternion& ori = camera->getDerivedOrientation();
+
+        // Primary rays through a 1024x1024 grid in front of the
+        // camera are coherent, neighbours point the same way.
+        const SKuint32 side = 1024;
+
+        skArray<rtCpuRayQuery> queries;
+        queries.reserve(side * side);
+        for (SKuint32 y = 0; y < side; ++y)
+        {
+            for (SKuint32 x = 0; x < side; ++x)
+            {
+                skVector3 d = ori * skVector3((skScalar)x / side - .5f, (skScalar)y / side - .5f, -1);
+                d.normalize();
+
+                queries.push_back({
+                    {{eye.x, eye.y, eye.z}, {d.x, d.y, d.z}},
+                    {camera->getNear(), camera->getFar()},
+                });
+            }
+        }
+        runRays(system, scene, "rays (coherent)", queries);
+
+        // Random origins and directions, as picking and
+        // collision probes from many places would give.
+        SKuint32 seed = 1;
+        auto     next = [&seed]()
+        {
+            seed = seed * 1664525u + 1013904223u;
+            return (skScalar)(seed >> 8) / (skScalar)(1 << 24);
+        };
+
+        queries.resizeFast(0);
+        for (SKuint32 i = 0; i < side * side; ++i)
+        {
+            skVector3 o(next() * 40 - 20, next() * 40 - 20, next() * 10);
+            skVector3 d(next() * 2 - 1, next() * 2 - 1, next() * 2 - 1);
+            d.normalize();
+
+            queries.push_back({
+                {{o.x, o.y, o.z}, {d.x, d.y, d.z}},
+                {skScalar(10e-4), 1000},
+            });
+        }
+        runRays(system, scene, "rays (random)", queries);
+
+        delete loader;
+    }
+
+    template <typename Stream>
+    static double inflate(const char* path, SKuint32& checksum, SKsize& bytes)
+    {
+        skTimer timer;
+        Stream  stream;
+
+        // The checksum stands in for the parser, it
+        // touches every byte that comes out of the stream.
+        checksum = 0;
+        bytes    = 0;
+        timer.reset();
+        stream.open(path, skStream::READ);
+        if (!stream.isOpen())
+            return -1;
+
+        SKubyte buffer[0x10000];
+        SKsize  len;
+        while ((len = stream.read(buffer, sizeof buffer)) > 0 && len != SK_NPOS)
+        {
+            for (SKsize i = 0; i < len; ++i)
+                checksum = checksum * 31 + buffer[i];
+            bytes += len;
+        }
+        return elapsed(timer);
+    }
+
+    static void reportInflate(const char* name, const double ms, const SKsize bytes, const bool matches)
+    {
+        printf("  %-24s %10.3f ms  %8.2f MB/s  %s\n",
+               name,
+               ms,
+               ms > 0 ? (double)bytes / (ms * 1000.0) : 0.0,
+               matches ? "matches" : "DIFFERS");
+    }
+
+    void benchInflate() const
+    {
+        if (m_file.empty())
+        {
+            printf("inflate: skipped, no file was given with --file\n");
+            return;
+        }
+
+#if FT_USE_ZLIB == 1
+        const char* path = m_file.c_str();
+
+        SKuint32     expected, checksum;
+        SKsize       bytes, readBytes;
+        const double ms = inflate<ftGzStream>(path, expected, bytes);
+        if (ms < 0)
+        {
+            skLogf(LD_ERROR, "Failed to open '%s'.\n", path);
+            return;
+        }
+
+        printf("inflate: %s, %u uncompressed bytes\n", path, (SKuint32)bytes);
+        reportInflate("gzread", ms, bytes, true);
+
+        const double ahead = inflate<ftGzReadAheadStream>(path, checksum, readBytes);
+        reportInflate("read-ahead", ahead, readBytes, readBytes == bytes && checksum == expected);
+
+        // The first load also reads the file's tables, the ones
+        // after it find them in the table cache and only parse.
+        const SKuint32 repeats = 8;
+
+        skTimer timer;
+        double  first = 0, best = 0;
+        int     status = ftFlags::FS_OK;
+        for (SKuint32 i = 0; i < repeats && status == ftFlags::FS_OK; ++i)
+        {
+            ftBlend blend;
+            timer.reset();
+            status = blend.load(path, ftFlags::RM_COMPRESSED);
+
+            const double ms = elapsed(timer);
+            if (i == 0)
+                first = ms;
+            else if (i == 1 || ms < best)
+                best = ms;
+        }
+
+        if (status != ftFlags::FS_OK)
+            printf("  %-24s FAILED\n", "ftBlend::load");
+        else
+        {
+            printf("  %-24s %10.3f ms\n", "ftBlend::load, first", first);
+            printf("  %-24s %10.3f ms\n", "ftBlend::load, cached", best);
+        }
+#else
+        printf("inflate: skipped, FileTools was built without zlib\n");
+#endif
+    }
+
+    static double load(const char* path, SKuint32& objects)
+    {
+        skTimer timer;
+        timer.reset();
+
+        rtLoader* loader = rtLoader::create(path);
+        if (!loader || loader->load(path) != 0 || loader->getScenes().empty())
+        {
+            delete loader;
+            return -1;
+        }
+
+        const double ms = elapsed(timer);
+        objects         = loader->getScenes().at(0)->getBoundingVolumes().size();
+        delete loader;
+        return ms;
+    }
+
+    void benchLoad() const
+    {
+        if (m_file.empty())
+        {
+            printf("load: skipped, no scene was given with --file\n");
+            return;
+        }
+
+        const char* path      = m_file.c_str();
+        const char* converted = "Benchmark.rtscene";
+
+        SKuint32     expected = 0, objects = 0;
+        const double ms       = load(path, expected);
+        if (ms < 0)
+        {
+            skLogf(LD_ERROR, "Failed to load '%s'.\n", path);
+            return;
+        }
+
+        {
+            rtLoader* loader = rtLoader::create(path);
+            if (!loader || loader->load(path) != 0 ||
+                rtSceneFileWriter::save(loader->getScenes().at(0), converted) != 0)
+            {
+                skLogf(LD_ERROR, "Failed to convert '%s'.\n", path);
+                delete loader;
+                return;
+            }
+            delete loader;
+        }
+
+        printf("load: %s, %u objects\n", path, expected);
+        printf("  %-24s %10.3f ms\n", "source", ms);
+
+        const double binary = load(converted, objects);
+        printf("  %-24s %10.3f ms  %8.2fx  %s\n",
+               ".rtscene",
+               binary,
+               binary > 0 ? ms / binary : 0.0,
+               objects == expected ? "matches" : "DIFFERS");
+
+        remove(converted);
+    }
+
+    void benchParse() const
+    {
+        if (m_file.empty())
+        {
+            printf("parse: skipped, no .bascii file was given with --file\n");
+            return;
+        }
+
+        const char* path = m_file.c_str();
+
+        SKsize bytes = 0;
+        {
+            skFileStream stream;
+            stream.open(path, skStream::READ);
+            if (stream.isOpen())
+                bytes = stream.size();
+        }
+
+        // The first pass warms the file cache,
+        // the best of the remaining passes is reported.
+        double best = -1;
+        for (int i = 0; i < 4; ++i)
+        {
+            skTimer timer;
+            bAscii  file;
+            timer.reset();
+            if (file.load(path) != 0)
+            {
+                printf("parse: skipped, '%s' is not a valid .bascii file\n", path);
+                return;
+            }
+
+            const double ms = elapsed(timer);
+            if (i > 0 && (best < 0 || ms < best))
+                best = ms;
+        }
+
+        printf("parse: %s, %u bytes\n", path, (SKuint32)bytes);
+        printf("  %-24s %10.3f ms  %8.2f MB/s\n",
+               "bAscii::load",
+               best,
+               best > 0 ? (double)bytes / (best * 1000.0) : 0.0);
+    }
+
+public:
+    Benchmark() :
+        m_triangles(1000000)
+    {
+    }
+
+    static SKuint32 nextRandom(SKuint32& seed)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 8;
+    }
+
+    static skScalar nextScalar(SKuint32& seed)
+    {
+        return (skScalar)nextRandom(seed) / (skScalar)(1 << 24);
+    }
+
+    static void reportRefit(const char*    name,
+                            const double   total,
+                            const double   worst,
+                            const SKuint32 frames,
+                            const rtScene& scene,
+                            const SKuint32 rebuilds)
+    {
+        const rtMeshBvh& bvh = scene.getHierarchy();
+        printf("  %-24s %10.3f ms  %8.3f ms worst  %6.2f cost  %4u rebuilds\n",
+               name,
+               total / frames,
+               worst,
+               bvh.getBuildCost() > 0 ? bvh.getCost() / bvh.getBuildCost() : 0,
+               rebuilds);
+    }
+
+    static void moveObjects(rtScene&                    scene,
+                            const skArray<rtBvObject*>& objects,
+                            const SKuint32              frames,
+                            const SKuint32              moving,
+                            const skScalar              step,
+                            const char*                 name)
+    {
+        SKuint32 seed  = 7;
+        double   total = 0;
+        double   worst = 0;
+        skTimer  timer;
+
+        // The scene is shared by the runs, so only this run's rebuilds are counted.
+        const SKuint32 rebuilds = scene.getRebuildCount();
+
+        for (SKuint32 f = 0; f < frames; ++f)
+        {
+            for (SKuint32 i = 0; i < moving; ++i)
+            {
+                rtBvObject*     object = objects[nextRandom(seed) % objects.size()];
+                const skVector3 offset((nextScalar(seed) - .5f) * step, (nextScalar(seed) - .5f) * step, 0);
+                object->setPosition(object->getPosition() + offset);
+            }
+
+            timer.reset();
+            scene.updateCaches();
+            const double ms = elapsed(timer);
+
+            total += ms;
+            worst = skMax(worst, ms);
+        }
+        reportRefit(name, total, worst, frames, scene, scene.getRebuildCount() - rebuilds);
+    }
+
+    static void addObjects(rtScene& scene, skArray<rtBvObject*>& objects, const SKuint32 side)
+    {
+        for (SKuint32 y = 0; y < side; ++y)
+        {
+            for (SKuint32 x = 0; x < side; ++x)
+            {
+                rtBvObject* object;
+                if ((x + y) & 1)
+                    object = new rtSphere(&scene);
+                else
+                    object = new rtCube(&scene);
+
+                object->setPosition(skScalar(2 * x), skScalar(2 * y), 0);
+                scene.addBoundingObject(object);
+                objects.push_back(object);
+            }
+        }
+    }
+
+    void benchRefit() const
+    {
+        // A field of alternating cubes and spheres, a small share of which
+        // move every frame, as they would in an animated or edited scene.
+        const SKuint32 side   = 100;
+        const SKuint32 frames = 1000;
+        const SKuint32 moving = side * side / 100;
+
+        rtScene              scene;
+        skArray<rtBvObject*> objects;
+        addObjects(scene, objects, side);
+
+        skTimer timer;
+        timer.reset();
+        scene.updateCaches();
+        const double build = elapsed(timer);
+
+        printf("refit: %u objects, %u frames, %u moving per frame\n", objects.size(), frames, moving);
+        printf("  %-24s %10.3f ms  %9u nodes\n", "full compile", build, scene.getHierarchy().getView().nodeCount);
+
+        const rtPackedSceneType& packed = scene.getData().packed;
+
+        rtMeshBvh bvh;
+        timer.reset();
+        for (SKuint32 f = 0; f < 10; ++f)
+            bvh.build(packed.bounds.data, packed.bounds.size);
+        printf("  %-24s %10.3f ms\n", "hierarchy rebuild", elapsed(timer) / 10);
+
+        moveObjects(scene, objects, frames, moving, skScalar(0.5), "small steps");
+
+        // Objects that travel far stretch the nodes above them, which
+        // the cost tracks until a rebuild is started in the background.
+        moveObjects(scene, objects, frames, moving, skScalar(40), "large jumps");
+
+        // The refit hierarchy must give the same hits as a fresh one. Objects
+        // can overlap at the same height, so only the distances are compared.
+        rtScene              fresh;
+        skArray<rtBvObject*> copies;
+        addObjects(fresh, copies, side);
+        for (SKuint32 i = 0; i < objects.size(); ++i)
+            copies[i]->setPosition(objects[i]->getPosition());
+        fresh.updateCaches();
+
+        SKuint32 seed       = 3;
+        SKuint32 mismatches = 0;
+        for (SKuint32 i = 0; i < 100000; ++i)
+        {
+            const rtCpuRayQuery query = {
+                {{nextScalar(seed) * 2 * side, nextScalar(seed) * 2 * side, 10}, {0, 0, -1}},
+                {0, 100},
+            };
+
+            rtCpuHitResult a, b;
+            rtCpuIntersectRay(scene.getPtr(), query, a);
+            rtCpuIntersectRay(fresh.getPtr(), query, b);
+            if ((a.index == SK_NPOS32) != (b.index == SK_NPOS32) ||
+                (a.index != SK_NPOS32 && a.distance != b.distance))
+                ++mismatches;
+        }
+        printf("  %-24s %s\n", "against a fresh build", mismatches == 0 ? "matches" : "DIFFERS");
+    }
+
+    struct Builder
+    {
+        const char*          name;
+        rtMeshBvh::BuildMode mode;
+        SKuint32             threads;
+    };
+
+    static void buildMesh(const char* name, const rtMeshView& view)
+    {
+        const SKuint32 threads = skMax<SKuint32>(1, std::thread::hardware_concurrency());
+
+        char parallel[32];
+        snprintf(parallel, sizeof parallel, "sah, parallel x%u", threads);
+
+        const Builder builders[] = {
+            {"sah, serial", rtMeshBvh::BM_SAH, 1},
+            {parallel, rtMeshBvh::BM_SAH, 0},
+            {"morton", rtMeshBvh::BM_MORTON, 0},
+        };
+
+        // Rays from above the mesh's bounds, pointing down at
+        // random angles, most of which hit something.
+        skBoundingBox box;
+        box.clear();
+        for (SKuint32 i = 0; i < view.vertexCount; ++i)
+        {
+            const rtScalar* v = (const rtScalar*)(view.vertices + (SKsize)i * view.vertexStride);
+            box.compare(skVector3(v[0], v[1], v[2]));
+        }
+
+        const SKuint32  count = 200000;
+        const skVector3 size  = box.max() - box.min();
+
+        skArray<skVector3> origins, directions;
+        origins.reserve(count);
+        directions.reserve(count);
+
+        SKuint32 seed = 5;
+        for (SKuint32 i = 0; i < count; ++i)
+        {
+            origins.push_back(skVector3(box.min().x + nextScalar(seed) * size.x,
+                                        box.min().y + nextScalar(seed) * size.y,
+                                        box.max().z + 1));
+
+            skVector3 d(nextScalar(seed) - .5f, nextScalar(seed) - .5f, -1);
+            d.normalize();
+            directions.push_back(d);
+        }
+
+        printf("build: %s, %u triangles, %u rays\n", name, view.indexCount / 3, count);
+
+        skArray<skScalar> reference;
+        reference.resizeFast(count);
+
+        for (SKuint32 b = 0; b < sizeof builders / sizeof builders[0]; ++b)
+        {
+            rtMeshBvh bvh;
+            skTimer   timer;
+
+            timer.reset();
+            bvh.build(view, builders[b].mode, builders[b].threads);
+            const double build = elapsed(timer);
+
+            SKuint32 hits = 0, mismatches = 0;
+            timer.reset();
+            for (SKuint32 i = 0; i < count; ++i)
+            {
+                skScalar t   = SK_INFINITY;
+                SKuint32 tri = SK_NPOS32;
+                if (bvh.intersect(view, origins[i], directions[i], 0, t, tri))
+                    ++hits;
+
+                // Every builder must find the same nearest distance.
+                if (b == 0)
+                    reference[i] = t;
+                else if (t != reference[i])
+                    ++mismatches;
+            }
+            const double trace = elapsed(timer);
+
+            printf("  %-24s %10.3f ms  %9u nodes  %6.2f cost  %8.2f Mrays/s  %s\n",
+                   builders[b].name,
+                   build,
+                   bvh.getView().nodeCount,
+                   bvh.getCost(),
+                   trace > 0 ? (double)count / (trace * 1000.0) : 0.0,
+                   mismatches == 0 ? "matches" : "DIFFERS");
+        }
+    }
+
+    void benchBuild() const
+    {
+        // A grid with hills in it, so that the
+        // hierarchy has more than one level to sort.
+        const SKuint32 n  = skMax<SKuint32>(1, (SKuint32)skSqrt((skScalar)m_triangles / 2));
+        const SKuint32 n1 = n + 1;
+
+        rtMesh::Vertices vertices;
+        rtMesh::Indices  indices;
+
+        vertices.reserve(n1 * n1);
+        for (SKuint32 y = 0; y < n1; ++y)
+        {
+            for (SKuint32 x = 0; x < n1; ++x)
+            {
+                const skScalar z = skSin((skScalar)x * .05f) * skCos((skScalar)y * .07f) * (skScalar)n * .1f;
+                vertices.push_back(skVector3((skScalar)x, (skScalar)y, z));
+            }
+        }
+
+        indices.reserve(n * n * 6);
+        for (SKuint32 y = 0; y < n; ++y)
+        {
+            for (SKuint32 x = 0; x < n; ++x)
+            {
+                const SKuint32 i0     = y * n1 + x;
+                const SKuint32 tri[6] = {i0, i0 + 1, i0 + n1 + 1, i0 + n1 + 1, i0 + n1, i0};
+                for (SKuint32 i : tri)
+                    indices.push_back(i);
+            }
+        }
+
+        const rtMeshView view = {
+            (const SKubyte*)vertices.ptr(),
+            vertices.size(),
+            (SKuint32)sizeof(skVector3),
+            (const SKubyte*)indices.ptr(),
+            indices.size(),
+            (SKuint32)sizeof(SKuint32),
+        };
+        buildMesh("generated", view);
+
+        if (m_file.empty())
+            return;
+
+        rtLoader* loader = rtLoader::create(m_file.c_str());
+        if (!loader || loader->load(m_file.c_str()) != 0 || loader->getScenes().empty())
+        {
+            skLogf(LD_ERROR, "Failed to load '%s'.\n", m_file.c_str());
+            delete loader;
+            return;
+        }
+
+        // The largest mesh is the one whose build matters most.
+        const rtMesh* largest = nullptr;
+        for (const rtMesh* mesh : loader->getScenes().at(0)->getMeshes())
+        {
+            if (!largest || mesh->getIndexCount() > largest->getIndexCount())
+                largest = mesh;
+        }
+
+        if (largest && largest->getIndexCount() > 0)
+            buildMesh(m_file.c_str(), largest->getView());
+        else
+            printf("build: %s has no meshes\n", m_file.c_str());
+
+        delete loader;
+    }
+
+    int parse(int argc, char** argv)
+    {
+        skCmd psr;
+        if (psr.parse(argc, argv, Switches, ID_MAX) < 0)
+            return 1;
+
+        m_bench = psr.getValueString(ID_BENCH, 0);
+        m_file  = psr.getValueString(ID_FILE, 0);
+
+        const SKint32 triangles = psr.getValueInt(ID_TRIANGLES, 0, (SKint32)m_triangles);
+        if (triangles <= 0)
+        {
+            skLogd(LD_ERROR, "Invalid triangle count.\n");
+            return 1;
+        }
+        m_triangles = (SKuint32)triangles;
+        return 0;
+    }
+
+    bool isSelected(const char* name) const
+    {
+        return m_bench.empty() || m_bench.equals(name);
+    }
+
+    int go() const
+    {
+        if (isSelected("mesh"))
+            benchMesh();
+        if (isSelected("region"))
+            benchRegion();
+        if (isSelected("rays"))
+            benchRays();
+        if (isSelected("inflate"))
+            benchInflate();
+        if (isSelected("load"))
+            benchLoad();
+        if (isSelected("parse"))
+            benchParse();
+        if (isSelected("refit"))
+            benchRefit();
+        if (isSelected("build"))
+            benchBuild();
+        return 0;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    int      status = 0;
+    skLogger log;
+    log.setFlags(LF_STDOUT);
+
+    try
+    {
+        Benchmark app;
+        status = app.parse(argc, argv);
+        if (status == 0)
+            status = app.go();
+    }
+    catch (std::exception& e)
+    {
+        skLogf(LD_ERROR, "An exception occurred.\n%s\n", e.what());
+    }
+    catch (...)
+    {
+        log.logMessage(LD_ERROR, "An unhanded exception occurred.\n");
+    }
+    return status;
+}
@@ -0,0 +1,84 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "CameraPath.h"
+#include <cstring>
+#include "Math/skMath.h"
+#include "Utils/skMinMax.h"
+
+skString CameraPath::getFramePath(const skString& output, const SKuint32 frame)
+{
+    // A dot in a directory name is not an extension.
+    const char* path = output.c_str();
+    const char* name = path;
+    for (const char* ch = path; *ch; ++ch)
+    {
+        if (*ch == '/' || *ch == '\\')
+            name = ch + 1;
+    }
+
+    const char* ext = strrchr(name, '.');
+    if (!ext)
+        ext = path + output.size();
+
+    return skString::format("%.*s.%04u%s", (int)(ext - path), path, frame, ext);
+}
+
+void CameraPath::evaluate(const CameraKeys& keys,
+                          const SKuint32    frame,
+                          const SKuint32    frames,
+                          CameraKey&        dest)
+{
+    if (keys.size() == 1)
+    {
+        // Turntable, one full turn without repeating the first frame.
+        skQuaternion q;
+        q.makeRotZ(skPi2 * skScalar(frame) / skScalar(frames));
+
+        dest.position    = q * keys[0].position;
+        dest.orientation = q * keys[0].orientation;
+        dest.fov         = keys[0].fov;
+        return;
+    }
+
+    const skScalar t = frames > 1 ? skScalar(frame) * skScalar(keys.size() - 1) / skScalar(frames - 1) : 0;
+
+    const SKuint32 seg = skMin<SKuint32>((SKuint32)t, keys.size() - 2);
+    const skScalar f   = t - skScalar(seg);
+    const CameraKey& a = keys[seg];
+    const CameraKey& b = keys[seg + 1];
+
+    const skQuaternion& qa = a.orientation;
+    const skQuaternion& qb = b.orientation;
+
+    // Take the shorter arc between the two orientations.
+    const skScalar dot = qa.w * qb.w + qa.x * qb.x + qa.y * qb.y + qa.z * qb.z;
+    const skScalar fb  = dot < 0 ? -f : f;
+    const skScalar fa  = 1 - f;
+
+    dest.position    = a.position + (b.position - a.position) * f;
+    dest.orientation = skQuaternion(qa.w * fa + qb.w * fb,
+                                    qa.x * fa + qb.x * fb,
+                                    qa.y * fa + qb.y * fb,
+                                    qa.z * fa + qb.z * fb);
+    dest.orientation.normalize();
+    dest.fov = a.fov + (b.fov - a.fov) * f;
+}
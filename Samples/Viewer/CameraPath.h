@@ -0,0 +1,69 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _CameraPath_h_
+#define _CameraPath_h_
+
+#include "Math/skQuaternion.h"
+#include "Math/skVector3.h"
+#include "Utils/skArray.h"
+#include "Utils/skString.h"
+
+/// <summary>
+/// A camera transform that a batch path passes through.
+/// </summary>
+struct CameraKey
+{
+    skVector3    position;
+    skQuaternion orientation;
+    skScalar     fov;
+};
+
+using CameraKeys = skArray<CameraKey>;
+
+/// <summary>
+/// The camera path and output files of a batch of frames.
+/// </summary>
+class CameraPath
+{
+public:
+    /// <summary>
+    /// Numbers an output path for one frame, by inserting the frame
+    /// number in front of the extension. For example out.png becomes
+    /// out.0007.png for frame 7.
+    /// </summary>
+    /// <param name="output">The path given for the output.</param>
+    /// <param name="frame">The frame number.</param>
+    static skString getFramePath(const skString& output, SKuint32 frame);
+
+    /// <summary>
+    /// Computes the camera for one frame of a batch. A single key turns
+    /// once around the world z axis over the batch. Two or more keys are
+    /// interpolated in order, reaching the last key on the last frame.
+    /// </summary>
+    /// <param name="keys">The keys, in world space. It must not be empty.</param>
+    /// <param name="frame">The frame, from 0 to frames - 1.</param>
+    /// <param name="frames">The number of frames in the batch.</param>
+    /// <param name="dest">Receives the camera for the frame.</param>
+    static void evaluate(const CameraKeys& keys, SKuint32 frame, SKuint32 frames, CameraKey& dest);
+};
+
+#endif  //_CameraPath_h_
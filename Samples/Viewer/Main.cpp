@@ -20,28 +20,46 @@
 -------------------------------------------------------------------------------
 */
 #include <cstdio>
+#include <cstring>
 #include <vector>
 
+#include "CameraPath.h"
 #include "Image/skImage.h"
 #include "RenderSystem/Cpu/rtCpuRenderSystem.h"
 #include "RenderSystem/Cuda/rtCudaRenderSystem.h"
-#include "RenderSystem/Loader/Ascii/rtAsciiLoader.h"
-#include "RenderSystem/Loader/Blend/rtBlendLoader.h"
+#include "RenderSystem/Loader/Scene/rtSceneFileWriter.h"
+#include "RenderSystem/Loader/rtLoader.h"
+#include "RenderSystem/rtCamera.h"
+#include "RenderSystem/rtImageWriter.h"
 #include "RenderSystem/Viewer/rtViewerImpl.h"
 #include "RenderSystem/rtImageTarget.h"
 #include "RenderSystem/rtRenderSystem.h"
+#include "RenderSystem/rtTiledImageTarget.h"
 #include "Utils/CommandLine/skCommandLineParser.h"
 #include "Utils/skLogger.h"
+#include "Utils/skTimer.h"
+#if SK_PLATFORM != SK_PLATFORM_WIN32
+#include "RenderServer.h"
+#include "TileWorkers.h"
+#endif
 
 using skCmd              = skCommandLine::Parser;
 using rtScenes           = rtLoader::SceneArray;
 constexpr SKint32 Width  = 800;
 constexpr SKint32 Height = 600;
+constexpr SKint32 TileRows = 16;
 
 enum RayTracerAppIds
 {
     ID_BACKEND,
     ID_OUTPUT,
+    ID_ARENA,
+    ID_SIZE,
+    ID_CAMERAS,
+    ID_FRAMES,
+    ID_DAEMON,
+    ID_WORKERS,
+    ID_TILE_WORKER,
     ID_MAX,
 };
 
@@ -62,26 +80,125 @@ const skCommandLine::Switch Switches[ID_MAX] = {
         'o',
         "output",
         "Specify an output file.\n"
-        " - Where the value is a file-system pathname.\n",
+        " - Where the value is a file-system pathname.\n"
+        " - A .rtscene output converts the input scene to the\n"
+        "   binary scene format instead of rendering it.\n",
+        true,
+        1,
+    },
+    {
+        ID_ARENA,
+        'a',
+        "arena",
+        "Allocate scene data from per-scene arenas (CPU backend only).\n"
+        " - Where the value is one of the following values:\n"
+        "   - Heap blocks: 1\n"
+        "   - Huge page blocks: 2\n",
+        true,
+        1,
+    },
+    {
+        ID_SIZE,
+        's',
+        "size",
+        "Specify the size of the output image.\n"
+        " - Where the values are the width and height in pixels.\n"
+        " - A .ppm or .png output is rendered in bands and encoded\n"
+        "   while the next band renders, so it is not limited by the\n"
+        "   amount of memory a full frame would take.\n",
+        true,
+        2,
+    },
+    {
+        ID_CAMERAS,
+        'c',
+        "cameras",
+        "Render one frame from each of the listed cameras.\n"
+        " - Where the value is 'all' or a comma separated list of\n"
+        "   camera indices, for example 0,2,3.\n"
+        " - Frames are written to the output path with a frame\n"
+        "   number inserted before the extension.\n"
+        " - All of the cameras are rendered together in a single\n"
+        "   pass over the scene.\n",
+        true,
+        1,
+    },
+    {
+        ID_FRAMES,
+        'f',
+        "frames",
+        "Render a sequence of frames along a camera path.\n"
+        " - Where the value is the number of frames.\n"
+        " - The path interpolates between the selected cameras.\n"
+        "   With a single camera, it orbits the world z-axis.\n",
+        true,
+        1,
+    },
+    {
+        ID_DAEMON,
+        'd',
+        "daemon",
+        "Run as a render server on a Unix domain socket (CPU backend only).\n"
+        " - Where the value is the file-system path of the socket.\n"
+        " - Input files are loaded up front as scenes 0, 1, ...\n"
+        " - See Readme.md for the request format.\n",
+        true,
+        1,
+    },
+    {
+        ID_WORKERS,
+        'w',
+        "workers",
+        "Render the output image with local worker processes (CPU backend only).\n"
+        " - Where the value is the number of processes.\n"
+        " - The image is handed out in tiles of 16 rows, as workers\n"
+        "   finish their previous tiles.\n"
+        " - The output must be a .png or .ppm file.\n",
+        true,
+        1,
+    },
+    {
+        ID_TILE_WORKER,
+        0,
+        "tile-worker",
+        "Used by --workers to start a worker process.\n"
+        " - Where the value is the connection to the coordinator.\n",
         true,
         1,
     },
 };
 
+using CameraList = skArray<rtCamera*>;
+
 class Application : public rtViewerImpl
 {
 private:
-    rtLoader*      m_loader;
-    int            m_backend;
-    skString       m_output;
-    rtImageTarget* m_image;
+    rtLoader*           m_loader;
+    int                 m_backend;
+    skString            m_output;
+    SKuint32            m_width;
+    SKuint32            m_height;
+    rtImageTarget*      m_image;
+    rtTiledImageTarget* m_tiled;
+    skString            m_cameraList;
+    SKint32             m_frames;
+    skString            m_daemon;
+    skStringArray       m_inputs;
+    SKint32             m_workers;
+    int                 m_workerFd;
 
 public:
     Application() :
         rtViewerImpl(Width, Height),
         m_loader(nullptr),
         m_backend(0),
-        m_image(nullptr)
+        m_width(Width),
+        m_height(Height),
+        m_image(nullptr),
+        m_tiled(nullptr),
+        m_frames(0),
+        m_workers(0),
+        m_workerFd(-1)
     {
         skImage::initialize();
     }
@@ -89,6 +206,7 @@ public:
     ~Application() override
     {
         delete m_image;
+        delete m_tiled;
         delete m_system;
         delete m_loader;
         skImage::finalize();
@@ -101,6 +219,39 @@ public:
             return 1;
 
         const skStringArray& arr = psr.getArgList();
+
+        if (psr.isPresent(ID_TILE_WORKER))
+        {
+#if SK_PLATFORM != SK_PLATFORM_WIN32
+            // The scene and camera are sent by the coordinator.
+            rtAllocator::setBackend(RT_CPU);
+            m_workerFd = psr.getValueInt(ID_TILE_WORKER, 0, -1);
+            return m_workerFd < 0 ? 1 : 0;
+#else
+            return 1;
+#endif
+        }
+
+        m_daemon = psr.getValueString(ID_DAEMON, 0);
+        if (!m_daemon.empty())
+        {
+#if SK_PLATFORM != SK_PLATFORM_WIN32
+            if (psr.getValueInt(ID_BACKEND, 0, 0) != 0)
+            {
+                skLogd(LD_ERROR, "The render server only supports the CPU backend.\n");
+                return 1;
+            }
+
+            // Scenes are loaded by the server.
+            rtAllocator::setBackend(RT_CPU);
+            m_inputs = arr;
+            return 0;
+#else
+            skLogd(LD_ERROR, "The render server is not supported on this platform.\n");
+            return 1;
+#endif
+        }
+
         if (arr.empty())
         {
             skLogd(LD_ERROR, "No input file.\n");
@@ -109,6 +260,33 @@ public:
 
         m_output = psr.getValueString(ID_OUTPUT, 0);
 
+        if (psr.isPresent(ID_SIZE))
+        {
+            const SKint32 w = psr.getValueInt(ID_SIZE, 0, 0);
+            const SKint32 h = psr.getValueInt(ID_SIZE, 1, 0);
+            if (w <= 0 || h <= 0 || w > 0xFFFFFF / 4 || h > 0xFFFFFF)
+            {
+                skLogd(LD_ERROR, "Invalid output size.\n");
+                return 1;
+            }
+            m_width  = (SKuint32)w;
+            m_height = (SKuint32)h;
+        }
+
+        m_cameraList = psr.getValueString(ID_CAMERAS, 0);
+        m_frames     = psr.getValueInt(ID_FRAMES, 0, 0);
+        if (m_frames < 0)
+        {
+            skLogd(LD_ERROR, "Invalid frame count.\n");
+            return 1;
+        }
+
+        if (isBatch() && m_output.empty())
+        {
+            skLogd(LD_ERROR, "Batch rendering requires an output file.\n");
+            return 1;
+        }
+
         m_backend = psr.getValueInt(ID_BACKEND, 0, 0);
         if (m_backend != 0 && m_backend != 1)
         {
@@ -116,14 +294,42 @@ public:
             return 1;
         }
 
-        // Set the allocator type...
-        rtAllocator::setBackend(m_backend);
+        m_workers = psr.getValueInt(ID_WORKERS, 0, 0);
+        if (m_workers != 0)
+        {
+#if SK_PLATFORM != SK_PLATFORM_WIN32
+            if (m_workers < 0 || m_backend != 0 || isBatch() ||
+                !(m_output.endsWith(".png") || m_output.endsWith(".ppm")))
+            {
+                skLogd(LD_ERROR, "Workers need a single .png or .ppm output and the CPU backend.\n");
+                return 1;
+            }
+#else
+            skLogd(LD_ERROR, "Worker processes are not supported on this platform.\n");
+            return 1;
+#endif
+        }
 
-        if (arr[0].endsWith(".blend"))
-            m_loader = new rtBlendLoader();
-        else if (arr[0].endsWith(".bascii"))
-            m_loader = new rtAsciiLoader();
+        const int arena = psr.getValueInt(ID_ARENA, 0, 0);
+        if (arena < 0 || arena > 2 || (arena != 0 && m_backend != 0))
+        {
+            skLogd(LD_ERROR, "Invalid arena option.\n");
+            return 1;
+        }
+
+        // Set the allocator type...
+        if (arena != 0)
+        {
+            rtAllocator::setArenaOptions(rtArena::DefaultBlockSize,
+                                         arena == 2 ? RT_AF_HUGE_PAGES : RT_AF_NONE);
+            rtAllocator::setBackend(RT_CPU_ARENA);
+        }
         else
+            rtAllocator::setBackend(m_backend);
+
+        m_inputs = arr;
+        m_loader = rtLoader::create(arr[0].c_str());
+        if (!m_loader)
         {
             skLogd(LD_ERROR, "Unknown file extension.\n");
             return 1;
@@ -132,8 +338,246 @@ public:
         return m_loader->load(arr[0].c_str());
     }
 
+    bool isBatch() const
+    {
+        return !m_cameraList.empty() || m_frames > 0;
+    }
+
+    bool selectCameras(rtCameras& cameras, CameraList& dest) const
+    {
+        if (m_cameraList.empty() || m_cameraList.equals("all"))
+        {
+            for (rtCamera* camera : cameras)
+                dest.push_back(camera);
+            return true;
+        }
+
+        skArray<skString> indices;
+        m_cameraList.split(indices, ',');
+
+        for (const skString& index : indices)
+        {
+            const SKint32 i = index.toInt32(-1);
+            if (i < 0 || i >= (SKint32)cameras.size())
+            {
+                skLogf(LD_ERROR, "Invalid camera index '%s'.\n", index.c_str());
+                return false;
+            }
+            dest.push_back(cameras.at((SKuint32)i));
+        }
+        return !dest.empty();
+    }
+
+    skString getFramePath(const SKuint32 frame) const
+    {
+        return CameraPath::getFramePath(m_output, frame);
+    }
+
+    bool renderFrame(const skString& path)
+    {
+        if (m_tiled && !m_tiled->open(path.c_str()))
+            return false;
+
+        m_system->render(m_scene);
+
+        if (m_tiled)
+            return m_tiled->close();
+
+        m_image->save(path.c_str());
+        return true;
+    }
+
+    int renderViews(const CameraList& selected)
+    {
+        // Every camera gets its own target, then all of
+        // them are rendered in a single pass over the scene.
+        skArray<rtTiledImageTarget*> tiled;
+        skArray<rtImageTarget*>      images;
+        rtViews                      views;
+
+        int status = 0;
+        for (SKuint32 i = 0; i < selected.size() && status == 0; ++i)
+        {
+            rtTarget* target;
+            if (m_tiled)
+            {
+                rtTiledImageTarget* image = new rtTiledImageTarget(m_width, m_height);
+                tiled.push_back(image);
+                if (!image->open(getFramePath(i).c_str()))
+                    status = 1;
+                target = image;
+            }
+            else
+            {
+                rtImageTarget* image = new rtImageTarget(m_width, m_height);
+                images.push_back(image);
+                target = image;
+            }
+            views.push_back({selected[i], target});
+        }
+
+        skTimer timer;
+        if (status == 0)
+        {
+            m_system->render(m_scene, views);
+            printf("%u views %.3f ms\n", views.size(), (double)timer.getMicroseconds() / 1000.0);
+        }
+
+        for (SKuint32 i = 0; i < views.size(); ++i)
+        {
+            const skString path = getFramePath(i);
+            if (m_tiled)
+            {
+                if (!tiled[i]->close())
+                    status = 1;
+            }
+            else if (status == 0)
+                images[i]->save(path.c_str());
+
+            if (status == 0)
+                printf("%s\n", path.c_str());
+        }
+
+        for (rtTiledImageTarget* image : tiled)
+            delete image;
+        for (rtImageTarget* image : images)
+            delete image;
+        return status;
+    }
+
+    int renderBatch()
+    {
+        CameraList selected;
+        if (!selectCameras(m_scene->getCameras(), selected))
+            return 1;
+
+        skTimer timer;
+
+        if (m_frames <= 0)
+            return renderViews(selected);
+
+        // Keys are taken in world space, so cameras with their
+        // own transform rules, such as orbit cameras, still work.
+        CameraKeys keys;
+        keys.reserve(selected.size());
+        for (rtCamera* camera : selected)
+        {
+            camera->update();
+            keys.push_back({
+                camera->getDerivedPosition(),
+                camera->getDerivedOrientation(),
+                camera->getFieldOfViewAngle(),
+            });
+        }
+
+        // A plain camera is moved along the path, the scene owns it.
+        rtCamera* camera = new rtCamera(m_scene);
+        camera->setNear(selected[0]->getNear());
+        camera->setFar(selected[0]->getFar());
+        m_scene->addCamera(camera);
+
+        for (SKuint32 i = 0; i < (SKuint32)m_frames; ++i)
+        {
+            const skString path = getFramePath(i);
+            timer.reset();
+
+            CameraKey key;
+            CameraPath::evaluate(keys, i, (SKuint32)m_frames, key);
+            camera->setPosition(key.position);
+            camera->setOrientation(key.orientation);
+            camera->setFieldOfViewAngle(key.fov);
+            m_system->setCamera(camera);
+
+            if (!renderFrame(path))
+                return 1;
+
+            printf("%s %.3f ms\n", path.c_str(), (double)timer.getMicroseconds() / 1000.0);
+        }
+        return 0;
+    }
+
+    int serve()
+    {
+#if SK_PLATFORM != SK_PLATFORM_WIN32
+        RenderServer server;
+
+        for (SKuint32 i = 0; i < m_inputs.size(); ++i)
+        {
+            if (!server.load(skString::format("%u", i), m_inputs[i].c_str()))
+                return 1;
+        }
+
+        if (!server.open(m_daemon.c_str()))
+            return 1;
+        return server.run();
+#else
+        return 1;
+#endif
+    }
+
+    int renderWithWorkers()
+    {
+#if SK_PLATFORM != SK_PLATFORM_WIN32
+        m_camera->update();
+
+        const skVector3&    position    = m_camera->getDerivedPosition();
+        const skQuaternion& orientation = m_camera->getDerivedOrientation();
+
+        TileJob job;
+        job.scene          = m_inputs[0];
+        job.width          = m_width;
+        job.height         = m_height;
+        job.mode           = m_scene->getFlags() | RM_AA;
+        job.position[0]    = position.x;
+        job.position[1]    = position.y;
+        job.position[2]    = position.z;
+        job.orientation[0] = orientation.w;
+        job.orientation[1] = orientation.x;
+        job.orientation[2] = orientation.y;
+        job.orientation[3] = orientation.z;
+        job.fov            = m_camera->getFieldOfViewAngle();
+        job.clip[0]        = m_camera->getNear();
+        job.clip[1]        = m_camera->getFar();
+        job.tileRows       = TileRows;
+
+        const SKuint32 pitch = m_width * 4;
+
+        skArray<SKubyte> pixels;
+        pixels.resizeFast((SKuint32)(pitch * m_height));
+
+        {
+            TileCoordinator coordinator;
+            if (!coordinator.spawn((SKuint32)m_workers) || !coordinator.render(job, pixels.ptr()))
+                return 1;
+        }
+
+        rtImageWriter* writer = rtImageWriter::create(m_output.c_str());
+
+        bool result = writer && writer->open(m_output.c_str(), m_width, m_height);
+        result      = result && writer->writeRows(pixels.ptr(), pitch, m_height);
+        result      = writer && writer->close() && result;
+        delete writer;
+
+        if (!result)
+        {
+            skLogf(LD_ERROR, "Failed to write '%s'.\n", m_output.c_str());
+            return 1;
+        }
+        return 0;
+#else
+        return 1;
+#endif
+    }
+
     int go()
     {
+#if SK_PLATFORM != SK_PLATFORM_WIN32
+        if (m_workerFd >= 0)
+            return TileCoordinator::runWorker(m_workerFd);
+#endif
+        if (!m_daemon.empty())
+            return serve();
+
         if (!m_loader)
             return 1;
 
@@ -146,6 +590,9 @@ public:
         }
         m_scene = scenes.at(0);
 
+        if (m_output.endsWith(".rtscene"))
+            return rtSceneFileWriter::save(m_scene, m_output.c_str()) == 0 ? 0 : 1;
+
         rtCameras& cameras = m_scene->getCameras();
         if (cameras.empty())
         {
@@ -154,6 +601,9 @@ public:
         }
         m_camera = cameras.at(0);
 
+        if (m_workers > 0)
+            return renderWithWorkers();
+
         switch (m_backend)
         {
 #ifdef USING_CUDA
@@ -166,21 +616,38 @@ public:
             break;
         }
 
-        if (!m_output.empty())
+        if (m_output.endsWith(".ppm") || m_output.endsWith(".png"))
         {
-            m_image = new rtImageTarget(Width, Height);
+            m_tiled = new rtTiledImageTarget(m_width, m_height);
+            if (!isBatch() && !m_tiled->open(m_output.c_str()))
+                return 1;
+            m_system->setTarget(m_tiled);
+        }
+        else if (!m_output.empty())
+        {
+            m_image = new rtImageTarget(m_width, m_height);
             m_system->setTarget(m_image);
         }
         else
             m_system->setTarget(this);
 
         m_isInteractiveCamera = m_camera->getType() == RT_AO_USER_CAMERA;
-        if (m_image)
+        if (m_image || m_tiled)
         {
             m_scene->setFlags(m_scene->getFlags() | RM_AA);
             m_system->setMode(m_scene->getFlags());
+
+            // The scene, its compiled data and the render
+            // threads are shared by every frame of a batch.
+            if (isBatch())
+                return renderBatch();
+
             m_system->render(m_scene);
-            m_image->save(m_output.c_str());
+
+            if (m_image)
+                m_image->save(m_output.c_str());
+            else if (!m_tiled->close())
+                return 1;
         }
         else
         {
@@ -0,0 +1,668 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "RenderServer.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "RenderSystem/Cpu/rtCpuRenderSystem.h"
+#include "RenderSystem/Loader/rtLoader.h"
+#include "RenderSystem/rtBufferTarget.h"
+#include "RenderSystem/rtCamera.h"
+#include "RenderSystem/rtCommon.h"
+#include "RenderSystem/rtImageWriter.h"
+#include "RenderSystem/rtScene.h"
+#include "Utils/skLogger.h"
+
+// Clients that have this much unserved input are not
+// read from until some of their requests are served.
+constexpr SKsize MaxPendingInput = 0x100000;
+
+// Clients that have this much unsent output are not served
+// again until they have read some of it.
+constexpr SKsize MaxPendingOutput = 0x100000;
+
+static volatile sig_atomic_t gStopRequested = 0;
+
+static void rtServerSignal(int)
+{
+    gStopRequested = 1;
+}
+
+RenderServer::RenderServer() :
+    m_socket(-1),
+    m_next(0),
+    m_quit(false)
+{
+}
+
+RenderServer::~RenderServer()
+{
+    for (Client* client : m_clients)
+        closeClient(client);
+
+    while (!m_scenes.empty())
+        unload(m_scenes.back()->id);
+
+    if (m_socket != -1)
+    {
+        close(m_socket);
+        unlink(m_path.c_str());
+    }
+}
+
+RenderServer::Scene* RenderServer::findScene(const skString& id) const
+{
+    for (Scene* scene : m_scenes)
+    {
+        if (scene->id == id)
+            return scene;
+    }
+    return nullptr;
+}
+
+bool RenderServer::load(const skString& id, const char* path)
+{
+    if (findScene(id))
+    {
+        skLogf(LD_ERROR, "A scene named '%s' is already loaded.\n", id.c_str());
+        return false;
+    }
+
+    rtLoader* loader = rtLoader::create(path);
+    if (!loader)
+    {
+        skLogf(LD_ERROR, "Unknown file extension '%s'.\n", path);
+        return false;
+    }
+
+    if (loader->load(path) != 0 || loader->getScenes().empty())
+    {
+        skLogf(LD_ERROR, "Failed to load '%s'.\n", path);
+        delete loader;
+        return false;
+    }
+
+    rtScene*   scene   = loader->getScenes().at(0);
+    rtCameras& cameras = scene->getCameras();
+    if (cameras.empty())
+    {
+        skLogf(LD_ERROR, "No cameras found in '%s'.\n", path);
+        delete loader;
+        return false;
+    }
+
+    // Requests that supply their own camera transform move this
+    // camera, so the cameras in the file are never modified.
+    rtCamera* main = cameras.at(0);
+    main->update();
+
+    rtCamera* camera = new rtCamera(scene);
+    camera->setNear(main->getNear());
+    camera->setFar(main->getFar());
+    camera->setFieldOfViewAngle(main->getFieldOfViewAngle());
+    camera->setPosition(main->getDerivedPosition());
+    camera->setOrientation(main->getDerivedOrientation());
+    scene->addCamera(camera);
+
+    Scene* entry  = new Scene;
+    entry->id     = id;
+    entry->loader = loader;
+    entry->scene  = scene;
+    entry->camera = camera;
+    entry->target = nullptr;
+    entry->system = new rtCpuRenderSystem();
+    m_scenes.push_back(entry);
+
+    printf("Loaded '%s' as %s\n", path, id.c_str());
+    return true;
+}
+
+bool RenderServer::unload(const skString& id)
+{
+    Scene* entry = findScene(id);
+    if (!entry)
+        return false;
+
+    m_scenes.erase(entry);
+
+    delete entry->system;
+    delete entry->target;
+    delete entry->loader;
+    delete entry;
+    return true;
+}
+
+bool RenderServer::open(const char* path)
+{
+    sockaddr_un address = {};
+    address.sun_family  = AF_UNIX;
+
+    if (!path || strlen(path) >= sizeof(address.sun_path))
+    {
+        skLogd(LD_ERROR, "Invalid socket path.\n");
+        return false;
+    }
+    strcpy(address.sun_path, path);
+
+    m_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_socket == -1)
+    {
+        skLogf(LD_ERROR, "socket failed: %s\n", strerror(errno));
+        return false;
+    }
+
+    // Replace a socket left behind by a server that did not shut down
+    // cleanly, but never a live one or any other kind of file.
+    struct stat st = {};
+    if (lstat(path, &st) == 0)
+    {
+        if (!S_ISSOCK(st.st_mode))
+        {
+            skLogf(LD_ERROR, "'%s' exists and is not a socket.\n", path);
+            close(m_socket);
+            m_socket = -1;
+            return false;
+        }
+
+        const int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        const bool live = probe != -1 && connect(probe, (sockaddr*)&address, sizeof(address)) == 0;
+        if (probe != -1)
+            close(probe);
+
+        if (live)
+        {
+            skLogf(LD_ERROR, "A server is already listening on '%s'.\n", path);
+            close(m_socket);
+            m_socket = -1;
+            return false;
+        }
+        unlink(path);
+    }
+
+    if (bind(m_socket, (sockaddr*)&address, sizeof(address)) != 0 || listen(m_socket, 16) != 0)
+    {
+        skLogf(LD_ERROR, "Failed to listen on '%s': %s\n", path, strerror(errno));
+        close(m_socket);
+        m_socket = -1;
+        return false;
+    }
+
+    m_path = path;
+    printf("Listening on %s\n", path);
+    return true;
+}
+
+void RenderServer::accept()
+{
+    const int fd = accept4(m_socket, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+    if (fd == -1)
+        return;
+
+    Client* client = new Client;
+    client->fd     = fd;
+    client->sent   = 0;
+    client->hungUp = false;
+    m_clients.push_back(client);
+}
+
+bool RenderServer::receive(Client* client)
+{
+    char buffer[4096];
+
+    const ssize_t len = recv(client->fd, buffer, sizeof buffer, 0);
+    if (len < 0)
+        return errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK;
+
+    // The client has finished sending, but still
+    // reads the replies to what it has already sent.
+    if (len == 0)
+    {
+        // A last request without a line break is still served.
+        if (!client->input.empty() && client->input[client->input.size() - 1] != '\n')
+            client->input.append('\n');
+        client->hungUp = true;
+        return true;
+    }
+
+    client->input.append(buffer, (SKsize)len);
+    return true;
+}
+
+bool RenderServer::hasRequest(const Client* client)
+{
+    return !client->input.empty() && memchr(client->input.c_str(), '\n', client->input.size()) != nullptr;
+}
+
+bool RenderServer::canServe(const Client* client)
+{
+    return hasRequest(client) && pendingOutput(client) < MaxPendingOutput;
+}
+
+bool RenderServer::isFinished(const Client* client)
+{
+    return client->hungUp && !hasRequest(client) && pendingOutput(client) == 0;
+}
+
+SKsize RenderServer::pendingOutput(const Client* client)
+{
+    return (SKsize)client->output.size() - client->sent;
+}
+
+bool RenderServer::hasRequests() const
+{
+    for (const Client* client : m_clients)
+    {
+        if (canServe(client))
+            return true;
+    }
+    return false;
+}
+
+void RenderServer::serveNext()
+{
+    // Round robin, so one client with a long queue cannot hold up the
+    // requests of the others. Clients whose replies are backed up are
+    // passed over until they read them.
+    const SKuint32 count = m_clients.size();
+    for (SKuint32 i = 0; i < count; ++i)
+    {
+        const SKuint32 index  = (m_next + i) % count;
+        Client*        client = m_clients[index];
+        if (!canServe(client))
+            continue;
+
+        m_next = index + 1;
+
+        const char*  text = client->input.c_str();
+        const SKsize end  = (SKsize)((const char*)memchr(text, '\n', client->input.size()) - text);
+
+        skString request;
+        if (end > 0)
+            request = skString(text, end);
+        client->input = client->input.substr(end + 1, client->input.size() - end - 1);
+
+        execute(client, request);
+
+        // Most replies fit in the socket's buffer, so they
+        // are written now rather than on the next poll.
+        if (!flush(client) || isFinished(client))
+        {
+            m_clients.erase(client);
+            closeClient(client);
+        }
+        return;
+    }
+}
+
+void RenderServer::execute(Client* client, const skString& request)
+{
+    // Tabs and carriage returns separate arguments as well.
+    skString line;
+    line.reserve(request.size());
+    for (SKsize i = 0; i < request.size(); ++i)
+    {
+        const char ch = request[i];
+        line.append(ch == '\t' || ch == '\r' ? ' ' : ch);
+    }
+
+    skArray<skString> args;
+    line.split(args, ' ');
+
+    if (args.empty())
+        return;
+
+    const skString& command = args[0];
+
+    if (command == "render")
+        render(client, args);
+    else if (command == "load" && args.size() == 3)
+    {
+        if (!load(args[1], args[2].c_str()))
+            reply(client, "error failed to load %s\n", args[2].c_str());
+        else
+            reply(client, "ok\n");
+    }
+    else if (command == "unload" && args.size() == 2)
+    {
+        if (!unload(args[1]))
+            reply(client, "error unknown scene %s\n", args[1].c_str());
+        else
+            reply(client, "ok\n");
+    }
+    else if (command == "quit" && args.size() == 1)
+    {
+        m_quit = true;
+        reply(client, "ok\n");
+    }
+    else
+        reply(client, "error invalid request\n");
+}
+
+void RenderServer::render(Client* client, const skArray<skString>& args)
+{
+    if (args.size() < 5)
+    {
+        reply(client, "error expected render <id> <width> <height> <mode>\n");
+        return;
+    }
+
+    Scene* entry = findScene(args[1]);
+    if (!entry)
+    {
+        reply(client, "error unknown scene %s\n", args[1].c_str());
+        return;
+    }
+
+    const SKint32 width  = args[2].toInt32(0);
+    const SKint32 height = args[3].toInt32(0);
+    const SKint32 mode   = args[4].toInt32(-1);
+    if (width <= 0 || height <= 0 || width > 0x4000 || height > 0x4000 || mode < 0)
+    {
+        reply(client, "error invalid size or mode\n");
+        return;
+    }
+
+    rtCamera* camera = entry->scene->getCameras().at(0);
+    skString  file;
+
+    for (SKuint32 i = 5; i < args.size();)
+    {
+        if (args[i] == "camera" && i + 8 < args.size())
+        {
+            float v[8];
+            for (int j = 0; j < 8; ++j)
+                v[j] = skChar::toFloat(args[i + 1 + j]);
+
+            camera = entry->camera;
+            camera->setPosition(v[0], v[1], v[2]);
+            camera->setOrientation(skQuaternion(v[3], v[4], v[5], v[6]).normalized());
+            camera->setFieldOfViewAngle(v[7]);
+            i += 9;
+        }
+        else if (args[i] == "file" && i + 1 < args.size())
+        {
+            file = args[i + 1];
+            i += 2;
+        }
+        else
+        {
+            reply(client, "error unknown argument %s\n", args[i].c_str());
+            return;
+        }
+    }
+
+    rtCpuRenderSystem* system = entry->system;
+
+    // The target, and the tile threads with it, are only
+    // recreated when the requested size changes.
+    rtBufferTarget* target = entry->target;
+    if (!target || target->getWidth() != (SKuint32)width || target->getHeight() != (SKuint32)height)
+    {
+        target = new rtBufferTarget((SKuint32)width, (SKuint32)height);
+        system->setTarget(target);
+        system->invalidate();
+
+        delete entry->target;
+        entry->target = target;
+    }
+
+    // setMode only reaches the scene once the system has
+    // been initialized with it, so both are set here.
+    entry->scene->setFlags(mode);
+    system->setCamera(camera);
+    system->setMode(mode);
+    system->render(entry->scene);
+
+    const SKuint32 pitch = target->getPitch();
+
+    if (!file.empty())
+    {
+        rtImageWriter* writer = rtImageWriter::create(file.c_str());
+        if (!writer)
+        {
+            reply(client, "error unsupported image type %s\n", file.c_str());
+            return;
+        }
+
+        bool result = writer->open(file.c_str(), (SKuint32)width, (SKuint32)height);
+        result      = result && writer->writeRows(target->getPixels(), pitch, (SKuint32)height);
+        result      = writer->close() && result;
+        delete writer;
+
+        if (!result)
+            reply(client, "error failed to write %s\n", file.c_str());
+        else
+            reply(client, "ok %s\n", file.c_str());
+        return;
+    }
+
+    reply(client, "ok %d %d %u\n", width, height, (SKuint32)(pitch * height));
+
+    // The whole frame is queued at once, and written out as the client reads it.
+    client->output.reserve(client->output.size() + pitch * (SKuint32)height);
+
+    // Send R, G, B, A in memory order, whatever the host order is.
+    skArray<SKubyte> row;
+    row.resizeFast(pitch);
+
+    for (SKint32 y = 0; y < height; ++y)
+    {
+        const rtPixelRGBA* src = (const rtPixelRGBA*)(target->getPixels() + (SKsize)y * pitch);
+
+        SKubyte* dst = row.ptr();
+        for (SKint32 x = 0; x < width; ++x, ++src)
+        {
+            *dst++ = src->r;
+            *dst++ = src->g;
+            *dst++ = src->b;
+            *dst++ = src->a;
+        }
+
+        send(client, row.ptr(), pitch);
+    }
+}
+
+void RenderServer::send(Client* client, const void* data, SKsize len)
+{
+    if (len == 0)
+        return;
+
+    // Sent bytes are dropped once there are more of them than
+    // unsent ones, so the buffer does not grow without bound.
+    if (client->sent > 0 && client->sent >= pendingOutput(client))
+    {
+        const SKsize pending = pendingOutput(client);
+        memmove(client->output.ptr(), client->output.ptr() + client->sent, pending);
+        client->output.resizeFast((SKuint32)pending);
+        client->sent = 0;
+    }
+
+    const SKuint32 size = client->output.size();
+    if (client->output.capacity() < size + len)
+        client->output.reserve(skMax<SKuint32>(size + (SKuint32)len, client->output.capacity() * 2));
+
+    client->output.resizeFast(size + (SKuint32)len);
+    memcpy(client->output.ptr() + size, data, len);
+}
+
+void RenderServer::reply(Client* client, const char* fmt, ...)
+{
+    char buffer[1024];
+
+    va_list lst;
+    va_start(lst, fmt);
+    const int len = vsnprintf(buffer, sizeof buffer, fmt, lst);
+    va_end(lst);
+
+    if (len > 0)
+        send(client, buffer, skMin<SKsize>((SKsize)len, sizeof buffer - 1));
+}
+
+bool RenderServer::flush(Client* client)
+{
+    while (pendingOutput(client) > 0)
+    {
+        const ssize_t written = ::send(client->fd,
+                                       client->output.ptr() + client->sent,
+                                       pendingOutput(client),
+                                       MSG_NOSIGNAL);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            // The rest is written when poll says there is room.
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        client->sent += (SKsize)written;
+    }
+
+    client->output.resizeFast(0);
+    client->sent = 0;
+    return true;
+}
+
+void RenderServer::drain()
+{
+    // Give the replies that are still queued, such as the one to quit,
+    // a moment to go out before the connections are closed.
+    constexpr int Timeout = 1000;
+
+    skArray<pollfd>  fds;
+    skArray<Client*> waiting;
+
+    for (int left = Timeout; left > 0;)
+    {
+        fds.resizeFast(0);
+        waiting.resizeFast(0);
+        for (Client* client : m_clients)
+        {
+            if (pendingOutput(client) > 0)
+            {
+                fds.push_back({client->fd, POLLOUT, 0});
+                waiting.push_back(client);
+            }
+        }
+        if (fds.empty())
+            return;
+
+        const int step = 50;
+        if (poll(fds.ptr(), fds.size(), skMin(step, left)) < 0 && errno != EINTR)
+            return;
+        left -= step;
+
+        for (SKuint32 i = 0; i < fds.size(); ++i)
+        {
+            if (fds[i].revents && !flush(waiting[i]))
+            {
+                // The client went away, so nothing more is sent to it.
+                waiting[i]->output.resizeFast(0);
+                waiting[i]->sent = 0;
+            }
+        }
+    }
+}
+
+void RenderServer::closeClient(Client* client)
+{
+    close(client->fd);
+    delete client;
+}
+
+int RenderServer::run()
+{
+    if (m_socket == -1)
+        return 1;
+
+    struct sigaction action = {};
+    action.sa_handler       = rtServerSignal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    skArray<pollfd> fds;
+
+    while (!m_quit && !gStopRequested)
+    {
+        fds.resizeFast(0);
+        fds.push_back({m_socket, POLLIN, 0});
+        for (const Client* client : m_clients)
+        {
+            short events = 0;
+            if (!client->hungUp && client->input.size() < MaxPendingInput)
+                events |= POLLIN;
+            if (pendingOutput(client) > 0)
+                events |= POLLOUT;
+            fds.push_back({client->fd, events, 0});
+        }
+
+        // Only block when there is nothing left to serve.
+        const int timeout = hasRequests() ? 0 : -1;
+        if (poll(fds.ptr(), fds.size(), timeout) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            skLogf(LD_ERROR, "poll failed: %s\n", strerror(errno));
+            return 1;
+        }
+
+        // Walk backwards, so clients can be removed in place.
+        for (SKuint32 i = fds.size() - 1; i > 0; --i)
+        {
+            const short revents = fds[i].revents;
+            if (!revents)
+                continue;
+
+            Client* client = m_clients[i - 1];
+
+            bool result = !(revents & POLLERR);
+            if (result && revents & (POLLIN | POLLHUP) && fds[i].events & POLLIN)
+                result = receive(client);
+            if (result && revents & POLLOUT)
+                result = flush(client);
+
+            // A client that has hung up is kept until every
+            // request it sent has been answered and written.
+            if (!result || isFinished(client))
+            {
+                m_clients.erase(client);
+                closeClient(client);
+            }
+        }
+
+        if (fds[0].revents & POLLIN)
+            accept();
+
+        serveNext();
+    }
+
+    drain();
+
+    printf("Shutting down\n");
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _RenderServer_h_
+#define _RenderServer_h_
+
+#include "Utils/skArray.h"
+#include "Utils/skString.h"
+
+class rtLoader;
+class rtScene;
+class rtCamera;
+class rtCpuRenderSystem;
+class rtBufferTarget;
+
+/// <summary>
+/// Long running render process that keeps loaded scenes resident and
+/// renders them on request. Clients connect to a Unix domain socket and
+/// send one request per line:
+///
+///   load   <id> <path>
+///   unload <id>
+///   render <id> <width> <height> <mode> [camera px py pz qw qx qy qz fov] [file <path>]
+///   quit
+///
+/// Every request is answered with a line that starts with 'ok' or 'error'.
+/// A render without a file is answered with 'ok <width> <height> <bytes>'
+/// followed by the raw top down RGBA pixels. Requests from one client are
+/// served in order, and clients take turns, one request at a time.
+/// Replies are queued and written as the client reads them, so a client
+/// that stops reading only holds up its own requests. A client that
+/// closes its end for writing still has its queued requests answered.
+/// </summary>
+class RenderServer
+{
+private:
+    struct Scene
+    {
+        skString           id;
+        rtLoader*          loader;
+        rtScene*           scene;
+        rtCamera*          camera;
+        rtCpuRenderSystem* system;
+        rtBufferTarget*    target;
+    };
+
+    // Received text that has not been served yet, where each complete
+    // line is one queued request, and replies that have not been sent.
+    struct Client
+    {
+        int              fd;
+        skString         input;
+        skArray<SKubyte> output;
+        SKsize           sent;
+        bool             hungUp;
+    };
+
+    typedef skArray<Scene*>  Scenes;
+    typedef skArray<Client*> Clients;
+
+    int      m_socket;
+    skString m_path;
+    Scenes   m_scenes;
+    Clients  m_clients;
+    SKuint32 m_next;
+    bool     m_quit;
+
+    Scene* findScene(const skString& id) const;
+
+    void accept();
+
+    static bool receive(Client* client);
+
+    static bool hasRequest(const Client* client);
+
+    static bool canServe(const Client* client);
+
+    static bool isFinished(const Client* client);
+
+    static SKsize pendingOutput(const Client* client);
+
+    bool hasRequests() const;
+
+    void serveNext();
+
+    void execute(Client* client, const skString& request);
+
+    void render(Client* client, const skArray<skString>& args);
+
+    static void send(Client* client, const void* data, SKsize len);
+
+    static void reply(Client* client, const char* fmt, ...);
+
+    static bool flush(Client* client);
+
+    void drain();
+
+    static void closeClient(Client* client);
+
+public:
+    RenderServer();
+    ~RenderServer();
+
+    /// <summary>
+    /// Loads a .blend or .bascii file and keeps its first scene resident.
+    /// </summary>
+    /// <param name="id">The name clients use to refer to the scene.</param>
+    /// <param name="path">The file-system path of the scene.</param>
+    /// <returns>True if the scene was loaded.</returns>
+    bool load(const skString& id, const char* path);
+
+    /// <summary>
+    /// Releases a resident scene.
+    /// </summary>
+    /// <param name="id">The name of the scene.</param>
+    /// <returns>True if the scene was found.</returns>
+    bool unload(const skString& id);
+
+    /// <summary>
+    /// Creates the listening socket.
+    /// </summary>
+    /// <param name="path">The file-system path of the socket.</param>
+    /// <returns>True if the socket is ready for connections.</returns>
+    bool open(const char* path);
+
+    /// <summary>
+    /// Serves requests until a client sends quit or the
+    /// process receives SIGINT or SIGTERM.
+    /// </summary>
+    /// <returns>Zero on a clean shutdown.</returns>
+    int run();
+};
+
+#endif  //_RenderServer_h_
@@ -0,0 +1,133 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+#include "CameraPath.h"
+#include "Math/skMath.h"
+
+constexpr skScalar Tolerance = skScalar(1e-5);
+
+void ExpectKey(const CameraKey& expected, const CameraKey& actual)
+{
+    EXPECT_NEAR(expected.position.x, actual.position.x, Tolerance);
+    EXPECT_NEAR(expected.position.y, actual.position.y, Tolerance);
+    EXPECT_NEAR(expected.position.z, actual.position.z, Tolerance);
+
+    // q and -q are the same rotation.
+    const skQuaternion& a    = expected.orientation;
+    const skQuaternion& b    = actual.orientation;
+    const skScalar      sign = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z < 0 ? -1 : 1;
+    EXPECT_NEAR(a.w, b.w * sign, Tolerance);
+    EXPECT_NEAR(a.x, b.x * sign, Tolerance);
+    EXPECT_NEAR(a.y, b.y * sign, Tolerance);
+    EXPECT_NEAR(a.z, b.z * sign, Tolerance);
+
+    EXPECT_NEAR(expected.fov, actual.fov, Tolerance);
+}
+
+CameraKey MakeKey(const skVector3& position, const skScalar angle, const skScalar fov)
+{
+    CameraKey key;
+    key.position = position;
+    key.orientation.makeRotZ(angle);
+    key.fov = fov;
+    return key;
+}
+
+GTEST_TEST(Batch, FramePath)
+{
+    EXPECT_STREQ("out.0000.png", CameraPath::getFramePath("out.png", 0).c_str());
+    EXPECT_STREQ("out.0042.ppm", CameraPath::getFramePath("out.ppm", 42).c_str());
+    EXPECT_STREQ("out.12345.png", CameraPath::getFramePath("out.png", 12345).c_str());
+    EXPECT_STREQ("a.b.0007.png", CameraPath::getFramePath("a.b.png", 7).c_str());
+
+    // Without an extension the number goes at the end.
+    EXPECT_STREQ("out.0003", CameraPath::getFramePath("out", 3).c_str());
+    EXPECT_STREQ("render.v2/out.0003", CameraPath::getFramePath("render.v2/out", 3).c_str());
+    EXPECT_STREQ("render.v2\\out.0003", CameraPath::getFramePath("render.v2\\out", 3).c_str());
+    EXPECT_STREQ("render.v2/out.0003.png", CameraPath::getFramePath("render.v2/out.png", 3).c_str());
+}
+
+GTEST_TEST(Batch, Turntable)
+{
+    CameraKeys keys;
+    keys.push_back(MakeKey({4, 0, 1}, 0, 40));
+
+    CameraKey key;
+    CameraPath::evaluate(keys, 0, 4, key);
+    ExpectKey(keys[0], key);
+
+    // A quarter turn per frame, and the last frame stops short of a full turn.
+    CameraPath::evaluate(keys, 1, 4, key);
+    ExpectKey(MakeKey({0, 4, 1}, skPiH, 40), key);
+
+    CameraPath::evaluate(keys, 3, 4, key);
+    ExpectKey(MakeKey({0, -4, 1}, skPi + skPiH, 40), key);
+
+    // A single frame is the key itself.
+    CameraPath::evaluate(keys, 0, 1, key);
+    ExpectKey(keys[0], key);
+}
+
+GTEST_TEST(Batch, Keyed)
+{
+    CameraKeys keys;
+    keys.push_back(MakeKey({0, 0, 0}, 0, 30));
+    keys.push_back(MakeKey({2, 0, 0}, skPiH, 50));
+    keys.push_back(MakeKey({2, 4, 0}, skPiH, 50));
+
+    // The first and last frames are the first and last keys.
+    CameraKey key;
+    CameraPath::evaluate(keys, 0, 5, key);
+    ExpectKey(keys[0], key);
+    CameraPath::evaluate(keys, 4, 5, key);
+    ExpectKey(keys[2], key);
+
+    // Five frames over two segments put a key on frame 2,
+    // and frame 1 halfway between the first two keys.
+    CameraPath::evaluate(keys, 2, 5, key);
+    ExpectKey(keys[1], key);
+    CameraPath::evaluate(keys, 1, 5, key);
+    ExpectKey(MakeKey({1, 0, 0}, skPiH / 2, 40), key);
+    CameraPath::evaluate(keys, 3, 5, key);
+    ExpectKey(MakeKey({2, 2, 0}, skPiH, 50), key);
+
+    // A single frame is the first key.
+    CameraPath::evaluate(keys, 0, 1, key);
+    ExpectKey(keys[0], key);
+}
+
+GTEST_TEST(Batch, ShorterArc)
+{
+    // The second key holds the same rotation as the first,
+    // negated, so the path must not turn at all.
+    CameraKeys keys;
+    keys.push_back(MakeKey({0, 0, 0}, skPiH, 40));
+    keys.push_back(keys[0]);
+    keys[1].orientation = keys[0].orientation * skScalar(-1);
+
+    CameraKey key;
+    for (SKuint32 i = 0; i < 3; ++i)
+    {
+        CameraPath::evaluate(keys, i, 3, key);
+        ExpectKey(keys[0], key);
+    }
+}
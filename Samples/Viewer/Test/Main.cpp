@@ -0,0 +1,39 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <cstring>
+#include "TileWorkers.h"
+
+// The worker tests spawn this executable as their
+// tile workers, so it handles the worker's arguments.
+int main(int argc, char** argv)
+{
+    if (argc >= 3 && strcmp(argv[1], "--tile-worker") == 0)
+    {
+        const SKuint32 tileLimit = argc >= 4 ? (SKuint32)strtoul(argv[3], nullptr, 10) : SK_NPOS32;
+        return TileCoordinator::runWorker(atoi(argv[2]), tileLimit);
+    }
+
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,324 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+#include <thread>
+#include "RenderServer.h"
+#include "RenderSystem/Cpu/rtCpuRenderSystem.h"
+#include "RenderSystem/Loader/rtLoader.h"
+#include "RenderSystem/rtBufferTarget.h"
+#include "RenderSystem/rtScene.h"
+#include "TestDirectory.h"
+#include "Utils/skArray.h"
+#include "Utils/skString.h"
+
+// The client end of a connection to the server.
+class Connection
+{
+private:
+    int m_fd;
+
+public:
+    explicit Connection(const char* path) :
+        m_fd(socket(AF_UNIX, SOCK_STREAM, 0))
+    {
+        sockaddr_un address = {};
+        address.sun_family  = AF_UNIX;
+        strcpy(address.sun_path, path);
+
+        if (m_fd != -1 && connect(m_fd, (sockaddr*)&address, sizeof(address)) != 0)
+        {
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    ~Connection()
+    {
+        if (m_fd != -1)
+            close(m_fd);
+    }
+
+    bool isOpen() const
+    {
+        return m_fd != -1;
+    }
+
+    // Fails reads that wait longer than the timeout,
+    // so that a server that stalls fails the test.
+    void setTimeout(const int milliseconds) const
+    {
+        timeval tv = {milliseconds / 1000, (milliseconds % 1000) * 1000};
+        setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+    }
+
+    // Tells the server that nothing more will be sent.
+    void hangUp() const
+    {
+        shutdown(m_fd, SHUT_WR);
+    }
+
+    // Returns true if the server has closed its end.
+    bool isClosed() const
+    {
+        char ch;
+        return recv(m_fd, &ch, 1, 0) == 0;
+    }
+
+    bool send(const char* request) const
+    {
+        const SKsize len = strlen(request);
+        return ::send(m_fd, request, len, MSG_NOSIGNAL) == (ssize_t)len;
+    }
+
+    skString readLine() const
+    {
+        skString line;
+        char     ch;
+        while (recv(m_fd, &ch, 1, 0) == 1 && ch != '\n')
+            line.append(ch);
+        return line;
+    }
+
+    bool read(SKubyte* dest, SKsize len) const
+    {
+        while (len > 0)
+        {
+            const ssize_t got = recv(m_fd, dest, len, 0);
+            if (got <= 0)
+                return false;
+            dest += got;
+            len -= (SKsize)got;
+        }
+        return true;
+    }
+};
+
+// Renders the first camera of a scene file in R, G, B, A order.
+skArray<SKubyte> RenderDirect(const char* path, const SKuint32 width, const SKuint32 height, SKint32& mode)
+{
+    skArray<SKubyte> pixels;
+
+    rtLoader* loader = rtLoader::create(path);
+    if (loader && loader->load(path) == 0 && !loader->getScenes().empty())
+    {
+        rtScene* scene = loader->getScenes().at(0);
+        mode           = scene->getFlags();
+
+        rtCpuRenderSystem system;
+        rtBufferTarget    target(width, height);
+        system.setTarget(&target);
+        system.setMode(mode);
+        system.render(scene);
+
+        const rtPixelRGBA* src = (const rtPixelRGBA*)target.getPixels();
+        for (SKuint32 i = 0; i < width * height; ++i, ++src)
+        {
+            pixels.push_back(src->r);
+            pixels.push_back(src->g);
+            pixels.push_back(src->b);
+            pixels.push_back(src->a);
+        }
+    }
+    delete loader;
+    return pixels;
+}
+
+// Runs a server with Test01.bascii loaded as 'a' on a thread of its own.
+class ServerThread
+{
+private:
+    RenderServer m_server;
+    std::thread  m_thread;
+    skString     m_path;
+    int          m_status;
+
+public:
+    explicit ServerThread(const char* name) :
+        m_path(skString(testing::TempDir().c_str()) + name),
+        m_status(-1)
+    {
+        if (m_server.load("a", GetTestFilePath("Test01.bascii")) && m_server.open(m_path.c_str()))
+            m_thread = std::thread([this] {
+                m_status = m_server.run();
+            });
+    }
+
+    ~ServerThread()
+    {
+        if (m_thread.joinable())
+        {
+            Connection client(m_path.c_str());
+            client.send("quit\n");
+            client.readLine();
+            m_thread.join();
+        }
+    }
+
+    bool isRunning() const
+    {
+        return m_thread.joinable();
+    }
+
+    const char* getPath() const
+    {
+        return m_path.c_str();
+    }
+};
+
+// Reads a render reply, and checks it against a direct render.
+void ExpectFrame(const Connection&       client,
+                 const skArray<SKubyte>& expected,
+                 const SKuint32          width,
+                 const SKuint32          height)
+{
+    char header[64];
+    snprintf(header, sizeof header, "ok %u %u %u", width, height, width * height * 4);
+    ASSERT_EQ(skString(header), client.readLine());
+
+    skArray<SKubyte> pixels;
+    pixels.resize(width * height * 4);
+    ASSERT_TRUE(client.read(pixels.ptr(), pixels.size()));
+    ASSERT_EQ(expected.size(), pixels.size());
+    EXPECT_EQ(0, memcmp(expected.ptr(), pixels.ptr(), pixels.size()));
+}
+
+GTEST_TEST(RenderServer, Requests)
+{
+    const char* scene = GetTestFilePath("Test01.bascii");
+
+    SKint32                mode     = 0;
+    const skArray<SKubyte> expected = RenderDirect(scene, 32, 24, mode);
+    ASSERT_EQ(32 * 24 * 4, expected.size());
+
+    const skString path = skString(testing::TempDir().c_str()) + "RenderServer.sock";
+
+    RenderServer server;
+    ASSERT_TRUE(server.load("a", scene));
+    EXPECT_FALSE(server.load("a", scene));
+    EXPECT_FALSE(server.load("b", GetTestFilePath("Missing.bascii")));
+    ASSERT_TRUE(server.open(path.c_str()));
+
+    int         status = -1;
+    std::thread thread([&server, &status] {
+        status = server.run();
+    });
+
+    {
+        Connection client(path.c_str());
+        ASSERT_TRUE(client.isOpen());
+
+        // Pixels come back in R, G, B, A order after a header line.
+        char request[64];
+        snprintf(request, sizeof request, "render a 32 24 %d\n", mode);
+        ASSERT_TRUE(client.send(request));
+        EXPECT_EQ(skString("ok 32 24 3072"), client.readLine());
+
+        skArray<SKubyte> pixels;
+        pixels.resize(32 * 24 * 4);
+        ASSERT_TRUE(client.read(pixels.ptr(), pixels.size()));
+        EXPECT_EQ(0, memcmp(expected.ptr(), pixels.ptr(), pixels.size()));
+
+        // Several requests may arrive at once.
+        ASSERT_TRUE(client.send("render b 32 24 0\nrender a 0 24 0\nhello\n"));
+        EXPECT_EQ(skString("error unknown scene b"), client.readLine());
+        EXPECT_EQ(skString("error invalid size or mode"), client.readLine());
+        EXPECT_EQ(skString("error invalid request"), client.readLine());
+
+        ASSERT_TRUE(client.send("unload a\nunload a\n"));
+        EXPECT_EQ(skString("ok"), client.readLine());
+        EXPECT_EQ(skString("error unknown scene a"), client.readLine());
+
+        ASSERT_TRUE(client.send("quit\n"));
+        EXPECT_EQ(skString("ok"), client.readLine());
+    }
+
+    thread.join();
+    EXPECT_EQ(0, status);
+}
+
+GTEST_TEST(RenderServer, HalfClosed)
+{
+    SKint32                mode  = 0;
+    const skArray<SKubyte> large = RenderDirect(GetTestFilePath("Test01.bascii"), 32, 24, mode);
+    const skArray<SKubyte> small = RenderDirect(GetTestFilePath("Test01.bascii"), 16, 8, mode);
+
+    ServerThread server("HalfClosed.sock");
+    ASSERT_TRUE(server.isRunning());
+
+    Connection client(server.getPath());
+    ASSERT_TRUE(client.isOpen());
+    client.setTimeout(10000);
+
+    // Both requests are sent before the client hangs up. The
+    // last one has no line break, and is answered all the same.
+    char request[64];
+    snprintf(request, sizeof request, "render a 32 24 %d\nrender a 16 8 %d", mode, mode);
+    ASSERT_TRUE(client.send(request));
+    client.hangUp();
+
+    ASSERT_NO_FATAL_FAILURE(ExpectFrame(client, large, 32, 24));
+    ASSERT_NO_FATAL_FAILURE(ExpectFrame(client, small, 16, 8));
+
+    // Once everything has been answered, the server closes its end.
+    EXPECT_TRUE(client.isClosed());
+}
+
+GTEST_TEST(RenderServer, SlowReader)
+{
+    constexpr SKuint32 Size = 256;
+
+    SKint32                mode  = 0;
+    const skArray<SKubyte> frame = RenderDirect(GetTestFilePath("Test01.bascii"), Size, Size, mode);
+    const skArray<SKubyte> small = RenderDirect(GetTestFilePath("Test01.bascii"), 16, 8, mode);
+
+    ServerThread server("SlowReader.sock");
+    ASSERT_TRUE(server.isRunning());
+
+    Connection slow(server.getPath()), fast(server.getPath());
+    ASSERT_TRUE(slow.isOpen());
+    ASSERT_TRUE(fast.isOpen());
+    slow.setTimeout(10000);
+    fast.setTimeout(10000);
+
+    // Far more than fits in the socket's buffer, which the slow
+    // client does not read until the fast one has been answered.
+    constexpr int Frames = 8;
+
+    char request[64];
+    snprintf(request, sizeof request, "render a %u %u %d\n", Size, Size, mode);
+    for (int i = 0; i < Frames; ++i)
+        ASSERT_TRUE(slow.send(request));
+
+    snprintf(request, sizeof request, "render a 16 8 %d\n", mode);
+    for (int i = 0; i < Frames; ++i)
+    {
+        ASSERT_TRUE(fast.send(request));
+        ASSERT_NO_FATAL_FAILURE(ExpectFrame(fast, small, 16, 8));
+    }
+
+    for (int i = 0; i < Frames; ++i)
+        ASSERT_NO_FATAL_FAILURE(ExpectFrame(slow, frame, Size, Size));
+}
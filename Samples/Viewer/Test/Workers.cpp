@@ -0,0 +1,152 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include <gtest/gtest.h>
+#include <cstring>
+#include "Math/skQuaternion.h"
+#include "RenderSystem/Cpu/rtCpuRenderSystem.h"
+#include "RenderSystem/Loader/rtLoader.h"
+#include "RenderSystem/rtBufferTarget.h"
+#include "RenderSystem/rtCamera.h"
+#include "RenderSystem/rtScene.h"
+#include "TestDirectory.h"
+#include "TileWorkers.h"
+#include "Utils/skArray.h"
+
+constexpr SKuint32 Width  = 96;
+constexpr SKuint32 Height = 64;
+
+// Fills a job with the first camera of a scene file, the way the viewer does.
+bool MakeJob(const char* path, TileJob& job)
+{
+    rtLoader* loader = rtLoader::create(path);
+    if (!loader || loader->load(path) != 0 || loader->getScenes().empty())
+    {
+        delete loader;
+        return false;
+    }
+
+    rtScene*  scene  = loader->getScenes().at(0);
+    rtCamera* camera = scene->getCameras().at(0);
+    camera->update();
+
+    const skVector3&    position    = camera->getDerivedPosition();
+    const skQuaternion& orientation = camera->getDerivedOrientation();
+
+    job.scene          = path;
+    job.width          = Width;
+    job.height         = Height;
+    job.mode           = scene->getFlags();
+    job.position[0]    = position.x;
+    job.position[1]    = position.y;
+    job.position[2]    = position.z;
+    job.orientation[0] = orientation.w;
+    job.orientation[1] = orientation.x;
+    job.orientation[2] = orientation.y;
+    job.orientation[3] = orientation.z;
+    job.fov            = camera->getFieldOfViewAngle();
+    job.clip[0]        = camera->getNear();
+    job.clip[1]        = camera->getFar();
+    job.tileRows       = 4;
+
+    delete loader;
+    return true;
+}
+
+// Renders a job in this process, with one render system over the whole frame.
+skArray<SKubyte> RenderDirect(const TileJob& job)
+{
+    skArray<SKubyte> pixels;
+
+    rtLoader* loader = rtLoader::create(job.scene.c_str());
+    if (loader && loader->load(job.scene.c_str()) == 0 && !loader->getScenes().empty())
+    {
+        rtScene*  scene  = loader->getScenes().at(0);
+        rtCamera* camera = new rtCamera(scene);
+        scene->addCamera(camera);
+
+        camera->setNear(job.clip[0]);
+        camera->setFar(job.clip[1]);
+        camera->setFieldOfViewAngle(job.fov);
+        camera->setPosition(job.position[0], job.position[1], job.position[2]);
+        camera->setOrientation(skQuaternion(job.orientation));
+        scene->setFlags(job.mode);
+
+        rtCpuRenderSystem system;
+        rtBufferTarget    target(job.width, job.height);
+        system.setTarget(&target);
+        system.setCamera(camera);
+        system.setMode(job.mode);
+        system.render(scene);
+
+        pixels.resize(target.getPitch() * job.height);
+        memcpy(pixels.ptr(), target.getPixels(), pixels.size());
+    }
+    delete loader;
+    return pixels;
+}
+
+GTEST_TEST(TileWorkers, MatchesSingleProcess)
+{
+    TileJob job;
+    ASSERT_TRUE(MakeJob(GetTestFilePath("Test01.bascii"), job));
+
+    const skArray<SKubyte> expected = RenderDirect(job);
+    ASSERT_EQ(expected.size(), Width * Height * 4);
+
+    TileCoordinator coordinator;
+    ASSERT_TRUE(coordinator.spawn(3));
+
+    // The second frame is rendered by workers that kept the scene loaded.
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        skArray<SKubyte> pixels;
+        pixels.resize(expected.size());
+        ASSERT_TRUE(coordinator.render(job, pixels.ptr()));
+        EXPECT_EQ(memcmp(pixels.ptr(), expected.ptr(), expected.size()), 0);
+        EXPECT_EQ(coordinator.getRunningCount(), 3);
+    }
+}
+
+GTEST_TEST(TileWorkers, WorkerExitsMidFrame)
+{
+    TileJob job;
+    ASSERT_TRUE(MakeJob(GetTestFilePath("Test01.bascii"), job));
+
+    const skArray<SKubyte> expected = RenderDirect(job);
+    ASSERT_EQ(expected.size(), Width * Height * 4);
+
+    // The first worker exits after one tile, with more already handed to it.
+    TileCoordinator coordinator;
+    ASSERT_TRUE(coordinator.spawn(1, nullptr, "1"));
+    ASSERT_TRUE(coordinator.spawn(2));
+
+    skArray<SKubyte> pixels;
+    pixels.resize(expected.size());
+    ASSERT_TRUE(coordinator.render(job, pixels.ptr()));
+    EXPECT_EQ(memcmp(pixels.ptr(), expected.ptr(), expected.size()), 0);
+    EXPECT_EQ(coordinator.getRunningCount(), 2);
+
+    // The next frame goes to the workers that are left.
+    memset(pixels.ptr(), 0, pixels.size());
+    ASSERT_TRUE(coordinator.render(job, pixels.ptr()));
+    EXPECT_EQ(memcmp(pixels.ptr(), expected.ptr(), expected.size()), 0);
+}
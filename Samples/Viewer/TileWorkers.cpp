@@ -0,0 +1,455 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#include "TileWorkers.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "Math/skQuaternion.h"
+#include "Math/skRectangle.h"
+#include "RenderSystem/Cpu/rtCpuRenderSystem.h"
+#include "RenderSystem/Loader/rtLoader.h"
+#include "RenderSystem/rtBufferTarget.h"
+#include "RenderSystem/rtCamera.h"
+#include "RenderSystem/rtScene.h"
+#include "Utils/skLogger.h"
+#include "Utils/skMinMax.h"
+
+// Both ends run the same executable, so
+// messages are sent in their native layout.
+constexpr SKuint32 TileMagic = 0x544C5452;
+
+// The number of tiles each worker has queued, so
+// it never waits on the coordinator between tiles.
+constexpr SKuint32 TilesInFlight = 2;
+
+struct TileSetup
+{
+    SKuint32 magic;
+    SKuint32 width;
+    SKuint32 height;
+    SKint32  mode;
+    float    position[3];
+    float    orientation[4];
+    float    fov;
+    float    clip[2];
+    SKuint32 tileRows;
+    SKuint32 pathLength;
+};
+
+/// <summary>
+/// Sent by the coordinator to request rows [row, row + rows), and sent back
+/// in front of the rendered pixels. A request with zero rows ends the frame.
+/// The first reply to a TileSetup reports whether the scene loaded.
+/// </summary>
+struct TileHeader
+{
+    SKuint32 row;
+    SKuint32 rows;
+};
+
+static bool writeFull(const int fd, const void* data, SKsize len)
+{
+    const char* ptr = (const char*)data;
+    while (len > 0)
+    {
+        const ssize_t written = send(fd, ptr, len, MSG_NOSIGNAL);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        ptr += written;
+        len -= (SKsize)written;
+    }
+    return true;
+}
+
+static bool readFull(const int fd, void* data, SKsize len)
+{
+    char* ptr = (char*)data;
+    while (len > 0)
+    {
+        const ssize_t got = recv(fd, ptr, len, 0);
+        if (got <= 0)
+        {
+            if (got < 0 && errno == EINTR)
+                continue;
+            return false;
+        }
+        ptr += got;
+        len -= (SKsize)got;
+    }
+    return true;
+}
+
+TileCoordinator::TileCoordinator() = default;
+
+TileCoordinator::~TileCoordinator()
+{
+    // Closing the connections stops the workers.
+    for (Worker& worker : m_workers)
+    {
+        if (worker.fd != -1)
+            close(worker.fd);
+        waitpid(worker.pid, nullptr, 0);
+    }
+}
+
+bool TileCoordinator::spawn(const SKuint32 count, const char* executable, const char* argument)
+{
+    if (!executable)
+        executable = "/proc/self/exe";
+
+    for (SKuint32 i = 0; i < count; ++i)
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+        {
+            skLogf(LD_ERROR, "socketpair failed: %s\n", strerror(errno));
+            return false;
+        }
+
+        const pid_t pid = fork();
+        if (pid == 0)
+        {
+            // dup clears close-on-exec, so only this end is inherited.
+            char fd[16];
+            snprintf(fd, sizeof fd, "%d", dup(fds[1]));
+
+            execl(executable, executable, "--tile-worker", fd, argument, (char*)nullptr);
+            _exit(127);
+        }
+
+        close(fds[1]);
+        if (pid < 0)
+        {
+            skLogf(LD_ERROR, "fork failed: %s\n", strerror(errno));
+            close(fds[0]);
+            return false;
+        }
+
+        Worker worker       = {};
+        worker.pid          = (int)pid;
+        worker.fd           = fds[0];
+        worker.ready        = false;
+        worker.pendingCount = 0;
+        worker.rendered     = 0;
+        m_workers.push_back(worker);
+    }
+    return true;
+}
+
+SKuint32 TileCoordinator::getRunningCount() const
+{
+    SKuint32 count = 0;
+    for (const Worker& worker : m_workers)
+    {
+        if (worker.fd != -1)
+            ++count;
+    }
+    return count;
+}
+
+bool TileCoordinator::dispatch(Worker& worker, skArray<SKuint32>& tiles, const TileJob& job)
+{
+    while (worker.pendingCount < TilesInFlight && !tiles.empty())
+    {
+        const SKuint32 row = tiles.back();
+
+        const TileHeader request = {row, skMin<SKuint32>(job.tileRows, job.height - row)};
+        if (!writeFull(worker.fd, &request, sizeof request))
+            return false;
+
+        tiles.pop_back();
+        worker.pending[worker.pendingCount++] = row;
+    }
+    return true;
+}
+
+void TileCoordinator::stop(Worker& worker, skArray<SKuint32>& tiles)
+{
+    // Hand its unfinished tiles to the others.
+    for (SKuint32 i = 0; i < worker.pendingCount; ++i)
+        tiles.push_back(worker.pending[i]);
+    worker.pendingCount = 0;
+
+    close(worker.fd);
+    worker.fd = -1;
+}
+
+bool TileCoordinator::render(const TileJob& job, SKubyte* pixels)
+{
+    const SKuint32 tileRows = skMax<SKuint32>(job.tileRows, 1);
+    const SKsize   pitch    = (SKsize)job.width * 4;
+
+    TileSetup setup  = {};
+    setup.magic      = TileMagic;
+    setup.width      = job.width;
+    setup.height     = job.height;
+    setup.mode       = job.mode;
+    setup.fov        = job.fov;
+    setup.tileRows   = tileRows;
+    setup.pathLength = (SKuint32)job.scene.size();
+    memcpy(setup.position, job.position, sizeof setup.position);
+    memcpy(setup.orientation, job.orientation, sizeof setup.orientation);
+    memcpy(setup.clip, job.clip, sizeof setup.clip);
+
+    for (Worker& worker : m_workers)
+    {
+        if (worker.fd == -1)
+            continue;
+
+        worker.ready    = false;
+        worker.rendered = 0;
+        if (!writeFull(worker.fd, &setup, sizeof setup) ||
+            !writeFull(worker.fd, job.scene.c_str(), setup.pathLength))
+        {
+            close(worker.fd);
+            worker.fd = -1;
+        }
+    }
+
+    // The tiles are taken from the back, so push
+    // them bottom up to hand them out top down.
+    skArray<SKuint32> tiles;
+    const SKuint32    tileCount = (job.height + tileRows - 1) / tileRows;
+    tiles.reserve(tileCount);
+    for (SKuint32 i = tileCount; i > 0; --i)
+        tiles.push_back((i - 1) * tileRows);
+
+    TileJob request  = job;
+    request.tileRows = tileRows;
+
+    skArray<pollfd> fds;
+    skArray<Worker*> polled;
+    SKuint32         completed = 0;
+
+    while (completed < tileCount)
+    {
+        fds.resizeFast(0);
+        polled.resizeFast(0);
+        for (Worker& worker : m_workers)
+        {
+            if (worker.fd != -1)
+            {
+                fds.push_back({worker.fd, POLLIN, 0});
+                polled.push_back(&worker);
+            }
+        }
+
+        if (fds.empty())
+        {
+            skLogd(LD_ERROR, "Every tile worker has stopped.\n");
+            return false;
+        }
+
+        if (poll(fds.ptr(), fds.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            skLogf(LD_ERROR, "poll failed: %s\n", strerror(errno));
+            return false;
+        }
+
+        for (SKuint32 i = 0; i < fds.size(); ++i)
+        {
+            if (!fds[i].revents)
+                continue;
+
+            Worker&    worker = *polled[i];
+            TileHeader reply  = {};
+
+            if (!readFull(worker.fd, &reply, sizeof reply))
+            {
+                stop(worker, tiles);
+                continue;
+            }
+
+            if (!worker.ready)
+            {
+                if (reply.row != 0 || reply.rows != 0)
+                {
+                    skLogf(LD_ERROR, "Worker %d failed to load %s.\n", worker.pid, job.scene.c_str());
+                    stop(worker, tiles);
+                    continue;
+                }
+                worker.ready = true;
+            }
+            else
+            {
+                SKuint32 slot = 0;
+                while (slot < worker.pendingCount && worker.pending[slot] != reply.row)
+                    ++slot;
+
+                if (slot == worker.pendingCount || reply.rows > tileRows || reply.row + reply.rows > job.height ||
+                    !readFull(worker.fd, pixels + (SKsize)reply.row * pitch, (SKsize)reply.rows * pitch))
+                {
+                    stop(worker, tiles);
+                    continue;
+                }
+
+                worker.pending[slot] = worker.pending[--worker.pendingCount];
+                ++worker.rendered;
+                ++completed;
+            }
+
+            if (!dispatch(worker, tiles, request))
+                stop(worker, tiles);
+        }
+
+        // Tiles taken back from a stopped worker go to anyone with room.
+        for (Worker& worker : m_workers)
+        {
+            if (worker.fd != -1 && worker.ready && !dispatch(worker, tiles, request))
+                stop(worker, tiles);
+        }
+    }
+
+    const TileHeader end = {0, 0};
+    for (Worker& worker : m_workers)
+    {
+        if (worker.fd != -1)
+        {
+            if (!writeFull(worker.fd, &end, sizeof end))
+                stop(worker, tiles);
+            printf("Worker %d rendered %u of %u tiles\n", worker.pid, worker.rendered, tileCount);
+        }
+    }
+    return true;
+}
+
+int TileCoordinator::runWorker(const int fd, SKuint32 tileLimit)
+{
+    TileSetup          setup  = {};
+    skString           loaded;
+    rtLoader*          loader = nullptr;
+    rtScene*           scene  = nullptr;
+    rtCamera*          camera = nullptr;
+    rtCpuRenderSystem* system = nullptr;
+    rtBufferTarget*    target = nullptr;
+    bool               result = true;
+
+    // One setup per frame, until the coordinator closes the connection.
+    while (result && readFull(fd, &setup, sizeof setup))
+    {
+        if (setup.magic != TileMagic || setup.width == 0 || setup.height == 0 || setup.tileRows == 0)
+        {
+            result = false;
+            break;
+        }
+
+        skString path;
+        path.reserve(setup.pathLength + 1);
+        for (SKuint32 i = 0; i < setup.pathLength && result; ++i)
+        {
+            char ch;
+            result = readFull(fd, &ch, 1);
+            path.append(ch);
+        }
+        if (!result)
+            break;
+
+        // Frames of the same scene reuse it.
+        if (!loader || path != loaded)
+        {
+            delete system;
+            delete loader;
+            system = nullptr;
+
+            loader = rtLoader::create(path.c_str());
+            if (!loader || loader->load(path.c_str()) != 0 || loader->getScenes().empty())
+            {
+                const TileHeader failed = {SK_NPOS32, 0};
+                writeFull(fd, &failed, sizeof failed);
+                result = false;
+                break;
+            }
+
+            scene  = loader->getScenes().at(0);
+            camera = new rtCamera(scene);
+            scene->addCamera(camera);
+
+            system = new rtCpuRenderSystem();
+            if (target)
+                system->setTarget(target);
+            loaded = path;
+        }
+
+        camera->setNear(setup.clip[0]);
+        camera->setFar(setup.clip[1]);
+        camera->setFieldOfViewAngle(setup.fov);
+        camera->setPosition(setup.position[0], setup.position[1], setup.position[2]);
+        camera->setOrientation(skQuaternion(setup.orientation));
+        scene->setFlags(setup.mode);
+
+        // The buffer holds a single tile.
+        if (!target || target->getWidth() != setup.width || target->getHeight() != setup.height ||
+            target->getBandHeight() != skMin(setup.tileRows, setup.height))
+        {
+            rtBufferTarget* resized = new rtBufferTarget(setup.width, setup.height, setup.tileRows);
+            system->setTarget(resized);
+            system->invalidate();
+
+            delete target;
+            target = resized;
+        }
+
+        system->setCamera(camera);
+        system->setMode(setup.mode);
+
+        TileHeader message = {0, 0};
+        result             = writeFull(fd, &message, sizeof message);
+
+        // A request for zero rows ends the frame.
+        while (result && (result = readFull(fd, &message, sizeof message)) && message.rows > 0)
+        {
+            if (message.rows > setup.tileRows || message.row >= setup.height)
+            {
+                result = false;
+                break;
+            }
+
+            system->render(scene,
+                           skRectangle(0,
+                                       (skScalar)message.row,
+                                       (skScalar)setup.width,
+                                       (skScalar)message.rows));
+
+            result = writeFull(fd, &message, sizeof message) &&
+                     writeFull(fd, target->getPixels(), (SKsize)target->getPitch() * message.rows);
+
+            if (result && tileLimit != SK_NPOS32 && --tileLimit == 0)
+                result = false;
+        }
+    }
+
+    delete system;
+    delete target;
+    delete loader;
+    close(fd);
+    return result ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+/*
+-------------------------------------------------------------------------------
+    Copyright (c) Charles Carley.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+-------------------------------------------------------------------------------
+*/
+#ifndef _TileWorkers_h_
+#define _TileWorkers_h_
+
+#include "Utils/skArray.h"
+#include "Utils/skString.h"
+
+/// <summary>
+/// Everything a worker process needs to render tiles of a frame.
+/// </summary>
+struct TileJob
+{
+    skString scene;
+    SKuint32 width;
+    SKuint32 height;
+    SKint32  mode;
+    float    position[3];
+    float    orientation[4];
+    float    fov;
+    float    clip[2];
+
+    /// <summary>
+    /// The number of image rows in one tile.
+    /// </summary>
+    SKuint32 tileRows;
+};
+
+/// <summary>
+/// Renders one frame with a set of local worker processes. The frame is
+/// split into tiles of whole rows. Workers are handed tiles as they finish
+/// the previous ones, so faster workers end up rendering more of the frame.
+/// </summary>
+class TileCoordinator
+{
+private:
+    struct Worker
+    {
+        int      pid;
+        int      fd;
+        bool     ready;
+        SKuint32 pending[2];
+        SKuint32 pendingCount;
+        SKuint32 rendered;
+    };
+
+    skArray<Worker> m_workers;
+
+    bool dispatch(Worker& worker, skArray<SKuint32>& tiles, const TileJob& job);
+
+    void stop(Worker& worker, skArray<SKuint32>& tiles);
+
+public:
+    TileCoordinator();
+    ~TileCoordinator();
+
+    /// <summary>
+    /// Starts count worker processes. Each one runs
+    /// executable --tile-worker fd [argument].
+    /// </summary>
+    /// <param name="count">The number of worker processes.</param>
+    /// <param name="executable">The program to run, or null to run this executable.</param>
+    /// <param name="argument">An argument passed after the connection, or null.</param>
+    /// <returns>True if every worker was started.</returns>
+    bool spawn(SKuint32 count, const char* executable = nullptr, const char* argument = nullptr);
+
+    /// <summary>
+    /// Returns the number of workers that are still connected.
+    /// </summary>
+    SKuint32 getRunningCount() const;
+
+    /// <summary>
+    /// Renders a frame with the running workers. The workers keep
+    /// the scene loaded for the following frames while it is unchanged.
+    /// </summary>
+    /// <param name="job">The scene, camera and frame to render.</param>
+    /// <param name="pixels">Receives width * height top down rtPixelRGBA pixels.</param>
+    /// <returns>False if the frame could not be completed.</returns>
+    bool render(const TileJob& job, SKubyte* pixels);
+
+    /// <summary>
+    /// The main loop of a worker process.
+    /// </summary>
+    /// <param name="fd">The worker's end of the coordinator connection.</param>
+    /// <param name="tileLimit">
+    /// The number of tiles after which the worker exits without finishing
+    /// the ones it was handed, as if it had crashed. Tests use it to check
+    /// that the coordinator hands those tiles to the other workers.
+    /// </param>
+    /// <returns>The exit code of the process.</returns>
+    static int runWorker(int fd, SKuint32 tileLimit = SK_NPOS32);
+};
+
+#endif  //_TileWorkers_h_